@@ -0,0 +1,29 @@
+@echo off
+
+SETLOCAL ENABLEDELAYEDEXPANSION
+
+break>..\bin\bench_unity_build.cpp
+
+:: NOTE: The engine systems are compiled in (optimized), the renderer and the application are left out
+for %%f in (..\engine\src\core\*.cpp ..\engine\src\platform\*.cpp src\*.cpp) do (
+	if /I not "%%~nxf"=="application.cpp" (
+		set "IncludeFile=#include "%%~ff""
+		echo !IncludeFile! >> ..\bin\bench_unity_build.cpp
+	)
+)
+
+pushd ..\bin
+
+set Assembly=Bench
+set IncludeFolders=/I../bench/src /I../engine/src/ /I%VULKAN_SDK%/Include
+set Defines=/DKIWI_SLOW /DKIWI_ENGINE_EXPORTS
+set WarningsOptions=/W4 /WX
+:: NOTE: Vulkan only for the surface creation in the platform layer
+set Libraries=user32.lib winmm.lib dbghelp.lib %VULKAN_SDK%\Lib\vulkan-1.lib
+
+set CompilerFlags=/nologo /MT /fp:fast /GR- /O2 /Oi /FC /Zi /permissive- %IncludeFolders% %Defines% %WarningsOptions%
+set LinkerFlags=/nologo /incremental:no /opt:ref %Libraries%
+
+cl %CompilerFlags% bench_unity_build.cpp /Fe%Assembly% /link %LinkerFlags%
+
+popd
@@ -0,0 +1,22 @@
+#!/bin/bash
+# NOTE: Linux build of the benchmarks. Same unity build as the .bat: the engine
+# systems are compiled in (optimized), the renderer and the application are left out
+set -e
+
+mkdir -p ../bin
+UnityBuild=../bin/bench_unity_build.cpp
+: > $UnityBuild
+
+for File in $(ls ../engine/src/core/*.cpp ../engine/src/platform/*.cpp src/*.cpp | grep -v application.cpp); do
+	echo "#include \"$(realpath $File)\"" >> $UnityBuild
+done
+
+Assembly=Bench
+IncludeFolders="-I../engine/src -Isrc"
+Defines="-DKIWI_SLOW -DKIWI_ENGINE_EXPORTS"
+WarningsOptions="-Wall -Werror -Wno-unused-function -Wno-unused-parameter -Wno-unused-variable -Wno-missing-braces"
+# NOTE: -rdynamic so the sampling profiler can name the functions
+CompilerFlags="-std=c++14 -O2 -g -fno-rtti -pthread -rdynamic $IncludeFolders $Defines $WarningsOptions"
+Libraries="-ldl"
+
+g++ $CompilerFlags $UnityBuild -o ../bin/$Assembly $Libraries
@@ -0,0 +1,365 @@
+#include "bench.h"
+
+#include "core/clock.h"
+#include "core/kiwi_mem.h"
+#include "core/kiwi_string.h"
+#include "platform/platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define BENCH_MAX_ITERATIONS (1ULL << 40)
+#define BENCH_NAME_WIDTH 36
+
+BenchDesc Bench::Descs[BENCH_MAX_COUNT];
+u32 Bench::Count = 0;
+BenchCheckDesc Bench::Checks[BENCH_MAX_CHECK_COUNT];
+u32 Bench::CheckCount = 0;
+volatile u64 Bench::Sink = 0;
+
+void Bench::Register(const char *Name, bench_function *Run, bench_callback *Setup, bench_callback *Teardown,
+					 bench_callback *BatchEnd, u64 MaxIterations)
+{
+	Assert(Count < BENCH_MAX_COUNT);
+	Descs[Count++] = {Name, Run, Setup, Teardown, BatchEnd, MaxIterations};
+}
+
+void Bench::RegisterCheck(const char *Name, bench_check *Run)
+{
+	Assert(CheckCount < BENCH_MAX_CHECK_COUNT);
+	Checks[CheckCount++] = {Name, Run};
+}
+
+void Bench::Consume(u64 Value)
+{
+	Sink = Sink + Value;
+}
+
+void Bench::List()
+{
+	for (u32 Idx = 0; Idx < Count; ++Idx)
+	{
+		printf("%s\n", Descs[Idx].Name);
+	}
+	for (u32 Idx = 0; Idx < CheckCount; ++Idx)
+	{
+		printf("%s (check)\n", Checks[Idx].Name);
+	}
+}
+
+u32 Bench::RunChecks(const char *Filter)
+{
+	u32 Failures = 0;
+	for (u32 Idx = 0; Idx < CheckCount; ++Idx)
+	{
+		const BenchCheckDesc &Check = Checks[Idx];
+		if (Filter && KStr::FindSubstring(Check.Name, Filter) == KSTR_NOT_FOUND)
+		{
+			continue;
+		}
+
+		u64 Start = Clock::Now();
+		b8 Passed = Check.Run();
+		f64 Elapsed = Clock::TicksToSeconds(Clock::Now() - Start);
+		printf("%-*s %s (%.2fs)\n", BENCH_NAME_WIDTH, Check.Name, Passed ? "ok" : "FAILED", Elapsed);
+		fflush(stdout);
+		if (!Passed)
+		{
+			++Failures;
+		}
+	}
+	return Failures;
+}
+
+u32 Bench::RunAll(const BenchOptions &Options, BenchResult *OutResults)
+{
+	// NOTE: The benchmarks run on this thread, the counters are this thread's
+	PlatformPerfCounters Counters = {};
+	b8 HasCounters = Platform::PerfCountersOpen(&Counters);
+	if (!HasCounters)
+	{
+		printf("No hardware performance counters (no PMU, or perf_event_paranoid too high), timing only\n\n");
+	}
+
+	u32 ResultCount = 0;
+	for (u32 Idx = 0; Idx < Count; ++Idx)
+	{
+		if (Options.Filter && KStr::FindSubstring(Descs[Idx].Name, Options.Filter) == KSTR_NOT_FOUND)
+		{
+			continue;
+		}
+
+		OutResults[ResultCount++] = Run(Descs[Idx], Options, HasCounters ? &Counters : nullptr);
+	}
+
+	Platform::PerfCountersClose(&Counters);
+	return ResultCount;
+}
+
+// NOTE: Returns the nanoseconds the batch took. The counters are read out of
+// the timing, a read is a syscall
+u64 Bench::RunBatch(const BenchDesc &Desc, u64 Iterations, PlatformPerfCounters *Counters, u64 *OutCounters)
+{
+	u64 CountersBefore[PerfCounter_Count];
+	if (OutCounters)
+	{
+		Platform::PerfCountersRead(Counters, CountersBefore);
+	}
+
+	u64 Start = Clock::Now();
+	u64 Result = Desc.Run(Iterations);
+	u64 End = Clock::Now();
+	Consume(Result);
+
+	if (OutCounters)
+	{
+		u64 CountersAfter[PerfCounter_Count];
+		Platform::PerfCountersRead(Counters, CountersAfter);
+		for (u32 Idx = 0; Idx < PerfCounter_Count; ++Idx)
+		{
+			OutCounters[Idx] += CountersAfter[Idx] - CountersBefore[Idx];
+		}
+	}
+
+	if (Desc.BatchEnd)
+	{
+		Desc.BatchEnd();
+	}
+	return Clock::TicksToNS(End - Start);
+}
+
+BenchResult Bench::Run(const BenchDesc &Desc, const BenchOptions &Options, PlatformPerfCounters *Counters)
+{
+	if (Desc.Setup)
+	{
+		Desc.Setup();
+	}
+
+	// NOTE: Calibration, the batch time of the last doubling decides the iterations
+	u64 MaxIterations = Desc.MaxIterations ? Desc.MaxIterations : BENCH_MAX_ITERATIONS;
+	u64 MinBatchNS = (u64)(Options.MinBatchMS * 1000000.0);
+	u64 Iterations = 1;
+	for (;;)
+	{
+		u64 Elapsed = RunBatch(Desc, Iterations);
+		if (Elapsed >= MinBatchNS || Iterations >= MaxIterations)
+		{
+			break;
+		}
+
+		// NOTE: Jump close to the target when the batch is long enough to be measured
+		u64 NextIterations = Iterations * 2;
+		if (Elapsed > MinBatchNS / 100)
+		{
+			NextIterations = Max(NextIterations, (u64)((f64)Iterations * (f64)MinBatchNS / (f64)Elapsed * 1.1));
+		}
+		Iterations = Min(NextIterations, MaxIterations);
+	}
+
+	u64 WarmupNS = (u64)(Options.WarmupMS * 1000000.0);
+	u64 Warmup = 0;
+	while (Warmup < WarmupNS)
+	{
+		Warmup += RunBatch(Desc, Iterations);
+	}
+
+	f64 Samples[BENCH_MAX_REPETITIONS];
+	u64 CounterTotals[PerfCounter_Count] = {};
+	u32 Repetitions = Clamp(Options.Repetitions, 1u, (u32)BENCH_MAX_REPETITIONS);
+	for (u32 Idx = 0; Idx < Repetitions; ++Idx)
+	{
+		Samples[Idx] = (f64)RunBatch(Desc, Iterations, Counters, Counters ? CounterTotals : nullptr) / (f64)Iterations;
+	}
+
+	if (Desc.Teardown)
+	{
+		Desc.Teardown();
+	}
+
+	// NOTE: Insertion sort, there are only a few samples
+	for (u32 Idx = 1; Idx < Repetitions; ++Idx)
+	{
+		f64 Sample = Samples[Idx];
+		u32 Slot = Idx;
+		while (Slot > 0 && Samples[Slot - 1] > Sample)
+		{
+			Samples[Slot] = Samples[Slot - 1];
+			--Slot;
+		}
+		Samples[Slot] = Sample;
+	}
+
+	BenchResult Result = {};
+	Result.Name = Desc.Name;
+	Result.Iterations = Iterations;
+	Result.Repetitions = Repetitions;
+	Result.Min = Samples[0];
+	Result.Max = Samples[Repetitions - 1];
+	Result.Median = Repetitions % 2 ? Samples[Repetitions / 2]
+									: (Samples[Repetitions / 2 - 1] + Samples[Repetitions / 2]) * 0.5;
+
+	f64 Sum = 0.0;
+	for (u32 Idx = 0; Idx < Repetitions; ++Idx)
+	{
+		Sum += Samples[Idx];
+	}
+	Result.Mean = Sum / Repetitions;
+
+	f64 Variance = 0.0;
+	for (u32 Idx = 0; Idx < Repetitions; ++Idx)
+	{
+		Variance += (Samples[Idx] - Result.Mean) * (Samples[Idx] - Result.Mean);
+	}
+	Result.StdDev = Repetitions > 1 ? sqrt(Variance / (Repetitions - 1)) : 0.0;
+
+	Result.HasCounters = Counters != nullptr;
+	for (u32 Idx = 0; Idx < PerfCounter_Count; ++Idx)
+	{
+		Result.Counters[Idx] = (f64)CounterTotals[Idx] / ((f64)Iterations * Repetitions);
+	}
+
+	return Result;
+}
+
+void Bench::Print(const BenchResult *Results, u32 ResultCount)
+{
+	b8 HasCounters = ResultCount && Results[0].HasCounters;
+	printf("%-*s %12s %10s %10s %10s %10s %10s", BENCH_NAME_WIDTH, "benchmark (ns/op)", "iterations", "min",
+		   "median", "mean", "stddev", "max");
+	if (HasCounters)
+	{
+		printf(" %10s %10s %6s %10s %10s", "cycles", "instrs", "ipc", "cache miss", "br miss");
+	}
+	printf("\n");
+
+	for (u32 Idx = 0; Idx < ResultCount; ++Idx)
+	{
+		const BenchResult &Result = Results[Idx];
+		printf("%-*s %12llu %10.2f %10.2f %10.2f %10.2f %10.2f", BENCH_NAME_WIDTH, Result.Name,
+			   Result.Iterations, Result.Min, Result.Median, Result.Mean, Result.StdDev, Result.Max);
+		if (HasCounters)
+		{
+			const f64 *Counters = Result.Counters;
+			f64 IPC = Counters[PerfCounter_Cycles] > 0.0
+						  ? Counters[PerfCounter_Instructions] / Counters[PerfCounter_Cycles]
+						  : 0.0;
+			printf(" %10.2f %10.2f %6.2f %10.3f %10.3f", Counters[PerfCounter_Cycles],
+				   Counters[PerfCounter_Instructions], IPC, Counters[PerfCounter_CacheMisses],
+				   Counters[PerfCounter_BranchMisses]);
+		}
+		printf("\n");
+	}
+	// NOTE: The logger writes to the console on its own, without going through stdio
+	fflush(stdout);
+}
+
+// NOTE: One object per line, so the files diff well and the baseline parser stays trivial
+b8 Bench::WriteJSON(const char *Path, const BenchResult *Results, u32 ResultCount)
+{
+	PlatformFile File;
+	if (!Platform::FileOpen(&File, Path, FileMode_Write))
+	{
+		return false;
+	}
+
+	b8 Success = true;
+	for (u32 Idx = 0; Idx < ResultCount && Success; ++Idx)
+	{
+		const BenchResult &Result = Results[Idx];
+		char Line[512];
+		int Length = snprintf(Line, sizeof(Line),
+							  "{\"name\": \"%s\", \"iterations\": %llu, \"repetitions\": %u, \"median_ns\": %.3f, "
+							  "\"mean_ns\": %.3f, \"stddev_ns\": %.3f, \"min_ns\": %.3f, \"max_ns\": %.3f",
+							  Result.Name, Result.Iterations, Result.Repetitions, Result.Median, Result.Mean,
+							  Result.StdDev, Result.Min, Result.Max);
+		if (Length > 0 && Length < (int)sizeof(Line) && Result.HasCounters)
+		{
+			const f64 *Counters = Result.Counters;
+			Length += snprintf(Line + Length, sizeof(Line) - Length,
+							   ", \"cycles\": %.3f, \"instructions\": %.3f, \"cache_misses\": %.4f, "
+							   "\"branch_misses\": %.4f",
+							   Counters[PerfCounter_Cycles], Counters[PerfCounter_Instructions],
+							   Counters[PerfCounter_CacheMisses], Counters[PerfCounter_BranchMisses]);
+		}
+		if (Length > 0 && Length + 2 < (int)sizeof(Line))
+		{
+			Line[Length++] = '}';
+			Line[Length++] = '\n';
+		}
+		Success = Length > 0 && Length < (int)sizeof(Line) && Platform::FileWrite(&File, Line, (u64)Length);
+	}
+
+	Platform::FileClose(&File);
+	return Success;
+}
+
+// NOTE: Only reads back what WriteJSON writes: the median of the line with the
+// given name. Returns a negative value if the name isn't there
+internal_func f64 FindBaselineMedian(const char *Baseline, const char *Name)
+{
+	char Key[256];
+	snprintf(Key, sizeof(Key), "\"name\": \"%s\"", Name);
+
+	u64 At = KStr::FindSubstring(Baseline, Key);
+	if (At == KSTR_NOT_FOUND)
+	{
+		return -1.0;
+	}
+
+	const char *Line = Baseline + At;
+	u64 LineEnd = KStr::FindChar(Line, '\n');
+	u64 Median = KStr::FindSubstring(Line, "\"median_ns\": ");
+	if (Median == KSTR_NOT_FOUND || (LineEnd != KSTR_NOT_FOUND && Median > LineEnd))
+	{
+		return -1.0;
+	}
+	return strtod(Line + Median + sizeof("\"median_ns\": ") - 1, nullptr);
+}
+
+b8 Bench::Compare(const char *BaselinePath, const BenchResult *Results, u32 ResultCount, f64 Threshold,
+				  u32 &OutRegressions)
+{
+	OutRegressions = 0;
+
+	PlatformFile File;
+	if (!Platform::FileOpen(&File, BaselinePath, FileMode_Read))
+	{
+		return false;
+	}
+
+	AutoFreeArena Scratch(MemTag_Scratch);
+	u64 Size = Platform::FileSize(&File);
+	char *Baseline = (char *)Scratch.Arena->Push(Size + 1);
+	u64 Read = Platform::FileRead(&File, Baseline, Size);
+	Platform::FileClose(&File);
+	if (Read != Size)
+	{
+		return false;
+	}
+
+	printf("\n%-*s %12s %12s %9s\n", BENCH_NAME_WIDTH, "baseline comparison (median)", "baseline", "current",
+		   "change");
+	for (u32 Idx = 0; Idx < ResultCount; ++Idx)
+	{
+		const BenchResult &Result = Results[Idx];
+		f64 BaselineMedian = FindBaselineMedian(Baseline, Result.Name);
+		if (BaselineMedian < 0.0)
+		{
+			printf("%-*s %12s %12.2f %9s\n", BENCH_NAME_WIDTH, Result.Name, "-", Result.Median, "new");
+			continue;
+		}
+
+		f64 Change = BaselineMedian > 0.0 ? (Result.Median / BaselineMedian - 1.0) * 100.0 : 0.0;
+		b8 Regressed = Change > Threshold;
+		if (Regressed)
+		{
+			++OutRegressions;
+		}
+		printf("%-*s %12.2f %12.2f %+8.1f%%%s\n", BENCH_NAME_WIDTH, Result.Name, BaselineMedian, Result.Median,
+			   Change, Regressed ? "  REGRESSION" : "");
+	}
+	fflush(stdout);
+
+	return true;
+}
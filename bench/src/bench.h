@@ -0,0 +1,142 @@
+#pragma once
+
+/*
+NOTE: Micro benchmarks of the engine, see main.cpp for the command line.
+A benchmark is a function running its operation Iterations times, it
+returns something computed from the results so the compiler can't throw
+the work away. Every benchmark is run like this:
+- calibration: Iterations doubles until a batch takes at least MinBatchMS
+- warmup: batches are run and thrown away for WarmupMS
+- repetitions: BENCH_DEFAULT_REPETITIONS timed batches, the statistics
+  are computed on their time per operation.
+The median is the number the baseline comparison uses, it's the one the
+least affected by the occasional preemption.
+When the OS gives access to the hardware counters (see
+Platform::PerfCountersOpen) they are read around the timed batches too,
+the results get cycles, instructions, cache and branch misses per operation.
+Setup and Teardown run once, around all of the above. BatchEnd runs after
+every batch, out of the timing, for the benchmarks that have to clean up
+(e.g. give the memory back) to stay in a steady state.
+Checks are the correctness side: a check runs once (--check) and returns
+whether the code it exercises behaved, e.g. nothing lost under contention
+or the same results as a reference implementation.
+*/
+
+#include "defines.h"
+#include "platform/platform.h"
+
+#define BENCH_FUNCTION(Name) u64 Name(u64 Iterations)
+typedef BENCH_FUNCTION(bench_function);
+typedef void bench_callback();
+#define BENCH_CHECK(Name) b8 Name()
+typedef BENCH_CHECK(bench_check);
+
+#define BENCH_MAX_COUNT 128
+#define BENCH_MAX_CHECK_COUNT 32
+#define BENCH_DEFAULT_REPETITIONS 20
+#define BENCH_MAX_REPETITIONS 1000
+#define BENCH_DEFAULT_MIN_BATCH_MS 10.0
+#define BENCH_DEFAULT_WARMUP_MS 100.0
+// NOTE: Percent, a median this much slower than the baseline is a regression
+#define BENCH_DEFAULT_THRESHOLD 10.0
+
+struct BenchDesc
+{
+	const char *Name;
+	bench_function *Run;
+	bench_callback *Setup;
+	bench_callback *Teardown;
+	bench_callback *BatchEnd;
+	// NOTE: 0 means no limit, for the benchmarks that fill a fixed size buffer
+	u64 MaxIterations;
+};
+
+// NOTE: Nanoseconds per operation
+struct BenchResult
+{
+	const char *Name;
+	u64 Iterations;
+	u32 Repetitions;
+	f64 Min;
+	f64 Median;
+	f64 Mean;
+	f64 StdDev;
+	f64 Max;
+	// NOTE: Per operation, over all the repetitions. Only valid with HasCounters
+	b8 HasCounters;
+	f64 Counters[PerfCounter_Count];
+};
+
+struct BenchCheckDesc
+{
+	const char *Name;
+	bench_check *Run;
+};
+
+struct BenchOptions
+{
+	const char *Filter;
+	u32 Repetitions;
+	f64 MinBatchMS;
+	f64 WarmupMS;
+};
+
+// NOTE: this is a singleton
+class Bench
+{
+public:
+	static void Register(const char *Name, bench_function *Run, bench_callback *Setup = nullptr,
+						 bench_callback *Teardown = nullptr, bench_callback *BatchEnd = nullptr,
+						 u64 MaxIterations = 0);
+	static void RegisterCheck(const char *Name, bench_check *Run);
+
+	// NOTE: Runs the benchmarks whose name contains Options.Filter (all of them
+	// if it's null), OutResults must have room for BENCH_MAX_COUNT results
+	static u32 RunAll(const BenchOptions &Options, BenchResult *OutResults);
+	static void List();
+	// NOTE: Runs the checks whose name contains Filter and prints their outcome.
+	// Returns how many failed
+	static u32 RunChecks(const char *Filter);
+
+	static void Print(const BenchResult *Results, u32 Count);
+	static b8 WriteJSON(const char *Path, const BenchResult *Results, u32 Count);
+	// NOTE: Prints the comparison, OutRegressions gets how many medians are more
+	// than Threshold percent slower. Benchmarks missing from the baseline are
+	// reported but don't count. Returns false if the baseline can't be read
+	static b8 Compare(const char *BaselinePath, const BenchResult *Results, u32 Count, f64 Threshold,
+					  u32 &OutRegressions);
+
+	// NOTE: Keeps the compiler from optimizing the value away
+	static void Consume(u64 Value);
+
+private:
+	// NOTE: Counters is null when the hardware counters aren't available
+	static BenchResult Run(const BenchDesc &Desc, const BenchOptions &Options, PlatformPerfCounters *Counters);
+	// NOTE: OutCounters, if any, gets the counts of the batch added to it
+	static u64 RunBatch(const BenchDesc &Desc, u64 Iterations, PlatformPerfCounters *Counters = nullptr,
+						u64 *OutCounters = nullptr);
+
+	static BenchDesc Descs[BENCH_MAX_COUNT];
+	static u32 Count;
+	static BenchCheckDesc Checks[BENCH_MAX_CHECK_COUNT];
+	static u32 CheckCount;
+	static volatile u64 Sink;
+};
+
+// NOTE: Registration functions of the benchmark files (benchmarks and checks), called by main
+void RegisterMemoryBenchmarks();
+void RegisterHeapBenchmarks();
+void RegisterEventBenchmarks();
+void RegisterMathBenchmarks();
+void RegisterEngineBenchmarks();
+
+// NOTE: Forces the compiler to assume the memory behind Pointer is read and written
+KIWI_INLINE void BenchClobber(void *Pointer)
+{
+#ifdef KIWI_MSVC
+	_ReadWriteBarrier();
+	(void)Pointer;
+#else
+	asm volatile("" : : "r"(Pointer) : "memory");
+#endif
+}
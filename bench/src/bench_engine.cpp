@@ -0,0 +1,182 @@
+#include "bench.h"
+
+#include "core/clock.h"
+#include "core/logger.h"
+#include "core/metrics.h"
+#include "core/profiler.h"
+#include "platform/platform.h"
+
+local_var MetricId BenchCounter = METRICS_INVALID_ID;
+local_var MetricId BenchHistogram = METRICS_INVALID_ID;
+local_var u8 SavedGeneralMask = 0;
+
+internal_func BENCH_FUNCTION(ClockNow)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Result += Clock::Now();
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(CycleCounter)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Result += ReadCycleCounter();
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(PlatformTicks)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Result += Platform::GetTicks();
+	}
+	return Result;
+}
+
+// NOTE: The profiler drops the scopes past the size of the ring, a batch
+// stays under it and BatchEnd drains it as the end of a frame would
+internal_func BENCH_FUNCTION(ProfileScopeEmpty)
+{
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		KIWI_PROFILE_SCOPE("Bench");
+	}
+	return Iterations;
+}
+
+internal_func void ProfilerEndFrame()
+{
+	Profiler::EndFrame();
+}
+
+internal_func void MetricsSetup()
+{
+	BenchCounter = Metrics::RegisterCounter("bench.counter");
+	BenchHistogram = Metrics::RegisterHistogram("bench.histogram");
+}
+
+internal_func BENCH_FUNCTION(MetricsAdd)
+{
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Metrics::Add(BenchCounter, 1);
+	}
+	return Iterations;
+}
+
+internal_func BENCH_FUNCTION(MetricsRecord)
+{
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Metrics::Record(BenchHistogram, Idx);
+	}
+	return Iterations;
+}
+
+internal_func void LogMaskSetup()
+{
+	SavedGeneralMask = Logger::ChannelMasks[LogChannel_General];
+	Logger::SetChannelLevel(LogChannel_General, LogLevel_Info);
+}
+
+internal_func void LogMaskTeardown()
+{
+	Logger::SetChannelMask(LogChannel_General, SavedGeneralMask);
+}
+
+internal_func BENCH_FUNCTION(LogDebugMasked)
+{
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		LogDebug("Masked out %llu", Idx);
+	}
+	return Iterations;
+}
+
+internal_func BENCH_FUNCTION(LogFastDebugMasked)
+{
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		LogFastDebug("Masked out %llu", Idx);
+	}
+	return Iterations;
+}
+
+// NOTE: The enabled path is only the producer side: format and push into
+// the ring. The console is turned off so the writer thread doesn't measure
+// the terminal, it still writes every record to the log file. A batch stays
+// well under the ring size and BatchEnd waits for the writer, so nothing
+// gets dropped and every iteration pays for a real push.
+// The LogInfo macros are rate limited per call site, a loop over one of
+// them would measure the limiter, so this calls Output directly.
+internal_func void LogEnabledSetup()
+{
+	LogMaskSetup();
+	Logger::SetConsoleOutput(false);
+}
+
+internal_func void LogEnabledTeardown()
+{
+	Logger::Flush();
+	Logger::SetConsoleOutput(true);
+	LogMaskTeardown();
+}
+
+internal_func void LogEnabledBatchEnd()
+{
+	Logger::Flush();
+}
+
+internal_func BENCH_FUNCTION(LogInfoEnabled)
+{
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Logger::Output(LogLevel_Info, "Frame %llu took %.3fms", Idx, 16.6);
+	}
+	return Iterations;
+}
+
+// NOTE: Same record as LogInfoEnabled, the formatting moves to the writer thread
+internal_func BENCH_FUNCTION(LogFastInfoEnabled)
+{
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		LogFastInfo("Frame %llu took %.3fms", Idx, 16.6);
+	}
+	return Iterations;
+}
+
+// NOTE: How long a 1ms sleep really takes, the oversleep of SleepPrecise
+internal_func BENCH_FUNCTION(SleepPrecise1MS)
+{
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Platform::SleepPrecise(0.001);
+	}
+	return Iterations;
+}
+
+void RegisterEngineBenchmarks()
+{
+	Bench::Register("clock.now", ClockNow);
+	Bench::Register("clock.read_cycle_counter", CycleCounter);
+	Bench::Register("platform.get_ticks", PlatformTicks);
+	Bench::Register("profiler.scope", ProfileScopeEmpty, nullptr, nullptr, ProfilerEndFrame,
+					PROFILER_RING_EVENT_COUNT / 4);
+	Bench::Register("metrics.add", MetricsAdd, MetricsSetup);
+	Bench::Register("metrics.record", MetricsRecord, MetricsSetup);
+	Bench::Register("logger.debug_masked", LogDebugMasked, LogMaskSetup, LogMaskTeardown);
+	Bench::Register("logger.fast_debug_masked", LogFastDebugMasked, LogMaskSetup, LogMaskTeardown);
+	Bench::Register("logger.info_enabled", LogInfoEnabled, LogEnabledSetup, LogEnabledTeardown, LogEnabledBatchEnd,
+					LOG_RING_CELL_COUNT / 4);
+	Bench::Register("logger.fast_info_enabled", LogFastInfoEnabled, LogEnabledSetup, LogEnabledTeardown,
+					LogEnabledBatchEnd, LOG_RING_CELL_COUNT / 4);
+	Bench::Register("platform.sleep_precise_1ms", SleepPrecise1MS, nullptr, nullptr, nullptr, 10);
+}
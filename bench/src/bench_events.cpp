@@ -0,0 +1,582 @@
+#include "bench.h"
+
+#include "core/event.h"
+#include "core/event_channel.h"
+#include "containers/klinked_list.h"
+#include "platform/platform.h"
+
+#include <stdio.h>
+
+// NOTE: Codes nobody else uses, application codes start at 0x100
+#define BENCH_EVENT_FIRE_1 0x200
+#define BENCH_EVENT_FIRE_8 0x201
+#define BENCH_EVENT_FIRE_64 0x202
+#define BENCH_EVENT_REGISTER 0x203
+#define BENCH_EVENT_QUEUED 0x204
+#define BENCH_EVENT_NO_LISTENERS 0x205
+#define BENCH_EVENT_HANDLED 0x206
+#define BENCH_EVENT_THREADS 0x207
+#define BENCH_EVENT_REENTRANT 0x208
+// NOTE: The other codes the scattered linked list registers to
+#define BENCH_EVENT_SCATTER_FIRST_CODE 0x300
+#define BENCH_EVENT_SCATTER 64
+
+#define BENCH_EVENT_MAX_LISTENERS 64
+// NOTE: Posts per DispatchQueued, the frame queue of the event system is bounded
+#define BENCH_EVENT_QUEUE_BATCH 256
+// NOTE: 16 producers, 10M events in total
+#define BENCH_EVENT_PRODUCER_COUNT 16
+#define BENCH_EVENT_PRODUCER_EVENTS 625000
+
+local_var u64 EventListeners[BENCH_EVENT_MAX_LISTENERS];
+local_var u64 EventsReceived = 0;
+
+internal_func EVENT_FUNCTION(OnBenchEvent)
+{
+	EventsReceived += Data.u64[0];
+	return false;
+}
+
+internal_func EVENT_FUNCTION(OnBenchEventHandled)
+{
+	EventsReceived += Data.u64[0];
+	return true;
+}
+
+internal_func void RegisterListeners(u16 Code, u32 Count)
+{
+	for (u32 Idx = 0; Idx < Count; ++Idx)
+	{
+		EventSystem::Register(Code, EventListeners + Idx, OnBenchEvent);
+	}
+}
+
+internal_func void UnregisterListeners(u16 Code, u32 Count)
+{
+	for (u32 Idx = 0; Idx < Count; ++Idx)
+	{
+		EventSystem::Unregister(Code, EventListeners + Idx, OnBenchEvent);
+	}
+}
+
+internal_func void Fire1Setup() { RegisterListeners(BENCH_EVENT_FIRE_1, 1); }
+internal_func void Fire1Teardown() { UnregisterListeners(BENCH_EVENT_FIRE_1, 1); }
+internal_func void Fire8Setup() { RegisterListeners(BENCH_EVENT_FIRE_8, 8); }
+internal_func void Fire8Teardown() { UnregisterListeners(BENCH_EVENT_FIRE_8, 8); }
+internal_func void Fire64Setup() { RegisterListeners(BENCH_EVENT_FIRE_64, 64); }
+internal_func void Fire64Teardown() { UnregisterListeners(BENCH_EVENT_FIRE_64, 64); }
+internal_func void QueuedSetup() { RegisterListeners(BENCH_EVENT_QUEUED, 1); }
+internal_func void QueuedTeardown() { UnregisterListeners(BENCH_EVENT_QUEUED, 1); }
+
+// NOTE: The first listener handles it, the other 7 are never called
+internal_func void HandledSetup()
+{
+	EventSystem::Register(BENCH_EVENT_HANDLED, EventListeners, OnBenchEventHandled);
+	for (u32 Idx = 1; Idx < 8; ++Idx)
+	{
+		EventSystem::Register(BENCH_EVENT_HANDLED, EventListeners + Idx, OnBenchEvent);
+	}
+}
+
+internal_func void HandledTeardown()
+{
+	EventSystem::Unregister(BENCH_EVENT_HANDLED, EventListeners, OnBenchEventHandled);
+	for (u32 Idx = 1; Idx < 8; ++Idx)
+	{
+		EventSystem::Unregister(BENCH_EVENT_HANDLED, EventListeners + Idx, OnBenchEvent);
+	}
+}
+
+internal_func u64 FireLoop(u16 Code, u64 Iterations)
+{
+	EventContext Context = {};
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Context.u64[0] = Idx;
+		EventSystem::Fire(Code, nullptr, Context);
+	}
+	return EventsReceived;
+}
+
+internal_func BENCH_FUNCTION(EventFire1) { return FireLoop(BENCH_EVENT_FIRE_1, Iterations); }
+internal_func BENCH_FUNCTION(EventFire8) { return FireLoop(BENCH_EVENT_FIRE_8, Iterations); }
+internal_func BENCH_FUNCTION(EventFire64) { return FireLoop(BENCH_EVENT_FIRE_64, Iterations); }
+internal_func BENCH_FUNCTION(EventFireHandled) { return FireLoop(BENCH_EVENT_HANDLED, Iterations); }
+internal_func BENCH_FUNCTION(EventFireNoListeners) { return FireLoop(BENCH_EVENT_NO_LISTENERS, Iterations); }
+
+// NOTE: Appends to the listeners of the code and takes it out again
+internal_func BENCH_FUNCTION(EventRegisterUnregister)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		u64 *Listener = EventListeners + (Idx & (BENCH_EVENT_MAX_LISTENERS - 1));
+		Result += EventSystem::Register(BENCH_EVENT_REGISTER, Listener, OnBenchEvent);
+		Result += EventSystem::Unregister(BENCH_EVENT_REGISTER, Listener, OnBenchEvent);
+	}
+	return Result;
+}
+
+// NOTE: Post plus its share of the DispatchQueued that fires it
+internal_func BENCH_FUNCTION(EventPostDispatch)
+{
+	EventContext Context = {};
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Context.u64[0] = Idx;
+		EventSystem::Post(BENCH_EVENT_QUEUED, nullptr, Context);
+		if ((Idx & (BENCH_EVENT_QUEUE_BATCH - 1)) == BENCH_EVENT_QUEUE_BATCH - 1)
+		{
+			EventSystem::DispatchQueued();
+		}
+	}
+	EventSystem::DispatchQueued();
+	return EventsReceived;
+}
+
+// NOTE: Uncontended, the cost of the lock-free ring on its own
+internal_func BENCH_FUNCTION(EventPostFromAnyThread)
+{
+	EventContext Context = {};
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Context.u64[0] = Idx;
+		EventSystem::TryPostFromAnyThread(BENCH_EVENT_QUEUED, nullptr, Context);
+		if ((Idx & (BENCH_EVENT_QUEUE_BATCH - 1)) == BENCH_EVENT_QUEUE_BATCH - 1)
+		{
+			EventSystem::DispatchQueued();
+		}
+	}
+	EventSystem::DispatchQueued();
+	return EventsReceived;
+}
+
+/*
+NOTE: The dispatch as it was before the listeners moved to contiguous
+per-code arrays: a KLinkedList per code, walked node by node. It's copied
+here as the baseline of the event.fire benchmarks, the *_linked_list ones
+run the same listeners through it. The nodes of these benchmarks are pushed
+back to back on the arena, that's the best case of the lists: in a game the
+registrations of different codes interleave and scatter them.
+*/
+class LinkedListEventSystem
+{
+public:
+	static void Initialize()
+	{
+		for (u32 Idx = 0; Idx < MAX_MESSAGE_CODES; ++Idx)
+		{
+			Registered[Idx].Create(MemTag_Game);
+		}
+		IsInitialized = true;
+	}
+
+	static b8 Register(u16 Code, void *Listener, on_event OnEvent)
+	{
+		if (!IsInitialized)
+		{
+			return false;
+		}
+
+		KLinkedList<RegisteredEvent> *Events = &Registered[Code];
+		for (KLinkedList<RegisteredEvent>::Node *Node = Events->FirstNode; Node; Node = Node->Next)
+		{
+			if (Node->Element.Listener == Listener)
+			{
+				return false;
+			}
+		}
+
+		RegisteredEvent Event;
+		Event.Listener = Listener;
+		Event.Callback = OnEvent;
+		Events->Add(Event);
+		return true;
+	}
+
+	static b8 Unregister(u16 Code, void *Listener, on_event OnEvent)
+	{
+		if (!IsInitialized)
+		{
+			return false;
+		}
+
+		KLinkedList<RegisteredEvent> *Events = &Registered[Code];
+		for (KLinkedList<RegisteredEvent>::Node *Node = Events->FirstNode; Node; Node = Node->Next)
+		{
+			if (Node->Element.Listener == Listener && Node->Element.Callback == OnEvent)
+			{
+				Events->Remove(Node);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// NOTE: The engine's Fire was exported by the DLL, it never got inlined
+	// into the loops of its callers. This one must not be either.
+	static KIWI_NOINLINE b8 Fire(u16 Code, void *Sender, EventContext Context)
+	{
+		if (!IsInitialized)
+		{
+			return false;
+		}
+
+		KLinkedList<RegisteredEvent> *Events = &Registered[Code];
+		for (KLinkedList<RegisteredEvent>::Node *Node = Events->FirstNode; Node; Node = Node->Next)
+		{
+			if (Node->Element.Callback(Code, Sender, Node->Element.Listener, Context))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+private:
+	static KLinkedList<RegisteredEvent> Registered[MAX_MESSAGE_CODES];
+	static b8 IsInitialized;
+};
+
+KLinkedList<RegisteredEvent> LinkedListEventSystem::Registered[MAX_MESSAGE_CODES];
+b8 LinkedListEventSystem::IsInitialized = false;
+
+internal_func void RegisterLinkedListListeners(u16 Code, u32 Count)
+{
+	for (u32 Idx = 0; Idx < Count; ++Idx)
+	{
+		LinkedListEventSystem::Register(Code, EventListeners + Idx, OnBenchEvent);
+	}
+}
+
+internal_func void UnregisterLinkedListListeners(u16 Code, u32 Count)
+{
+	for (u32 Idx = 0; Idx < Count; ++Idx)
+	{
+		LinkedListEventSystem::Unregister(Code, EventListeners + Idx, OnBenchEvent);
+	}
+}
+
+// NOTE: Every listener of the fired code is followed by BENCH_EVENT_SCATTER
+// registrations to other codes, as if the systems had registered in turns:
+// the nodes walked by Fire are that far apart in the arena
+internal_func void LinkedListScatteredSetup()
+{
+	for (u32 Idx = 0; Idx < 64; ++Idx)
+	{
+		LinkedListEventSystem::Register(BENCH_EVENT_FIRE_64, EventListeners + Idx, OnBenchEvent);
+		for (u16 Filler = 0; Filler < BENCH_EVENT_SCATTER; ++Filler)
+		{
+			LinkedListEventSystem::Register(BENCH_EVENT_SCATTER_FIRST_CODE + Filler, EventListeners + Idx,
+											OnBenchEvent);
+		}
+	}
+}
+
+internal_func void LinkedListScatteredTeardown()
+{
+	for (u32 Idx = 0; Idx < 64; ++Idx)
+	{
+		LinkedListEventSystem::Unregister(BENCH_EVENT_FIRE_64, EventListeners + Idx, OnBenchEvent);
+		for (u16 Filler = 0; Filler < BENCH_EVENT_SCATTER; ++Filler)
+		{
+			LinkedListEventSystem::Unregister(BENCH_EVENT_SCATTER_FIRST_CODE + Filler, EventListeners + Idx,
+											  OnBenchEvent);
+		}
+	}
+}
+
+internal_func void LinkedListFire1Setup() { RegisterLinkedListListeners(BENCH_EVENT_FIRE_1, 1); }
+internal_func void LinkedListFire1Teardown() { UnregisterLinkedListListeners(BENCH_EVENT_FIRE_1, 1); }
+internal_func void LinkedListFire8Setup() { RegisterLinkedListListeners(BENCH_EVENT_FIRE_8, 8); }
+internal_func void LinkedListFire8Teardown() { UnregisterLinkedListListeners(BENCH_EVENT_FIRE_8, 8); }
+internal_func void LinkedListFire64Setup() { RegisterLinkedListListeners(BENCH_EVENT_FIRE_64, 64); }
+internal_func void LinkedListFire64Teardown() { UnregisterLinkedListListeners(BENCH_EVENT_FIRE_64, 64); }
+
+// NOTE: The lists push at the front: the handling listener goes in last to be the first one called
+internal_func void LinkedListHandledSetup()
+{
+	for (u32 Idx = 1; Idx < 8; ++Idx)
+	{
+		LinkedListEventSystem::Register(BENCH_EVENT_HANDLED, EventListeners + Idx, OnBenchEvent);
+	}
+	LinkedListEventSystem::Register(BENCH_EVENT_HANDLED, EventListeners, OnBenchEventHandled);
+}
+
+internal_func void LinkedListHandledTeardown()
+{
+	LinkedListEventSystem::Unregister(BENCH_EVENT_HANDLED, EventListeners, OnBenchEventHandled);
+	for (u32 Idx = 1; Idx < 8; ++Idx)
+	{
+		LinkedListEventSystem::Unregister(BENCH_EVENT_HANDLED, EventListeners + Idx, OnBenchEvent);
+	}
+}
+
+internal_func u64 LinkedListFireLoop(u16 Code, u64 Iterations)
+{
+	EventContext Context = {};
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Context.u64[0] = Idx;
+		LinkedListEventSystem::Fire(Code, nullptr, Context);
+	}
+	return EventsReceived;
+}
+
+internal_func BENCH_FUNCTION(LinkedListFire1) { return LinkedListFireLoop(BENCH_EVENT_FIRE_1, Iterations); }
+internal_func BENCH_FUNCTION(LinkedListFire8) { return LinkedListFireLoop(BENCH_EVENT_FIRE_8, Iterations); }
+internal_func BENCH_FUNCTION(LinkedListFire64) { return LinkedListFireLoop(BENCH_EVENT_FIRE_64, Iterations); }
+internal_func BENCH_FUNCTION(LinkedListFireHandled) { return LinkedListFireLoop(BENCH_EVENT_HANDLED, Iterations); }
+internal_func BENCH_FUNCTION(LinkedListFireNoListeners)
+{
+	return LinkedListFireLoop(BENCH_EVENT_NO_LISTENERS, Iterations);
+}
+
+internal_func BENCH_FUNCTION(LinkedListRegisterUnregister)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		u64 *Listener = EventListeners + (Idx & (BENCH_EVENT_MAX_LISTENERS - 1));
+		Result += LinkedListEventSystem::Register(BENCH_EVENT_REGISTER, Listener, OnBenchEvent);
+		Result += LinkedListEventSystem::Unregister(BENCH_EVENT_REGISTER, Listener, OnBenchEvent);
+	}
+	return Result;
+}
+
+// NOTE: Every event carries its producer in the high bits and its sequence
+// number in the low ones. A producer's posts claim increasing slots in the
+// ring, so they must arrive in order: the expected sequence of each producer
+// catches a loss, a duplicate and a torn cell alike.
+local_var volatile u64 ProducersStarted = 0;
+local_var volatile u64 ProducersFinished = 0;
+local_var u64 ProducerNext[BENCH_EVENT_PRODUCER_COUNT];
+local_var u64 ProducerErrors = 0;
+local_var u64 ThreadEventsReceived = 0;
+
+internal_func THREAD_PROC(EventProducer)
+{
+	u64 Producer = (u64)Param;
+
+	// NOTE: Everybody starts at once, for as much contention as possible
+	AtomicAdd64(&ProducersStarted, 1);
+	while (AtomicLoadAcquire64(&ProducersStarted) < BENCH_EVENT_PRODUCER_COUNT)
+	{
+		CpuPause();
+	}
+
+	EventContext Context = {};
+	for (u64 Sequence = 0; Sequence < BENCH_EVENT_PRODUCER_EVENTS; ++Sequence)
+	{
+		Context.u64[0] = (Producer << 32) | Sequence;
+		Context.u64[1] = ~Context.u64[0];
+		EventSystem::PostFromAnyThread(BENCH_EVENT_THREADS, nullptr, Context);
+	}
+
+	AtomicAdd64(&ProducersFinished, 1);
+	return 0;
+}
+
+internal_func EVENT_FUNCTION(OnProducerEvent)
+{
+	u64 Producer = Data.u64[0] >> 32;
+	u64 Sequence = Data.u64[0] & 0xFFFFFFFF;
+	if (Data.u64[1] != ~Data.u64[0] || Producer >= BENCH_EVENT_PRODUCER_COUNT ||
+		Sequence != ProducerNext[Producer])
+	{
+		if (ProducerErrors++ == 0)
+		{
+			printf("Producer %llu: got event %llu, expected %llu\n", Producer, Sequence,
+				   Producer < BENCH_EVENT_PRODUCER_COUNT ? ProducerNext[Producer] : 0);
+		}
+	}
+	else
+	{
+		++ProducerNext[Producer];
+	}
+	++ThreadEventsReceived;
+	return false;
+}
+
+// NOTE: The producers post with back-pressure while the main thread
+// dispatches as fast as it can, so the ring keeps filling up and wrapping
+internal_func BENCH_CHECK(EventPostFromAnyThreadNoLoss)
+{
+	u64 Listener = 0;
+	EventSystem::Register(BENCH_EVENT_THREADS, &Listener, OnProducerEvent);
+	ProducersStarted = 0;
+	ProducersFinished = 0;
+	ProducerErrors = 0;
+	ThreadEventsReceived = 0;
+	MemSystem::Zero(ProducerNext, sizeof(ProducerNext));
+
+	PlatformThread Producers[BENCH_EVENT_PRODUCER_COUNT];
+	u32 ProducerCount = 0;
+	for (; ProducerCount < BENCH_EVENT_PRODUCER_COUNT; ++ProducerCount)
+	{
+		if (!Platform::ThreadCreate(Producers + ProducerCount, EventProducer, (void *)(u64)ProducerCount))
+		{
+			// NOTE: The ones that started wait for the others forever, let them go
+			printf("Could only start %u producers\n", ProducerCount);
+			AtomicAdd64(&ProducersStarted, BENCH_EVENT_PRODUCER_COUNT);
+			break;
+		}
+	}
+
+	// NOTE: Once the producers are done, every event is either in the ring or
+	// dispatched already: a dispatch that finds nothing after that means the
+	// missing ones are lost, not late
+	u64 Expected = (u64)ProducerCount * BENCH_EVENT_PRODUCER_EVENTS;
+	u64 QueueFullCount = 0;
+	while (ThreadEventsReceived < Expected)
+	{
+		b8 ProducersDone = AtomicLoadAcquire64(&ProducersFinished) == ProducerCount;
+		EventSystem::DispatchQueued();
+		EventQueueStats Stats = EventSystem::GetQueueStats();
+		QueueFullCount += Stats.ThreadQueueFull;
+		if (ProducersDone && Stats.FromThreads == 0 && Stats.Dispatched == 0)
+		{
+			break;
+		}
+	}
+
+	for (u32 Idx = 0; Idx < ProducerCount; ++Idx)
+	{
+		Platform::ThreadJoin(Producers + Idx);
+	}
+	// NOTE: Anything still queued now would be a duplicate
+	EventSystem::DispatchQueued();
+	EventSystem::Unregister(BENCH_EVENT_THREADS, &Listener, OnProducerEvent);
+
+	for (u32 Idx = 0; Idx < ProducerCount; ++Idx)
+	{
+		if (ProducerNext[Idx] != BENCH_EVENT_PRODUCER_EVENTS)
+		{
+			printf("Producer %u: %llu events received in order out of %u\n", Idx, ProducerNext[Idx],
+				   BENCH_EVENT_PRODUCER_EVENTS);
+			++ProducerErrors;
+		}
+	}
+	if (ThreadEventsReceived != Expected)
+	{
+		printf("%llu events received, %llu expected\n", ThreadEventsReceived, Expected);
+		++ProducerErrors;
+	}
+
+	printf("%llu events from %u producers, the ring was full %llu times\n", ThreadEventsReceived, ProducerCount,
+		   QueueFullCount);
+	return ProducerCount == BENCH_EVENT_PRODUCER_COUNT && ProducerErrors == 0;
+}
+
+// NOTE: The first listener unregisters itself and registers enough new ones
+// to make the listener array grow while Fire walks it. The new ones are
+// called by the same Fire, the removed one never again.
+local_var u64 ReentrantFirstCalls = 0;
+local_var u64 ReentrantCalls = 0;
+
+internal_func EVENT_FUNCTION(OnReentrantCounter)
+{
+	++ReentrantCalls;
+	return false;
+}
+
+internal_func EVENT_FUNCTION(OnReentrantFirst)
+{
+	++ReentrantFirstCalls;
+	EventSystem::Unregister(Code, Listener, OnReentrantFirst);
+	for (u32 Idx = 0; Idx < BENCH_EVENT_MAX_LISTENERS; ++Idx)
+	{
+		EventSystem::Register(Code, EventListeners + Idx, OnReentrantCounter);
+	}
+	return false;
+}
+
+internal_func BENCH_CHECK(EventRegisterUnregisterWhileFiring)
+{
+	u64 First = 0;
+	u64 Second = 0;
+	ReentrantFirstCalls = 0;
+	ReentrantCalls = 0;
+	EventSystem::Register(BENCH_EVENT_REENTRANT, &First, OnReentrantFirst);
+	EventSystem::Register(BENCH_EVENT_REENTRANT, &Second, OnReentrantCounter);
+
+	EventContext Context = {};
+	EventSystem::Fire(BENCH_EVENT_REENTRANT, nullptr, Context);
+	u64 FirstFireCalls = ReentrantCalls;
+	ReentrantCalls = 0;
+	EventSystem::Fire(BENCH_EVENT_REENTRANT, nullptr, Context);
+	u64 SecondFireCalls = ReentrantCalls;
+
+	EventSystem::Unregister(BENCH_EVENT_REENTRANT, &Second, OnReentrantCounter);
+	for (u32 Idx = 0; Idx < BENCH_EVENT_MAX_LISTENERS; ++Idx)
+	{
+		EventSystem::Unregister(BENCH_EVENT_REENTRANT, EventListeners + Idx, OnReentrantCounter);
+	}
+
+	u64 Expected = BENCH_EVENT_MAX_LISTENERS + 1;
+	if (ReentrantFirstCalls != 1 || FirstFireCalls != Expected || SecondFireCalls != Expected)
+	{
+		printf("First listener called %llu times, the others %llu and %llu times, expected 1, %llu and %llu\n",
+			   ReentrantFirstCalls, FirstFireCalls, SecondFireCalls, Expected, Expected);
+		return false;
+	}
+	return true;
+}
+
+struct BenchPayload
+{
+	u64 Value;
+};
+
+template <u32 Index>
+struct BenchChannelListener
+{
+	static b8 OnEvent(const BenchPayload &Payload)
+	{
+		EventsReceived += Payload.Value + Index;
+		return false;
+	}
+};
+
+// NOTE: Same 8 listeners as EventFire8, without the function pointers
+typedef EventChannel<BenchPayload, BenchChannelListener<0>, BenchChannelListener<1>, BenchChannelListener<2>,
+					 BenchChannelListener<3>, BenchChannelListener<4>, BenchChannelListener<5>,
+					 BenchChannelListener<6>, BenchChannelListener<7>>
+	BenchChannel;
+
+internal_func BENCH_FUNCTION(EventChannelFire8)
+{
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchChannel::Fire({Idx});
+	}
+	return EventsReceived;
+}
+
+void RegisterEventBenchmarks()
+{
+	Bench::Register("event.fire_1", EventFire1, Fire1Setup, Fire1Teardown);
+	Bench::Register("event.fire_8", EventFire8, Fire8Setup, Fire8Teardown);
+	Bench::Register("event.fire_64", EventFire64, Fire64Setup, Fire64Teardown);
+	Bench::Register("event.fire_handled_first_of_8", EventFireHandled, HandledSetup, HandledTeardown);
+	Bench::Register("event.fire_no_listeners", EventFireNoListeners);
+	Bench::Register("event.register_unregister", EventRegisterUnregister);
+
+	LinkedListEventSystem::Initialize();
+	Bench::Register("event.fire_1_linked_list", LinkedListFire1, LinkedListFire1Setup, LinkedListFire1Teardown);
+	Bench::Register("event.fire_8_linked_list", LinkedListFire8, LinkedListFire8Setup, LinkedListFire8Teardown);
+	Bench::Register("event.fire_64_linked_list", LinkedListFire64, LinkedListFire64Setup, LinkedListFire64Teardown);
+	Bench::Register("event.fire_64_linked_list_scattered", LinkedListFire64, LinkedListScatteredSetup,
+					LinkedListScatteredTeardown);
+	Bench::Register("event.fire_handled_first_of_8_linked_list", LinkedListFireHandled, LinkedListHandledSetup,
+					LinkedListHandledTeardown);
+	Bench::Register("event.fire_no_listeners_linked_list", LinkedListFireNoListeners);
+	Bench::Register("event.register_unregister_linked_list", LinkedListRegisterUnregister);
+
+	Bench::Register("event.post_dispatch", EventPostDispatch, QueuedSetup, QueuedTeardown);
+	Bench::Register("event.post_from_any_thread", EventPostFromAnyThread, QueuedSetup, QueuedTeardown);
+	Bench::Register("event_channel.fire_8", EventChannelFire8);
+
+	Bench::RegisterCheck("event.post_from_any_thread_16_producers", EventPostFromAnyThreadNoLoss);
+	Bench::RegisterCheck("event.register_unregister_while_firing", EventRegisterUnregisterWhileFiring);
+}
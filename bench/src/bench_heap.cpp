@@ -0,0 +1,339 @@
+#include "bench.h"
+
+#include "core/kiwi_mem.h"
+#include "containers/kheap.h"
+
+#include <stdio.h>
+#include <queue>
+#include <vector>
+
+// NOTE: The heaps are benchmarked at 1M elements, past the caches, as the
+// request queues and open sets that motivated them get
+#define BENCH_HEAP_SIZE (1 << 20)
+// NOTE: Keys start high so that the decrease-key benchmark never reaches 0
+#define BENCH_HEAP_KEY_BASE (1ULL << 62)
+#define BENCH_HEAP_CHECK_OPERATIONS 200000
+#define BENCH_HEAP_CHECK_MAX_HANDLES 4096
+
+local_var MemArena HeapArena;
+local_var KHeap<u64> BenchHeap;
+local_var KIndexedHeap<u64> BenchIndexedHeap;
+local_var std::priority_queue<u64, std::vector<u64>, std::greater<u64>> *ReferenceHeap;
+local_var u64 HeapRandomState = 1;
+
+// NOTE: xorshift64, the same sequence on every run and on every platform
+internal_func u64 HeapRandom()
+{
+	HeapRandomState ^= HeapRandomState << 13;
+	HeapRandomState ^= HeapRandomState >> 7;
+	HeapRandomState ^= HeapRandomState << 17;
+	return HeapRandomState;
+}
+
+internal_func u64 HeapRandomKey()
+{
+	return BENCH_HEAP_KEY_BASE + (HeapRandom() >> 24);
+}
+
+internal_func void HeapSetup()
+{
+	HeapRandomState = 1;
+	HeapArena.Allocate(MiB(1), MemTag_Game, MiB(256));
+	BenchHeap.Create(&HeapArena, BENCH_HEAP_SIZE * 2);
+	for (u32 Idx = 0; Idx < BENCH_HEAP_SIZE; ++Idx)
+	{
+		BenchHeap.Push(HeapRandomKey());
+	}
+}
+
+internal_func void HeapTeardown()
+{
+	BenchHeap = {};
+	HeapArena.Free();
+	HeapArena = {};
+}
+
+internal_func void IndexedHeapSetup()
+{
+	HeapRandomState = 1;
+	HeapArena.Allocate(MiB(1), MemTag_Game, MiB(256));
+	BenchIndexedHeap.Create(&HeapArena, BENCH_HEAP_SIZE * 2);
+	for (u32 Idx = 0; Idx < BENCH_HEAP_SIZE; ++Idx)
+	{
+		BenchIndexedHeap.Push(HeapRandomKey());
+	}
+}
+
+internal_func void IndexedHeapTeardown()
+{
+	BenchIndexedHeap = {};
+	HeapArena.Free();
+	HeapArena = {};
+}
+
+internal_func void ReferenceHeapSetup()
+{
+	HeapRandomState = 1;
+	ReferenceHeap = new std::priority_queue<u64, std::vector<u64>, std::greater<u64>>();
+	for (u32 Idx = 0; Idx < BENCH_HEAP_SIZE; ++Idx)
+	{
+		ReferenceHeap->push(HeapRandomKey());
+	}
+}
+
+internal_func void ReferenceHeapTeardown()
+{
+	delete ReferenceHeap;
+	ReferenceHeap = nullptr;
+}
+
+// NOTE: A push and a pop per operation, the heap stays at 1M elements.
+// std::priority_queue is the reference the two heaps are compared against
+internal_func BENCH_FUNCTION(HeapPushPop)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		u64 Top = 0;
+		BenchHeap.Push(HeapRandomKey());
+		BenchHeap.Pop(Top);
+		Result += Top;
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(IndexedHeapPushPop)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		u64 Top = 0;
+		BenchIndexedHeap.Push(HeapRandomKey());
+		BenchIndexedHeap.Pop(Top);
+		Result += Top;
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(ReferenceHeapPushPop)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		ReferenceHeap->push(HeapRandomKey());
+		Result += ReferenceHeap->top();
+		ReferenceHeap->pop();
+	}
+	return Result;
+}
+
+// NOTE: The handles of the setup are 0..BENCH_HEAP_SIZE - 1, and the push
+// and pop pairs give the popped handle right back, so any of them is valid
+internal_func BENCH_FUNCTION(IndexedHeapDecreaseKey)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		u32 Handle = (u32)(HeapRandom() & (BENCH_HEAP_SIZE - 1));
+		u64 Key = *BenchIndexedHeap.Get(Handle);
+		Key -= Min(Key, HeapRandom() & 0xFFFF);
+		Result += BenchIndexedHeap.DecreaseKey(Handle, Key);
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(IndexedHeapUpdate)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		u32 Handle = (u32)(HeapRandom() & (BENCH_HEAP_SIZE - 1));
+		Result += BenchIndexedHeap.Update(Handle, HeapRandomKey());
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(IndexedHeapRemovePush)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		u32 Handle = (u32)(HeapRandom() & (BENCH_HEAP_SIZE - 1));
+		BenchIndexedHeap.Remove(Handle);
+		Result += BenchIndexedHeap.Push(HeapRandomKey());
+	}
+	return Result;
+}
+
+/*
+NOTE: Random operations on the heaps next to a reference: std::priority_queue
+for KHeap, and a plain array of keys indexed by handle for KIndexedHeap,
+where the minimum is found by scanning. Only the keys are compared, equal
+keys can come out in any order. The keys are small so that there are ties.
+*/
+internal_func BENCH_CHECK(HeapMatchesReference)
+{
+	HeapRandomState = 7;
+	MemArena Arena = {};
+	Arena.Allocate(MiB(1), MemTag_Game, MiB(64));
+	KHeap<u64> Heap = {};
+	Heap.Create(&Arena);
+	std::priority_queue<u64, std::vector<u64>, std::greater<u64>> Reference;
+
+	b8 Passed = true;
+	for (u32 Op = 0; Op < BENCH_HEAP_CHECK_OPERATIONS && Passed; ++Op)
+	{
+		// NOTE: Slightly more pushes than pops, the heap grows and shrinks
+		if (HeapRandom() % 100 < 55 || Reference.empty())
+		{
+			u64 Key = HeapRandom() % 1000;
+			Heap.Push(Key);
+			Reference.push(Key);
+		}
+		else
+		{
+			u64 Top = 0;
+			Passed = Heap.Pop(Top) && Top == Reference.top();
+			if (!Passed)
+			{
+				printf("KHeap: operation %u popped %llu, expected %llu\n", Op, Top, Reference.top());
+			}
+			Reference.pop();
+		}
+		Passed = Passed && Heap.Count() == Reference.size();
+	}
+
+	while (Passed && !Reference.empty())
+	{
+		u64 Top = 0;
+		Passed = Heap.Pop(Top) && Top == Reference.top();
+		Reference.pop();
+	}
+	Passed = Passed && Heap.IsEmpty();
+
+	Heap = {};
+	Arena.Free();
+	return Passed;
+}
+
+internal_func b8 ReferenceMin(const u64 *Keys, const b8 *Alive, u32 HandleCount, u64 &OutKey)
+{
+	b8 Found = false;
+	for (u32 Handle = 0; Handle < HandleCount; ++Handle)
+	{
+		if (Alive[Handle] && (!Found || Keys[Handle] < OutKey))
+		{
+			OutKey = Keys[Handle];
+			Found = true;
+		}
+	}
+	return Found;
+}
+
+internal_func BENCH_CHECK(IndexedHeapMatchesReference)
+{
+	HeapRandomState = 11;
+	MemArena Arena = {};
+	Arena.Allocate(MiB(1), MemTag_Game, MiB(64));
+	KIndexedHeap<u64> Heap = {};
+	Heap.Create(&Arena);
+
+	u64 Keys[BENCH_HEAP_CHECK_MAX_HANDLES] = {};
+	b8 Alive[BENCH_HEAP_CHECK_MAX_HANDLES] = {};
+	u32 HandleCount = 0;
+	u64 AliveCount = 0;
+
+	b8 Passed = true;
+	for (u32 Op = 0; Op < BENCH_HEAP_CHECK_OPERATIONS && Passed; ++Op)
+	{
+		u32 Handle = HandleCount ? (u32)(HeapRandom() % HandleCount) : 0;
+		b8 HandleAlive = HandleCount && Alive[Handle];
+		u64 Key = HeapRandom() % 1000;
+		u32 Kind = (u32)(HeapRandom() % 100);
+
+		if (Kind < 35 || AliveCount == 0)
+		{
+			u32 NewHandle = Heap.Push(Key);
+			// NOTE: The handles are reused, they never go past the most ever in the heap at once
+			if (NewHandle >= BENCH_HEAP_CHECK_MAX_HANDLES || (NewHandle < HandleCount && Alive[NewHandle]))
+			{
+				printf("KIndexedHeap: operation %u pushed into handle %u, which is taken\n", Op, NewHandle);
+				Passed = false;
+				break;
+			}
+			HandleCount = Max(HandleCount, NewHandle + 1);
+			Keys[NewHandle] = Key;
+			Alive[NewHandle] = true;
+			++AliveCount;
+		}
+		else if (Kind < 60)
+		{
+			u64 Top = 0;
+			u32 TopHandle = KHEAP_INVALID_HANDLE;
+			u64 Expected = 0;
+			ReferenceMin(Keys, Alive, HandleCount, Expected);
+			Passed = Heap.Pop(Top, &TopHandle) && Top == Expected && TopHandle < HandleCount &&
+					 Alive[TopHandle] && Keys[TopHandle] == Top;
+			if (!Passed)
+			{
+				printf("KIndexedHeap: operation %u popped %llu (handle %u), expected %llu\n", Op, Top, TopHandle,
+					   Expected);
+				break;
+			}
+			Alive[TopHandle] = false;
+			--AliveCount;
+		}
+		else if (!HandleAlive)
+		{
+			Passed = !Heap.Contains(Handle);
+		}
+		else if (Kind < 75)
+		{
+			u64 Decreased = Keys[Handle] - Min(Keys[Handle], HeapRandom() % 100);
+			Passed = Heap.DecreaseKey(Handle, Decreased);
+			Keys[Handle] = Decreased;
+		}
+		else if (Kind < 90)
+		{
+			Passed = Heap.Update(Handle, Key);
+			Keys[Handle] = Key;
+		}
+		else
+		{
+			Passed = Heap.Remove(Handle);
+			Alive[Handle] = false;
+			--AliveCount;
+		}
+
+		u64 Expected = 0;
+		b8 HasMin = ReferenceMin(Keys, Alive, HandleCount, Expected);
+		Passed = Passed && Heap.Count() == AliveCount && (HasMin ? *Heap.Peek() == Expected : !Heap.Peek());
+		if (!Passed)
+		{
+			printf("KIndexedHeap: mismatch after operation %u\n", Op);
+		}
+	}
+
+	for (u32 Handle = 0; Handle < HandleCount && Passed; ++Handle)
+	{
+		Passed = Heap.Contains(Handle) == Alive[Handle] && (!Alive[Handle] || *Heap.Get(Handle) == Keys[Handle]);
+	}
+
+	Heap = {};
+	Arena.Free();
+	return Passed;
+}
+
+void RegisterHeapBenchmarks()
+{
+	Bench::Register("kheap.push_pop_1m", HeapPushPop, HeapSetup, HeapTeardown);
+	Bench::Register("kindexed_heap.push_pop_1m", IndexedHeapPushPop, IndexedHeapSetup, IndexedHeapTeardown);
+	Bench::Register("std_priority_queue.push_pop_1m", ReferenceHeapPushPop, ReferenceHeapSetup,
+					ReferenceHeapTeardown);
+	Bench::Register("kindexed_heap.decrease_key_1m", IndexedHeapDecreaseKey, IndexedHeapSetup, IndexedHeapTeardown);
+	Bench::Register("kindexed_heap.update_1m", IndexedHeapUpdate, IndexedHeapSetup, IndexedHeapTeardown);
+	Bench::Register("kindexed_heap.remove_push_1m", IndexedHeapRemovePush, IndexedHeapSetup, IndexedHeapTeardown);
+
+	Bench::RegisterCheck("kheap.matches_priority_queue", HeapMatchesReference);
+	Bench::RegisterCheck("kindexed_heap.matches_reference", IndexedHeapMatchesReference);
+}
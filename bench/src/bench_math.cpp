@@ -0,0 +1,158 @@
+#include "bench.h"
+
+#include "core/kiwi_mem.h"
+#include "math/kmath.h"
+
+// NOTE: Small enough to stay in L1, the operations are measured, not the memory
+#define BENCH_VECTOR_COUNT 1024
+
+local_var Vec3 Vectors3[BENCH_VECTOR_COUNT];
+local_var Vec4 Vectors4[BENCH_VECTOR_COUNT];
+
+// NOTE: Same values every run, so the results are comparable
+internal_func void VectorsSetup()
+{
+	for (u32 Idx = 0; Idx < BENCH_VECTOR_COUNT; ++Idx)
+	{
+		f32 Value = (f32)(Idx + 1);
+		Vectors3[Idx] = Vec3(Value, Value * 0.5f, 1.0f / Value);
+		Vectors4[Idx] = Vec4(Value, Value * 0.5f, 1.0f / Value, -Value);
+	}
+}
+
+// NOTE: The results are folded into a float sum, returned as its bits
+KIWI_INLINE u64 FloatResult(f32 Value)
+{
+	u32 Bits;
+	MemSystem::Copy(&Bits, &Value, sizeof(Bits));
+	return Bits;
+}
+
+internal_func BENCH_FUNCTION(Vec3Add)
+{
+	Vec3 Sum(0.0f);
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Sum += Vectors3[Idx & (BENCH_VECTOR_COUNT - 1)];
+	}
+	return FloatResult(Sum.x + Sum.y + Sum.z);
+}
+
+internal_func BENCH_FUNCTION(Vec3Scale)
+{
+	Vec3 Sum(0.0f);
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Sum += Vectors3[Idx & (BENCH_VECTOR_COUNT - 1)] * 0.5f;
+	}
+	return FloatResult(Sum.x + Sum.y + Sum.z);
+}
+
+internal_func BENCH_FUNCTION(Vec3Dot)
+{
+	f32 Sum = 0.0f;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Vec3 A = Vectors3[Idx & (BENCH_VECTOR_COUNT - 1)];
+		Sum += A.Dot(Vectors3[(Idx + 1) & (BENCH_VECTOR_COUNT - 1)]);
+	}
+	return FloatResult(Sum);
+}
+
+internal_func BENCH_FUNCTION(Vec3Cross)
+{
+	Vec3 Sum(0.0f);
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Vec3 A = Vectors3[Idx & (BENCH_VECTOR_COUNT - 1)];
+		Sum += A.Cross(Vectors3[(Idx + 1) & (BENCH_VECTOR_COUNT - 1)]);
+	}
+	return FloatResult(Sum.x + Sum.y + Sum.z);
+}
+
+internal_func BENCH_FUNCTION(Vec3Length)
+{
+	f32 Sum = 0.0f;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Sum += Vectors3[Idx & (BENCH_VECTOR_COUNT - 1)].Length();
+	}
+	return FloatResult(Sum);
+}
+
+internal_func BENCH_FUNCTION(Vec3Normalized)
+{
+	Vec3 Sum(0.0f);
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Sum += Vectors3[Idx & (BENCH_VECTOR_COUNT - 1)].Normalized();
+	}
+	return FloatResult(Sum.x + Sum.y + Sum.z);
+}
+
+internal_func BENCH_FUNCTION(Vec3Distance)
+{
+	f32 Sum = 0.0f;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Vec3 A = Vectors3[Idx & (BENCH_VECTOR_COUNT - 1)];
+		Sum += A.Distance(Vectors3[(Idx + 1) & (BENCH_VECTOR_COUNT - 1)]);
+	}
+	return FloatResult(Sum);
+}
+
+internal_func BENCH_FUNCTION(Vec4Add)
+{
+	Vec4 Sum(0.0f);
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Sum += Vectors4[Idx & (BENCH_VECTOR_COUNT - 1)];
+	}
+	return FloatResult(Sum.x + Sum.y + Sum.z + Sum.w);
+}
+
+internal_func BENCH_FUNCTION(Vec4Dot)
+{
+	f32 Sum = 0.0f;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Vec4 A = Vectors4[Idx & (BENCH_VECTOR_COUNT - 1)];
+		Sum += A.Dot(Vectors4[(Idx + 1) & (BENCH_VECTOR_COUNT - 1)]);
+	}
+	return FloatResult(Sum);
+}
+
+internal_func BENCH_FUNCTION(Vec4Normalized)
+{
+	Vec4 Sum(0.0f);
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Sum += Vectors4[Idx & (BENCH_VECTOR_COUNT - 1)].Normalized();
+	}
+	return FloatResult(Sum.x + Sum.y + Sum.z + Sum.w);
+}
+
+internal_func BENCH_FUNCTION(ScalarSqrt)
+{
+	f32 Sum = 0.0f;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Sum += KSqrt(Vectors3[Idx & (BENCH_VECTOR_COUNT - 1)].x);
+	}
+	return FloatResult(Sum);
+}
+
+void RegisterMathBenchmarks()
+{
+	Bench::Register("vec3.add", Vec3Add, VectorsSetup);
+	Bench::Register("vec3.scale", Vec3Scale, VectorsSetup);
+	Bench::Register("vec3.dot", Vec3Dot, VectorsSetup);
+	Bench::Register("vec3.cross", Vec3Cross, VectorsSetup);
+	Bench::Register("vec3.length", Vec3Length, VectorsSetup);
+	Bench::Register("vec3.normalized", Vec3Normalized, VectorsSetup);
+	Bench::Register("vec3.distance", Vec3Distance, VectorsSetup);
+	Bench::Register("vec4.add", Vec4Add, VectorsSetup);
+	Bench::Register("vec4.dot", Vec4Dot, VectorsSetup);
+	Bench::Register("vec4.normalized", Vec4Normalized, VectorsSetup);
+	Bench::Register("kmath.sqrt", ScalarSqrt, VectorsSetup);
+}
@@ -0,0 +1,438 @@
+#include "bench.h"
+
+#include "core/kiwi_mem.h"
+#include "core/kiwi_string.h"
+#include "containers/karray.h"
+#include "containers/klinked_list.h"
+
+#include <string.h>
+
+// NOTE: Elements of the containers benchmarks, a small struct as the engine mostly stores
+struct BenchElement
+{
+	u64 Key;
+	u64 Value;
+};
+
+// NOTE: KArray::Contains compares with ==
+KIWI_INLINE b8 operator==(BenchElement A, BenchElement B)
+{
+	return A.Key == B.Key && A.Value == B.Value;
+}
+
+#define BENCH_ARRAY_SIZE 1024
+#define BENCH_LIST_SIZE 64
+#define BENCH_STRING_SIZE 4096
+
+// NOTE: There is no game in the benchmarks, they use its tag
+local_var MemArena BenchArena;
+local_var KArray<BenchElement> BenchArray;
+local_var KLinkedList<BenchElement> BenchList;
+local_var char BenchString[BENCH_STRING_SIZE];
+local_var char BenchStringCopy[BENCH_STRING_SIZE];
+
+internal_func void ArenaSetup()
+{
+	BenchArena.Allocate(MiB(1), MemTag_Game, MiB(64));
+}
+
+internal_func void ArenaTeardown()
+{
+	BenchArena.Free();
+	BenchArena = {};
+}
+
+internal_func void ArenaClear()
+{
+	BenchArena.Clear();
+}
+
+// NOTE: Push and Pop in pairs, the arena stays in its committed pages
+internal_func BENCH_FUNCTION(ArenaPushPop)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		void *Memory = BenchArena.Push(64);
+		BenchClobber(Memory);
+		Result += (u64)Memory;
+		BenchArena.Pop(64);
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(ArenaPushNoZeroPop)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		void *Memory = BenchArena.PushNoZero(64);
+		BenchClobber(Memory);
+		Result += (u64)Memory;
+		BenchArena.Pop(64);
+	}
+	return Result;
+}
+
+// NOTE: Growing pushes, the arena commits new pages along the way.
+// BatchEnd clears it, so the commits only happen in the first batches
+internal_func BENCH_FUNCTION(ArenaPushAligned)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		void *Memory = BenchArena.PushAligned(24, 16);
+		BenchClobber(Memory);
+		Result += (u64)Memory;
+	}
+	return Result;
+}
+
+internal_func void ArraySetup()
+{
+	BenchArena.Allocate(MiB(1), MemTag_Game, MiB(64));
+	BenchArray.Create(&BenchArena, BENCH_ARRAY_SIZE);
+	for (u64 Idx = 0; Idx < BENCH_ARRAY_SIZE; ++Idx)
+	{
+		BenchArray.Push({Idx, Idx * 3});
+	}
+}
+
+internal_func void ArrayTeardown()
+{
+	BenchArray = {};
+	ArenaTeardown();
+}
+
+// NOTE: A fresh array every batch grows from the default capacity,
+// so the resizes are part of the measure
+internal_func BENCH_FUNCTION(ArrayPushGrow)
+{
+	u64 Result = 0;
+	u64 Remaining = Iterations;
+	while (Remaining)
+	{
+		KArray<BenchElement> Array = {};
+		Array.Create(&BenchArena);
+		u64 Count = Min(Remaining, (u64)BENCH_ARRAY_SIZE);
+		for (u64 Idx = 0; Idx < Count; ++Idx)
+		{
+			Array.Push({Idx, Idx});
+		}
+		Result += Array.Length;
+		Remaining -= Count;
+		BenchArena.Clear();
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(ArrayPushPop)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchArray.Push({Idx, Idx});
+		Result += BenchArray.Pop()->Key;
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(ArrayGet)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Result += BenchArray.Get(Idx & (BENCH_ARRAY_SIZE - 1))->Value;
+	}
+	return Result;
+}
+
+// NOTE: In the middle, half of the array moves every time
+internal_func BENCH_FUNCTION(ArrayInsertRemove)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchArray.InsertAt({Idx, Idx}, BENCH_ARRAY_SIZE / 2);
+		Result += BenchArray.RemoveAt(BENCH_ARRAY_SIZE / 2)->Key;
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(ArrayContains)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		// NOTE: Not in the array, every element gets compared
+		Result += BenchArray.Contains({Idx + BENCH_ARRAY_SIZE, 0});
+	}
+	return Result;
+}
+
+internal_func void ListSetup()
+{
+	BenchList.Create(MemTag_Game);
+	for (u64 Idx = 0; Idx < BENCH_LIST_SIZE; ++Idx)
+	{
+		BenchList.Add({Idx, Idx});
+	}
+}
+
+internal_func void ListTeardown()
+{
+	BenchList.Destroy();
+}
+
+// NOTE: Removing the node just added is the best case, it's the first one
+internal_func BENCH_FUNCTION(ListAddRemoveFirst)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchElement *Element = BenchList.Add({Idx, Idx});
+		Result += Element->Key;
+		BenchList.Remove((KLinkedList<BenchElement>::Node *)Element);
+	}
+	return Result;
+}
+
+// NOTE: The worst case, the oldest node is at the end of the list
+internal_func BENCH_FUNCTION(ListRemoveLast)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		KLinkedList<BenchElement>::Node *Last = BenchList.FirstNode;
+		while (Last->Next)
+		{
+			Last = Last->Next;
+		}
+		Result += Last->Element.Key;
+		BenchList.Remove(Last);
+		BenchList.Add({Idx, Idx});
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(ListClearRefill)
+{
+	u64 Result = 0;
+	u64 Remaining = Iterations;
+	while (Remaining)
+	{
+		BenchList.Clear();
+		u64 Count = Min(Remaining, (u64)BENCH_LIST_SIZE);
+		for (u64 Idx = 0; Idx < Count; ++Idx)
+		{
+			BenchList.Add({Idx, Idx});
+		}
+		Result += BenchList.NodeCount;
+		Remaining -= Count;
+	}
+	return Result;
+}
+
+// NOTE: A string with no match for the searches, they go through all of it
+internal_func void StringSetup()
+{
+	for (u32 Idx = 0; Idx < BENCH_STRING_SIZE - 1; ++Idx)
+	{
+		BenchString[Idx] = (char)('a' + Idx % 23);
+	}
+	BenchString[BENCH_STRING_SIZE - 1] = '\0';
+	MemSystem::Copy(BenchStringCopy, BenchString, BENCH_STRING_SIZE);
+}
+
+// NOTE: The libc versions are the reference the KStr ones are compared against
+internal_func BENCH_FUNCTION(StrLength)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchClobber(BenchString);
+		Result += KStr::Length(BenchString);
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(StrLengthLibc)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchClobber(BenchString);
+		Result += strlen(BenchString);
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(StrEqual)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchClobber(BenchString);
+		Result += KStr::Equal(BenchString, BenchStringCopy);
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(StrEqualLibc)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchClobber(BenchString);
+		Result += strcmp(BenchString, BenchStringCopy) == 0;
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(StrFindChar)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchClobber(BenchString);
+		Result += KStr::FindChar(BenchString, 'z');
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(StrFindCharLibc)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchClobber(BenchString);
+		Result += (u64)strchr(BenchString, 'z');
+	}
+	return Result;
+}
+
+// NOTE: The length known versions, against memcmp/memchr
+internal_func BENCH_FUNCTION(StrEqualView)
+{
+	u64 Result = 0;
+	KStrView A = {BENCH_STRING_SIZE - 1, BenchString};
+	KStrView B = {BENCH_STRING_SIZE - 1, BenchStringCopy};
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchClobber(BenchString);
+		Result += KStr::Equal(A, B);
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(StrEqualViewLibc)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchClobber(BenchString);
+		Result += memcmp(BenchString, BenchStringCopy, BENCH_STRING_SIZE - 1) == 0;
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(StrFindCharView)
+{
+	u64 Result = 0;
+	KStrView Str = {BENCH_STRING_SIZE - 1, BenchString};
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchClobber(BenchString);
+		Result += KStr::FindChar(Str, 'z');
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(StrFindCharViewLibc)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchClobber(BenchString);
+		Result += (u64)memchr(BenchString, 'z', BENCH_STRING_SIZE - 1);
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(StrFindSubstring)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchClobber(BenchString);
+		Result += KStr::FindSubstring(BenchString, "abcz");
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(StrFindSubstringLibc)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchClobber(BenchString);
+		Result += (u64)strstr(BenchString, "abcz");
+	}
+	return Result;
+}
+
+internal_func BENCH_FUNCTION(StrFastHash)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchClobber(BenchString);
+		Result += KStr::FastHash(BenchString, BENCH_STRING_SIZE - 1);
+	}
+	return Result;
+}
+
+// NOTE: Short strings, the size of most names in the engine
+internal_func BENCH_FUNCTION(StrFastHashShort)
+{
+	u64 Result = 0;
+	for (u64 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		BenchClobber(BenchString);
+		Result += KStr::FastHash(BenchString, 16);
+	}
+	return Result;
+}
+
+void RegisterMemoryBenchmarks()
+{
+	Bench::Register("arena.push_pop_64", ArenaPushPop, ArenaSetup, ArenaTeardown);
+	Bench::Register("arena.push_no_zero_pop_64", ArenaPushNoZeroPop, ArenaSetup, ArenaTeardown);
+	// NOTE: 40 bytes with the padding, 64MiB hold ~1.6M of them
+	Bench::Register("arena.push_aligned_24", ArenaPushAligned, ArenaSetup, ArenaTeardown, ArenaClear, 1000000);
+
+	Bench::Register("karray.push_grow", ArrayPushGrow, ArenaSetup, ArenaTeardown);
+	Bench::Register("karray.push_pop", ArrayPushPop, ArraySetup, ArrayTeardown);
+	Bench::Register("karray.get", ArrayGet, ArraySetup, ArrayTeardown);
+	Bench::Register("karray.insert_remove_mid_1k", ArrayInsertRemove, ArraySetup, ArrayTeardown);
+	Bench::Register("karray.contains_miss_1k", ArrayContains, ArraySetup, ArrayTeardown);
+
+	Bench::Register("klist.add_remove_first", ListAddRemoveFirst, ListSetup, ListTeardown);
+	Bench::Register("klist.remove_last_64", ListRemoveLast, ListSetup, ListTeardown);
+	Bench::Register("klist.clear_refill", ListClearRefill, ListSetup, ListTeardown);
+
+	Bench::Register("kstr.length_4k", StrLength, StringSetup);
+	Bench::Register("libc.strlen_4k", StrLengthLibc, StringSetup);
+	Bench::Register("kstr.equal_4k", StrEqual, StringSetup);
+	Bench::Register("libc.strcmp_4k", StrEqualLibc, StringSetup);
+	Bench::Register("kstr.find_char_4k", StrFindChar, StringSetup);
+	Bench::Register("libc.strchr_4k", StrFindCharLibc, StringSetup);
+	Bench::Register("kstr.equal_view_4k", StrEqualView, StringSetup);
+	Bench::Register("libc.memcmp_4k", StrEqualViewLibc, StringSetup);
+	Bench::Register("kstr.find_char_view_4k", StrFindCharView, StringSetup);
+	Bench::Register("libc.memchr_4k", StrFindCharViewLibc, StringSetup);
+	Bench::Register("kstr.find_substring_4k", StrFindSubstring, StringSetup);
+	Bench::Register("libc.strstr_4k", StrFindSubstringLibc, StringSetup);
+	Bench::Register("kstr.fast_hash_4k", StrFastHash, StringSetup);
+	Bench::Register("kstr.fast_hash_16", StrFastHashShort, StringSetup);
+}
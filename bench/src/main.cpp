@@ -0,0 +1,163 @@
+#include "bench.h"
+
+#include "core/clock.h"
+#include "core/event.h"
+#include "core/kiwi_mem.h"
+#include "core/kiwi_string.h"
+#include "core/logger.h"
+#include "core/metrics.h"
+#include "core/profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+NOTE: Usage: bench [options]
+	--filter <text>       only the benchmarks whose name contains text
+	--reps <count>        timed repetitions per benchmark
+	--min-time-ms <ms>    minimum time of a batch
+	--warmup-ms <ms>      time spent warming up every benchmark
+	--out <file>          write the results, a JSON object per line
+	--baseline <file>     compare the medians with the ones of a previous --out
+	--threshold <pct>     slowdown that counts as a regression
+	--check               run the correctness checks instead of the benchmarks
+	--list                print the benchmark and check names
+Exit code 1 when something regressed or a check failed, 2 on errors: good
+enough for a build gate.
+*/
+
+#define BENCH_EXIT_REGRESSION 1
+#define BENCH_EXIT_CHECK_FAILED 1
+#define BENCH_EXIT_ERROR 2
+
+local_var BenchResult Results[BENCH_MAX_COUNT];
+
+internal_func void PrintUsage()
+{
+	printf("Usage: bench [--filter <text>] [--reps <count>] [--min-time-ms <ms>] [--warmup-ms <ms>]\n"
+		   "             [--out <file>] [--baseline <file>] [--threshold <pct, default %.0f>] [--check] [--list]\n",
+		   BENCH_DEFAULT_THRESHOLD);
+}
+
+int main(int ArgCount, char **Args)
+{
+	BenchOptions Options = {};
+	Options.Repetitions = BENCH_DEFAULT_REPETITIONS;
+	Options.MinBatchMS = BENCH_DEFAULT_MIN_BATCH_MS;
+	Options.WarmupMS = BENCH_DEFAULT_WARMUP_MS;
+	const char *OutPath = nullptr;
+	const char *BaselinePath = nullptr;
+	f64 Threshold = BENCH_DEFAULT_THRESHOLD;
+	b8 ListOnly = false;
+	b8 ChecksOnly = false;
+
+	for (int Idx = 1; Idx < ArgCount; ++Idx)
+	{
+		const char *Arg = Args[Idx];
+		b8 HasValue = Idx + 1 < ArgCount;
+		if (KStr::Equal(Arg, "--list"))
+		{
+			ListOnly = true;
+		}
+		else if (KStr::Equal(Arg, "--check"))
+		{
+			ChecksOnly = true;
+		}
+		else if (HasValue && KStr::Equal(Arg, "--filter"))
+		{
+			Options.Filter = Args[++Idx];
+		}
+		else if (HasValue && KStr::Equal(Arg, "--reps"))
+		{
+			Options.Repetitions = (u32)strtoul(Args[++Idx], nullptr, 10);
+		}
+		else if (HasValue && KStr::Equal(Arg, "--min-time-ms"))
+		{
+			Options.MinBatchMS = strtod(Args[++Idx], nullptr);
+		}
+		else if (HasValue && KStr::Equal(Arg, "--warmup-ms"))
+		{
+			Options.WarmupMS = strtod(Args[++Idx], nullptr);
+		}
+		else if (HasValue && KStr::Equal(Arg, "--out"))
+		{
+			OutPath = Args[++Idx];
+		}
+		else if (HasValue && KStr::Equal(Arg, "--baseline"))
+		{
+			BaselinePath = Args[++Idx];
+		}
+		else if (HasValue && KStr::Equal(Arg, "--threshold"))
+		{
+			Threshold = strtod(Args[++Idx], nullptr);
+		}
+		else
+		{
+			PrintUsage();
+			return BENCH_EXIT_ERROR;
+		}
+	}
+
+	// NOTE: Registering only needs the arenas. --list stops right after it,
+	// before the systems that print a report when they terminate
+	MemSystem::Initialize();
+	RegisterMemoryBenchmarks();
+	RegisterHeapBenchmarks();
+	RegisterEventBenchmarks();
+	RegisterMathBenchmarks();
+	RegisterEngineBenchmarks();
+
+	if (ListOnly)
+	{
+		Bench::List();
+		return 0;
+	}
+
+	// NOTE: The engine systems the benchmarks go through, same order as Application
+	Clock::Initialize();
+	Logger::Initialize();
+	EventSystem::Initialize();
+	Metrics::Initialize(nullptr, METRICS_DEFAULT_INTERVAL);
+	Profiler::Initialize();
+
+	int ExitCode = 0;
+	if (ChecksOnly)
+	{
+		u32 Failures = Bench::RunChecks(Options.Filter);
+		if (Failures)
+		{
+			printf("\n%u checks failed\n", Failures);
+			ExitCode = BENCH_EXIT_CHECK_FAILED;
+		}
+	}
+	else
+	{
+		u32 ResultCount = Bench::RunAll(Options, Results);
+		Bench::Print(Results, ResultCount);
+
+		if (OutPath && !Bench::WriteJSON(OutPath, Results, ResultCount))
+		{
+			printf("Could not write the results to %s\n", OutPath);
+			ExitCode = BENCH_EXIT_ERROR;
+		}
+
+		u32 Regressions = 0;
+		if (BaselinePath && !Bench::Compare(BaselinePath, Results, ResultCount, Threshold, Regressions))
+		{
+			printf("Could not read the baseline %s\n", BaselinePath);
+			ExitCode = BENCH_EXIT_ERROR;
+		}
+		else if (Regressions)
+		{
+			printf("\n%u benchmarks regressed by more than %.1f%%\n", Regressions, Threshold);
+			ExitCode = ExitCode ? ExitCode : BENCH_EXIT_REGRESSION;
+		}
+	}
+
+	Metrics::Terminate();
+	Profiler::Terminate();
+	EventSystem::Terminate();
+	Clock::Terminate();
+	Logger::Terminate();
+	return ExitCode;
+}
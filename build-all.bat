@@ -20,4 +20,14 @@ call build.bat
 popd
 if %errorlevel% neq 0 (echo Error:%errorlevel% && exit)
 
+pushd tools\logdump
+call build.bat
+popd
+if %errorlevel% neq 0 (echo Error:%errorlevel% && exit)
+
+pushd bench
+call build.bat
+popd
+if %errorlevel% neq 0 (echo Error:%errorlevel% && exit)
+
 echo "Build finished successfully! YAY"
\ No newline at end of file
@@ -17,7 +17,7 @@ set Defines=/DKIWI_SLOW /DKIWI_ENGINE_EXPORTS
 :: set IgnoredWarnings=/wd4201 /wd4505 /wd4820
 :: set AdditionalWarnings=/w14820
 set WarningsOptions=/W4 /WX %AdditionalWarnings% %ignoredWarnings%
-set Libraries=user32.lib winmm.lib %VULKAN_SDK%\Lib\vulkan-1.lib
+set Libraries=user32.lib winmm.lib dbghelp.lib %VULKAN_SDK%\Lib\vulkan-1.lib
 
 set CompilerFlags=/nologo /MTd /fp:fast /GR- /Od /Oi /FC /Zi /LD /permissive- %IncludeFolders% %Defines% %WarningsOptions%
 set LinkerFlags=/nologo /incremental:no /opt:ref /WX %Libraries%
@@ -0,0 +1,21 @@
+#!/bin/bash
+# NOTE: Linux build of the engine. There is no window on Linux yet, so no Vulkan
+# either: the renderer/vulkan sources are left out and only headless runs work
+set -e
+
+mkdir -p ../bin
+UnityBuild=../bin/engine_unity_build.cpp
+: > $UnityBuild
+
+for File in $(find src -name "*.cpp" -not -path "src/renderer/vulkan/*" | sort); do
+	echo "#include \"$(realpath $File)\"" >> $UnityBuild
+done
+
+Assembly=libengine.so
+IncludeFolders="-Isrc"
+Defines="-DKIWI_SLOW -DKIWI_ENGINE_EXPORTS"
+WarningsOptions="-Wall -Werror -Wno-unused-function -Wno-unused-parameter -Wno-unused-variable -Wno-missing-braces"
+CompilerFlags="-std=c++14 -g -O0 -fno-rtti -fPIC -shared -pthread $IncludeFolders $Defines $WarningsOptions"
+Libraries="-ldl"
+
+g++ $CompilerFlags $UnityBuild -o ../bin/$Assembly $Libraries
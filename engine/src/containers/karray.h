@@ -30,17 +30,11 @@ is in reverse creation order.
 #include "defines.h"
 #include "core/kiwi_mem.h"
 #include "core/logger.h"
+#include "core/metrics.h"
 
 #define KARRAY_RESIZE_FACTOR 2
 #define KARRAY_DEFAULT_INIT_CAPACITY 4
 
-/*
-TODO: Given the note above, this variable is for monitoring
-how many times the arrays "naturally" resize.
-This will determine how and if the array implementation will be modified.
-*/
-static u64 ResizeCount = 0;
-
 // TODO: Do we need shrinking?
 template <typename T>
 class KIWI_API KArray
@@ -88,7 +82,10 @@ public:
 		Capacity = NewSize;
 		Elements = (T *)NewBlock;
 
-		++ResizeCount;
+		// TODO: Given the note above, karray.resizes is for monitoring how many
+		// times the arrays "naturally" resize. This will determine how and if
+		// the array implementation will be modified.
+		Metrics::Add(Metric_KArrayResizes, 1);
 	}
 
 	void Clear()
@@ -0,0 +1,430 @@
+#pragma once
+
+/*
+NOTE: Dense bit sets.
+KBitSet<N> is the fixed size version that lives inline wherever it is
+declared (input state, visibility masks, component masks...) while
+KBitArray is the arena backed one for when the number of bits is only
+known at runtime.
+
+Both store the bits in u64 words padded to a multiple of a 256 bit block,
+so the set operations always run on full SIMD registers without a scalar
+tail loop. The padding bits are always kept at zero, that's what allows
+Count(), Any() and FindNextSet() to simply walk every word.
+*/
+
+#include "defines.h"
+#include "core/kiwi_mem.h"
+#include "core/logger.h"
+
+#include <immintrin.h>
+
+// NOTE: SSE2 is always available on x64, AVX2 only if the compiler
+// has been told it can use it (/arch:AVX2)
+#if defined(__AVX2__)
+#define KBITS_AVX2
+#endif
+
+#define KBITS_WORD_BITS 64
+#define KBITS_BLOCK_WORDS 4
+#define KBITS_NOT_FOUND ((u64)-1)
+
+#define KBitsWordCount(BitCount) \
+	((((BitCount) + (KBITS_WORD_BITS * KBITS_BLOCK_WORDS) - 1) / (KBITS_WORD_BITS * KBITS_BLOCK_WORDS)) * KBITS_BLOCK_WORDS)
+
+// NOTE: Word-wise operators used as template arguments by KBits::Combine.
+// Each one has a scalar and a SIMD version of the same operation.
+struct KBitsAnd
+{
+	static KIWI_INLINE u64 Apply(u64 A, u64 B) { return A & B; }
+	static KIWI_INLINE __m128i Apply(__m128i A, __m128i B) { return _mm_and_si128(A, B); }
+#ifdef KBITS_AVX2
+	static KIWI_INLINE __m256i Apply(__m256i A, __m256i B) { return _mm256_and_si256(A, B); }
+#endif
+};
+
+struct KBitsOr
+{
+	static KIWI_INLINE u64 Apply(u64 A, u64 B) { return A | B; }
+	static KIWI_INLINE __m128i Apply(__m128i A, __m128i B) { return _mm_or_si128(A, B); }
+#ifdef KBITS_AVX2
+	static KIWI_INLINE __m256i Apply(__m256i A, __m256i B) { return _mm256_or_si256(A, B); }
+#endif
+};
+
+struct KBitsXor
+{
+	static KIWI_INLINE u64 Apply(u64 A, u64 B) { return A ^ B; }
+	static KIWI_INLINE __m128i Apply(__m128i A, __m128i B) { return _mm_xor_si128(A, B); }
+#ifdef KBITS_AVX2
+	static KIWI_INLINE __m256i Apply(__m256i A, __m256i B) { return _mm256_xor_si256(A, B); }
+#endif
+};
+
+// NOTE: A & ~B. Be careful, the intrinsic negates its FIRST operand
+struct KBitsAndNot
+{
+	static KIWI_INLINE u64 Apply(u64 A, u64 B) { return A & ~B; }
+	static KIWI_INLINE __m128i Apply(__m128i A, __m128i B) { return _mm_andnot_si128(B, A); }
+#ifdef KBITS_AVX2
+	static KIWI_INLINE __m256i Apply(__m256i A, __m256i B) { return _mm256_andnot_si256(B, A); }
+#endif
+};
+
+namespace KBits
+{
+	// NOTE: WordCount must be a multiple of KBITS_BLOCK_WORDS.
+	// Dest is allowed to alias A and/or B.
+	template <typename Op>
+	KIWI_INLINE void Combine(u64 *Dest, const u64 *A, const u64 *B, u64 WordCount)
+	{
+		for (u64 Idx = 0; Idx < WordCount; Idx += KBITS_BLOCK_WORDS)
+		{
+#ifdef KBITS_AVX2
+			__m256i VA = _mm256_loadu_si256((const __m256i *)(A + Idx));
+			__m256i VB = _mm256_loadu_si256((const __m256i *)(B + Idx));
+			_mm256_storeu_si256((__m256i *)(Dest + Idx), Op::Apply(VA, VB));
+#else
+			__m128i VA0 = _mm_loadu_si128((const __m128i *)(A + Idx));
+			__m128i VA1 = _mm_loadu_si128((const __m128i *)(A + Idx + 2));
+			__m128i VB0 = _mm_loadu_si128((const __m128i *)(B + Idx));
+			__m128i VB1 = _mm_loadu_si128((const __m128i *)(B + Idx + 2));
+			_mm_storeu_si128((__m128i *)(Dest + Idx), Op::Apply(VA0, VB0));
+			_mm_storeu_si128((__m128i *)(Dest + Idx + 2), Op::Apply(VA1, VB1));
+#endif
+		}
+	}
+
+	KIWI_INLINE b8 Any(const u64 *Words, u64 WordCount)
+	{
+#ifdef KBITS_AVX2
+		__m256i Accumulator = _mm256_setzero_si256();
+		for (u64 Idx = 0; Idx < WordCount; Idx += KBITS_BLOCK_WORDS)
+		{
+			Accumulator = _mm256_or_si256(Accumulator, _mm256_loadu_si256((const __m256i *)(Words + Idx)));
+		}
+		return !_mm256_testz_si256(Accumulator, Accumulator);
+#else
+		__m128i Accumulator = _mm_setzero_si128();
+		for (u64 Idx = 0; Idx < WordCount; Idx += KBITS_BLOCK_WORDS)
+		{
+			Accumulator = _mm_or_si128(Accumulator, _mm_loadu_si128((const __m128i *)(Words + Idx)));
+			Accumulator = _mm_or_si128(Accumulator, _mm_loadu_si128((const __m128i *)(Words + Idx + 2)));
+		}
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(Accumulator, _mm_setzero_si128())) != 0xFFFF;
+#endif
+	}
+
+	KIWI_INLINE b8 Equal(const u64 *A, const u64 *B, u64 WordCount)
+	{
+		__m128i Difference = _mm_setzero_si128();
+		for (u64 Idx = 0; Idx < WordCount; Idx += 2)
+		{
+			__m128i VA = _mm_loadu_si128((const __m128i *)(A + Idx));
+			__m128i VB = _mm_loadu_si128((const __m128i *)(B + Idx));
+			Difference = _mm_or_si128(Difference, _mm_xor_si128(VA, VB));
+		}
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(Difference, _mm_setzero_si128())) == 0xFFFF;
+	}
+
+	// NOTE: There is no vector popcount before AVX-512, the scalar
+	// POPCNT is one instruction per word and pipelines very well anyway
+	KIWI_INLINE u64 Count(const u64 *Words, u64 WordCount)
+	{
+		u64 Result = 0;
+		for (u64 Idx = 0; Idx < WordCount; ++Idx)
+		{
+			Result += PopCount64(Words[Idx]);
+		}
+		return Result;
+	}
+
+	// NOTE: Returns the index of the first set bit at or after From,
+	// KBITS_NOT_FOUND if there is none
+	KIWI_INLINE u64 FindNextSet(const u64 *Words, u64 WordCount, u64 From)
+	{
+		u64 WordIdx = From / KBITS_WORD_BITS;
+		if (WordIdx >= WordCount)
+		{
+			return KBITS_NOT_FOUND;
+		}
+
+		// Mask out the bits before From in the first word
+		u64 Word = Words[WordIdx] & (~0ull << (From % KBITS_WORD_BITS));
+		while (!Word)
+		{
+			if (++WordIdx == WordCount)
+			{
+				return KBITS_NOT_FOUND;
+			}
+			Word = Words[WordIdx];
+		}
+
+		return WordIdx * KBITS_WORD_BITS + FindFirstSet64(Word);
+	}
+
+	// NOTE: Sets the first BitCount bits leaving the padding untouched (zeroed)
+	KIWI_INLINE void Fill(u64 *Words, u64 WordCount, u64 BitCount)
+	{
+		u64 FullWords = BitCount / KBITS_WORD_BITS;
+		u64 RemainingBits = BitCount % KBITS_WORD_BITS;
+		for (u64 Idx = 0; Idx < WordCount; ++Idx)
+		{
+			if (Idx < FullWords)
+				Words[Idx] = ~0ull;
+			else if (Idx == FullWords && RemainingBits)
+				Words[Idx] = (1ull << RemainingBits) - 1;
+			else
+				Words[Idx] = 0;
+		}
+	}
+}
+
+template <u64 N>
+class KIWI_API KBitSet
+{
+public:
+	static const u64 WordCount = KBitsWordCount(N);
+
+	void Set(u64 Index)
+	{
+		Assert(Index < N);
+		Words[Index / KBITS_WORD_BITS] |= (1ull << (Index % KBITS_WORD_BITS));
+	}
+
+	void Clear(u64 Index)
+	{
+		Assert(Index < N);
+		Words[Index / KBITS_WORD_BITS] &= ~(1ull << (Index % KBITS_WORD_BITS));
+	}
+
+	void Toggle(u64 Index)
+	{
+		Assert(Index < N);
+		Words[Index / KBITS_WORD_BITS] ^= (1ull << (Index % KBITS_WORD_BITS));
+	}
+
+	void Assign(u64 Index, b8 Value)
+	{
+		Assert(Index < N);
+		u64 Mask = 1ull << (Index % KBITS_WORD_BITS);
+		u64 &Word = Words[Index / KBITS_WORD_BITS];
+		Word = (Word & ~Mask) | (Value ? Mask : 0);
+	}
+
+	b8 Test(u64 Index) const
+	{
+		Assert(Index < N);
+		return (b8)((Words[Index / KBITS_WORD_BITS] >> (Index % KBITS_WORD_BITS)) & 1);
+	}
+
+	void SetAll() { KBits::Fill(Words, WordCount, N); }
+
+	void ClearAll()
+	{
+		for (u64 Idx = 0; Idx < WordCount; ++Idx)
+		{
+			Words[Idx] = 0;
+		}
+	}
+
+	u64 Count() const { return KBits::Count(Words, WordCount); }
+	b8 Any() const { return KBits::Any(Words, WordCount); }
+	b8 None() const { return !KBits::Any(Words, WordCount); }
+
+	// NOTE: Iterate over the set bits with:
+	// for (u64 Bit = Set.FindFirstSet(); Bit != KBITS_NOT_FOUND; Bit = Set.FindNextSet(Bit + 1))
+	u64 FindFirstSet() const { return KBits::FindNextSet(Words, WordCount, 0); }
+	u64 FindNextSet(u64 From) const { return KBits::FindNextSet(Words, WordCount, From); }
+
+	static u64 Size() { return N; }
+
+	// Set operations
+	KBitSet AndNot(const KBitSet &Other) const
+	{
+		KBitSet Result;
+		KBits::Combine<KBitsAndNot>(Result.Words, Words, Other.Words, WordCount);
+		return Result;
+	}
+
+	u64 Words[WordCount] = {};
+
+	// Operators overload
+public:
+	KBitSet operator&(const KBitSet &Other) const
+	{
+		KBitSet Result;
+		KBits::Combine<KBitsAnd>(Result.Words, Words, Other.Words, WordCount);
+		return Result;
+	}
+
+	KBitSet operator|(const KBitSet &Other) const
+	{
+		KBitSet Result;
+		KBits::Combine<KBitsOr>(Result.Words, Words, Other.Words, WordCount);
+		return Result;
+	}
+
+	KBitSet operator^(const KBitSet &Other) const
+	{
+		KBitSet Result;
+		KBits::Combine<KBitsXor>(Result.Words, Words, Other.Words, WordCount);
+		return Result;
+	}
+
+	KBitSet &operator&=(const KBitSet &Other)
+	{
+		KBits::Combine<KBitsAnd>(Words, Words, Other.Words, WordCount);
+		return *this;
+	}
+
+	KBitSet &operator|=(const KBitSet &Other)
+	{
+		KBits::Combine<KBitsOr>(Words, Words, Other.Words, WordCount);
+		return *this;
+	}
+
+	KBitSet &operator^=(const KBitSet &Other)
+	{
+		KBits::Combine<KBitsXor>(Words, Words, Other.Words, WordCount);
+		return *this;
+	}
+
+	b8 operator==(const KBitSet &Other) const { return KBits::Equal(Words, Other.Words, WordCount); }
+	b8 operator!=(const KBitSet &Other) const { return !KBits::Equal(Words, Other.Words, WordCount); }
+};
+
+class KIWI_API KBitArray
+{
+public:
+	void Create(MemArena *InArena, u64 InBitCount)
+	{
+		if (WordCount > 0)
+		{
+			KDebugBreak();
+			LogWarning("Attempting to create the KBitArray twice!");
+		}
+
+		Arena = InArena;
+		BitCount = InBitCount;
+		WordCount = KBitsWordCount(BitCount);
+		Words = (u64 *)Arena->Push(WordCount * sizeof(u64));
+	}
+
+	void Destroy()
+	{
+		// NOTE: Same as KArray, whoever calls this knows that it pops the arena as well
+		Arena->Pop(WordCount * sizeof(u64));
+		BitCount = 0;
+		WordCount = 0;
+		Words = nullptr;
+	}
+
+	// NOTE: The new bits are cleared. Like KArray the old block is not
+	// given back to the arena, see the note at the top of karray.h
+	void Resize(u64 NewBitCount)
+	{
+		if (NewBitCount <= BitCount)
+		{
+			KDebugBreak();
+			LogWarning("Trying to resize the bit array to a smaller (or equal) value than the actual size.");
+			return;
+		}
+
+		u64 NewWordCount = KBitsWordCount(NewBitCount);
+		if (NewWordCount > WordCount)
+		{
+			u64 *NewWords = (u64 *)Arena->Push(NewWordCount * sizeof(u64));
+			MemSystem::Copy(NewWords, Words, WordCount * sizeof(u64));
+			Words = NewWords;
+			WordCount = NewWordCount;
+		}
+		BitCount = NewBitCount;
+	}
+
+	void Set(u64 Index)
+	{
+		Assert(Index < BitCount);
+		Words[Index / KBITS_WORD_BITS] |= (1ull << (Index % KBITS_WORD_BITS));
+	}
+
+	void Clear(u64 Index)
+	{
+		Assert(Index < BitCount);
+		Words[Index / KBITS_WORD_BITS] &= ~(1ull << (Index % KBITS_WORD_BITS));
+	}
+
+	void Toggle(u64 Index)
+	{
+		Assert(Index < BitCount);
+		Words[Index / KBITS_WORD_BITS] ^= (1ull << (Index % KBITS_WORD_BITS));
+	}
+
+	void Assign(u64 Index, b8 Value)
+	{
+		Assert(Index < BitCount);
+		u64 Mask = 1ull << (Index % KBITS_WORD_BITS);
+		u64 &Word = Words[Index / KBITS_WORD_BITS];
+		Word = (Word & ~Mask) | (Value ? Mask : 0);
+	}
+
+	b8 Test(u64 Index) const
+	{
+		Assert(Index < BitCount);
+		return (b8)((Words[Index / KBITS_WORD_BITS] >> (Index % KBITS_WORD_BITS)) & 1);
+	}
+
+	void SetAll() { KBits::Fill(Words, WordCount, BitCount); }
+	void ClearAll() { MemSystem::Zero(Words, WordCount * sizeof(u64)); }
+
+	u64 Count() const { return KBits::Count(Words, WordCount); }
+	b8 Any() const { return KBits::Any(Words, WordCount); }
+	b8 None() const { return !KBits::Any(Words, WordCount); }
+
+	u64 FindFirstSet() const { return KBits::FindNextSet(Words, WordCount, 0); }
+	u64 FindNextSet(u64 From) const { return KBits::FindNextSet(Words, WordCount, From); }
+
+	// In-place set operations.
+	// NOTE: Both arrays must have the same BitCount, the same word count isn't
+	// enough: the padding bits of the smaller one would end up set
+	void And(const KBitArray &Other)
+	{
+		AssertMsg(BitCount == Other.BitCount, "KBitArray size mismatch");
+		KBits::Combine<KBitsAnd>(Words, Words, Other.Words, WordCount);
+	}
+
+	void Or(const KBitArray &Other)
+	{
+		AssertMsg(BitCount == Other.BitCount, "KBitArray size mismatch");
+		KBits::Combine<KBitsOr>(Words, Words, Other.Words, WordCount);
+	}
+
+	void Xor(const KBitArray &Other)
+	{
+		AssertMsg(BitCount == Other.BitCount, "KBitArray size mismatch");
+		KBits::Combine<KBitsXor>(Words, Words, Other.Words, WordCount);
+	}
+
+	void AndNot(const KBitArray &Other)
+	{
+		AssertMsg(BitCount == Other.BitCount, "KBitArray size mismatch");
+		KBits::Combine<KBitsAndNot>(Words, Words, Other.Words, WordCount);
+	}
+
+	void CopyFrom(const KBitArray &Other)
+	{
+		AssertMsg(BitCount == Other.BitCount, "KBitArray size mismatch");
+		MemSystem::Copy(Words, Other.Words, WordCount * sizeof(u64));
+	}
+
+	b8 Equal(const KBitArray &Other) const
+	{
+		return BitCount == Other.BitCount && KBits::Equal(Words, Other.Words, WordCount);
+	}
+
+	MemArena *Arena = nullptr;
+
+	u64 BitCount = 0;
+	u64 WordCount = 0;
+	u64 *Words = nullptr;
+};
@@ -0,0 +1,368 @@
+#pragma once
+
+/*
+NOTE: Priority queues.
+KHeap is a plain binary heap on top of a KArray, good for timers and
+streaming requests where elements are only pushed and popped.
+KIndexedHeap is a d-ary heap where every pushed element gets a handle
+that stays valid until the element leaves the heap. The handle can be
+used to change the priority of an element in place (decrease-key for
+A* open sets) or remove it without searching for it.
+
+Both are min-heaps with the default comparator: the element for which
+Compare(A, B) is true against every other one sits on top.
+Since they are built on KArray the same arena considerations apply,
+see the note at the top of karray.h
+*/
+
+#include "defines.h"
+#include "containers/karray.h"
+
+#define KHEAP_DEFAULT_INIT_CAPACITY 64
+#define KHEAP_INVALID_HANDLE ((u32)-1)
+
+template <typename T>
+struct KHeapLess
+{
+	KIWI_INLINE b8 operator()(const T &A, const T &B) const { return A < B; }
+};
+
+template <typename T>
+struct KHeapGreater
+{
+	KIWI_INLINE b8 operator()(const T &A, const T &B) const { return B < A; }
+};
+
+template <typename T, typename Compare = KHeapLess<T>>
+class KIWI_API KHeap
+{
+public:
+	void Create(MemArena *InArena = nullptr, u64 InitialCapacity = KHEAP_DEFAULT_INIT_CAPACITY)
+	{
+		Elements.Create(InArena, InitialCapacity);
+	}
+
+	void Destroy()
+	{
+		Elements.Destroy();
+	}
+
+	void Clear()
+	{
+		Elements.Clear();
+	}
+
+	u64 Count() const { return Elements.Length; }
+	b8 IsEmpty() const { return Elements.Length == 0; }
+
+	T *Peek()
+	{
+		return Elements.Length ? Elements.Elements : nullptr;
+	}
+
+	void Push(T Element)
+	{
+		// NOTE: KArray takes care of the growth, then we sift the
+		// new element up moving the parents down instead of swapping
+		Elements.Push(Element);
+
+		T *Data = Elements.Elements;
+		u64 Idx = Elements.Length - 1;
+		while (Idx > 0)
+		{
+			u64 Parent = (Idx - 1) >> 1;
+			if (!Cmp(Element, Data[Parent]))
+			{
+				break;
+			}
+			Data[Idx] = Data[Parent];
+			Idx = Parent;
+		}
+		Data[Idx] = Element;
+	}
+
+	b8 Pop(T &OutElement)
+	{
+		if (Elements.Length == 0)
+		{
+			return false;
+		}
+
+		T *Data = Elements.Elements;
+		OutElement = Data[0];
+
+		u64 Length = --Elements.Length;
+		if (Length == 0)
+		{
+			return true;
+		}
+
+		// Sift the last element down from the root
+		T Last = Data[Length];
+		u64 Idx = 0;
+		for (;;)
+		{
+			u64 Child = (Idx << 1) + 1;
+			if (Child >= Length)
+			{
+				break;
+			}
+			if (Child + 1 < Length && Cmp(Data[Child + 1], Data[Child]))
+			{
+				++Child;
+			}
+			if (!Cmp(Data[Child], Last))
+			{
+				break;
+			}
+			Data[Idx] = Data[Child];
+			Idx = Child;
+		}
+		Data[Idx] = Last;
+
+		return true;
+	}
+
+	KArray<T> Elements;
+	Compare Cmp;
+};
+
+// NOTE: D = 4 is usually the sweet spot: the tree is half as deep as a
+// binary one and the 4 children of a node are contiguous in memory,
+// so a sift down touches far fewer cache lines.
+template <typename T, typename Compare = KHeapLess<T>, u32 D = 4>
+class KIWI_API KIndexedHeap
+{
+public:
+	struct Node
+	{
+		T Element;
+		u32 Handle;
+	};
+
+	void Create(MemArena *InArena = nullptr, u64 InitialCapacity = KHEAP_DEFAULT_INIT_CAPACITY)
+	{
+		StaticAssertMsg(D >= 2, "KIndexedHeap needs at least 2 children per node");
+		Nodes.Create(InArena, InitialCapacity);
+		Positions.Create(InArena, InitialCapacity);
+		FreeHandles.Create(InArena, KARRAY_DEFAULT_INIT_CAPACITY);
+	}
+
+	void Destroy()
+	{
+		// NOTE: Reverse creation order, see karray.h
+		FreeHandles.Destroy();
+		Positions.Destroy();
+		Nodes.Destroy();
+	}
+
+	void Clear()
+	{
+		Nodes.Clear();
+		Positions.Clear();
+		FreeHandles.Clear();
+	}
+
+	u64 Count() const { return Nodes.Length; }
+	b8 IsEmpty() const { return Nodes.Length == 0; }
+
+	b8 Contains(u32 Handle) const
+	{
+		return Handle < Positions.Length && Positions.Elements[Handle] != KHEAP_INVALID_HANDLE;
+	}
+
+	T *Peek()
+	{
+		return Nodes.Length ? &Nodes.Elements[0].Element : nullptr;
+	}
+
+	T *Get(u32 Handle)
+	{
+		if (!Contains(Handle))
+		{
+			LogWarning("Invalid handle %u in KIndexedHeap::Get", Handle);
+			return nullptr;
+		}
+		return &Nodes.Elements[Positions.Elements[Handle]].Element;
+	}
+
+	// NOTE: The returned handle stays valid until the element is popped or removed
+	u32 Push(T Element)
+	{
+		u32 Handle;
+		if (FreeHandles.Length)
+		{
+			Handle = *FreeHandles.Pop();
+		}
+		else
+		{
+			Handle = (u32)Positions.Length;
+			Positions.Push(KHEAP_INVALID_HANDLE);
+		}
+
+		Node NewNode;
+		NewNode.Element = Element;
+		NewNode.Handle = Handle;
+		Nodes.Push(NewNode);
+
+		SiftUp(Nodes.Length - 1, NewNode);
+		return Handle;
+	}
+
+	b8 Pop(T &OutElement, u32 *OutHandle = nullptr)
+	{
+		if (Nodes.Length == 0)
+		{
+			return false;
+		}
+
+		Node Top = Nodes.Elements[0];
+		OutElement = Top.Element;
+		if (OutHandle)
+		{
+			*OutHandle = Top.Handle;
+		}
+
+		RemoveAt(0);
+		return true;
+	}
+
+	b8 Remove(u32 Handle)
+	{
+		if (!Contains(Handle))
+		{
+			LogWarning("Invalid handle %u in KIndexedHeap::Remove", Handle);
+			return false;
+		}
+
+		RemoveAt(Positions.Elements[Handle]);
+		return true;
+	}
+
+	// NOTE: Works in both directions, DecreaseKey is just the common case
+	b8 Update(u32 Handle, T NewElement)
+	{
+		if (!Contains(Handle))
+		{
+			LogWarning("Invalid handle %u in KIndexedHeap::Update", Handle);
+			return false;
+		}
+
+		u64 Idx = Positions.Elements[Handle];
+		Node UpdatedNode = {NewElement, Handle};
+		if (Cmp(NewElement, Nodes.Elements[Idx].Element))
+		{
+			SiftUp(Idx, UpdatedNode);
+		}
+		else
+		{
+			SiftDown(Idx, UpdatedNode);
+		}
+		return true;
+	}
+
+	b8 DecreaseKey(u32 Handle, T NewElement)
+	{
+		if (!Contains(Handle))
+		{
+			LogWarning("Invalid handle %u in KIndexedHeap::DecreaseKey", Handle);
+			return false;
+		}
+
+		// NOTE: Sifting a larger key up would break the heap order silently,
+		// outside of KIWI_SLOW it goes down instead, like Update
+		u64 Idx = Positions.Elements[Handle];
+		Node UpdatedNode = {NewElement, Handle};
+		if (Cmp(Nodes.Elements[Idx].Element, NewElement))
+		{
+			AssertMsg(false, "KIndexedHeap::DecreaseKey with a key that didn't decrease, use Update");
+			SiftDown(Idx, UpdatedNode);
+			return true;
+		}
+
+		SiftUp(Idx, UpdatedNode);
+		return true;
+	}
+
+	KArray<Node> Nodes;
+	// NOTE: Handle -> position in Nodes, KHEAP_INVALID_HANDLE if not in the heap
+	KArray<u32> Positions;
+	KArray<u32> FreeHandles;
+	Compare Cmp;
+
+private:
+	void Place(u64 Idx, const Node &InNode)
+	{
+		Nodes.Elements[Idx] = InNode;
+		Positions.Elements[InNode.Handle] = (u32)Idx;
+	}
+
+	void SiftUp(u64 Idx, Node InNode)
+	{
+		while (Idx > 0)
+		{
+			u64 Parent = (Idx - 1) / D;
+			if (!Cmp(InNode.Element, Nodes.Elements[Parent].Element))
+			{
+				break;
+			}
+			Place(Idx, Nodes.Elements[Parent]);
+			Idx = Parent;
+		}
+		Place(Idx, InNode);
+	}
+
+	void SiftDown(u64 Idx, Node InNode)
+	{
+		u64 Length = Nodes.Length;
+		for (;;)
+		{
+			u64 FirstChild = Idx * D + 1;
+			if (FirstChild >= Length)
+			{
+				break;
+			}
+
+			u64 LastChild = Min(FirstChild + D, Length);
+			u64 Best = FirstChild;
+			for (u64 Child = FirstChild + 1; Child < LastChild; ++Child)
+			{
+				if (Cmp(Nodes.Elements[Child].Element, Nodes.Elements[Best].Element))
+				{
+					Best = Child;
+				}
+			}
+
+			if (!Cmp(Nodes.Elements[Best].Element, InNode.Element))
+			{
+				break;
+			}
+			Place(Idx, Nodes.Elements[Best]);
+			Idx = Best;
+		}
+		Place(Idx, InNode);
+	}
+
+	void RemoveAt(u64 Idx)
+	{
+		u32 Handle = Nodes.Elements[Idx].Handle;
+		Positions.Elements[Handle] = KHEAP_INVALID_HANDLE;
+		FreeHandles.Push(Handle);
+
+		Node Last = *Nodes.Pop();
+		if (Idx == Nodes.Length)
+		{
+			return;
+		}
+
+		// NOTE: The last node can belong anywhere relative to the hole
+		if (Idx > 0 && Cmp(Last.Element, Nodes.Elements[(Idx - 1) / D].Element))
+		{
+			SiftUp(Idx, Last);
+		}
+		else
+		{
+			SiftDown(Idx, Last);
+		}
+	}
+};
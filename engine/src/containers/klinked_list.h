@@ -27,6 +27,7 @@ public:
 		FreeNode = nullptr;
 		FirstNode = nullptr;
 		NodeCount = 0;
+		FreeNodeCount = 0;
 	}
 
 	void Clear()
@@ -1,9 +1,21 @@
 #include "application.h"
 #include "core/logger.h"
+#include "core/clock.h"
+#include "core/log_crash_ring.h"
+#include "core/profiler.h"
+#include "core/trace_writer.h"
+#include "core/sample_profiler.h"
+#include "core/frame_pacer.h"
+#include "core/frame_stats.h"
+#include "core/metrics.h"
 #include "game_types.h"
 #include "core/kiwi_mem.h"
 #include "core/input.h"
+#include "core/event_channel.h"
+#include "core/event_recorder.h"
 #include "core/timer.h"
+#include "core/fixed_timestep.h"
+#include "core/string_interner.h"
 #include "renderer/renderer_frontend.h"
 
 Application *Application::Instance = nullptr;
@@ -24,7 +36,17 @@ b8 Application::Create(Game *GameInstance)
 	Instance->GameInstance = GameInstance;
 
 	// Initialize Subsystems
+	Clock::Initialize();
 	Logger::Initialize();
+	if (GameInstance->AppConfig.CrashLogPath)
+	{
+		LogCrashRing::Open(GameInstance->AppConfig.CrashLogPath);
+	}
+	if (!StringInterner::Initialize())
+	{
+		LogFatal("String interner failed to initialize");
+		return false;
+	}
 	if (!EventSystem::Initialize())
 	{
 		LogFatal("Event system failed to initialize");
@@ -43,14 +65,34 @@ b8 Application::Create(Game *GameInstance)
 
 	// Startup the platform with the informations inside the game instance
 	ApplicationConfig *AppConfig = &Instance->GameInstance->AppConfig;
-	if (!Platform::Startup(&Instance->PlatformState, AppConfig->Name,
-						   AppConfig->PosX, AppConfig->PosY, AppConfig->Width, AppConfig->Height))
+	if (AppConfig->Headless)
+	{
+		if (!Platform::StartupHeadless(&Instance->PlatformState))
+		{
+			return false;
+		}
+	}
+	else if (!Platform::Startup(&Instance->PlatformState, AppConfig->Name,
+								AppConfig->PosX, AppConfig->PosY, AppConfig->Width, AppConfig->Height))
 	{
 		return false;
 	}
 
+	FramePacer::Initialize(AppConfig->TargetFrameRate);
+	FrameStats::Initialize();
+	Metrics::Initialize(AppConfig->MetricsPath, AppConfig->MetricsInterval);
+
+	Profiler::Initialize(AppConfig->PerfCounters);
+	TraceWriter::Initialize(AppConfig->TraceBaseName ? AppConfig->TraceBaseName : TRACE_DEFAULT_BASE_NAME,
+							AppConfig->TraceSeconds > 0.0f ? AppConfig->TraceSeconds : TRACE_DEFAULT_SECONDS,
+							AppConfig->TraceSpikeMS);
+	SampleProfiler::RegisterThread("Main thread");
+	SampleProfiler::Initialize(AppConfig->SampleRate, AppConfig->SamplePath ? AppConfig->SamplePath : SAMPLE_DEFAULT_PATH);
+
 	// NOTE: Initialize Renderer after the Platform in order to have a valid PlatformState
-	if (!Renderer::Initialize(AppConfig->Name, AppConfig->Width, AppConfig->Height, &Instance->PlatformState))
+	RendererBackendType RendererType = AppConfig->Headless ? RendererBackendType_Null : RendererBackendType_Vulkan;
+	if (!Renderer::Initialize(RendererType, AppConfig->Name, AppConfig->Width, AppConfig->Height,
+							  &Instance->PlatformState))
 	{
 		LogFatal("Failed to initialize the Renderer");
 		return false;
@@ -65,25 +107,91 @@ b8 Application::Create(Game *GameInstance)
 
 	Instance->GameInstance->OnResize(Instance->GameInstance, Instance->Width, Instance->Height);
 
+	if (AppConfig->ReplayPath)
+	{
+		if (!EventRecorder::StartReplay(AppConfig->ReplayPath))
+		{
+			LogFatal("Could not replay %s", AppConfig->ReplayPath);
+			return false;
+		}
+	}
+	else if (AppConfig->RecordPath)
+	{
+		// NOTE: Not being able to record is not a reason to stop the game
+		EventRecorder::StartRecording(AppConfig->RecordPath);
+	}
+
 	return true;
 }
 
 b8 Application::Run()
 {
 	// Time management init
-	f64 TargetFrameTime = 1.0 / 60.0;
 	Timer ApplicationClock;
 	ApplicationClock.Start();
 	ApplicationClock.Update();
 	f64 LastFrameTime = ApplicationClock.UpdatedTime;
 
-	LogInfo("%s", MemSystem::Report());
+	{
+		AutoFreeArena ScratchArenaHandle = AutoFreeArena(MemTag_Scratch);
+		LogInfo("%s", MemSystem::Report(ScratchArenaHandle.Arena));
+	}
+
+	// NOTE: Replays run uncapped, with the recorded delta times,
+	// and report how long the frames actually took
+	b8 IsReplaying = EventRecorder::IsReplaying();
+	f32 ReplayDeltaTime = 0.0f;
+	u32 FrameIndex = 0;
+	u32 ReplayedFrames = 0;
+	f64 ReplayFrameTimeSum = 0.0;
+	f64 ReplayFrameTimeMin = 1e9;
+	f64 ReplayFrameTimeMax = 0.0;
+
+	// NOTE: Without a fixed update rate Update runs once per frame with the frame time
+	ApplicationConfig *AppConfig = &Instance->GameInstance->AppConfig;
+	b8 IsFixedTimestep = AppConfig->FixedUpdateRate > 0.0f;
+	FixedTimestep Simulation = {};
+	if (IsFixedTimestep)
+	{
+		Simulation.Start(AppConfig->FixedUpdateRate, AppConfig->MaxUpdatesPerFrame);
+	}
+
+	// NOTE: Headless runs go as fast as they can, the throughput is what they measure
+	b8 IsUncapped = IsReplaying || AppConfig->Headless;
+
+	// NOTE: A frame, for the stats, goes from the end of the previous one to the end of this one
+	u64 FrameStartTime = Clock::Now();
+	u64 RunStartTime = FrameStartTime;
+	Profiler::BeginFrames();
 
 	while (Instance->IsRunning)
 	{
-		if (!Platform::ProcessMessageQueue(&Instance->PlatformState))
+		if (IsReplaying)
 		{
-			Instance->IsRunning = false;
+			KIWI_PROFILE_SCOPE("EventRecorder::ReplayFrame");
+			if (!EventRecorder::ReplayFrame(ReplayDeltaTime))
+			{
+				Instance->IsRunning = false;
+				break;
+			}
+		}
+		else
+		{
+			KIWI_PROFILE_SCOPE("Platform::ProcessMessageQueue");
+			EventRecorder::BeginCapture();
+			if (!Platform::ProcessMessageQueue(&Instance->PlatformState))
+			{
+				Instance->IsRunning = false;
+			}
+			EventRecorder::EndCapture();
+		}
+
+		// NOTE: Fire what the platform and the input system posted while
+		// processing the messages. This happens even while suspended,
+		// since the resize that ends the suspension is one of these.
+		{
+			KIWI_PROFILE_SCOPE("EventSystem::DispatchQueued");
+			EventSystem::DispatchQueued();
 		}
 
 		if (!Instance->IsSuspended)
@@ -92,60 +200,139 @@ b8 Application::Run()
 			ApplicationClock.Update();
 			f64 DeltaTime = (ApplicationClock.UpdatedTime - LastFrameTime);
 			LastFrameTime = ApplicationClock.UpdatedTime;
+			if (IsReplaying)
+			{
+				DeltaTime = ReplayDeltaTime;
+			}
+			EventRecorder::EndFrame(FrameIndex, (f32)DeltaTime, false);
 			// LogDebug("Delta Time: %fms", DeltaTime * 1000);
 
-			if (!Instance->GameInstance->Update(Instance->GameInstance, (f32)DeltaTime))
+			u64 UpdateStartTime = Clock::Now();
+			u32 UpdateCount = 1;
+			f32 UpdateDeltaTime = (f32)DeltaTime;
+			f32 Alpha = 1.0f;
+			if (IsFixedTimestep)
 			{
-				LogFatal("Game update failed, shutting down");
-				Instance->IsRunning = false;
+				UpdateCount = Simulation.Advance(DeltaTime);
+				UpdateDeltaTime = (f32)Simulation.Step;
+				Alpha = Simulation.GetAlpha();
 			}
 
-			if (!Instance->GameInstance->Render(Instance->GameInstance, (f32)DeltaTime))
+			for (u32 UpdateIdx = 0; UpdateIdx < UpdateCount; ++UpdateIdx)
 			{
-				LogFatal("Game render failed, shutting down");
-				Instance->IsRunning = false;
+				KIWI_PROFILE_SCOPE("Game::Update");
+				if (!Instance->GameInstance->Update(Instance->GameInstance, UpdateDeltaTime))
+				{
+					LogFatal("Game update failed, shutting down");
+					Instance->IsRunning = false;
+					break;
+				}
 			}
 
-			// TODO: temporary code! Refactor!
-			RenderPacket Packet;
-			Packet.DeltaTime = (f32)DeltaTime;
-			Renderer::DrawFrame(&Packet);
-
-			// calculate how much we have to sleep
-			f64 ActualFrameTime = Platform::GetAbsoluteTime() - LastFrameTime;
-			f64 RemainingFrameTimeMS = (TargetFrameTime - ActualFrameTime) * 1000.0;
-
-			// NOTE: Check for > 1.0 because we cannot sleep for fractional ms
-			if (RemainingFrameTimeMS > 1.0)
+			u64 RenderStartTime = Clock::Now();
 			{
-				// TODO: Hardcoded for now
-				b8 LimitFps = true;
-				if (LimitFps)
+				KIWI_PROFILE_SCOPE("Game::Render");
+				if (!Instance->GameInstance->Render(Instance->GameInstance, (f32)DeltaTime, Alpha))
 				{
-					Platform::SleepMS((u64)RemainingFrameTimeMS);
-					RemainingFrameTimeMS -= (u64)RemainingFrameTimeMS;
+					LogFatal("Game render failed, shutting down");
+					Instance->IsRunning = false;
 				}
 			}
-			else if (RemainingFrameTimeMS < 0.0)
+
+			{
+				KIWI_PROFILE_SCOPE("Renderer::DrawFrame");
+				// TODO: temporary code! Refactor!
+				RenderPacket Packet;
+				Packet.DeltaTime = (f32)DeltaTime;
+				Renderer::DrawFrame(&Packet);
+			}
+
+			u64 RenderEndTime = Clock::Now();
+			if (IsReplaying)
+			{
+				f64 ActualFrameTime = Platform::GetAbsoluteTime() - LastFrameTime;
+				++ReplayedFrames;
+				ReplayFrameTimeSum += ActualFrameTime;
+				ReplayFrameTimeMin = Min(ReplayFrameTimeMin, ActualFrameTime);
+				ReplayFrameTimeMax = Max(ReplayFrameTimeMax, ActualFrameTime);
+			}
+			if (!IsUncapped)
 			{
-				LogWarning("Frame missed. Remaining Frame Time: %f ms", RemainingFrameTimeMS);
+				FramePacer::Wait();
 			}
+			u64 SleepTime = Clock::Now() - RenderEndTime;
 
-			// NOTE: Spin-lock until frame time is reached
-			while (RemainingFrameTimeMS > 0.0)
 			{
-				ActualFrameTime = Platform::GetAbsoluteTime() - LastFrameTime;
-				RemainingFrameTimeMS = (TargetFrameTime - ActualFrameTime) * 1000.0;
+				KIWI_PROFILE_SCOPE("EndOfFrame");
+				// NOTE: Since the update function for the input swaps
+				// the previous/current states, we want to perform this
+				// at the end of the frame so that the game operates
+				// on fresh input provided by the OS
+				InputSystem::Update();
+
+				++FrameIndex;
+				if (AppConfig->FrameCount && FrameIndex >= AppConfig->FrameCount)
+				{
+					Instance->IsRunning = false;
+				}
+
+				// NOTE: Everything allocated on the frame arena lives until here,
+				// that includes the payloads posted to the event channels
+				EventChannels::DispatchPending();
+				MemSystem::GetArena(MemTag_Frame)->Clear();
 			}
 
-			// NOTE: Since the update function for the input swaps
-			// the previous/current states, we want to perform this
-			// at the end of the frame so that the game operates
-			// on fresh input provided by the OS
-			InputSystem::Update();
+			u64 FrameEndTime = Clock::Now();
+			u64 FrameTime = FrameEndTime - FrameStartTime;
+			FrameStats::Record(FrameStat_Frame, FrameTime);
+			FrameStats::Record(FrameStat_Cpu, FrameTime - SleepTime);
+			FrameStats::Record(FrameStat_Update, RenderStartTime - UpdateStartTime);
+			FrameStats::Record(FrameStat_Render, RenderEndTime - RenderStartTime);
+			FrameStats::Record(FrameStat_Sleep, SleepTime);
+			Metrics::Add(Metric_Frames, 1);
+			Metrics::Record(Metric_FrameTime, Clock::TicksToNS(FrameTime));
+			FrameStartTime = FrameEndTime;
 		}
+		else
+		{
+			EventRecorder::EndFrame(FrameIndex, 0.0f, true);
+			// NOTE: Nothing to draw, but no reason to spin on the message queue either
+			FramePacer::Wait();
+			// NOTE: Suspended frames stay out of the stats
+			FrameStartTime = Clock::Now();
+		}
+
+		// NOTE: Every scope of this frame is closed by now
+		Profiler::EndFrame();
+		TraceWriter::EndFrame();
+		SampleProfiler::EndFrame();
+		Metrics::EndFrame();
 	}
 
+	if (AppConfig->Headless && FrameIndex)
+	{
+		f64 RunSeconds = Clock::TicksToSeconds(Clock::Now() - RunStartTime);
+		LogInfo("Headless run: %u frames in %.3fs, %.1f fps (%.3fms per frame)", FrameIndex, RunSeconds,
+				FrameIndex / RunSeconds, RunSeconds / FrameIndex * 1000.0);
+	}
+	if (ReplayedFrames)
+	{
+		LogInfo("Replayed %u frames. Frame time avg: %.3fms, min: %.3fms, max: %.3fms", ReplayedFrames,
+				ReplayFrameTimeSum / ReplayedFrames * 1000.0, ReplayFrameTimeMin * 1000.0, ReplayFrameTimeMax * 1000.0);
+	}
+	if (IsFixedTimestep)
+	{
+		LogInfo("Fixed timestep at %.1fHz: %llu updates in %u frames, %.3fs dropped to keep up",
+				AppConfig->FixedUpdateRate, Simulation.StepCount, FrameIndex, Simulation.DroppedTime);
+	}
+	EventRecorder::Stop();
+	FramePacer::Terminate();
+	FrameStats::Terminate();
+	Metrics::Terminate();
+	TraceWriter::Terminate();
+	Profiler::Terminate();
+	SampleProfiler::Terminate();
+
 	// TODO: Check all the Terminate function to make sure
 	// we actually need to terminate these subsystems or
 	// we cand simply let the OS handle it for us
@@ -158,6 +345,11 @@ b8 Application::Run()
 	EventSystem::Terminate();
 	Renderer::Terminate();
 	Platform::Terminate(&Instance->PlatformState);
+	StringInterner::Terminate();
+	Clock::Terminate();
+	// NOTE: Last one, so that everything logged until here ends up in the file
+	Logger::Terminate();
+	LogCrashRing::Close();
 
 	return true;
 }
@@ -191,6 +383,11 @@ EVENT_FUNCTION(Application::HandleKey)
 			EventSystem::Fire(SEC_ApplicationQuit, nullptr, {});
 			return true;
 		}
+		if (KeyCode == Key_F9)
+		{
+			TraceWriter::RequestDump();
+			return true;
+		}
 	}
 	return false;
 }
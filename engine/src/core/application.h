@@ -14,6 +14,45 @@ struct ApplicationConfig
 	u16 PosY;
 	u16 Width;
 	u16 Height;
+
+	// NOTE: Optional, see core/event_recorder.h. Can be set from the
+	// command line with --record <path> and --replay <path>
+	const char *RecordPath = nullptr;
+	const char *ReplayPath = nullptr;
+	// NOTE: Optional, see core/log_crash_ring.h. Can be set from the
+	// command line with --crash-log <path>
+	const char *CrashLogPath = nullptr;
+	// NOTE: Optional, see core/trace_writer.h. Can be set from the command line with
+	// --trace <base name>, --trace-seconds <seconds> and --trace-spike <ms>
+	const char *TraceBaseName = nullptr;
+	f32 TraceSeconds = 0.0f;
+	f32 TraceSpikeMS = 0.0f;
+	// NOTE: See core/frame_pacer.h, 0 runs uncapped. Can be set from the command line with --fps <rate>
+	f32 TargetFrameRate = 60.0f;
+	// NOTE: Optional, see core/fixed_timestep.h. When set Update runs at this rate,
+	// as many times per frame as needed up to MaxUpdatesPerFrame, and Render gets
+	// the interpolation alpha. Can be set from the command line with --update-rate <hz>
+	f32 FixedUpdateRate = 0.0f;
+	u32 MaxUpdatesPerFrame = 5;
+	// NOTE: Optional, see core/sample_profiler.h. Samples per second, 0 is off. Can be set
+	// from the command line with --sample <hz> and --sample-output <path>
+	f32 SampleRate = 0.0f;
+	const char *SamplePath = nullptr;
+	// NOTE: See core/profiler.h, hardware counters in every profiler scope where the
+	// platform has them. Can be set from the command line with --perf-counters <0|1>
+	b8 PerfCounters = false;
+	// NOTE: Optional, see core/metrics.h. Snapshot file, .csv or JSON lines, and seconds
+	// between snapshots. Can be set from the command line with --metrics <path> and
+	// --metrics-interval <seconds>
+	const char *MetricsPath = nullptr;
+	f32 MetricsInterval = 1.0f;
+	// NOTE: No window and the null renderer backend, the frames run uncapped and the
+	// throughput is logged at the end. For load testing the game logic on machines
+	// without a display or a GPU
+	b8 Headless = false;
+	// NOTE: Frames to run before quitting, 0 runs until the application is closed.
+	// --headless <frames> sets both
+	u32 FrameCount = 0;
 };
 
 // NOTE: this is a singleton
@@ -35,7 +74,7 @@ private:
 	Game *GameInstance;
 	b8 IsRunning = false;
 	b8 IsSuspended = false;
-	PlatformState PlatformState;
+	::PlatformState PlatformState;
 	u16 Width;
 	u16 Height;
 };
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "clock.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+
+ClockInfo Clock::Info = {};
+f64 Clock::SecondsPerTick = 0.0;
+f64 Clock::SecondsPerCycle = 0.0;
+u64 Clock::StartTicks = 0;
+u64 Clock::StartOSTicks = 0;
+
+typedef u64 clock_read_func();
+
+// NOTE: Keeps the timed reads from being optimized away
+local_var volatile u64 ClockReadSink;
+
+// NOTE: Spins until the OS clock ticks, with the cycle counter read right
+// before the tick was seen, so that the pair is as close as it gets
+internal_func u64 WaitNextOSTick(u64 &OutCycles)
+{
+	u64 Ticks = Platform::GetTicks();
+	u64 Next;
+	do
+	{
+		OutCycles = ReadCycleCounter();
+		Next = Platform::GetTicks();
+	} while (Next == Ticks);
+	return Next;
+}
+
+// NOTE: The cost of the call through the pointer is included
+internal_func f64 MeasureClockReadCycles(clock_read_func *Read)
+{
+	u64 Sink = 0;
+	u64 Begin = ReadCycleCounter();
+	for (u32 Idx = 0; Idx < CLOCK_READ_COST_SAMPLES; ++Idx)
+	{
+		Sink += Read();
+	}
+	u64 Cycles = ReadCycleCounter() - Begin;
+	ClockReadSink = Sink;
+	return (f64)Cycles / CLOCK_READ_COST_SAMPLES;
+}
+
+void Clock::Initialize()
+{
+	Info.OSFrequency = Platform::GetTickFrequency();
+
+	u64 CycleStart;
+	u64 CycleEnd;
+	u64 OSStart = WaitNextOSTick(CycleStart);
+	u64 OSWait = Max((u64)(CLOCK_CALIBRATION_TIME * (f64)Info.OSFrequency), (u64)1);
+	u64 OSEnd;
+	do
+	{
+		OSEnd = WaitNextOSTick(CycleEnd);
+	} while (OSEnd - OSStart < OSWait);
+
+	Info.CycleFrequency = (u64)((f64)(CycleEnd - CycleStart) * (f64)Info.OSFrequency / (f64)(OSEnd - OSStart));
+	SecondsPerCycle = Info.CycleFrequency ? 1.0 / (f64)Info.CycleFrequency : 0.0;
+
+	Info.UsesCycleCounter = HasInvariantCycleCounter() && Info.CycleFrequency != 0;
+	Info.Frequency = Info.UsesCycleCounter ? Info.CycleFrequency : Info.OSFrequency;
+	SecondsPerTick = 1.0 / (f64)Info.Frequency;
+
+	Info.ReadCostNS = MeasureClockReadCycles(Now) * SecondsPerCycle * 1000000000.0;
+	Info.CycleReadCostNS = MeasureClockReadCycles(ReadCycleCounter) * SecondsPerCycle * 1000000000.0;
+	Info.OSReadCostNS = MeasureClockReadCycles(Platform::GetTicks) * SecondsPerCycle * 1000000000.0;
+
+	StartTicks = Now();
+	StartOSTicks = Platform::GetTicks();
+}
+
+void Clock::Terminate()
+{
+	f64 Seconds = GetSeconds();
+	if (Seconds < CLOCK_DRIFT_MIN_TIME)
+	{
+		LogInfo("Clock on the %s at %.3fMHz: read %.1fns (cycle counter %.1fns, OS clock %.1fns)",
+				Info.UsesCycleCounter ? "cycle counter" : "OS clock", (f64)Info.Frequency / 1000000.0,
+				Info.ReadCostNS, Info.CycleReadCostNS, Info.OSReadCostNS);
+		return;
+	}
+
+	f64 DriftPPM = MeasureDriftPPM();
+	LogInfo("Clock on the %s at %.3fMHz: read %.1fns (cycle counter %.1fns, OS clock %.1fns), "
+			"drift %.2fppm (%.1fus over %.1fs)",
+			Info.UsesCycleCounter ? "cycle counter" : "OS clock", (f64)Info.Frequency / 1000000.0,
+			Info.ReadCostNS, Info.CycleReadCostNS, Info.OSReadCostNS, DriftPPM, DriftPPM * Seconds, Seconds);
+}
+
+u64 Clock::Now()
+{
+	return Info.UsesCycleCounter ? ReadCycleCounter() : Platform::GetTicks();
+}
+
+u64 Clock::GetFrequency()
+{
+	return Info.Frequency;
+}
+
+f64 Clock::GetSeconds()
+{
+	// NOTE: SecondsPerTick is 0 before Initialize
+	return (f64)(Now() - StartTicks) * SecondsPerTick;
+}
+
+f64 Clock::TicksToSeconds(u64 Ticks)
+{
+	return (f64)Ticks * SecondsPerTick;
+}
+
+f64 Clock::TicksToMS(u64 Ticks)
+{
+	return (f64)Ticks * SecondsPerTick * 1000.0;
+}
+
+u64 Clock::TicksToNS(u64 Ticks)
+{
+	return (u64)((f64)Ticks * SecondsPerTick * 1000000000.0);
+}
+
+u64 Clock::SecondsToTicks(f64 Seconds)
+{
+	return Seconds > 0.0 ? (u64)(Seconds * (f64)Info.Frequency) : 0;
+}
+
+f64 Clock::CyclesToMS(u64 Cycles)
+{
+	return (f64)Cycles * SecondsPerCycle * 1000.0;
+}
+
+f64 Clock::MeasureDriftPPM()
+{
+	if (!Info.UsesCycleCounter)
+	{
+		return 0.0;
+	}
+
+	u64 Ticks = Now();
+	u64 OSTicks = Platform::GetTicks();
+	f64 OSSeconds = (f64)(OSTicks - StartOSTicks) / (f64)Info.OSFrequency;
+	if (OSSeconds <= 0.0)
+	{
+		return 0.0;
+	}
+	return (TicksToSeconds(Ticks - StartTicks) - OSSeconds) / OSSeconds * 1000000.0;
+}
+
+ClockInfo Clock::GetInfo()
+{
+	return Info;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+/*
+NOTE: The engine clock. Time is a monotonic u64 count of ticks from
+Clock::Now(), converted to seconds only where someone needs them.
+When the cpu says its cycle counter is invariant the ticks are cycles:
+reading them is a single instruction, no trip in the OS. Otherwise they
+are the ticks of the OS clock (Platform::GetTicks).
+The cycle counter frequency is measured against the OS clock during
+Initialize, whatever the tick source, for ReadCycleCounter users like the
+profiler. A short calibration means the cycle clock drifts a bit from the
+OS one, Terminate measures how much along with the cost of a read.
+*/
+
+#include "defines.h"
+
+// NOTE: Seconds spent measuring the cycle counter frequency
+#define CLOCK_CALIBRATION_TIME 0.02
+// NOTE: Shorter runs don't report the drift, it would be mostly calibration noise
+#define CLOCK_DRIFT_MIN_TIME (10 * CLOCK_CALIBRATION_TIME)
+// NOTE: Reads timed to get the cost of a read
+#define CLOCK_READ_COST_SAMPLES 4096
+
+struct ClockInfo
+{
+	b8 UsesCycleCounter;
+	// NOTE: Ticks per second of Clock::Now
+	u64 Frequency;
+	u64 CycleFrequency;
+	u64 OSFrequency;
+	f64 ReadCostNS;
+	f64 CycleReadCostNS;
+	f64 OSReadCostNS;
+};
+
+// NOTE: this is a singleton
+class Clock
+{
+public:
+	// NOTE: First thing at startup, before the logger: it doesn't log
+	static void Initialize();
+	// NOTE: Logs the read cost and, past CLOCK_DRIFT_MIN_TIME, the drift of the run
+	static void Terminate();
+
+	KIWI_API static u64 Now();
+	KIWI_API static u64 GetFrequency();
+	// NOTE: Since Initialize
+	KIWI_API static f64 GetSeconds();
+
+	// NOTE: Conversions of intervals, not of Now() values
+	KIWI_API static f64 TicksToSeconds(u64 Ticks);
+	KIWI_API static f64 TicksToMS(u64 Ticks);
+	KIWI_API static u64 TicksToNS(u64 Ticks);
+	KIWI_API static u64 SecondsToTicks(f64 Seconds);
+	KIWI_API static f64 CyclesToMS(u64 Cycles);
+
+	// NOTE: How many parts per million the clock got ahead of the OS one since
+	// Initialize, negative if it's behind. Always 0 when using the OS clock
+	KIWI_API static f64 MeasureDriftPPM();
+	KIWI_API static ClockInfo GetInfo();
+
+private:
+	static ClockInfo Info;
+	static f64 SecondsPerTick;
+	static f64 SecondsPerCycle;
+	static u64 StartTicks;
+	static u64 StartOSTicks;
+};
@@ -1,58 +1,121 @@
 #include "event.h"
 #include "core/kiwi_mem.h"
 #include "core/logger.h"
-#include "containers/karray.h"
+#include "core/event_recorder.h"
+#include "platform/platform.h"
 
-EventCodeEntry EventSystem::Registered[MAX_MESSAGE_CODES];
+u16 EventSystem::EntryIndex[MAX_MESSAGE_CODES];
+KArray<EventCodeEntry> EventSystem::Entries;
+MemArena *EventSystem::Arena = nullptr;
+b8 EventSystem::IsFiring = false;
+u32 EventSystem::RegisterGeneration = 0;
+b8 EventSystem::HasPendingRemovals = false;
+KArray<QueuedEvent> EventSystem::Queues[2];
+u32 EventSystem::CurrentQueue = 0;
+KBitSet<MAX_MESSAGE_CODES> EventSystem::CoalescibleCodes;
+KBitSet<MAX_MESSAGE_CODES> EventSystem::Queued;
+u32 EventSystem::QueuedIndex[MAX_MESSAGE_CODES];
+EventQueueStats EventSystem::CurrentStats = {};
+EventQueueStats EventSystem::LastStats = {};
+EventQueueStats EventSystem::TotalStats = {};
+EventThreadQueue EventSystem::ThreadQueue = {};
 b8 EventSystem::IsInitialized = false;
 
+#define EVENT_DEFAULT_CODE_COUNT 32
+#define EVENT_DEFAULT_LISTENER_COUNT 4
+#define EVENT_DEFAULT_QUEUE_SIZE 256
+
 b8 EventSystem::Initialize()
 {
 	if (IsInitialized)
 	{
-		LogError("EventSystem already initialized");
+		LogChannelError(Event, "EventSystem already initialized");
 		return false;
 	}
 
-	for (u16 Index = 0; Index < MAX_MESSAGE_CODES; ++Index)
+	// NOTE: Nothing is created for the single codes here, see GetEntry
+	Arena = MemSystem::GetArena(MemTag_EventSystem);
+	Entries.Create(Arena, EVENT_DEFAULT_CODE_COUNT);
+	Queues[0].Create(Arena, EVENT_DEFAULT_QUEUE_SIZE);
+	Queues[1].Create(Arena, EVENT_DEFAULT_QUEUE_SIZE);
+
+	ThreadQueue = {};
+	ThreadQueue.Cells = (EventThreadQueueCell *)Arena->Push(EVENT_THREAD_QUEUE_SIZE * sizeof(EventThreadQueueCell));
+	for (u64 Idx = 0; Idx < EVENT_THREAD_QUEUE_SIZE; ++Idx)
 	{
-		Registered[Index].Events.Create(MemTag_EventSystem);
+		ThreadQueue.Cells[Idx].Sequence = Idx;
 	}
+
+	CoalescibleCodes.Set(SEC_MouseMoved);
+	CoalescibleCodes.Set(SEC_Resized);
+
 	IsInitialized = true;
 	return true;
 }
 
 b8 EventSystem::Terminate()
 {
-	// TODO: Do we actually need to deinitialize this?
-	for (u16 Index = 0; Index < MAX_MESSAGE_CODES; ++Index)
+	if (!IsInitialized)
 	{
-		if (Registered[Index].Events.FirstNode || Registered[Index].Events.FreeNode)
-		{
-			// TODO: This is theoretically wrong since we are not necesarily freeing from
-			// the correct linked lists. I.E. LLA frees into LLB space and vice versa.
-			Registered[Index].Events.Destroy();
-		}
+		LogChannelError(Event, "EventSystem not yet initialized. Cannot terminate");
+		return false;
 	}
 
+	// NOTE: Every listener array lives in the event system arena,
+	// so clearing it releases all of them at once
+	MemSystem::Zero(EntryIndex, sizeof(EntryIndex));
+	Entries = {};
+	Queues[0] = {};
+	Queues[1] = {};
+	CurrentQueue = 0;
+	CoalescibleCodes.ClearAll();
+	Queued.ClearAll();
+	CurrentStats = {};
+	LastStats = {};
+	TotalStats = {};
+	ThreadQueue = {};
+	Arena->Clear();
+	IsFiring = false;
+	HasPendingRemovals = false;
+	IsInitialized = false;
 	return true;
 }
 
+EventCodeEntry *EventSystem::GetEntry(u16 Code)
+{
+	u16 Index = EntryIndex[Code];
+	return Index ? Entries.Elements + (Index - 1) : nullptr;
+}
+
 b8 EventSystem::Register(u16 Code, void *Listener, on_event OnEvent)
 {
 	if (!IsInitialized)
 	{
-		LogError("Event System not yet initialized. Event registration aborted");
+		LogChannelError(Event, "Event System not yet initialized. Event registration aborted");
+		return false;
+	}
+	if (Code >= MAX_MESSAGE_CODES)
+	{
+		LogChannelError(Event, "Event code %d out of range. Event registration aborted", Code);
 		return false;
 	}
 
-	KLinkedList<RegisteredEvent> *Events = &Registered[Code].Events;
+	EventCodeEntry *Entry = GetEntry(Code);
+	if (!Entry)
+	{
+		EventCodeEntry NewEntry = {};
+		NewEntry.Listeners.Create(Arena, EVENT_DEFAULT_LISTENER_COUNT);
+		Entries.Push(NewEntry);
+		EntryIndex[Code] = (u16)Entries.Length;
+		Entry = GetEntry(Code);
+	}
 
-	for (KLinkedList<RegisteredEvent>::Node *Node = Events->FirstNode; Node; Node = Node->Next)
+	for (u64 Idx = 0; Idx < Entry->Listeners.Length; ++Idx)
 	{
-		if (Node->Element.Listener == Listener)
+		if (Entry->Listeners.Elements[Idx].Listener == Listener &&
+			Entry->Listeners.Elements[Idx].Callback != OnRemovedListener)
 		{
-			LogWarning("Listener arleady registered to code %d", Code);
+			LogChannelWarning(Event, "Listener arleady registered to code %d", Code);
 			return false;
 		}
 	}
@@ -60,7 +123,8 @@ b8 EventSystem::Register(u16 Code, void *Listener, on_event OnEvent)
 	RegisteredEvent Event;
 	Event.Listener = Listener;
 	Event.Callback = OnEvent;
-	Events->Add(Event);
+	Entry->Listeners.Push(Event);
+	++RegisterGeneration;
 
 	return true;
 }
@@ -69,45 +133,327 @@ b8 EventSystem::Unregister(u16 Code, void *Listener, on_event OnEvent)
 {
 	if (!IsInitialized)
 	{
-		LogError("Event System not yet initialized. Event unregister aborted");
+		LogChannelError(Event, "Event System not yet initialized. Event unregister aborted");
 		return false;
 	}
 
-	KLinkedList<RegisteredEvent> *Events = &Registered[Code].Events;
-
-	for (KLinkedList<RegisteredEvent>::Node *Node = Events->FirstNode; Node; Node = Node->Next)
+	EventCodeEntry *Entry = Code < MAX_MESSAGE_CODES ? GetEntry(Code) : nullptr;
+	if (Entry)
 	{
-		if (Node->Element.Listener == Listener && Node->Element.Callback == OnEvent)
+		RegisteredEvent *Listeners = Entry->Listeners.Elements;
+		for (u64 Idx = 0; Idx < Entry->Listeners.Length; ++Idx)
 		{
-			Events->Remove(Node);
-			return true;
+			if (Listeners[Idx].Listener == Listener && Listeners[Idx].Callback == OnEvent)
+			{
+				if (IsFiring)
+				{
+					// NOTE: Someone is walking the arrays, moving listeners around now
+					// would make them skip one. Mark it and compact later.
+					Listeners[Idx].Callback = OnRemovedListener;
+					++Entry->PendingRemovals;
+					HasPendingRemovals = true;
+				}
+				else
+				{
+					Listeners[Idx] = Listeners[--Entry->Listeners.Length];
+				}
+				return true;
+			}
 		}
 	}
 
 	// Event not found
-	LogWarning("Listener not registered for event %d", Code);
+	LogChannelWarning(Event, "Listener not registered for event %d", Code);
 	return false;
 }
 
 b8 EventSystem::Fire(u16 Code, void *Sender, EventContext Context)
 {
+	EVENT_RECORD_SCOPE(EventRecordType_Fire, Code, Context);
+
 	if (!IsInitialized)
 	{
-		LogError("Event System not yet initialized. Cannot fire an event");
+		LogChannelError(Event, "Event System not yet initialized. Cannot fire an event");
+		return false;
+	}
+
+	u16 Index = Code < MAX_MESSAGE_CODES ? EntryIndex[Code] : 0;
+	if (!Index)
+	{
 		return false;
 	}
 
-	KLinkedList<RegisteredEvent> *Events = &Registered[Code].Events;
+	EventCodeEntry *Entry = Entries.Elements + (Index - 1);
+	b8 Handled = false;
+	// NOTE: Only the outermost Fire clears the flag and compacts the removals
+	b8 IsOutermost = !IsFiring;
+	IsFiring = true;
 
-	for (KLinkedList<RegisteredEvent>::Node *Node = Events->FirstNode; Node; Node = Node->Next)
+	// NOTE: A handler can register new listeners, which can move both the
+	// entries and the listener arrays. Register bumps the generation, and
+	// only then we go through the index again.
+	u32 Generation = RegisterGeneration;
+	RegisteredEvent *Listeners = Entry->Listeners.Elements;
+	u64 ListenerCount = Entry->Listeners.Length;
+	for (u64 Idx = 0; Idx < ListenerCount; ++Idx)
 	{
-		if (Node->Element.Callback(Code, Sender, Node->Element.Listener, Context))
+		RegisteredEvent Event = Listeners[Idx];
+		if (Event.Callback(Code, Sender, Event.Listener, Context))
 		{
 			// NOTE: if we enter here it means that the event has been handled
 			// and there is no need to send it to someone else
-			return true;
+			Handled = true;
+			break;
+		}
+
+		if (RegisterGeneration != Generation)
+		{
+			Generation = RegisterGeneration;
+			Entry = GetEntry(Code);
+			Listeners = Entry->Listeners.Elements;
+			ListenerCount = Entry->Listeners.Length;
 		}
 	}
 
+	if (IsOutermost)
+	{
+		IsFiring = false;
+		if (HasPendingRemovals)
+		{
+			CompactPendingRemovals();
+		}
+	}
+
+	return Handled;
+}
+
+EVENT_FUNCTION(EventSystem::OnRemovedListener)
+{
 	return false;
-}
\ No newline at end of file
+}
+
+void EventSystem::CompactPendingRemovals()
+{
+	for (u64 EntryIdx = 0; EntryIdx < Entries.Length; ++EntryIdx)
+	{
+		EventCodeEntry *Entry = Entries.Elements + EntryIdx;
+		if (!Entry->PendingRemovals)
+		{
+			continue;
+		}
+
+		RegisteredEvent *Listeners = Entry->Listeners.Elements;
+		for (u64 Idx = 0; Idx < Entry->Listeners.Length;)
+		{
+			if (Listeners[Idx].Callback != OnRemovedListener)
+			{
+				++Idx;
+			}
+			else
+			{
+				Listeners[Idx] = Listeners[--Entry->Listeners.Length];
+			}
+		}
+		Entry->PendingRemovals = 0;
+	}
+
+	HasPendingRemovals = false;
+}
+
+void EventSystem::Post(u16 Code, void *Sender, EventContext Context)
+{
+	EVENT_RECORD_SCOPE(EventRecordType_Post, Code, Context);
+
+	if (!IsInitialized)
+	{
+		LogChannelError(Event, "Event System not yet initialized. Cannot post an event");
+		return;
+	}
+	if (Code >= MAX_MESSAGE_CODES)
+	{
+		LogChannelError(Event, "Event code %d out of range. Event post aborted", Code);
+		return;
+	}
+
+	KArray<QueuedEvent> *Queue = Queues + CurrentQueue;
+	++CurrentStats.Posted;
+
+	if (CoalescibleCodes.Test(Code))
+	{
+		if (Queued.Test(Code))
+		{
+			// NOTE: Drop the old one instead of overwriting it, this way the
+			// latest value keeps its place relative to the other events
+			Queue->Elements[QueuedIndex[Code]].Code = EVENT_CODE_INVALID;
+			++CurrentStats.Coalesced;
+		}
+		Queued.Set(Code);
+		QueuedIndex[Code] = (u32)Queue->Length;
+	}
+
+	QueuedEvent Event;
+	Event.Code = Code;
+	Event.Sender = Sender;
+	Event.Context = Context;
+	Queue->Push(Event);
+}
+
+void EventSystem::SetCoalescible(u16 Code, b8 Coalescible)
+{
+	if (Code >= MAX_MESSAGE_CODES)
+	{
+		LogChannelError(Event, "Event code %d out of range", Code);
+		return;
+	}
+
+	// NOTE: Forget the queued one, otherwise a code turned back into
+	// coalescible could drop an unrelated event later in the frame
+	Queued.Clear(Code);
+	CoalescibleCodes.Assign(Code, Coalescible);
+}
+
+void EventSystem::DispatchQueued()
+{
+	if (!IsInitialized)
+	{
+		return;
+	}
+
+	// NOTE: Whatever the other threads posted joins this frame's events
+	u32 FromThreads = DrainThreadQueue();
+
+	// NOTE: From now on Post writes into the other queue
+	KArray<QueuedEvent> *Queue = Queues + CurrentQueue;
+	CurrentQueue ^= 1;
+	Queued.ClearAll();
+
+	EventQueueStats Stats = CurrentStats;
+	Stats.FromThreads = FromThreads;
+	u64 FullCount = AtomicLoadAcquire64(&ThreadQueue.FullCount);
+	Stats.ThreadQueueFull = (u32)(FullCount - ThreadQueue.LastFullCount);
+	ThreadQueue.LastFullCount = FullCount;
+	CurrentStats = {};
+
+	for (u64 Idx = 0; Idx < Queue->Length; ++Idx)
+	{
+		QueuedEvent *Event = Queue->Elements + Idx;
+		if (Event->Code != EVENT_CODE_INVALID)
+		{
+			Fire(Event->Code, Event->Sender, Event->Context);
+			++Stats.Dispatched;
+		}
+	}
+
+	Queue->Clear();
+	LastStats = Stats;
+	TotalStats.Posted += Stats.Posted;
+	TotalStats.Coalesced += Stats.Coalesced;
+	TotalStats.Dispatched += Stats.Dispatched;
+	TotalStats.FromThreads += Stats.FromThreads;
+	TotalStats.ThreadQueueFull += Stats.ThreadQueueFull;
+}
+
+EventQueueStats EventSystem::GetQueueStats()
+{
+	return LastStats;
+}
+
+EventQueueStats EventSystem::GetQueueTotals()
+{
+	return TotalStats;
+}
+
+b8 EventSystem::TryPostFromAnyThread(u16 Code, void *Sender, EventContext Context)
+{
+	if (!IsInitialized || Code >= MAX_MESSAGE_CODES)
+	{
+		LogChannelError(Event, "Cannot post event %d from thread: event system not initialized or code out of range", Code);
+		return false;
+	}
+
+	u64 Mask = EVENT_THREAD_QUEUE_SIZE - 1;
+	u64 Pos = AtomicLoadAcquire64(&ThreadQueue.EnqueuePos);
+	EventThreadQueueCell *Cell;
+	for (;;)
+	{
+		Cell = ThreadQueue.Cells + (Pos & Mask);
+		i64 Difference = (i64)AtomicLoadAcquire64(&Cell->Sequence) - (i64)Pos;
+		if (Difference == 0)
+		{
+			// NOTE: The cell is free for this lap, try to claim it.
+			// On failure Pos is updated to where the others got to.
+			if (AtomicCompareExchange64(&ThreadQueue.EnqueuePos, Pos, Pos + 1))
+			{
+				break;
+			}
+		}
+		else if (Difference < 0)
+		{
+			// NOTE: The main thread didn't consume this cell yet: the queue is full
+			AtomicAdd64(&ThreadQueue.FullCount, 1);
+			return false;
+		}
+		else
+		{
+			// NOTE: Someone else claimed it in the meantime
+			Pos = AtomicLoadAcquire64(&ThreadQueue.EnqueuePos);
+		}
+	}
+
+	Cell->Event.Code = Code;
+	Cell->Event.Sender = Sender;
+	Cell->Event.Context = Context;
+	AtomicStoreRelease64(&Cell->Sequence, Pos + 1);
+	return true;
+}
+
+#define EVENT_THREAD_POST_SPIN_COUNT 64
+
+b8 EventSystem::PostFromAnyThread(u16 Code, void *Sender, EventContext Context)
+{
+	u32 Attempt = 0;
+	while (!TryPostFromAnyThread(Code, Sender, Context))
+	{
+		if (!IsInitialized)
+		{
+			return false;
+		}
+
+		// NOTE: The main thread drains once per frame, so a short spin is
+		// enough when it's draining right now, otherwise let it run
+		if (++Attempt < EVENT_THREAD_POST_SPIN_COUNT)
+		{
+			CpuPause();
+		}
+		else
+		{
+			Platform::YieldThread();
+		}
+	}
+	return true;
+}
+
+u32 EventSystem::DrainThreadQueue()
+{
+	u64 Mask = EVENT_THREAD_QUEUE_SIZE - 1;
+	u32 Drained = 0;
+	while (Drained < EVENT_THREAD_QUEUE_MAX_DRAIN)
+	{
+		u64 Pos = ThreadQueue.DequeuePos;
+		EventThreadQueueCell *Cell = ThreadQueue.Cells + (Pos & Mask);
+		if (AtomicLoadAcquire64(&Cell->Sequence) != Pos + 1)
+		{
+			// NOTE: Empty, or the producer of this cell hasn't finished writing it yet
+			break;
+		}
+
+		QueuedEvent Event = Cell->Event;
+		// NOTE: Hand the cell back to the producers for the next lap
+		AtomicStoreRelease64(&Cell->Sequence, Pos + EVENT_THREAD_QUEUE_SIZE);
+		ThreadQueue.DequeuePos = Pos + 1;
+
+		Post(Event.Code, Event.Sender, Event.Context);
+		++Drained;
+	}
+	return Drained;
+}
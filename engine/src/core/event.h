@@ -1,25 +1,28 @@
 #pragma once
 
 #include "defines.h"
-#include "containers/klinked_list.h"
+#include "containers/karray.h"
+#include "containers/kbitset.h"
 
 struct EventContext
 {
+	// NOTE: The types are qualified because the members take their names,
+	// gcc and clang refuse the unqualified version
 	union
 	{
-		i64 i64[2];
-		u64 u64[2];
-		f64 f64[2];
+		::i64 i64[2];
+		::u64 u64[2];
+		::f64 f64[2];
 
-		i32 i32[4];
-		u32 u32[4];
-		f32 f32[4];
+		::i32 i32[4];
+		::u32 u32[4];
+		::f32 f32[4];
 
-		i16 i16[8];
-		u16 u16[8];
+		::i16 i16[8];
+		::u16 u16[8];
 
-		i8 i8[16];
-		u8 u8[16];
+		::i8 i8[16];
+		::u8 u8[16];
 
 		char c[16];
 	};
@@ -80,12 +83,69 @@ struct RegisteredEvent
 	on_event *Callback;
 };
 
+// NOTE: All the listeners of a code sit next to each other, so Fire walks a
+// flat array instead of chasing list nodes around the arena.
+// PendingRemovals counts the listeners unregistered while the code was being
+// fired: their callback is swapped for one that ignores the event, and they
+// get compacted away once the outermost Fire returns.
 struct EventCodeEntry
 {
-	KLinkedList<RegisteredEvent> Events;
+	KArray<RegisteredEvent> Listeners;
+	u32 PendingRemovals;
 };
 
 #define MAX_MESSAGE_CODES 4096
+#define EVENT_CODE_INVALID 0xFFFF
+
+// NOTE: Size of the queue fed by the other threads, must be a power of two.
+// At most EVENT_THREAD_QUEUE_MAX_DRAIN of those events are moved into the
+// frame queue per DispatchQueued, the rest waits for the next frame.
+#define EVENT_THREAD_QUEUE_SIZE 4096
+#define EVENT_THREAD_QUEUE_MAX_DRAIN 1024
+
+struct QueuedEvent
+{
+	u16 Code;
+	void *Sender;
+	EventContext Context;
+};
+
+// NOTE: Bounded multi-producer single-consumer ring (Dmitry Vyukov's design).
+// Every cell has a sequence number telling whose turn it is: producers
+// claim a slot with a single CAS on EnqueuePos and publish it by bumping
+// the sequence, the main thread is the only one moving DequeuePos.
+// The positions are padded apart so producers and consumer don't share a line.
+struct EventThreadQueueCell
+{
+	volatile u64 Sequence;
+	QueuedEvent Event;
+};
+
+struct EventThreadQueue
+{
+	EventThreadQueueCell *Cells;
+	u8 Padding0[CACHE_LINE_SIZE - sizeof(EventThreadQueueCell *)];
+	volatile u64 EnqueuePos;
+	volatile u64 FullCount;
+	u8 Padding1[CACHE_LINE_SIZE - 2 * sizeof(u64)];
+	u64 DequeuePos;
+	u64 LastFullCount;
+};
+
+// NOTE: Counters of the queue for a single frame. Posted counts every Post,
+// Coalesced the ones that replaced an event of the same code still in
+// the queue, Dispatched the events actually fired by DispatchQueued.
+// FromThreads counts the events drained from the other threads (they are
+// posted as well) and ThreadQueueFull how many times a thread found
+// their queue full.
+struct EventQueueStats
+{
+	u32 Posted;
+	u32 Coalesced;
+	u32 Dispatched;
+	u32 FromThreads;
+	u32 ThreadQueueFull;
+};
 
 class EventSystem
 {
@@ -100,15 +160,73 @@ public:
 
 	// NOTE: Unregister from an event with the provided code.
 	// If no matching registration is found, this will return false.
+	// The last listener takes the place of the removed one, so the
+	// order of the remaining listeners is not preserved.
 	KIWI_API static b8 Unregister(u16 Code, void *Listener, on_event OnEvent);
 
 	// NOTE: Fire the event to listeners of the corresponding code.
 	// if an event handler returns true the event is considered handled
 	// and not passed on to any more listeners.
+	// Handlers can safely register and unregister listeners (even themselves).
 	KIWI_API static b8 Fire(u16 Code, void *Sender, EventContext Context);
 
+	// NOTE: Queue the event, it will be fired during the next DispatchQueued.
+	// If the code is coalescible and an event with the same code is still in
+	// the queue, that one is dropped: only the latest value gets fired.
+	KIWI_API static void Post(u16 Code, void *Sender, EventContext Context);
+
+	// NOTE: Post from any thread, without locks. The event goes through
+	// the same frame queue (and coalescing) as Post, it's just moved there
+	// by DispatchQueued. The Try version returns false if the queue is full,
+	// the other one applies back-pressure: it waits until the main thread
+	// makes room. That's why it must never be called from the main thread.
+	// Don't post from other threads once the event system is terminated.
+	KIWI_API static b8 TryPostFromAnyThread(u16 Code, void *Sender, EventContext Context);
+	KIWI_API static b8 PostFromAnyThread(u16 Code, void *Sender, EventContext Context);
+
+	// NOTE: Mark a code as coalescible, meaning only its latest value per
+	// frame matters (SEC_MouseMoved and SEC_Resized are by default).
+	KIWI_API static void SetCoalescible(u16 Code, b8 Coalescible);
+
+	// NOTE: Fire all the queued events in the order they were posted.
+	// Events posted by the handlers are queued for the next dispatch.
+	// Called once per frame by Application::Run.
+	static void DispatchQueued();
+
+	// NOTE: Stats of the last DispatchQueued
+	KIWI_API static EventQueueStats GetQueueStats();
+	// NOTE: Stats summed over every DispatchQueued since startup, they wrap
+	// around like any u32: Metrics exports the differences
+	KIWI_API static EventQueueStats GetQueueTotals();
+
 private:
-	// NOTE: LUT for event codes
-	static EventCodeEntry Registered[MAX_MESSAGE_CODES];
+	static EventCodeEntry *GetEntry(u16 Code);
+	static EVENT_FUNCTION(OnRemovedListener);
+	static void CompactPendingRemovals();
+	static u32 DrainThreadQueue();
+
+	// NOTE: Sparse LUT: code -> index + 1 into Entries, 0 if nobody ever
+	// registered to it. Entries are only created on the first registration.
+	static u16 EntryIndex[MAX_MESSAGE_CODES];
+	static KArray<EventCodeEntry> Entries;
+	static MemArena *Arena;
+	// NOTE: Set while any Fire is walking the listeners, Unregister defers the removals then
+	static b8 IsFiring;
+	// NOTE: Bumped by every Register, Fire reloads the listeners when it changes
+	static u32 RegisterGeneration;
+	static b8 HasPendingRemovals;
+
+	// NOTE: Double buffered so that handlers can post while we dispatch.
+	// QueuedIndex is only valid for the codes set in Queued.
+	static KArray<QueuedEvent> Queues[2];
+	static u32 CurrentQueue;
+	static KBitSet<MAX_MESSAGE_CODES> CoalescibleCodes;
+	static KBitSet<MAX_MESSAGE_CODES> Queued;
+	static u32 QueuedIndex[MAX_MESSAGE_CODES];
+	static EventQueueStats CurrentStats;
+	static EventQueueStats LastStats;
+	static EventQueueStats TotalStats;
+	static EventThreadQueue ThreadQueue;
+
 	static b8 IsInitialized;
 };
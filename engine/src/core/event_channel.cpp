@@ -0,0 +1,48 @@
+#include "event_channel.h"
+#include "core/logger.h"
+
+event_channel_dispatch *EventChannels::Pending[MAX_PENDING_EVENT_CHANNELS];
+u32 EventChannels::PendingCount = 0;
+
+void EventChannels::Schedule(event_channel_dispatch *Dispatch)
+{
+	if (PendingCount == MAX_PENDING_EVENT_CHANNELS)
+	{
+		// NOTE: Better early than never, the payloads wouldn't survive the frame
+		LogChannelWarning(Event, "Too many event channels with posted events, dispatching immediately");
+		Dispatch(false);
+		return;
+	}
+
+	Pending[PendingCount++] = Dispatch;
+}
+
+void EventChannels::DispatchPending()
+{
+	for (u32 Round = 0; PendingCount && Round < EVENT_CHANNEL_MAX_ROUNDS; ++Round)
+	{
+		// NOTE: Channels scheduled during this round end up after Count
+		u32 Count = PendingCount;
+		for (u32 Idx = 0; Idx < Count; ++Idx)
+		{
+			Pending[Idx](false);
+		}
+
+		for (u32 Idx = Count; Idx < PendingCount; ++Idx)
+		{
+			Pending[Idx - Count] = Pending[Idx];
+		}
+		PendingCount -= Count;
+	}
+
+	if (PendingCount)
+	{
+		LogChannelWarning(Event, "Event channels are still posting after %d rounds, dropping %d channels' events",
+								 EVENT_CHANNEL_MAX_ROUNDS, PendingCount);
+		for (u32 Idx = 0; Idx < PendingCount; ++Idx)
+		{
+			Pending[Idx](true);
+		}
+		PendingCount = 0;
+	}
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+/*
+NOTE: Typed event channels, they live alongside the u16 codes of the EventSystem.
+A channel is a payload type plus a list of listeners known at compile time:
+
+	struct ShaderReloaded { KStrId Name; u32 StageMask; ... };
+	struct MaterialCache { static b8 OnEvent(const ShaderReloaded &Payload); };
+	struct PipelineCache { static b8 OnEvent(const ShaderReloaded &Payload); };
+	typedef EventChannel<ShaderReloaded, MaterialCache, PipelineCache> ShaderReloadedChannel;
+
+	ShaderReloadedChannel::Fire(Payload); // or Post(Payload)
+
+There are no function pointers and no void* involved, the listeners are
+called directly, so the compiler can inline them into Fire.
+The payload can have any size, but it's copied around with MemSystem::Copy
+so it must be trivially copyable, Post checks it.
+As with EventSystem::Fire, a listener returning true handles the event and
+the following listeners don't get it.
+Channels are meant to be used from the main thread only.
+*/
+
+#include "defines.h"
+#include "core/kiwi_mem.h"
+
+template <typename TPayload, typename... TListeners>
+struct EventListenerList;
+
+template <typename TPayload>
+struct EventListenerList<TPayload>
+{
+	static KIWI_INLINE b8 Dispatch(const TPayload &) { return false; }
+};
+
+template <typename TPayload, typename TListener, typename... TOthers>
+struct EventListenerList<TPayload, TListener, TOthers...>
+{
+	static KIWI_INLINE b8 Dispatch(const TPayload &Payload)
+	{
+		return TListener::OnEvent(Payload) || EventListenerList<TPayload, TOthers...>::Dispatch(Payload);
+	}
+};
+
+#define MAX_PENDING_EVENT_CHANNELS 256
+#define EVENT_CHANNEL_MAX_ROUNDS 8
+
+// NOTE: Dispatch (or throw away, if Discard is true) the events posted to a channel
+typedef void event_channel_dispatch(b8 Discard);
+
+// NOTE: Keeps track of the channels with posted events. Application::Run
+// calls DispatchPending at the end of every frame, right before the frame
+// arena (where the posted payloads live) is cleared.
+// NOTE: this is a singleton
+class EventChannels
+{
+public:
+	KIWI_API static void Schedule(event_channel_dispatch *Dispatch);
+
+	// NOTE: Events posted by the listeners during the dispatch are dispatched as
+	// well, up to EVENT_CHANNEL_MAX_ROUNDS times, then the remaining ones are dropped
+	static void DispatchPending();
+
+private:
+	static event_channel_dispatch *Pending[MAX_PENDING_EVENT_CHANNELS];
+	static u32 PendingCount;
+};
+
+template <typename TPayload, typename... TListeners>
+class EventChannel
+{
+public:
+	typedef EventListenerList<TPayload, TListeners...> Listeners;
+
+	static KIWI_INLINE b8 Fire(const TPayload &Payload)
+	{
+		return Listeners::Dispatch(Payload);
+	}
+
+	// NOTE: The payload is copied into the frame arena and fired at the end
+	// of the frame, in the same order it was posted
+	static void Post(const TPayload &Payload)
+	{
+		// NOTE: The payloads are copied bytewise and the frame arena is cleared
+		// without calling any destructor
+		StaticAssertMsg(__is_trivially_copyable(TPayload), "Posted event payloads must be trivially copyable");
+
+		MemArena *FrameArena = MemSystem::GetArena(MemTag_Frame);
+		PendingEvent *Event = (PendingEvent *)FrameArena->PushNoZeroAligned(sizeof(PendingEvent), alignof(PendingEvent));
+		if (!Event)
+		{
+			return;
+		}
+
+		Event->Next = nullptr;
+		MemSystem::Copy(&Event->Payload, (void *)&Payload, sizeof(TPayload));
+
+		if (Last)
+		{
+			Last->Next = Event;
+			Last = Event;
+		}
+		else
+		{
+			// NOTE: The list is complete before scheduling, Schedule dispatches
+			// it right away when too many channels are pending
+			First = Event;
+			Last = Event;
+			EventChannels::Schedule(DispatchPosted);
+		}
+	}
+
+private:
+	struct PendingEvent
+	{
+		PendingEvent *Next;
+		TPayload Payload;
+	};
+
+	static void DispatchPosted(b8 Discard)
+	{
+		// NOTE: Detach the list first, the listeners may post again
+		PendingEvent *Event = First;
+		First = nullptr;
+		Last = nullptr;
+
+		for (; Event && !Discard; Event = Event->Next)
+		{
+			Listeners::Dispatch(Event->Payload);
+		}
+	}
+
+	static PendingEvent *First;
+	static PendingEvent *Last;
+};
+
+template <typename TPayload, typename... TListeners>
+typename EventChannel<TPayload, TListeners...>::PendingEvent *EventChannel<TPayload, TListeners...>::First = nullptr;
+
+template <typename TPayload, typename... TListeners>
+typename EventChannel<TPayload, TListeners...>::PendingEvent *EventChannel<TPayload, TListeners...>::Last = nullptr;
@@ -0,0 +1,235 @@
+#include "event_recorder.h"
+#include "core/input.h"
+#include "core/kiwi_mem.h"
+#include "core/logger.h"
+
+b8 EventRecorder::Recording = false;
+b8 EventRecorder::Replaying = false;
+b8 EventRecorder::Capturing = false;
+u32 EventRecorder::Depth = 0;
+u32 EventRecorder::RecordedThisFrame = 0;
+
+PlatformFile EventRecorder::File = {};
+u8 *EventRecorder::Buffer = nullptr;
+u64 EventRecorder::BufferUsed = 0;
+
+u8 *EventRecorder::ReplayData = nullptr;
+u64 EventRecorder::ReplaySize = 0;
+u64 EventRecorder::ReplayCursor = 0;
+
+// NOTE: Type + Code + ContextSize
+#define EVENT_RECORD_PREFIX_SIZE 4
+
+b8 EventRecorder::StartRecording(const char *Path)
+{
+	if (Recording || Replaying)
+	{
+		LogChannelError(Event, "EventRecorder is already recording or replaying");
+		return false;
+	}
+
+	if (!Platform::FileOpen(&File, Path, FileMode_Write))
+	{
+		return false;
+	}
+
+	EventRecordHeader Header = {EVENT_RECORD_MAGIC, EVENT_RECORD_VERSION};
+	Platform::FileWrite(&File, &Header, sizeof(Header));
+
+	Buffer = (u8 *)MemSystem::GetArena(MemTag_Application)->PushNoZero(EVENT_RECORD_BUFFER_SIZE);
+	BufferUsed = 0;
+	RecordedThisFrame = 0;
+	Recording = true;
+
+	LogChannelInfo(Event, "Recording events to %s", Path);
+	return true;
+}
+
+b8 EventRecorder::StartReplay(const char *Path)
+{
+	if (Recording || Replaying)
+	{
+		LogChannelError(Event, "EventRecorder is already recording or replaying");
+		return false;
+	}
+
+	PlatformFile ReplayFile;
+	if (!Platform::FileOpen(&ReplayFile, Path, FileMode_Read))
+	{
+		return false;
+	}
+
+	// NOTE: Recordings are small, read it whole so replaying never touches the disk
+	ReplaySize = Platform::FileSize(&ReplayFile);
+	ReplayData = (u8 *)MemSystem::GetArena(MemTag_Application)->PushNoZero(ReplaySize);
+	u64 Read = Platform::FileRead(&ReplayFile, ReplayData, ReplaySize);
+	Platform::FileClose(&ReplayFile);
+
+	EventRecordHeader *Header = (EventRecordHeader *)ReplayData;
+	if (Read != ReplaySize || ReplaySize < sizeof(EventRecordHeader) ||
+		Header->Magic != EVENT_RECORD_MAGIC || Header->Version != EVENT_RECORD_VERSION)
+	{
+		LogChannelError(Event, "%s is not a valid event recording", Path);
+		return false;
+	}
+
+	ReplayCursor = sizeof(EventRecordHeader);
+	Replaying = true;
+
+	LogChannelInfo(Event, "Replaying events from %s", Path);
+	return true;
+}
+
+void EventRecorder::Stop()
+{
+	if (Recording)
+	{
+		Flush();
+		Platform::FileClose(&File);
+		Recording = false;
+	}
+	Replaying = false;
+	Capturing = false;
+}
+
+void EventRecorder::BeginCapture()
+{
+	Capturing = Recording;
+	Depth = 0;
+}
+
+void EventRecorder::EndCapture()
+{
+	Capturing = false;
+}
+
+void EventRecorder::Enter(EventRecordType Type, u16 Code, const EventContext &Context)
+{
+	if (Depth == 0)
+	{
+		Write(Type, Code, Context);
+		++RecordedThisFrame;
+	}
+	++Depth;
+}
+
+void EventRecorder::Leave()
+{
+	--Depth;
+}
+
+void EventRecorder::EndFrame(u32 FrameIndex, f32 DeltaTime, b8 IsSuspended)
+{
+	if (!Recording || (IsSuspended && !RecordedThisFrame))
+	{
+		return;
+	}
+
+	EventContext Context = {};
+	Context.u32[0] = FrameIndex;
+	Context.f32[1] = DeltaTime;
+	Write(EventRecordType_Frame, 0, Context);
+	RecordedThisFrame = 0;
+}
+
+void EventRecorder::Write(EventRecordType Type, u16 Code, EventContext Context)
+{
+	u8 ContextSize = sizeof(Context.u8);
+	while (ContextSize && !Context.u8[ContextSize - 1])
+	{
+		--ContextSize;
+	}
+
+	if (BufferUsed + EVENT_RECORD_PREFIX_SIZE + ContextSize > EVENT_RECORD_BUFFER_SIZE)
+	{
+		Flush();
+	}
+
+	u8 *Dest = Buffer + BufferUsed;
+	Dest[0] = Type;
+	Dest[1] = (u8)(Code & 0xFF);
+	Dest[2] = (u8)(Code >> 8);
+	Dest[3] = ContextSize;
+	MemSystem::Copy(Dest + EVENT_RECORD_PREFIX_SIZE, Context.u8, ContextSize);
+	BufferUsed += EVENT_RECORD_PREFIX_SIZE + ContextSize;
+}
+
+void EventRecorder::Flush()
+{
+	if (BufferUsed && !Platform::FileWrite(&File, Buffer, BufferUsed))
+	{
+		LogChannelError(Event, "Failed to write the event recording, the rest of it will be lost");
+		Platform::FileClose(&File);
+		Recording = false;
+		Capturing = false;
+	}
+	BufferUsed = 0;
+}
+
+b8 EventRecorder::ReplayFrame(f32 &OutDeltaTime)
+{
+	while (Replaying && ReplayCursor + EVENT_RECORD_PREFIX_SIZE <= ReplaySize)
+	{
+		u8 *Source = ReplayData + ReplayCursor;
+		EventRecordType Type = (EventRecordType)Source[0];
+		u16 Code = (u16)(Source[1] | (Source[2] << 8));
+		u8 ContextSize = Source[3];
+		if (ContextSize > sizeof(EventContext) || ReplayCursor + EVENT_RECORD_PREFIX_SIZE + ContextSize > ReplaySize)
+		{
+			break;
+		}
+
+		EventContext Context = {};
+		MemSystem::Copy(Context.u8, Source + EVENT_RECORD_PREFIX_SIZE, ContextSize);
+		ReplayCursor += EVENT_RECORD_PREFIX_SIZE + ContextSize;
+
+		switch (Type)
+		{
+		case EventRecordType_Frame:
+		{
+			OutDeltaTime = Context.f32[1];
+			return true;
+		}
+		case EventRecordType_Fire:
+		{
+			EventSystem::Fire(Code, nullptr, Context);
+			break;
+		}
+		case EventRecordType_Post:
+		{
+			EventSystem::Post(Code, nullptr, Context);
+			break;
+		}
+		case EventRecordType_Key:
+		{
+			InputSystem::ProcessKey((Key)Code, Context.u8[0]);
+			break;
+		}
+		case EventRecordType_MouseButton:
+		{
+			InputSystem::ProcessMouseButton((MouseButton)Code, Context.u8[0]);
+			break;
+		}
+		case EventRecordType_MouseMove:
+		{
+			InputSystem::ProcessMouseMove(Context.i16[0], Context.i16[1]);
+			break;
+		}
+		case EventRecordType_MouseWheel:
+		{
+			InputSystem::ProcessMouseWheel(Context.i8[0]);
+			break;
+		}
+		default:
+		{
+			LogChannelError(Event, "Unknown record type %d in the event recording", Type);
+			Replaying = false;
+			return false;
+		}
+		}
+	}
+
+	LogChannelInfo(Event, "Event replay finished");
+	Replaying = false;
+	return false;
+}
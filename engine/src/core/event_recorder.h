@@ -0,0 +1,130 @@
+#pragma once
+
+/*
+NOTE: Records what enters the engine from the outside world and replays it.
+While recording, everything the platform layer feeds to the engine during
+Platform::ProcessMessageQueue is written to a file: the InputSystem::Process*
+calls and the events it posts/fires directly, plus a marker at the end
+of every frame with the frame index and its delta time.
+Events fired as a consequence of those (by the input system or by the
+handlers) are not recorded: the replay produces them again on its own.
+
+While replaying, Application::Run doesn't process the platform messages:
+every frame it asks the recorder to feed the next recorded frame and uses
+the recorded delta time, without frame limiting. Two replays of the same
+file run the very same frames with the very same inputs, so their frame
+times are directly comparable.
+
+File format: an EventRecordHeader followed by the records. Every record is
+Type (u8), Code (u16), the number of context bytes that follow (u8) and
+the context bytes themselves, trailing zero bytes of the context are not stored.
+*/
+
+#include "defines.h"
+#include "core/event.h"
+#include "platform/platform.h"
+
+#define EVENT_RECORD_MAGIC 0x4345524B // "KREC"
+#define EVENT_RECORD_VERSION 1
+#define EVENT_RECORD_BUFFER_SIZE KiB(64)
+
+enum EventRecordType : u8
+{
+	// Context: u32[0] = FrameIndex, f32[1] = DeltaTime
+	EventRecordType_Frame,
+	EventRecordType_Fire,
+	EventRecordType_Post,
+	// Code = KeyCode, Context: u8[0] = Pressed
+	EventRecordType_Key,
+	// Code = MouseButton, Context: u8[0] = Pressed
+	EventRecordType_MouseButton,
+	// Context: i16[0] = X, i16[1] = Y
+	EventRecordType_MouseMove,
+	// Context: i8[0] = ZDelta
+	EventRecordType_MouseWheel,
+
+	EventRecordType_Count
+};
+
+struct EventRecordHeader
+{
+	u32 Magic;
+	u32 Version;
+};
+
+// NOTE: this is a singleton
+class EventRecorder
+{
+public:
+	static b8 StartRecording(const char *Path);
+	static b8 StartReplay(const char *Path);
+	// NOTE: Flushes and closes the recording, if any
+	static void Stop();
+
+	static b8 IsRecording() { return Recording; }
+	static b8 IsReplaying() { return Replaying; }
+
+	// NOTE: Only what happens between these two gets recorded
+	static void BeginCapture();
+	static void EndCapture();
+
+	// NOTE: Called by the recorded entry points through EVENT_RECORD_SCOPE,
+	// only while Capturing. Only the outermost call is recorded, the nested
+	// ones are its consequences.
+	KIWI_API static void Enter(EventRecordType Type, u16 Code, const EventContext &Context);
+	KIWI_API static void Leave();
+
+	// NOTE: Public so that EVENT_RECORD_SCOPE can test it inline, the entry
+	// points don't pay for a call when nothing is being recorded
+	KIWI_API static b8 Capturing;
+
+	// NOTE: Recording: write the marker of the frame.
+	// Suspended frames without inputs are skipped, they don't change anything.
+	static void EndFrame(u32 FrameIndex, f32 DeltaTime, b8 IsSuspended);
+
+	// NOTE: Replaying: feed the inputs of the next recorded frame and return its
+	// delta time. Returns false once the recording is over.
+	static b8 ReplayFrame(f32 &OutDeltaTime);
+
+private:
+	static void Write(EventRecordType Type, u16 Code, EventContext Context);
+	static void Flush();
+
+	static b8 Recording;
+	static b8 Replaying;
+	static u32 Depth;
+	static u32 RecordedThisFrame;
+
+	static PlatformFile File;
+	static u8 *Buffer;
+	static u64 BufferUsed;
+
+	static u8 *ReplayData;
+	static u64 ReplaySize;
+	static u64 ReplayCursor;
+};
+
+class EventRecordScope
+{
+public:
+	KIWI_INLINE EventRecordScope(EventRecordType Type, u16 Code, const EventContext &Context)
+		: Entered(EventRecorder::Capturing)
+	{
+		if (Entered)
+		{
+			EventRecorder::Enter(Type, Code, Context);
+		}
+	}
+	KIWI_INLINE ~EventRecordScope()
+	{
+		if (Entered)
+		{
+			EventRecorder::Leave();
+		}
+	}
+
+private:
+	b8 Entered;
+};
+
+#define EVENT_RECORD_SCOPE(Type, Code, Context) EventRecordScope EventRecordScopeInstance(Type, Code, Context)
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "defines.h"
+
+// NOTE: Fixed timestep accumulator. Every frame Advance() adds the frame
+// time and returns how many simulation steps to run, then GetAlpha() says
+// how far the frame is between the last two steps, for the renderer to
+// interpolate. At most MaxSteps run in a frame: when the simulation can't
+// keep up (or after a long stall) the extra time is dropped, catching up
+// would only make the next frame longer and so on (spiral of death).
+class FixedTimestep
+{
+public:
+	void Start(f64 Rate, u32 InMaxSteps)
+	{
+		Step = 1.0 / Rate;
+		MaxSteps = Max(InMaxSteps, 1u);
+		Accumulator = 0.0;
+		DroppedTime = 0.0;
+		StepCount = 0;
+	}
+
+	u32 Advance(f64 FrameTime)
+	{
+		Accumulator += FrameTime;
+		u64 Steps = (u64)(Accumulator / Step);
+		if (Steps > MaxSteps)
+		{
+			f64 Excess = (f64)(Steps - MaxSteps) * Step;
+			Accumulator -= Excess;
+			DroppedTime += Excess;
+			Steps = MaxSteps;
+		}
+
+		Accumulator = Max(Accumulator - (f64)Steps * Step, 0.0);
+		StepCount += Steps;
+		return (u32)Steps;
+	}
+
+	f32 GetAlpha() const
+	{
+		return (f32)Min(Accumulator / Step, 1.0);
+	}
+
+	f64 Step;
+	f64 Accumulator;
+	f64 DroppedTime;
+	u64 StepCount;
+	u32 MaxSteps;
+};
@@ -0,0 +1,160 @@
+#include "frame_pacer.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "core/clock.h"
+#include "platform/platform.h"
+
+f32 FramePacer::TargetFrameRate = 0.0f;
+u64 FramePacer::Period = 0;
+u64 FramePacer::NextDeadline = 0;
+u64 FramePacer::SleepMargin = 0;
+u64 FramePacer::Overshoots[FRAME_PACER_OVERSHOOT_SAMPLES] = {};
+u32 FramePacer::OvershootCount = 0;
+f32 FramePacer::Errors[FRAME_PACER_ERROR_SAMPLES] = {};
+u64 FramePacer::ErrorCount = 0;
+u32 FramePacer::MissedCount = 0;
+
+// NOTE: Insertion sort, the sample windows are small and mostly sorted already
+template <typename T>
+internal_func void SortPacerSamples(T *Samples, u32 Count)
+{
+	for (u32 Idx = 1; Idx < Count; ++Idx)
+	{
+		T Sample = Samples[Idx];
+		u32 Dest = Idx;
+		for (; Dest > 0 && Samples[Dest - 1] > Sample; --Dest)
+		{
+			Samples[Dest] = Samples[Dest - 1];
+		}
+		Samples[Dest] = Sample;
+	}
+}
+
+template <typename T>
+internal_func T PacerPercentile(const T *SortedSamples, u32 Count, f64 Percentile)
+{
+	return Count ? SortedSamples[(u32)((Count - 1) * Percentile + 0.5)] : (T)0;
+}
+
+void FramePacer::Initialize(f32 InTargetFrameRate)
+{
+	SetTargetFrameRate(InTargetFrameRate);
+	SleepMargin = Clock::SecondsToTicks(FRAME_PACER_INITIAL_MARGIN);
+	OvershootCount = 0;
+	ErrorCount = 0;
+	MissedCount = 0;
+}
+
+void FramePacer::Terminate()
+{
+	FramePacerStats Stats = GetStats();
+	if (!Stats.SampleCount)
+	{
+		return;
+	}
+
+	LogInfo("Frame pacing at %.1ffps: error p50 %.3fms, p90 %.3fms, p99 %.3fms, max %.3fms, "
+			"%u frames missed, sleep margin %.3fms",
+			Stats.TargetFrameRate, Stats.ErrorP50MS, Stats.ErrorP90MS, Stats.ErrorP99MS, Stats.ErrorMaxMS,
+			Stats.MissedCount, Stats.SleepMarginMS);
+}
+
+void FramePacer::SetTargetFrameRate(f32 FrameRate)
+{
+	TargetFrameRate = Max(FrameRate, 0.0f);
+	Period = TargetFrameRate > 0.0f ? Clock::SecondsToTicks(1.0 / TargetFrameRate) : 0;
+	// NOTE: The next Wait starts a new schedule
+	NextDeadline = 0;
+}
+
+f32 FramePacer::GetTargetFrameRate()
+{
+	return TargetFrameRate;
+}
+
+void FramePacer::AddOvershoot(i64 Overshoot)
+{
+	Overshoots[OvershootCount++ % FRAME_PACER_OVERSHOOT_SAMPLES] = (u64)Max(Overshoot, (i64)0);
+
+	u32 Count = Min(OvershootCount, (u32)FRAME_PACER_OVERSHOOT_SAMPLES);
+	if (Count < FRAME_PACER_OVERSHOOT_SAMPLES / 8)
+	{
+		return;
+	}
+
+	u64 Sorted[FRAME_PACER_OVERSHOOT_SAMPLES];
+	for (u32 Idx = 0; Idx < Count; ++Idx)
+	{
+		Sorted[Idx] = Overshoots[Idx];
+	}
+	SortPacerSamples(Sorted, Count);
+
+	// NOTE: Spinning the whole period is the worst it can get
+	SleepMargin = Clamp(PacerPercentile(Sorted, Count, FRAME_PACER_OVERSHOOT_PERCENTILE),
+						Clock::SecondsToTicks(FRAME_PACER_MIN_MARGIN), Period);
+}
+
+void FramePacer::Wait()
+{
+	if (!Period)
+	{
+		return;
+	}
+
+	KIWI_PROFILE_SCOPE("FramePacer::Wait");
+	u64 Now = Clock::Now();
+	u64 Deadline = NextDeadline;
+	if (!Deadline || Now >= Deadline)
+	{
+		if (Deadline)
+		{
+			++MissedCount;
+			// NOTE: A slow stretch misses every frame, the limiter keeps it to a few lines
+			// per second and --log renderer=error silences it, MissedCount still has them all
+			LogChannelWarning(Renderer, "Frame missed by %.3fms", Clock::TicksToMS(Now - Deadline));
+		}
+		NextDeadline = Now + Period;
+		return;
+	}
+
+	u64 Remaining = Deadline - Now;
+	if (Remaining > SleepMargin)
+	{
+		u64 Requested = Remaining - SleepMargin;
+		Platform::SleepPrecise(Clock::TicksToSeconds(Requested));
+		u64 WokeUp = Clock::Now();
+		AddOvershoot((i64)(WokeUp - Now - Requested));
+		Now = WokeUp;
+	}
+
+	while (Now < Deadline)
+	{
+		CpuPause();
+		Now = Clock::Now();
+	}
+
+	Errors[ErrorCount++ % FRAME_PACER_ERROR_SAMPLES] = (f32)Clock::TicksToSeconds(Now - Deadline);
+	NextDeadline = Deadline + Period;
+}
+
+FramePacerStats FramePacer::GetStats()
+{
+	FramePacerStats Stats = {};
+	Stats.TargetFrameRate = TargetFrameRate;
+	Stats.SampleCount = (u32)Min(ErrorCount, (u64)FRAME_PACER_ERROR_SAMPLES);
+	Stats.MissedCount = MissedCount;
+	Stats.SleepMarginMS = Clock::TicksToMS(SleepMargin);
+
+	f32 Sorted[FRAME_PACER_ERROR_SAMPLES];
+	for (u32 Idx = 0; Idx < Stats.SampleCount; ++Idx)
+	{
+		Sorted[Idx] = Errors[Idx];
+	}
+	SortPacerSamples(Sorted, Stats.SampleCount);
+
+	Stats.ErrorP50MS = PacerPercentile(Sorted, Stats.SampleCount, 0.5) * 1000.0;
+	Stats.ErrorP90MS = PacerPercentile(Sorted, Stats.SampleCount, 0.9) * 1000.0;
+	Stats.ErrorP99MS = PacerPercentile(Sorted, Stats.SampleCount, 0.99) * 1000.0;
+	Stats.ErrorMaxMS = Stats.SampleCount ? Sorted[Stats.SampleCount - 1] * 1000.0 : 0.0;
+	return Stats;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+/*
+NOTE: Frame pacing. Wait() holds the main loop until the end of the
+current frame slot: it sleeps with Platform::SleepPrecise for most of the
+remaining time and spins only the last SleepMargin, instead of spinning
+everything past the last whole millisecond.
+The margin is learned: every sleep measures how much it overslept, and
+the margin is a high percentile of the recent overshoots, so it follows
+whatever the OS timer and the load of the machine are doing.
+
+Deadlines follow a fixed schedule (the previous deadline + the period),
+so small errors don't accumulate. A frame that ends after its deadline
+is counted as missed and the schedule restarts from there, no attempt is
+made to catch up. A target rate of 0 runs uncapped.
+*/
+
+#include "defines.h"
+
+// NOTE: Sleep overshoots the margin is learned from
+#define FRAME_PACER_OVERSHOOT_SAMPLES 64
+#define FRAME_PACER_OVERSHOOT_PERCENTILE 0.95
+// NOTE: Before there are enough samples to learn from
+#define FRAME_PACER_INITIAL_MARGIN 0.002
+#define FRAME_PACER_MIN_MARGIN 0.0001
+// NOTE: Wake up errors the stats are computed from
+#define FRAME_PACER_ERROR_SAMPLES 1024
+
+// NOTE: Errors are how late Wait returned after the deadline, they
+// only account for the frames that were on time
+struct FramePacerStats
+{
+	f32 TargetFrameRate;
+	u32 SampleCount;
+	u32 MissedCount;
+	f64 SleepMarginMS;
+	f64 ErrorP50MS;
+	f64 ErrorP90MS;
+	f64 ErrorP99MS;
+	f64 ErrorMaxMS;
+};
+
+// NOTE: this is a singleton
+class FramePacer
+{
+public:
+	static void Initialize(f32 TargetFrameRate);
+	// NOTE: Logs the pacing stats of the run
+	static void Terminate();
+
+	// NOTE: Main thread, once per frame, once the frame's work is done
+	static void Wait();
+
+	// NOTE: 0 runs uncapped
+	KIWI_API static void SetTargetFrameRate(f32 FrameRate);
+	KIWI_API static f32 GetTargetFrameRate();
+	KIWI_API static FramePacerStats GetStats();
+
+private:
+	static void AddOvershoot(i64 Overshoot);
+
+	// NOTE: Times are Clock ticks
+	static f32 TargetFrameRate;
+	static u64 Period;
+	static u64 NextDeadline;
+	static u64 SleepMargin;
+	static u64 Overshoots[FRAME_PACER_OVERSHOOT_SAMPLES];
+	static u32 OvershootCount;
+	static f32 Errors[FRAME_PACER_ERROR_SAMPLES];
+	static u64 ErrorCount;
+	static u32 MissedCount;
+};
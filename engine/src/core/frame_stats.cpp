@@ -0,0 +1,144 @@
+#include "frame_stats.h"
+#include "core/logger.h"
+#include "core/kiwi_mem.h"
+#include "core/kiwi_string.h"
+#include "core/clock.h"
+
+FrameStatHistogram FrameStats::Total[FrameStat_Count] = {};
+FrameStatHistogram FrameStats::Window[FrameStat_Count] = {};
+u64 FrameStats::WindowSamples[FrameStat_Count][FRAME_STATS_WINDOW] = {};
+u64 FrameStats::WindowPos[FrameStat_Count] = {};
+
+#define FRAME_STATS_MAX_VALUE ((1ULL << FRAME_STATS_MAX_VALUE_BITS) - 1)
+
+local_var const char *FrameStatNames[FrameStat_Count] = {
+	"Frame",
+	"Cpu",
+	"Update",
+	"Render",
+	"Sleep",
+};
+
+internal_func void ResetFrameStatHistogram(FrameStatHistogram *Histogram)
+{
+	MemSystem::Zero(Histogram, sizeof(*Histogram));
+	Histogram->Min = (u64)-1;
+}
+
+internal_func f64 FrameStatPercentile(const FrameStatHistogram *Histogram, u64 MinValue, u64 MaxValue, f64 Percentile)
+{
+	// NOTE: The rank of the sample, 1 based, rounded up
+	u64 Rank = (u64)(Percentile * (f64)Histogram->Count + 0.999999);
+	Rank = Clamp(Rank, (u64)1, Histogram->Count);
+
+	u64 Seen = 0;
+	for (u32 Bucket = 0; Bucket < FRAME_STATS_BUCKET_COUNT; ++Bucket)
+	{
+		Seen += Histogram->Counts[Bucket];
+		if (Seen >= Rank)
+		{
+			// NOTE: Never report something outside of what was actually seen
+			return (f64)Clamp(HistogramBucketValue(Bucket, FRAME_STATS_SUB_BUCKET_BITS), MinValue, MaxValue) / 1000000.0;
+		}
+	}
+	return (f64)MaxValue / 1000000.0;
+}
+
+internal_func FrameStatSummary SummarizeFrameStat(const FrameStatHistogram *Histogram, u64 MinValue, u64 MaxValue)
+{
+	FrameStatSummary Summary = {};
+	Summary.Count = Histogram->Count;
+	if (!Histogram->Count)
+	{
+		return Summary;
+	}
+
+	Summary.MinMS = (f64)MinValue / 1000000.0;
+	Summary.MaxMS = (f64)MaxValue / 1000000.0;
+	Summary.MeanMS = (f64)Histogram->Sum / (f64)Histogram->Count / 1000000.0;
+	Summary.P50MS = FrameStatPercentile(Histogram, MinValue, MaxValue, 0.5);
+	Summary.P90MS = FrameStatPercentile(Histogram, MinValue, MaxValue, 0.9);
+	Summary.P99MS = FrameStatPercentile(Histogram, MinValue, MaxValue, 0.99);
+	Summary.P999MS = FrameStatPercentile(Histogram, MinValue, MaxValue, 0.999);
+	return Summary;
+}
+
+void FrameStats::Initialize()
+{
+	for (u32 Stat = 0; Stat < FrameStat_Count; ++Stat)
+	{
+		ResetFrameStatHistogram(&Total[Stat]);
+		ResetFrameStatHistogram(&Window[Stat]);
+		WindowPos[Stat] = 0;
+	}
+}
+
+void FrameStats::Terminate()
+{
+	if (!Total[FrameStat_Frame].Count)
+	{
+		return;
+	}
+
+	AutoFreeArena ScratchHandle = AutoFreeArena(MemTag_Scratch);
+	KStrBuilder Builder;
+	Builder.Begin(ScratchHandle.Arena);
+	Builder.Appendf("Frame stats of %llu frames (ms):", Total[FrameStat_Frame].Count);
+	Builder.Appendf("\n  %-8s %9s %9s %9s %9s %9s %9s %9s", "", "min", "mean", "p50", "p90", "p99", "p99.9", "max");
+	for (u32 Stat = 0; Stat < FrameStat_Count; ++Stat)
+	{
+		FrameStatSummary Summary = GetTotal((FrameStat)Stat);
+		Builder.Appendf("\n  %-8s %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f", FrameStatNames[Stat], Summary.MinMS,
+						Summary.MeanMS, Summary.P50MS, Summary.P90MS, Summary.P99MS, Summary.P999MS, Summary.MaxMS);
+	}
+	LogInfo("%s", Builder.End().Data);
+}
+
+void FrameStats::Record(FrameStat Stat, u64 Ticks)
+{
+	u64 Value = Min(Clock::TicksToNS(Ticks), FRAME_STATS_MAX_VALUE);
+	u32 Bucket = HistogramBucket(Value, FRAME_STATS_SUB_BUCKET_BITS);
+
+	FrameStatHistogram *Histogram = &Total[Stat];
+	++Histogram->Counts[Bucket];
+	++Histogram->Count;
+	Histogram->Sum += Value;
+	Histogram->Min = Min(Histogram->Min, Value);
+	Histogram->Max = Max(Histogram->Max, Value);
+
+	// NOTE: The oldest sample of the window makes room for the new one
+	Histogram = &Window[Stat];
+	u64 *Slot = &WindowSamples[Stat][WindowPos[Stat]++ % FRAME_STATS_WINDOW];
+	if (Histogram->Count == FRAME_STATS_WINDOW)
+	{
+		--Histogram->Counts[HistogramBucket(*Slot, FRAME_STATS_SUB_BUCKET_BITS)];
+		--Histogram->Count;
+		Histogram->Sum -= *Slot;
+	}
+	*Slot = Value;
+	++Histogram->Counts[Bucket];
+	++Histogram->Count;
+	Histogram->Sum += Value;
+}
+
+FrameStatSummary FrameStats::GetWindow(FrameStat Stat)
+{
+	u64 WindowMin = (u64)-1;
+	u64 WindowMax = 0;
+	for (u64 Idx = 0; Idx < Window[Stat].Count; ++Idx)
+	{
+		WindowMin = Min(WindowMin, WindowSamples[Stat][Idx]);
+		WindowMax = Max(WindowMax, WindowSamples[Stat][Idx]);
+	}
+	return SummarizeFrameStat(&Window[Stat], WindowMin, WindowMax);
+}
+
+FrameStatSummary FrameStats::GetTotal(FrameStat Stat)
+{
+	return SummarizeFrameStat(&Total[Stat], Total[Stat].Min, Total[Stat].Max);
+}
+
+const char *FrameStats::GetName(FrameStat Stat)
+{
+	return Stat < FrameStat_Count ? FrameStatNames[Stat] : "Invalid";
+}
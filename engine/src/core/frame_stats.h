@@ -0,0 +1,83 @@
+#pragma once
+
+/*
+NOTE: Frame time statistics, fed by Application::Run once per frame.
+Every stat has two log-linear histograms (core/histogram.h) of
+nanoseconds: one for the whole run and one for the last FRAME_STATS_WINDOW
+frames. With 64 sub-buckets every percentile is within ~1.6% of the real
+one whatever the magnitude, from nanoseconds to minutes.
+The window keeps the raw samples in a ring: the sample that falls out is
+removed from its bucket when a new one comes in. Recording is O(1) and
+everything is statically sized, nothing is allocated.
+*/
+
+#include "defines.h"
+#include "core/histogram.h"
+
+#define FRAME_STATS_WINDOW 4096
+#define FRAME_STATS_SUB_BUCKET_BITS 6
+// NOTE: Up to 2^40 ns (~18 minutes), longer samples are clamped
+#define FRAME_STATS_MAX_VALUE_BITS 40
+#define FRAME_STATS_BUCKET_COUNT HISTOGRAM_BUCKET_COUNT(FRAME_STATS_SUB_BUCKET_BITS, FRAME_STATS_MAX_VALUE_BITS)
+
+enum FrameStat
+{
+	// NOTE: From the end of a frame to the end of the next one, sleep included
+	FrameStat_Frame,
+	// NOTE: Frame minus Sleep
+	FrameStat_Cpu,
+	FrameStat_Update,
+	// NOTE: Game::Render and Renderer::DrawFrame
+	FrameStat_Render,
+	// NOTE: Time spent in FramePacer::Wait
+	FrameStat_Sleep,
+
+	FrameStat_Count
+};
+
+// NOTE: Min and Max are only tracked for the whole run, the window finds them in the ring
+struct FrameStatHistogram
+{
+	u32 Counts[FRAME_STATS_BUCKET_COUNT];
+	u64 Count;
+	u64 Sum;
+	u64 Min;
+	u64 Max;
+};
+
+struct FrameStatSummary
+{
+	u64 Count;
+	f64 MinMS;
+	f64 MaxMS;
+	f64 MeanMS;
+	f64 P50MS;
+	f64 P90MS;
+	f64 P99MS;
+	f64 P999MS;
+};
+
+// NOTE: this is a singleton
+class FrameStats
+{
+public:
+	static void Initialize();
+	// NOTE: Logs the stats of the whole run
+	static void Terminate();
+
+	// NOTE: Clock ticks
+	static void Record(FrameStat Stat, u64 Ticks);
+
+	// NOTE: Last FRAME_STATS_WINDOW frames
+	KIWI_API static FrameStatSummary GetWindow(FrameStat Stat);
+	// NOTE: Whole run
+	KIWI_API static FrameStatSummary GetTotal(FrameStat Stat);
+	KIWI_API static const char *GetName(FrameStat Stat);
+
+private:
+	static FrameStatHistogram Total[FrameStat_Count];
+	static FrameStatHistogram Window[FrameStat_Count];
+	static u64 WindowSamples[FrameStat_Count][FRAME_STATS_WINDOW];
+	// NOTE: Samples ever recorded in the window ring, the next one goes at WindowPos % FRAME_STATS_WINDOW
+	static u64 WindowPos[FrameStat_Count];
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+/*
+NOTE: Log-linear (HDR style) histogram buckets. A value lands in the
+bucket of its highest set bit, split in 2^SubBucketBits linear
+sub-buckets, so a bucket is within 1/2^SubBucketBits of the values in it
+whatever their magnitude. Values below 2^SubBucketBits get a bucket each.
+*/
+
+#include "defines.h"
+
+// NOTE: Buckets needed for values up to 2^MaxValueBits - 1
+#define HISTOGRAM_BUCKET_COUNT(SubBucketBits, MaxValueBits) (((MaxValueBits) - (SubBucketBits) + 1) << (SubBucketBits))
+
+KIWI_INLINE u32 HistogramBucket(u64 Value, u32 SubBucketBits)
+{
+	u64 SubBucketCount = 1ULL << SubBucketBits;
+	if (Value < SubBucketCount)
+	{
+		return (u32)Value;
+	}
+
+	u32 Shift = FindLastSet64(Value) - SubBucketBits;
+	return (Shift + 1) * (u32)SubBucketCount + (u32)((Value >> Shift) - SubBucketCount);
+}
+
+// NOTE: The middle of the range of values that land in the bucket
+KIWI_INLINE u64 HistogramBucketValue(u32 Bucket, u32 SubBucketBits)
+{
+	u32 SubBucketCount = 1u << SubBucketBits;
+	if (Bucket < SubBucketCount)
+	{
+		return Bucket;
+	}
+
+	u32 Shift = Bucket / SubBucketCount - 1;
+	u64 Lowest = (u64)(Bucket % SubBucketCount + SubBucketCount) << Shift;
+	return Lowest + ((1ULL << Shift) >> 1);
+}
@@ -1,5 +1,6 @@
 #include "input.h"
 #include "core/event.h"
+#include "core/event_recorder.h"
 #include "core/kiwi_mem.h"
 #include "core/logger.h"
 
@@ -19,7 +20,7 @@ void InputSystem::Initialize()
 {
 	// TODO: Do we really need this?
 	IsInitialized = true;
-	LogInfo("Input subsystem initialize");
+	LogChannelInfo(Input, "Input subsystem initialize");
 }
 
 void InputSystem::Terminate()
@@ -31,110 +32,155 @@ void InputSystem::Update()
 {
 	if (!IsInitialized)
 	{
-		LogError("Input system not initialized. Cannot update it's state");
+		LogChannelError(Input, "Input system not initialized. Cannot update it's state");
 		return;
 	}
 
-	Swap(CurrentKState, PreviousKState);
-	Swap(CurrentMState, PreviousMState);
+	// NOTE: The current state is only modified by the Process* functions,
+	// so the previous state has to be a snapshot of it, not a swap
+	*PreviousKState = *CurrentKState;
+	*PreviousMState = *CurrentMState;
 	MouseWheelZ = 0;
 }
 
 void InputSystem::ProcessKey(Key KeyCode, b8 Pressed)
 {
-	if (CurrentKState->Keys[KeyCode] != Pressed)
+	// NOTE: The OS can send virtual key codes that we don't map (yet)
+	if (KeyCode >= Key_Count)
+	{
+		return;
+	}
+
+	EventContext RecordContext = {};
+	RecordContext.u8[0] = Pressed;
+	EVENT_RECORD_SCOPE(EventRecordType_Key, KeyCode, RecordContext);
+
+	if (CurrentKState->Keys.Test(KeyCode) != Pressed)
 	{
 		// Update internal state
-		CurrentKState->Keys[KeyCode] = Pressed;
+		CurrentKState->Keys.Assign(KeyCode, Pressed);
 
-		// Fire an event
+		// Post an event
 		EventContext Context;
 		Context.u16[0] = (u16)KeyCode;
-		EventSystem::Fire(Pressed ? SEC_KeyPressed : SEC_KeyReleased, nullptr, Context);
+		EventSystem::Post(Pressed ? SEC_KeyPressed : SEC_KeyReleased, nullptr, Context);
 	}
 }
 
 b8 InputSystem::IsKeyDown(Key KeyCode)
 {
-	return CurrentKState->Keys[KeyCode];
+	return CurrentKState->Keys.Test(KeyCode);
 }
 
 b8 InputSystem::IsKeyUp(Key KeyCode)
 {
-	return !CurrentKState->Keys[KeyCode];
+	return !CurrentKState->Keys.Test(KeyCode);
 }
 
 b8 InputSystem::WasKeyDown(Key KeyCode)
 {
-	return PreviousKState->Keys[KeyCode];
+	return PreviousKState->Keys.Test(KeyCode);
 }
 
 b8 InputSystem::WasKeyUp(Key KeyCode)
 {
-	return !PreviousKState->Keys[KeyCode];
+	return !PreviousKState->Keys.Test(KeyCode);
+}
+
+KeySet InputSystem::GetKeysChanged()
+{
+	return CurrentKState->Keys ^ PreviousKState->Keys;
+}
+
+KeySet InputSystem::GetKeysPressed()
+{
+	return CurrentKState->Keys.AndNot(PreviousKState->Keys);
+}
+
+KeySet InputSystem::GetKeysReleased()
+{
+	return PreviousKState->Keys.AndNot(CurrentKState->Keys);
 }
 
 void InputSystem::ProcessMouseButton(MouseButton Button, b8 Pressed)
 {
-	if (CurrentMState->Buttons[Button] != Pressed)
+	EventContext RecordContext = {};
+	RecordContext.u8[0] = Pressed;
+	EVENT_RECORD_SCOPE(EventRecordType_MouseButton, Button, RecordContext);
+
+	if (CurrentMState->Buttons.Test(Button) != Pressed)
 	{
 		// Update internal state
-		CurrentMState->Buttons[Button] = Pressed;
+		CurrentMState->Buttons.Assign(Button, Pressed);
 
-		// Fire an event
+		// Post an event
 		EventContext Context;
 		Context.u16[0] = (u16)Button;
-		EventSystem::Fire(Pressed ? SEC_MouseButtonPressed : SEC_MouseButtonReleased, nullptr, Context);
+		EventSystem::Post(Pressed ? SEC_MouseButtonPressed : SEC_MouseButtonReleased, nullptr, Context);
 	}
 }
 
 void InputSystem::ProcessMouseMove(i16 X, i16 Y)
 {
+	EventContext RecordContext = {};
+	RecordContext.i16[0] = X;
+	RecordContext.i16[1] = Y;
+	EVENT_RECORD_SCOPE(EventRecordType_MouseMove, 0, RecordContext);
+
 	if (CurrentMState->X != X || CurrentMState->Y != Y)
 	{
-		// LogDebug("Mouse pos: %d, %d", X, Y);
+		// LogChannelDebug(Input, "Mouse pos: %d, %d", X, Y);
 
 		// Update internal state
 		CurrentMState->X = X;
 		CurrentMState->Y = Y;
 
-		// Fire an event
+		// Post an event
 		EventContext Context;
 		Context.i16[0] = (i16)X;
 		Context.i16[1] = (i16)Y;
-		EventSystem::Fire(SEC_MouseMoved, nullptr, Context);
+		EventSystem::Post(SEC_MouseMoved, nullptr, Context);
 	}
 }
 
 void InputSystem::ProcessMouseWheel(i8 ZDelta)
 {
+	EventContext RecordContext = {};
+	RecordContext.i8[0] = ZDelta;
+	EVENT_RECORD_SCOPE(EventRecordType_MouseWheel, 0, RecordContext);
+
 	// Update internal state
 	MouseWheelZ = ZDelta;
 
-	// Fire an event
+	// Post an event
 	EventContext Context;
 	Context.i8[0] = (i8)ZDelta;
-	EventSystem::Fire(SEC_MouseWheel, nullptr, Context);
+	EventSystem::Post(SEC_MouseWheel, nullptr, Context);
 }
 
 b8 InputSystem::IsMouseButtonDown(MouseButton Button)
 {
-	return CurrentMState->Buttons[Button];
+	return CurrentMState->Buttons.Test(Button);
 }
 
 b8 InputSystem::IsMouseButtonUp(MouseButton Button)
 {
-	return !CurrentMState->Buttons[Button];
+	return !CurrentMState->Buttons.Test(Button);
 }
 
 b8 InputSystem::WasMouseButtonDown(MouseButton Button)
 {
-	return PreviousMState->Buttons[Button];
+	return PreviousMState->Buttons.Test(Button);
 }
 
 b8 InputSystem::WasMouseButtonUp(MouseButton Button)
 {
-	return !PreviousMState->Buttons[Button];
+	return !PreviousMState->Buttons.Test(Button);
+}
+
+MouseButtonSet InputSystem::GetMouseButtonsChanged()
+{
+	return CurrentMState->Buttons ^ PreviousMState->Buttons;
 }
 
 void InputSystem::GetMousePosition(i16 &X, i16 &Y)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "defines.h"
+#include "containers/kbitset.h"
 
 enum MouseButton : u8
 {
@@ -147,14 +148,19 @@ enum Key : u16
 	Key_Count
 };
 
+typedef KBitSet<Key_Count> KeySet;
+typedef KBitSet<MouseButton_Count> MouseButtonSet;
+
+// NOTE: One bit per key/button so that comparing two frames
+// is a couple of vector ops instead of a loop over every key
 struct KeyboardState
 {
-	b8 Keys[Key_Count];
+	KeySet Keys;
 };
 
 struct MouseState
 {
-	b8 Buttons[MouseButton_Count];
+	MouseButtonSet Buttons;
 	i16 X;
 	i16 Y;
 };
@@ -175,6 +181,11 @@ public:
 	KIWI_API static b8 WasKeyDown(Key KeyCode);
 	KIWI_API static b8 WasKeyUp(Key KeyCode);
 
+	// NOTE: Whole-keyboard queries, computed as current/previous frame set operations
+	KIWI_API static KeySet GetKeysChanged();
+	KIWI_API static KeySet GetKeysPressed();
+	KIWI_API static KeySet GetKeysReleased();
+
 	// Mouse
 	static void ProcessMouseButton(MouseButton Button, b8 Pressed);
 	static void ProcessMouseMove(i16 X, i16 Y);
@@ -184,6 +195,7 @@ public:
 	KIWI_API static b8 IsMouseButtonUp(MouseButton Button);
 	KIWI_API static b8 WasMouseButtonDown(MouseButton Button);
 	KIWI_API static b8 WasMouseButtonUp(MouseButton Button);
+	KIWI_API static MouseButtonSet GetMouseButtonsChanged();
 	KIWI_API static void GetMousePosition(i16 &X, i16 &Y);
 	KIWI_API static void GetPreviousMousePosition(i16 &X, i16 &Y);
 	KIWI_API static i8 GetMouseWheelDelta();
@@ -1,5 +1,6 @@
 #include "core/kiwi_mem.h"
 #include "core/logger.h"
+#include "core/kiwi_string.h"
 #include "platform/platform.h"
 
 // MEMORY SYSTEM
@@ -13,6 +14,10 @@ local_var const char *MemTagStrings[MemTag_Count] = {
 	"MemTag_KArray",
 	"MemTag_Renderer",
 	"MemTag_String",
+	"MemTag_Logger",
+	"MemTag_Profiler",
+	"MemTag_Metrics",
+	"MemTag_Frame",
 	"MemTag_Unclear",
 };
 
@@ -33,15 +38,16 @@ void MemSystem::Initialize()
 
 	for (u8 Idx = 1; Idx < MemTag_Count; ++Idx)
 	{
-		// NOTE: by allocating 1 byte in the arena we automatically
-		// 16 pages and commit one
-		Arenas[Idx].Allocate(1, Idx);
+		// NOTE: by allocating 1 byte in the arena we commit a single page,
+		// the rest of the address space is only reserved
+		Arenas[Idx].Allocate(1, Idx, MEM_ARENA_DEFAULT_RESERVE);
 	}
 }
 
 void MemSystem::Terminate()
 {
-	Report();
+	AutoFreeArena ScratchArenaHandle = AutoFreeArena(MemTag_Scratch);
+	LogChannelInfo(Memory, "%s", Report(ScratchArenaHandle.Arena));
 }
 
 MemArena *MemSystem::GetArena(u8 Tag)
@@ -69,58 +75,58 @@ void MemSystem::Copy(void *Dest, void *Source, u64 Size)
 	Platform::CopyMem(Dest, Source, Size);
 }
 
-// TODO: Make this actually return a string once we have them
-#include <string.h>
-#include <stdio.h>
-// TODO: Hardocded number matching what the logger espects
-#define STRING_LENGTH 3999
-char *MemSystem::Report()
+internal_func void AppendMemorySize(KStrBuilder &Builder, u64 Size)
 {
-#if 0
-	// TODO: This function is currently LEAKING MEMORY
-	char Buffer[STRING_LENGTH] = "SYSTEM MEMORY USE:\n";
-	u32 BufferOffset = (u32)strlen(Buffer);
-	for (u32 Index = 0; Index < MemTag_Count; ++Index)
+	if (Size >= GiB(1))
+		Builder.Appendf("%.2fGiB", ToGiB(Size));
+	else if (Size >= MiB(1))
+		Builder.Appendf("%.2fMiB", ToMiB(Size));
+	else if (Size >= KiB(1))
+		Builder.Appendf("%.2fKiB", ToKiB(Size));
+	else
+		Builder.Appendf("%lluB", Size);
+}
+
+char *MemSystem::Report(MemArena *Arena)
+{
+	KStrBuilder Builder;
+	Builder.Begin(Arena);
+	Builder.Append("SYSTEM MEMORY USE (occupied / committed / reserved):\n");
+
+	for (u32 Index = 1; Index < MemTag_Count; ++Index)
 	{
-		char Unit[4] = "_iB";
-		f32 Amount = 1.0f;
-		if (MemSystem::TaggedAllocated[Index] >= GiB(1))
-		{
-			Unit[0] = 'G';
-			Amount = (f32)ToGiB(MemSystem::TaggedAllocated[Index]);
-		}
-		if (MemSystem::TaggedAllocated[Index] >= MiB(1))
-		{
-			Unit[0] = 'M';
-			Amount = (f32)ToMiB(MemSystem::TaggedAllocated[Index]);
-		}
-		if (MemSystem::TaggedAllocated[Index] >= KiB(1))
-		{
-			Unit[0] = 'K';
-			Amount = (f32)ToKiB(MemSystem::TaggedAllocated[Index]);
-		}
-		else
-		{
-			Unit[0] = 'B';
-			Unit[1] = '\0';
-			Amount = (f32)MemSystem::TaggedAllocated[Index];
-		}
-		BufferOffset += snprintf(Buffer + BufferOffset, 3999, "  %s: %.2f%s\n",
-								 MemTagStrings[Index], Amount, Unit);
+		MemArena *Current = &Arenas[Index];
+		Builder.Appendf("  %s: ", MemTagStrings[Index]);
+		AppendMemorySize(Builder, Current->OccupiedMem);
+		Builder.Append(" / ");
+		AppendMemorySize(Builder, Current->CommittedMem);
+		Builder.Append(" / ");
+		AppendMemorySize(Builder, Current->ReservedMem);
+		Builder.AppendChar('\n');
 	}
 
-	return _strdup(Buffer);
+#ifdef KIWI_SLOW
+	Builder.Append("  Total committed: ");
+	AppendMemorySize(Builder, TotalCommitted);
+	Builder.Append(", total reserved: ");
+	AppendMemorySize(Builder, TotalReserved);
 #endif
-	return (char *)"Not working right now";
+
+	return (char *)Builder.End().Data;
+}
+
+const char *MemSystem::GetTagName(u8 Tag)
+{
+	return Tag < MemTag_Count ? MemTagStrings[Tag] : "MemTag_Invalid";
 }
 
 // MEMORY ARENA
 
-void MemArena::Allocate(u64 Size, u8 Tag)
+void MemArena::Allocate(u64 Size, u8 Tag, u64 MinReserveSize)
 {
 	if (Tag == MemTag_Unknown)
 	{
-		LogWarning("Creating arena with memory tag Unknown. This should be tagged");
+		LogChannelWarning(Memory, "Creating arena with memory tag Unknown. This should be tagged");
 	}
 
 	MemTag = Tag;
@@ -129,25 +135,23 @@ void MemArena::Allocate(u64 Size, u8 Tag)
 	// and if it succedes we then commit the amount we need to cover the size required.
 	// Since this is not expected to happen often, we can afford the double syscall.
 	// NOTE: We reserve a multiple of MemSystem::AllocatorGranularity.
-	u64 ReserveSize = ((Size / MemSystem::AllocatorGranularity) + 1) * MemSystem::AllocatorGranularity;
+	u64 SizeToReserve = Max(Size, MinReserveSize);
+	u64 ReserveSize = ((SizeToReserve + MemSystem::AllocatorGranularity - 1) / MemSystem::AllocatorGranularity) * MemSystem::AllocatorGranularity;
 	BasePtr = Platform::Allocate(nullptr, ReserveSize, MemAlloc_Reserve | MemAlloc_NoAccess);
 
 	if (!BasePtr)
 	{
-		LogFatal("Allocation of %d bytes with tag %s failed!", Size, MemTagStrings[Tag]);
-		LogFatal(Platform::GetLastErrorMessage());
+		LogChannelFatal(Memory, "Allocation of %d bytes with tag %s failed!", Size, MemTagStrings[Tag]);
+		LogChannelFatal(Memory, Platform::GetLastErrorMessage());
 		KDebugBreak();
 		return;
 	}
 
-	Platform::Allocate(BasePtr, Size, MemAlloc_Commit | MemAlloc_ReadWrite);
+	u64 CommitSize = ((Size / MemSystem::PageSize) + 1) * MemSystem::PageSize;
+	Platform::Allocate(BasePtr, CommitSize, MemAlloc_Commit | MemAlloc_ReadWrite);
 
-	u32 PagesGranularity = MemSystem::AllocatorGranularity / MemSystem::PageSize;
-	u32 CommittedPages = ((u32)Size / MemSystem::PageSize) + 1;
-	u32 ReservedPages = ((CommittedPages / PagesGranularity) + 1) * PagesGranularity;
-
-	ReservedMem = ReservedPages * MemSystem::PageSize;
-	CommittedMem = CommittedPages * MemSystem::PageSize;
+	ReservedMem = ReserveSize;
+	CommittedMem = CommitSize;
 
 #ifdef KIWI_SLOW
 	MemSystem::TotalReserved += ReservedMem;
@@ -183,16 +187,16 @@ void *MemArena::PushNoZero(u64 Size)
 	if (NewOccupiedMem > CommittedMem)
 	{
 		u64 MemoryToCommit = Size - (CommittedMem - OccupiedMem);
-		if ((CommittedMem + MemoryToCommit) < ReservedMem)
+		u64 PagesToCommit = (MemoryToCommit + MemSystem::PageSize - 1) / MemSystem::PageSize;
+		u64 MemoryToCommitPageAlligned = (PagesToCommit * MemSystem::PageSize);
+		if ((CommittedMem + MemoryToCommitPageAlligned) <= ReservedMem)
 		{
-			u64 PagesToCommit = (MemoryToCommit / MemSystem::PageSize) + 1;
-			u64 MemoryToCommitPageAlligned = (PagesToCommit * MemSystem::PageSize);
 			void *CommitAddress = (void *)((u8 *)BasePtr + CommittedMem);
 			void *AllocResult = Platform::Allocate(CommitAddress, MemoryToCommitPageAlligned, MemAlloc_Commit | MemAlloc_ReadWrite);
 
 			if (!AllocResult)
 			{
-				LogError(Platform::GetLastErrorMessage());
+				LogChannelError(Memory, Platform::GetLastErrorMessage());
 				return nullptr;
 			}
 
@@ -207,7 +211,7 @@ void *MemArena::PushNoZero(u64 Size)
 			// TODO: We need a strategy for this:
 			// - Big contiguos reserve?
 			// - Chained Arenas?
-			LogFatal("No more Reserved Memory left in arena with tag %s", MemTagStrings[MemTag]);
+			LogChannelFatal(Memory, "No more Reserved Memory left in arena with tag %s", MemTagStrings[MemTag]);
 			KDebugBreak();
 			return nullptr;
 		}
@@ -224,6 +228,24 @@ void *MemArena::Push(u64 Size)
 	return Result;
 }
 
+void *MemArena::PushNoZeroAligned(u64 Size, u64 Alignment)
+{
+	u64 Address = (u64)BasePtr + OccupiedMem;
+	u64 Padding = ((Address + Alignment - 1) & ~(Alignment - 1)) - Address;
+	u8 *Result = (u8 *)PushNoZero(Padding + Size);
+	return Result ? Result + Padding : nullptr;
+}
+
+void *MemArena::PushAligned(u64 Size, u64 Alignment)
+{
+	void *Result = PushNoZeroAligned(Size, Alignment);
+	if (Result)
+	{
+		Platform::ZeroMem(Result, Size);
+	}
+	return Result;
+}
+
 void MemArena::Pop(u64 Size)
 {
 	// TODO: Do we want to decommit the pages at some point
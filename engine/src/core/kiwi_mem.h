@@ -13,6 +13,11 @@ enum MemTag
 	MemTag_KArray,
 	MemTag_Renderer,
 	MemTag_String,
+	MemTag_Logger,
+	MemTag_Profiler,
+	MemTag_Metrics,
+	// NOTE: Cleared at the end of every frame by Application::Run
+	MemTag_Frame,
 
 	// NOTE: All the allocation done in this arena are never gonna be cleared because
 	// it means that we still have to figure out where they should be placed so their
@@ -23,6 +28,10 @@ enum MemTag
 	MemTag_Count
 };
 
+// NOTE: Address space reserved by each of the MemSystem arenas.
+// Only the pages that are actually used get committed.
+#define MEM_ARENA_DEFAULT_RESERVE MiB(64)
+
 enum MemAlloc
 {
 	// Type
@@ -64,11 +73,14 @@ enum MemDealloc
 class KIWI_API MemArena
 {
 public:
-	void Allocate(u64 Size, u8 Tag);
+	void Allocate(u64 Size, u8 Tag, u64 MinReserveSize = 0);
 	void Free();
 
 	void *PushNoZero(u64 Size);
 	void *Push(u64 Size);
+	// NOTE: Alignment must be a power of 2, the padding is part of the occupied memory
+	void *PushNoZeroAligned(u64 Size, u64 Alignment);
+	void *PushAligned(u64 Size, u64 Alignment);
 	void Pop(u64 Size);
 	void PopAt(u64 MemoryLeft);
 	void Clear();
@@ -104,7 +116,9 @@ public:
 	static void Set(void *Address, u64 Size, u32 Value);
 	static void Zero(void *Address, u64 Size);
 	static void Copy(void *Dest, void *Source, u64 Size);
-	static char *Report();
+	// NOTE: The report is built on top of the given arena
+	static char *Report(MemArena *Arena);
+	static const char *GetTagName(u8 Tag);
 
 #ifdef KIWI_SLOW
 	static u64 TotalReserved;
@@ -1,33 +1,504 @@
 #include "kiwi_string.h"
 #include "core/kiwi_mem.h"
 
-// TODO: Custom strings one day
+#include <immintrin.h>
 #include <string.h>
+#include <stdio.h>
 
+// VECTOR HELPERS
+// NOTE: Everything below is written against this handful of helpers so the
+// same code runs 32 bytes at a time with AVX2 and 16 with SSE2, which every
+// x64 cpu has. The SSE4.2 string instructions (pcmpistri and friends) are
+// not used: they are slower than plain compares + movemask on recent cpus.
+#if defined(__AVX2__)
+#define KSTR_VEC_WIDTH 32
+#define KSTR_VEC_FULL_MASK 0xFFFFFFFFu
+typedef __m256i KStrVec;
+
+KIWI_INLINE KStrVec KStrVecLoad(const char *Ptr) { return _mm256_loadu_si256((const __m256i *)Ptr); }
+KIWI_INLINE KStrVec KStrVecSet(char C) { return _mm256_set1_epi8(C); }
+KIWI_INLINE u32 KStrVecEqMask(KStrVec A, KStrVec B) { return (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(A, B)); }
+KIWI_INLINE KStrVec KStrVecEq(KStrVec A, KStrVec B) { return _mm256_cmpeq_epi8(A, B); }
+KIWI_INLINE KStrVec KStrVecOr(KStrVec A, KStrVec B) { return _mm256_or_si256(A, B); }
+KIWI_INLINE KStrVec KStrVecAnd(KStrVec A, KStrVec B) { return _mm256_and_si256(A, B); }
+KIWI_INLINE KStrVec KStrVecMin(KStrVec A, KStrVec B) { return _mm256_min_epu8(A, B); }
+KIWI_INLINE u32 KStrVecMask(KStrVec V) { return (u32)_mm256_movemask_epi8(V); }
+KIWI_INLINE KStrVec KStrVecToLower(KStrVec V)
+{
+	// NOTE: Signed compares, bytes >= 0x80 are negative and never in range
+	__m256i IsUpper = _mm256_and_si256(_mm256_cmpgt_epi8(V, _mm256_set1_epi8('A' - 1)),
+									   _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), V));
+	return _mm256_or_si256(V, _mm256_and_si256(IsUpper, _mm256_set1_epi8(0x20)));
+}
+#else
+#define KSTR_VEC_WIDTH 16
+#define KSTR_VEC_FULL_MASK 0xFFFFu
+typedef __m128i KStrVec;
+
+KIWI_INLINE KStrVec KStrVecLoad(const char *Ptr) { return _mm_loadu_si128((const __m128i *)Ptr); }
+KIWI_INLINE KStrVec KStrVecSet(char C) { return _mm_set1_epi8(C); }
+KIWI_INLINE u32 KStrVecEqMask(KStrVec A, KStrVec B) { return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(A, B)); }
+KIWI_INLINE KStrVec KStrVecEq(KStrVec A, KStrVec B) { return _mm_cmpeq_epi8(A, B); }
+KIWI_INLINE KStrVec KStrVecOr(KStrVec A, KStrVec B) { return _mm_or_si128(A, B); }
+KIWI_INLINE KStrVec KStrVecAnd(KStrVec A, KStrVec B) { return _mm_and_si128(A, B); }
+KIWI_INLINE KStrVec KStrVecMin(KStrVec A, KStrVec B) { return _mm_min_epu8(A, B); }
+KIWI_INLINE u32 KStrVecMask(KStrVec V) { return (u32)_mm_movemask_epi8(V); }
+KIWI_INLINE KStrVec KStrVecToLower(KStrVec V)
+{
+	// NOTE: Signed compares, bytes >= 0x80 are negative and never in range
+	__m128i IsUpper = _mm_and_si128(_mm_cmpgt_epi8(V, _mm_set1_epi8('A' - 1)),
+									_mm_cmplt_epi8(V, _mm_set1_epi8('Z' + 1)));
+	return _mm_or_si128(V, _mm_and_si128(IsUpper, _mm_set1_epi8(0x20)));
+}
+#endif
+
+// NOTE: The smallest page size we can run on. A load that doesn't cross a
+// multiple of it can't fault as long as its first byte is readable.
+#define KSTR_PAGE_SIZE 4096
+// NOTE: The main loops handle this many vectors per iteration and test them
+// with a single movemask, one vector per iteration is bound by the loop itself
+#define KSTR_UNROLL 4
+#define KSTR_BLOCK_WIDTH (KSTR_UNROLL * KSTR_VEC_WIDTH)
+
+struct KStrFoldNone
+{
+	static KIWI_INLINE KStrVec Apply(KStrVec V) { return V; }
+	static KIWI_INLINE u8 Apply(u8 C) { return C; }
+};
+
+struct KStrFoldLower
+{
+	static KIWI_INLINE KStrVec Apply(KStrVec V) { return KStrVecToLower(V); }
+	static KIWI_INLINE u8 Apply(u8 C) { return (C >= 'A' && C <= 'Z') ? (u8)(C | 0x20) : C; }
+};
+
+// NOTE: A byte of the result is 0 where the strings differ or where A has its
+// terminator: the compare gives 0 where they differ, 0xFF elsewhere, the
+// minimum with A keeps A's zeros. Four of them reduce with one more minimum.
+template <typename Fold>
+KIWI_INLINE KStrVec KStrEqualTerminatedStops(const char *StrA, const char *StrB)
+{
+	KStrVec A = Fold::Apply(KStrVecLoad(StrA));
+	KStrVec B = Fold::Apply(KStrVecLoad(StrB));
+	return KStrVecMin(A, KStrVecEq(A, B));
+}
+
+template <typename Fold>
+internal_func b8 KStrEqualTerminated(const char *StrA, const char *StrB)
+{
+	KStrVec Zero = KStrVecSet(0);
+	u64 Idx = 0;
+	for (;;)
+	{
+		// NOTE: The two strings are rarely aligned the same way, so the loads
+		// can't be aligned. Unaligned ones are fine as long as they don't cross
+		// into the next page: the vectors run up to the nearer page end of the
+		// two, the few bytes left before it go one at a time and the next run
+		// starts on the other side.
+		u64 ToPageEndA = KSTR_PAGE_SIZE - ((u64)(StrA + Idx) & (KSTR_PAGE_SIZE - 1));
+		u64 ToPageEndB = KSTR_PAGE_SIZE - ((u64)(StrB + Idx) & (KSTR_PAGE_SIZE - 1));
+		u64 Run = Min(ToPageEndA, ToPageEndB);
+		u64 VectorEnd = Idx + (Run & ~(u64)(KSTR_VEC_WIDTH - 1));
+
+		for (; Idx + KSTR_BLOCK_WIDTH <= VectorEnd; Idx += KSTR_BLOCK_WIDTH)
+		{
+			KStrVec Stops0 = KStrEqualTerminatedStops<Fold>(StrA + Idx, StrB + Idx);
+			KStrVec Stops1 = KStrEqualTerminatedStops<Fold>(StrA + Idx + KSTR_VEC_WIDTH, StrB + Idx + KSTR_VEC_WIDTH);
+			KStrVec Stops2 = KStrEqualTerminatedStops<Fold>(StrA + Idx + 2 * KSTR_VEC_WIDTH,
+															StrB + Idx + 2 * KSTR_VEC_WIDTH);
+			KStrVec Stops3 = KStrEqualTerminatedStops<Fold>(StrA + Idx + 3 * KSTR_VEC_WIDTH,
+															StrB + Idx + 3 * KSTR_VEC_WIDTH);
+			KStrVec Stops = KStrVecMin(KStrVecMin(Stops0, Stops1), KStrVecMin(Stops2, Stops3));
+			if (KStrVecEqMask(Stops, Zero))
+			{
+				u64 Low = (u64)KStrVecEqMask(Stops0, Zero) | ((u64)KStrVecEqMask(Stops1, Zero) << KSTR_VEC_WIDTH);
+				u64 High = (u64)KStrVecEqMask(Stops2, Zero) | ((u64)KStrVecEqMask(Stops3, Zero) << KSTR_VEC_WIDTH);
+				u64 Stop = Idx + (Low ? FindFirstSet64(Low) : 2 * KSTR_VEC_WIDTH + FindFirstSet64(High));
+				return StrA[Stop] == StrB[Stop];
+			}
+		}
+
+		for (; Idx < VectorEnd; Idx += KSTR_VEC_WIDTH)
+		{
+			u32 Mask = KStrVecEqMask(KStrEqualTerminatedStops<Fold>(StrA + Idx, StrB + Idx), Zero);
+			if (Mask)
+			{
+				u64 Stop = Idx + FindFirstSet64(Mask);
+				return StrA[Stop] == StrB[Stop];
+			}
+		}
+
+		for (u64 PageEnd = Idx + (Run & (KSTR_VEC_WIDTH - 1)); Idx < PageEnd; ++Idx)
+		{
+			u8 A = Fold::Apply((u8)StrA[Idx]);
+			u8 B = Fold::Apply((u8)StrB[Idx]);
+			if (A != B)
+			{
+				return false;
+			}
+			if (!A)
+			{
+				return true;
+			}
+		}
+	}
+}
+
+template <typename Fold>
+internal_func b8 KStrEqualBytes(const char *StrA, const char *StrB, u64 Length)
+{
+	u64 Idx = 0;
+	for (; Idx + KSTR_BLOCK_WIDTH <= Length; Idx += KSTR_BLOCK_WIDTH)
+	{
+		KStrVec Same0 = KStrVecEq(Fold::Apply(KStrVecLoad(StrA + Idx)), Fold::Apply(KStrVecLoad(StrB + Idx)));
+		KStrVec Same1 = KStrVecEq(Fold::Apply(KStrVecLoad(StrA + Idx + KSTR_VEC_WIDTH)),
+								  Fold::Apply(KStrVecLoad(StrB + Idx + KSTR_VEC_WIDTH)));
+		KStrVec Same2 = KStrVecEq(Fold::Apply(KStrVecLoad(StrA + Idx + 2 * KSTR_VEC_WIDTH)),
+								  Fold::Apply(KStrVecLoad(StrB + Idx + 2 * KSTR_VEC_WIDTH)));
+		KStrVec Same3 = KStrVecEq(Fold::Apply(KStrVecLoad(StrA + Idx + 3 * KSTR_VEC_WIDTH)),
+								  Fold::Apply(KStrVecLoad(StrB + Idx + 3 * KSTR_VEC_WIDTH)));
+		if (KStrVecMask(KStrVecAnd(KStrVecAnd(Same0, Same1), KStrVecAnd(Same2, Same3))) != KSTR_VEC_FULL_MASK)
+		{
+			return false;
+		}
+	}
+
+	for (; Idx + KSTR_VEC_WIDTH <= Length; Idx += KSTR_VEC_WIDTH)
+	{
+		KStrVec A = Fold::Apply(KStrVecLoad(StrA + Idx));
+		KStrVec B = Fold::Apply(KStrVecLoad(StrB + Idx));
+		if (KStrVecEqMask(A, B) != KSTR_VEC_FULL_MASK)
+		{
+			return false;
+		}
+	}
+
+	if (Idx == Length)
+	{
+		return true;
+	}
+
+	if (Length >= KSTR_VEC_WIDTH)
+	{
+		// NOTE: Redo the last full vector, overlapping the part we already checked
+		Idx = Length - KSTR_VEC_WIDTH;
+		KStrVec A = Fold::Apply(KStrVecLoad(StrA + Idx));
+		KStrVec B = Fold::Apply(KStrVecLoad(StrB + Idx));
+		return KStrVecEqMask(A, B) == KSTR_VEC_FULL_MASK;
+	}
+
+	for (; Idx < Length; ++Idx)
+	{
+		if (Fold::Apply((u8)StrA[Idx]) != Fold::Apply((u8)StrB[Idx]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// NOTE: The plain scans and compares go to libc. glibc picks an AVX2/AVX-512
+// version at load time and was measured 2-5x faster than our SSE2 loops, even
+// unrolled (the kstr.*_4k benchmarks against their libc.* twins). What libc
+// doesn't have, the ASCII case folding and the substring search on views, stays ours.
 u64 KStr::Length(const char *Str)
 {
 	return strlen(Str);
 }
 
-// TODO: Fix this
-char *KStr::Duplicate(const char *Str)
+KStrView KStr::View(const char *Str)
 {
-	KDebugBreak();
-#if 0
-	// NOTE: +1 for the null terminator
-	u64 Len = KStr::Length(Str) + 1;
+	return {KStr::Length(Str), Str};
+}
 
-	char *Copy = (char *)MemSystem::Allocate(Len, MemTag_String);
-	MemSystem::Copy(Copy, (void *)Str, Len);
+char *KStr::Duplicate(const char *Str, MemArena *Arena)
+{
+	return (char *)Duplicate(View(Str), Arena).Data;
+}
 
-	return Copy;
-#else
-	Str;
-	return (char *)"";
-#endif
+KStrView KStr::Duplicate(KStrView Str, MemArena *Arena)
+{
+	char *Copy = (char *)Arena->PushNoZero(Str.Length + 1);
+	if (!Copy)
+	{
+		return {0, ""};
+	}
+
+	MemSystem::Copy(Copy, (void *)Str.Data, Str.Length);
+	Copy[Str.Length] = '\0';
+
+	return {Str.Length, Copy};
 }
 
 b8 KStr::Equal(const char *StrA, const char *StrB)
 {
 	return strcmp(StrA, StrB) == 0;
-}
\ No newline at end of file
+}
+
+b8 KStr::Equal(KStrView StrA, KStrView StrB)
+{
+	return StrA.Length == StrB.Length && memcmp(StrA.Data, StrB.Data, StrA.Length) == 0;
+}
+
+b8 KStr::EqualIgnoreCase(const char *StrA, const char *StrB)
+{
+	return KStrEqualTerminated<KStrFoldLower>(StrA, StrB);
+}
+
+b8 KStr::EqualIgnoreCase(KStrView StrA, KStrView StrB)
+{
+	return StrA.Length == StrB.Length && KStrEqualBytes<KStrFoldLower>(StrA.Data, StrB.Data, StrA.Length);
+}
+
+u64 KStr::FindChar(const char *Str, char C)
+{
+	const char *Found = strchr(Str, C);
+	return Found ? (u64)(Found - Str) : KSTR_NOT_FOUND;
+}
+
+u64 KStr::FindChar(KStrView Str, char C)
+{
+	const char *Found = (const char *)memchr(Str.Data, C, Str.Length);
+	return Found ? (u64)(Found - Str.Data) : KSTR_NOT_FOUND;
+}
+
+u64 KStr::FindSubstring(const char *Str, const char *Substring)
+{
+	return FindSubstring(View(Str), View(Substring));
+}
+
+u64 KStr::FindSubstring(KStrView Str, KStrView Substring)
+{
+	if (Substring.Length == 0)
+	{
+		return 0;
+	}
+	if (Substring.Length > Str.Length)
+	{
+		return KSTR_NOT_FOUND;
+	}
+	if (Substring.Length == 1)
+	{
+		return FindChar(Str, Substring.Data[0]);
+	}
+
+	// NOTE: Look for the first and the last character of the substring at the
+	// right distance from each other, a vector of candidates at a time.
+	// Only the candidates that match both get the full comparison, which
+	// filters out nearly everything on real text.
+	u64 LastOffset = Substring.Length - 1;
+	u64 LastStart = Str.Length - Substring.Length;
+	KStrVec First = KStrVecSet(Substring.Data[0]);
+	KStrVec Last = KStrVecSet(Substring.Data[LastOffset]);
+
+	u64 Idx = 0;
+	for (; Idx + LastOffset + KSTR_VEC_WIDTH <= Str.Length; Idx += KSTR_VEC_WIDTH)
+	{
+		u32 Mask = KStrVecEqMask(KStrVecLoad(Str.Data + Idx), First) &
+				   KStrVecEqMask(KStrVecLoad(Str.Data + Idx + LastOffset), Last);
+		while (Mask)
+		{
+			u64 Candidate = Idx + FindFirstSet64(Mask);
+			if (KStrEqualBytes<KStrFoldNone>(Str.Data + Candidate + 1, Substring.Data + 1, Substring.Length - 2))
+			{
+				return Candidate;
+			}
+			Mask &= Mask - 1;
+		}
+	}
+
+	for (; Idx <= LastStart; ++Idx)
+	{
+		if (Str.Data[Idx] == Substring.Data[0] && Str.Data[Idx + LastOffset] == Substring.Data[LastOffset] &&
+			KStrEqualBytes<KStrFoldNone>(Str.Data + Idx + 1, Substring.Data + 1, Substring.Length - 2))
+		{
+			return Idx;
+		}
+	}
+	return KSTR_NOT_FOUND;
+}
+
+// FAST HASH
+// NOTE: Same structure as wyhash: every 16 bytes are folded into the state
+// with a single 64x64->128 multiply, long inputs use three independent lanes.
+local_var const u64 FastHashSecret[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+										 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+KIWI_INLINE u64 FastHashMix(u64 A, u64 B)
+{
+	u64 High;
+	u64 Low = Multiply128(A, B, High);
+	return Low ^ High;
+}
+
+KIWI_INLINE u64 FastHashRead8(const u8 *Ptr)
+{
+	u64 Result;
+	memcpy(&Result, Ptr, sizeof(Result));
+	return Result;
+}
+
+KIWI_INLINE u64 FastHashRead4(const u8 *Ptr)
+{
+	u32 Result;
+	memcpy(&Result, Ptr, sizeof(Result));
+	return Result;
+}
+
+u64 KStr::FastHash(const void *Data, u64 Length, u64 Seed)
+{
+	const u8 *Ptr = (const u8 *)Data;
+	Seed ^= FastHashMix(Seed ^ FastHashSecret[0], FastHashSecret[1]);
+
+	u64 A;
+	u64 B;
+	if (Length <= 16)
+	{
+		if (Length >= 4)
+		{
+			// NOTE: Two possibly overlapping reads from each end cover 4 to 16 bytes
+			u64 Step = (Length >> 3) << 2;
+			A = (FastHashRead4(Ptr) << 32) | FastHashRead4(Ptr + Step);
+			B = (FastHashRead4(Ptr + Length - 4) << 32) | FastHashRead4(Ptr + Length - 4 - Step);
+		}
+		else if (Length > 0)
+		{
+			A = ((u64)Ptr[0] << 16) | ((u64)Ptr[Length >> 1] << 8) | Ptr[Length - 1];
+			B = 0;
+		}
+		else
+		{
+			A = 0;
+			B = 0;
+		}
+	}
+	else
+	{
+		u64 Remaining = Length;
+		if (Remaining > 48)
+		{
+			u64 Seed1 = Seed;
+			u64 Seed2 = Seed;
+			do
+			{
+				Seed = FastHashMix(FastHashRead8(Ptr) ^ FastHashSecret[1], FastHashRead8(Ptr + 8) ^ Seed);
+				Seed1 = FastHashMix(FastHashRead8(Ptr + 16) ^ FastHashSecret[2], FastHashRead8(Ptr + 24) ^ Seed1);
+				Seed2 = FastHashMix(FastHashRead8(Ptr + 32) ^ FastHashSecret[3], FastHashRead8(Ptr + 40) ^ Seed2);
+				Ptr += 48;
+				Remaining -= 48;
+			} while (Remaining > 48);
+			Seed ^= Seed1 ^ Seed2;
+		}
+
+		while (Remaining > 16)
+		{
+			Seed = FastHashMix(FastHashRead8(Ptr) ^ FastHashSecret[1], FastHashRead8(Ptr + 8) ^ Seed);
+			Ptr += 16;
+			Remaining -= 16;
+		}
+
+		// NOTE: The last 16 bytes, possibly overlapping the ones already mixed
+		A = FastHashRead8(Ptr + Remaining - 16);
+		B = FastHashRead8(Ptr + Remaining - 8);
+	}
+
+	A ^= FastHashSecret[1];
+	B ^= Seed;
+	A = Multiply128(A, B, B);
+	return FastHashMix(A ^ FastHashSecret[0] ^ Length, B ^ FastHashSecret[1]);
+}
+
+u64 KStr::FastHash(KStrView Str, u64 Seed)
+{
+	return FastHash(Str.Data, Str.Length, Seed);
+}
+
+// STRING BUILDER
+
+void KStrBuilder::Begin(MemArena *InArena)
+{
+	Arena = InArena;
+	Data = (char *)Arena->BasePtr + Arena->OccupiedMem;
+	Length = 0;
+}
+
+KStrView KStrBuilder::End()
+{
+	AppendChar('\0');
+	// NOTE: The terminator stays in the arena but is not part of the length
+	--Length;
+	return {Length, Data};
+}
+
+void KStrBuilder::Append(const char *Str)
+{
+	Append(KStr::View(Str));
+}
+
+void KStrBuilder::Append(KStrView Str)
+{
+	AssertMsg(Data + Length == (char *)Arena->BasePtr + Arena->OccupiedMem,
+			  "The arena has been modified while building a string");
+
+	char *Dest = (char *)Arena->PushNoZero(Str.Length);
+	if (Dest)
+	{
+		MemSystem::Copy(Dest, (void *)Str.Data, Str.Length);
+		Length += Str.Length;
+	}
+}
+
+void KStrBuilder::AppendChar(char C)
+{
+	AssertMsg(Data + Length == (char *)Arena->BasePtr + Arena->OccupiedMem,
+			  "The arena has been modified while building a string");
+
+	char *Dest = (char *)Arena->PushNoZero(1);
+	if (Dest)
+	{
+		*Dest = C;
+		++Length;
+	}
+}
+
+void KStrBuilder::Appendf(const char *Format, ...)
+{
+	va_list Args;
+	va_start(Args, Format);
+	AppendV(Format, Args);
+	va_end(Args);
+}
+
+void KStrBuilder::AppendV(const char *Format, va_list Args)
+{
+	AssertMsg(Data + Length == (char *)Arena->BasePtr + Arena->OccupiedMem,
+			  "The arena has been modified while building a string");
+
+	// NOTE: Format straight into the memory the arena has already committed.
+	// vsnprintf tells us how much it needed, so we only format a second time
+	// when the text didn't fit and the arena has to commit more pages.
+	char *Dest = Data + Length;
+	u64 Available = Arena->CommittedMem - Arena->OccupiedMem;
+
+	va_list ArgsCopy;
+	va_copy(ArgsCopy, Args);
+	i32 Needed = vsnprintf(Dest, Available, Format, Args);
+
+	if (Needed > 0)
+	{
+		if ((u64)Needed < Available)
+		{
+			Arena->PushNoZero((u64)Needed);
+			Length += (u64)Needed;
+		}
+		else if (Arena->PushNoZero((u64)Needed + 1))
+		{
+			// NOTE: +1 because vsnprintf always writes the terminator, we drop it right after
+			vsnprintf(Dest, (u64)Needed + 1, Format, ArgsCopy);
+			Arena->Pop(1);
+			Length += (u64)Needed;
+		}
+	}
+
+	va_end(ArgsCopy);
+}
@@ -2,13 +2,131 @@
 
 #include "defines.h"
 
+#include <stdarg.h>
+
+class MemArena;
+
+#define KSTR_INVALID_INDEX ((u32)-1)
+#define KSTR_NOT_FOUND ((u64)-1)
+
+// NOTE: Non-owning, length-prefixed view over a string. The length is always
+// known so nothing that takes a view has to scan for the terminator.
+// Views produced by the engine (KStrBuilder, Duplicate) are null terminated as well.
+struct KStrView
+{
+	u64 Length;
+	const char *Data;
+};
+
+#define KStrViewLiteral(Literal) (KStrView{sizeof(Literal) - 1, (Literal)})
+
+// NOTE: Handle to an interned string (see core/string_interner.h).
+// Two valid ids are equal if and only if they were interned from the
+// same bytes, so comparing them is a single integer compare.
+struct KStrId
+{
+	u32 Hash;
+	u32 Index;
+
+	b8 IsValid() const { return Index != KSTR_INVALID_INDEX; }
+
+	b8 operator==(KStrId Other) const { return Index == Other.Index; }
+	b8 operator!=(KStrId Other) const { return Index != Other.Index; }
+};
+
 namespace KStr
 {
 	// return the length of the given string.
 	KIWI_API u64 Length(const char *Str);
 
-	KIWI_API char *Duplicate(const char *Str);
+	KIWI_API KStrView View(const char *Str);
+
+	// NOTE: Copies the string (null terminator included) on top of the arena
+	KIWI_API char *Duplicate(const char *Str, MemArena *Arena);
+	KIWI_API KStrView Duplicate(KStrView Str, MemArena *Arena);
+
+	// NOTE: Equal and FindChar are libc's (strcmp/memcmp, strchr/memchr).
+	// EqualIgnoreCase and FindSubstring are vectorized (AVX2 when the engine is
+	// built with /arch:AVX2, SSE2 otherwise), the null terminated EqualIgnoreCase
+	// never reads across a page boundary past the terminator, so it is safe on any
+	// valid string. Prefer the KStrView versions when the length is known: they
+	// skip the scan for the terminator.
 
 	// Case sensitive string comparison
 	KIWI_API b8 Equal(const char *StrA, const char *StrB);
-}
\ No newline at end of file
+	KIWI_API b8 Equal(KStrView StrA, KStrView StrB);
+
+	// NOTE: Only ASCII letters are folded, every other byte must match exactly
+	KIWI_API b8 EqualIgnoreCase(const char *StrA, const char *StrB);
+	KIWI_API b8 EqualIgnoreCase(KStrView StrA, KStrView StrB);
+
+	// Return the index of the first occurrence or KSTR_NOT_FOUND
+	KIWI_API u64 FindChar(const char *Str, char C);
+	KIWI_API u64 FindChar(KStrView Str, char C);
+	KIWI_API u64 FindSubstring(const char *Str, const char *Substring);
+	KIWI_API u64 FindSubstring(KStrView Str, KStrView Substring);
+
+	// NOTE: Fast 64-bit non-cryptographic hash (wyhash style) for hash tables
+	// and caches keyed by strings or blobs. It's NOT the same function as Hash
+	// below, don't mix them: KStrId and KStrHashLiteral rely on that one.
+	KIWI_API u64 FastHash(const void *Data, u64 Length, u64 Seed = 0);
+	KIWI_API u64 FastHash(KStrView Str, u64 Seed = 0);
+
+	// NOTE: 32-bit FNV-1a. It's constexpr so that literals can be hashed
+	// at compile time (see KStrHashLiteral) and the interner uses the very
+	// same function at runtime, so the two always agree.
+	constexpr u32 Hash(const char *Str, u64 Length)
+	{
+		u32 Result = 2166136261u;
+		for (u64 Idx = 0; Idx < Length; ++Idx)
+		{
+			Result ^= (u8)Str[Idx];
+			Result *= 16777619u;
+		}
+		return Result;
+	}
+
+	constexpr u32 Hash(const char *Str)
+	{
+		u32 Result = 2166136261u;
+		for (; *Str; ++Str)
+		{
+			Result ^= (u8)*Str;
+			Result *= 16777619u;
+		}
+		return Result;
+	}
+}
+
+// NOTE: Using the hash as a template argument forces the compiler to
+// evaluate it at compile time, even in unoptimized builds
+template <u32 Value>
+struct KStrHashConstant
+{
+	static const u32 Hash = Value;
+};
+
+#define KStrHashLiteral(Literal) (KStrHashConstant<KStr::Hash(Literal)>::Hash)
+
+// NOTE: Builds a string directly on top of an arena (usually the frame or
+// the scratch one). The text grows in place as the arena grows, so it's
+// never capped, truncated or copied around. The catch is that while
+// building, the builder must be the only one pushing on that arena.
+// End() null terminates the string and returns a view of it, the memory
+// stays in the arena and is freed with it.
+class KIWI_API KStrBuilder
+{
+public:
+	void Begin(MemArena *InArena);
+	KStrView End();
+
+	void Append(const char *Str);
+	void Append(KStrView Str);
+	void AppendChar(char C);
+	void Appendf(const char *Format, ...);
+	void AppendV(const char *Format, va_list Args);
+
+	MemArena *Arena = nullptr;
+	char *Data = nullptr;
+	u64 Length = 0;
+};
@@ -0,0 +1,273 @@
+#include "log_crash_ring.h"
+#include "core/kiwi_mem.h"
+#include "core/kiwi_string.h"
+#include "core/clock.h"
+
+#include <stdio.h>
+
+PlatformFileMapping LogCrashRing::Mapping = {};
+LogCrashRingHeader *LogCrashRing::Header = nullptr;
+u8 *LogCrashRing::Data = nullptr;
+u64 LogCrashRing::DataMask = 0;
+
+#define LOG_CRASH_RECORD_ALIGNMENT 8
+#define LOG_CRASH_FORMAT_BUFFER_SIZE 4096
+
+// NOTE: What follows the record header of a binary record, then come the
+// format string and the argument types (both terminator included) and the arguments
+struct LogCrashBinaryPrefix
+{
+	u64 Timestamp;
+	u16 FormatLength;
+	u8 TypeCount;
+	u8 Padding[5];
+};
+
+internal_func u64 AlignCrashRecord(u64 Size)
+{
+	return (Size + LOG_CRASH_RECORD_ALIGNMENT - 1) & ~(u64)(LOG_CRASH_RECORD_ALIGNMENT - 1);
+}
+
+internal_func void CopyFromCrashRing(void *Dest, const u8 *Ring, u64 Mask, u64 Position, u64 Size)
+{
+	u64 Offset = Position & Mask;
+	u64 FirstChunk = Min(Size, Mask + 1 - Offset);
+	MemSystem::Copy(Dest, (void *)(Ring + Offset), FirstChunk);
+	if (FirstChunk < Size)
+	{
+		MemSystem::Copy((u8 *)Dest + FirstChunk, (void *)Ring, Size - FirstChunk);
+	}
+}
+
+b8 LogCrashRing::Open(const char *Path, u64 Size)
+{
+	if (Header)
+	{
+		LogError("The log crash ring is already open");
+		return false;
+	}
+
+	if (Size < KiB(64) || (Size & (Size - 1)))
+	{
+		LogError("The log crash ring size must be a power of 2 of at least 64KiB");
+		return false;
+	}
+
+	char PreviousPath[256];
+	snprintf(PreviousPath, sizeof(PreviousPath), "%s.prev", Path);
+	Platform::FileMove(Path, PreviousPath);
+
+	if (!Platform::FileMapOpen(&Mapping, Path, sizeof(LogCrashRingHeader) + Size))
+	{
+		return false;
+	}
+
+	// NOTE: A new file is zero filled, so no record is valid
+	LogCrashRingHeader *NewHeader = (LogCrashRingHeader *)Mapping.Memory;
+	NewHeader->Magic = LOG_CRASH_RING_MAGIC;
+	NewHeader->Version = LOG_CRASH_RING_VERSION;
+	NewHeader->DataSize = Size;
+	NewHeader->Clock = {Clock::Now(), Clock::GetSeconds(), (f64)Clock::GetFrequency()};
+	NewHeader->WritePos = 0;
+
+	Data = (u8 *)(NewHeader + 1);
+	DataMask = Size - 1;
+	Header = NewHeader;
+
+	LogInfo("Logging to the crash ring %s", Path);
+	return true;
+}
+
+void LogCrashRing::Close()
+{
+	if (!Header)
+	{
+		return;
+	}
+
+	Header = nullptr;
+	Platform::FileMapClose(&Mapping);
+	Data = nullptr;
+}
+
+u64 LogCrashRing::Claim(u64 Length)
+{
+	return AtomicAdd64(&Header->WritePos, AlignCrashRecord(sizeof(LogCrashRecordHeader) + Length));
+}
+
+void LogCrashRing::CopyIn(u64 Position, const void *Source, u64 Size)
+{
+	u64 Offset = Position & DataMask;
+	u64 FirstChunk = Min(Size, DataMask + 1 - Offset);
+	MemSystem::Copy(Data + Offset, (void *)Source, FirstChunk);
+	if (FirstChunk < Size)
+	{
+		MemSystem::Copy(Data, (u8 *)Source + FirstChunk, Size - FirstChunk);
+	}
+}
+
+void LogCrashRing::Commit(u64 Position, LogLevel Level, LogRecordKind Kind, u64 Length)
+{
+	// NOTE: Position is aligned, so is the Position field: it never wraps
+	LogCrashRecordHeader RecordHeader = {(u32)Length, (u8)Level, (u8)Kind, 0, 0};
+	u64 PositionOffset = sizeof(RecordHeader) - sizeof(u64);
+	CopyIn(Position, &RecordHeader, PositionOffset);
+	AtomicStoreRelease64((volatile u64 *)(Data + ((Position + PositionOffset) & DataMask)), Position + 1);
+}
+
+void LogCrashRing::WriteText(LogLevel Level, const char *Text, u64 Length)
+{
+	// NOTE: A single record can't take more than a quarter of the ring
+	Length = Min(Length, (DataMask + 1) / 4);
+
+	u64 Position = Claim(Length);
+	CopyIn(Position + sizeof(LogCrashRecordHeader), Text, Length);
+	Commit(Position, Level, LogRecord_Text, Length);
+}
+
+void LogCrashRing::WriteBinary(LogLevel Level, const u8 *Record, u64 Length)
+{
+	LogBinaryPrefix Source;
+	MemSystem::Copy(&Source, (void *)Record, sizeof(Source));
+
+	u64 FormatLength = Min(KStr::Length(Source.Format), (u64)0xFFFF - 1) + 1;
+	u64 TypeCount = KStr::Length((const char *)Source.ArgTypes) + 1;
+	u64 ArgsLength = Length - sizeof(Source);
+
+	LogCrashBinaryPrefix Prefix = {};
+	Prefix.Timestamp = Source.Timestamp;
+	Prefix.FormatLength = (u16)FormatLength;
+	Prefix.TypeCount = (u8)TypeCount;
+
+	u64 RecordLength = sizeof(Prefix) + FormatLength + TypeCount + ArgsLength;
+	if (RecordLength > (DataMask + 1) / 4)
+	{
+		return;
+	}
+
+	u64 Position = Claim(RecordLength);
+	u64 At = Position + sizeof(LogCrashRecordHeader);
+	CopyIn(At, &Prefix, sizeof(Prefix));
+	At += sizeof(Prefix);
+	CopyIn(At, Source.Format, FormatLength - 1);
+	At += FormatLength - 1;
+	u8 Terminator = 0;
+	CopyIn(At++, &Terminator, 1);
+	CopyIn(At, Source.ArgTypes, TypeCount);
+	At += TypeCount;
+	CopyIn(At, Record + sizeof(Source), ArgsLength);
+	Commit(Position, Level, LogRecord_Binary, RecordLength);
+}
+
+b8 LogCrashRing::Dump(const char *Path, u32 RecordCount)
+{
+	PlatformFile File;
+	if (!Platform::FileOpen(&File, Path, FileMode_Read))
+	{
+		return false;
+	}
+
+	AutoFreeArena ScratchHandle = AutoFreeArena(MemTag_Scratch);
+	MemArena *Scratch = ScratchHandle.Arena;
+
+	u64 FileSize = Platform::FileSize(&File);
+	u8 *FileData = (u8 *)Scratch->PushNoZero(FileSize);
+	b8 ReadAll = FileData && Platform::FileRead(&File, FileData, FileSize) == FileSize;
+	Platform::FileClose(&File);
+
+	LogCrashRingHeader FileHeader;
+	if (!ReadAll || FileSize < sizeof(FileHeader))
+	{
+		LogError("Could not read %s", Path);
+		return false;
+	}
+
+	MemSystem::Copy(&FileHeader, FileData, sizeof(FileHeader));
+	u64 Size = FileHeader.DataSize;
+	if (FileHeader.Magic != LOG_CRASH_RING_MAGIC || FileHeader.Version != LOG_CRASH_RING_VERSION ||
+		!Size || (Size & (Size - 1)) || FileSize != sizeof(FileHeader) + Size)
+	{
+		LogError("%s is not a valid log crash ring", Path);
+		return false;
+	}
+
+	// NOTE: Reads straight from the file data, same layout as when it was mapped
+	u8 *RingData = FileData + sizeof(FileHeader);
+	u64 Mask = Size - 1;
+	u64 MaxRecordLength = Size / 4;
+
+	// NOTE: Walk the valid records from the oldest position still in the ring.
+	// Where a record is missing (torn by the crash) resync on the next
+	// aligned position whose header says it belongs there.
+	u64 End = FileHeader.WritePos;
+	u64 Start = End > Size ? End - Size : 0;
+	u64 *Positions = (u64 *)Scratch->PushNoZero(Size / sizeof(LogCrashRecordHeader) * sizeof(u64));
+	u64 PositionCount = 0;
+	u64 SkippedBytes = 0;
+	for (u64 Position = Start; Position + sizeof(LogCrashRecordHeader) <= End;)
+	{
+		LogCrashRecordHeader RecordHeader;
+		CopyFromCrashRing(&RecordHeader, RingData, Mask, Position, sizeof(RecordHeader));
+		u64 RecordSize = AlignCrashRecord(sizeof(RecordHeader) + RecordHeader.Length);
+		if (RecordHeader.Position != Position + 1 || RecordHeader.Length > MaxRecordLength ||
+			Position + RecordSize > End)
+		{
+			Position += LOG_CRASH_RECORD_ALIGNMENT;
+			SkippedBytes += LOG_CRASH_RECORD_ALIGNMENT;
+			continue;
+		}
+
+		Positions[PositionCount++] = Position;
+		Position += RecordSize;
+	}
+
+	u64 FirstRecord = PositionCount > RecordCount ? PositionCount - RecordCount : 0;
+	LogInfo("%s: %llu records in the ring, %llu bytes not recoverable, showing the last %llu",
+			Path, PositionCount, SkippedBytes, PositionCount - FirstRecord);
+
+	u8 *Record = (u8 *)Scratch->PushNoZero(MaxRecordLength + 1);
+	char *Formatted = (char *)Scratch->PushNoZero(LOG_CRASH_FORMAT_BUFFER_SIZE);
+	for (u64 Idx = FirstRecord; Idx < PositionCount; ++Idx)
+	{
+		LogCrashRecordHeader RecordHeader;
+		CopyFromCrashRing(&RecordHeader, RingData, Mask, Positions[Idx], sizeof(RecordHeader));
+		CopyFromCrashRing(Record, RingData, Mask, Positions[Idx] + sizeof(RecordHeader), RecordHeader.Length);
+		Record[RecordHeader.Length] = '\0';
+
+		const char *Text = (const char *)Record;
+		LogLevel Level = (LogLevel)Min((u32)RecordHeader.Level, (u32)LogLevel_Trace);
+		if (RecordHeader.Kind == LogRecord_Binary)
+		{
+			LogCrashBinaryPrefix Prefix;
+			MemSystem::Copy(&Prefix, Record, sizeof(Prefix));
+			u64 Used = sizeof(Prefix) + Prefix.FormatLength + Prefix.TypeCount;
+			if (Used > RecordHeader.Length || !Prefix.FormatLength || !Prefix.TypeCount)
+			{
+				continue;
+			}
+
+			// NOTE: Both are stored with their terminator
+			const char *Format = (const char *)Record + sizeof(Prefix);
+			const u8 *ArgTypes = Record + sizeof(Prefix) + Prefix.FormatLength;
+			Record[sizeof(Prefix) + Prefix.FormatLength - 1] = '\0';
+			Record[Used - 1] = LogArg_End;
+
+			LogCrashClock *FileClock = &FileHeader.Clock;
+			f64 Time = -1.0;
+			if (FileClock->Frequency > 0)
+			{
+				Time = FileClock->SecondsStart + (f64)(i64)(Prefix.Timestamp - FileClock->TicksStart) / FileClock->Frequency;
+			}
+			Logger::FormatBinaryArgs(Formatted, LOG_CRASH_FORMAT_BUFFER_SIZE, Level, Time, Format, ArgTypes,
+									 Record + Used, RecordHeader.Length - Used);
+			Text = Formatted;
+		}
+
+		if (Level < LogLevel_Warning)
+			Platform::ConsoleWriteError(Text, (u8)Level);
+		else
+			Platform::ConsoleWrite(Text, (u8)Level);
+	}
+
+	return true;
+}
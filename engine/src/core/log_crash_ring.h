@@ -0,0 +1,92 @@
+#pragma once
+
+/*
+NOTE: Optional log sink that survives crashes. Every record is written by
+the logging thread itself, straight into a memory mapped file used as a
+circular buffer: no syscall per record, no writer thread in between, and
+since the pages belong to the OS file cache whatever was written is still
+there when the process dies (hard crashes, KDebugBreak, killed from the
+debugger...). Only a power loss can lose it.
+Text records are stored as they are printed. Binary records (LogFast)
+store the format string and the argument type list next to the arguments,
+so the file can be decoded by another process: see Dump and tools/logdump.
+
+File format: a LogCrashRingHeader followed by DataSize bytes of ring.
+WritePos counts the bytes ever written, a record at absolute position P
+lives at offset P % DataSize and starts with a LogCrashRecordHeader.
+Records are 8 bytes aligned and may wrap around the end of the ring.
+The Position field of a record (its absolute position + 1, so that a
+zero filled ring has no valid record) is written last: a record is valid
+only if Position matches where it is, which also rejects records of older
+laps and records that were being written during the crash.
+*/
+
+#include "defines.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+
+// NOTE: Converts the LogFast timestamps (Clock::Now ticks) to seconds since
+// Clock::Initialize. Stored in the file, the process decoding it has its own clock
+struct LogCrashClock
+{
+	u64 TicksStart;
+	f64 SecondsStart;
+	f64 Frequency;
+};
+
+#define LOG_CRASH_RING_MAGIC 0x474F4C4B // "KLOG"
+#define LOG_CRASH_RING_VERSION 1
+// NOTE: Must be a power of 2
+#define LOG_CRASH_RING_DEFAULT_SIZE MiB(4)
+#define LOG_CRASH_RING_DUMP_DEFAULT_COUNT 100
+
+struct LogCrashRingHeader
+{
+	u32 Magic;
+	u32 Version;
+	u64 DataSize;
+	LogCrashClock Clock;
+	u8 Padding0[CACHE_LINE_SIZE - 2 * sizeof(u32) - sizeof(u64) - sizeof(LogCrashClock)];
+	// NOTE: Every logging thread hits this one, keep it on its own line
+	volatile u64 WritePos;
+	u8 Padding1[CACHE_LINE_SIZE - sizeof(u64)];
+};
+
+struct LogCrashRecordHeader
+{
+	u32 Length;
+	u8 Level;
+	u8 Kind;
+	u16 Reserved;
+	volatile u64 Position;
+};
+
+// NOTE: this is a singleton
+class LogCrashRing
+{
+public:
+	// NOTE: The ring of the previous run, if any, is kept as <Path>.prev
+	static b8 Open(const char *Path, u64 Size = LOG_CRASH_RING_DEFAULT_SIZE);
+	static void Close();
+
+	KIWI_INLINE static b8 IsOpen() { return Header != nullptr; }
+
+	// NOTE: Called by the logger from any thread
+	static void WriteText(LogLevel Level, const char *Text, u64 Length);
+	// NOTE: Record is the one built by LogFast
+	static void WriteBinary(LogLevel Level, const u8 *Record, u64 Length);
+
+	// NOTE: Prints the last RecordCount records of a crash ring file to the console.
+	// Works on a file written by another process, it's what tools/logdump runs.
+	KIWI_API static b8 Dump(const char *Path, u32 RecordCount = LOG_CRASH_RING_DUMP_DEFAULT_COUNT);
+
+private:
+	static u64 Claim(u64 Length);
+	static void CopyIn(u64 Position, const void *Data, u64 Size);
+	static void Commit(u64 Position, LogLevel Level, LogRecordKind Kind, u64 Length);
+
+	static PlatformFileMapping Mapping;
+	static LogCrashRingHeader *Header;
+	static u8 *Data;
+	static u64 DataMask;
+};
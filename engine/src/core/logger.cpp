@@ -1,59 +1,833 @@
 #include "logger.h"
 #include "platform/platform.h"
+#include "core/kiwi_mem.h"
+#include "core/kiwi_string.h"
+#include "core/log_crash_ring.h"
+#include "core/sample_profiler.h"
 
-// TODO: Temporary! Remove once we have implemented those ourselves
 #include <stdio.h>
-#include <string.h>
 #include <stdarg.h>
 
+b8 Logger::IsAsync = false;
+u32 Logger::MainThreadId = 0;
+LogRingCell *Logger::Cells = nullptr;
+LogRingPositions Logger::Ring = {};
+PlatformThread Logger::Writer = {};
+u32 Logger::WriterThreadId = 0;
+PlatformSemaphore Logger::WakeUp = {};
+volatile u64 Logger::WriterRunning = 0;
+volatile b8 Logger::ConsoleOutput = true;
+char *Logger::RecordBuffer = nullptr;
+char *Logger::FormatBuffer = nullptr;
+u8 *Logger::FileBuffer = nullptr;
+u64 Logger::FileBufferUsed = 0;
+PlatformFile Logger::File = {};
+u64 Logger::FileBytes = 0;
+u64 Logger::ReportedDropped = 0;
+u8 Logger::ChannelMasks[LogChannel_Count] = {
+	LOG_COMPILED_MASK, LOG_COMPILED_MASK, LOG_COMPILED_MASK,
+	LOG_COMPILED_MASK, LOG_COMPILED_MASK, LOG_COMPILED_MASK,
+};
+StaticAssertMsg(LogChannel_Count == 6, "Update the default channel masks");
+
+#define LOG_BUFFER_SIZE 4096
+#define LOG_FILE_BUFFER_SIZE KiB(64)
+#define LOG_FIRST_CELL_DATA_SIZE (LOG_CELL_DATA_SIZE - sizeof(LogRecordHeader))
+#define LOG_MAX_RECORD_LENGTH (LOG_FIRST_CELL_DATA_SIZE + (LOG_MAX_RECORD_CELLS - 1) * LOG_CELL_DATA_SIZE)
+
+local_var const KStrView LogChannelNames[] = {
+	KStrViewLiteral("General"),
+	KStrViewLiteral("Memory"),
+	KStrViewLiteral("Event"),
+	KStrViewLiteral("Renderer"),
+	KStrViewLiteral("Vulkan"),
+	KStrViewLiteral("Input"),
+};
+StaticAssertMsg(ArrayCount(LogChannelNames) == LogChannel_Count, "Missing log channel names");
+
+// NOTE: General is the untagged one
+local_var const KStrView LogChannelTag[] = {
+	KStrViewLiteral(""),
+	KStrViewLiteral("[Memory] "),
+	KStrViewLiteral("[Event] "),
+	KStrViewLiteral("[Renderer] "),
+	KStrViewLiteral("[Vulkan] "),
+	KStrViewLiteral("[Input] "),
+};
+StaticAssertMsg(ArrayCount(LogChannelTag) == LogChannel_Count, "Missing log channel tags");
+
+local_var const KStrView LogLevelPrefix[] = {
+	KStrViewLiteral("[FATAL]: "),
+	KStrViewLiteral("[ERROR]: "),
+	KStrViewLiteral("[WARN]:  "),
+	KStrViewLiteral("[INFO]:  "),
+	KStrViewLiteral("[DEBUG]: "),
+	KStrViewLiteral("[TRACE]: "),
+};
+
 b8 Logger::Initialize()
 {
-	// TODO: implement file logging
-	// TODO: implement platform specific initialization
+	if (IsAsync)
+	{
+		LogError("Logger already initialized");
+		return false;
+	}
+
+	MainThreadId = Platform::GetThreadId();
+
+	MemArena *Arena = MemSystem::GetArena(MemTag_Logger);
+	Cells = (LogRingCell *)Arena->PushAligned(LOG_RING_CELL_COUNT * sizeof(LogRingCell), CACHE_LINE_SIZE);
+	RecordBuffer = (char *)Arena->PushNoZero(LOG_MAX_RECORD_LENGTH + 1);
+	FormatBuffer = (char *)Arena->PushNoZero(LOG_BUFFER_SIZE);
+	FileBuffer = (u8 *)Arena->PushNoZero(LOG_FILE_BUFFER_SIZE);
+	if (!Cells || !RecordBuffer || !FormatBuffer || !FileBuffer)
+	{
+		LogError("Could not allocate the log ring, logging synchronously");
+		return false;
+	}
+
+	for (u64 Idx = 0; Idx < LOG_RING_CELL_COUNT; ++Idx)
+	{
+		Cells[Idx].Sequence = Idx;
+	}
+	Ring = {};
+	FileBufferUsed = 0;
+	ReportedDropped = 0;
+
+	// NOTE: Keep the logs of the previous runs around
+	RotateFile();
+
+	if (!Platform::SemaphoreCreate(&WakeUp, 0))
+	{
+		LogError("Could not create the logger semaphore, logging synchronously");
+		Platform::FileClose(&File);
+		return false;
+	}
+
+	AtomicStoreRelease64(&WriterRunning, 1);
+	if (!Platform::ThreadCreate(&Writer, WriterThread, nullptr))
+	{
+		LogError("Could not start the log writer thread, logging synchronously");
+		Platform::SemaphoreDestroy(&WakeUp);
+		Platform::FileClose(&File);
+		return false;
+	}
+
+	IsAsync = true;
 	return true;
 }
 
 void Logger::Terminate()
 {
-	// TODO: terminate logging/write queue to disk
+	if (!IsAsync)
+	{
+		return;
+	}
+
+	// NOTE: The writer drains whatever is left before exiting
+	AtomicStoreRelease64(&WriterRunning, 0);
+	Platform::SemaphoreSignal(&WakeUp);
+	Platform::ThreadJoin(&Writer);
+	IsAsync = false;
+
+	Platform::SemaphoreDestroy(&WakeUp);
+	Platform::FileClose(&File);
 }
 
-#define LOG_BUFFER_SIZE 4096
 KIWI_API void Logger::Output(LogLevel Level, const char *Message, ...)
 {
-	// NOTE: I don't use LOG_BUFFER_SIZE to check because I want the extra
-	// 96 char to be left spare for the prefix and the \n\0 at the end.
-	// Since the limitation will be temporary (hopefully) we don't have to be
-	// extra precise here
-	Assert(strlen(Message) < 4000);
-	// TODO: We are imposing a limit to the logging message
-	// Address this once we have custom memory allocation (Arenas)
-	char Temp[LOG_BUFFER_SIZE];
-	memset(Temp, 0, LOG_BUFFER_SIZE);
-	char OutMessage[LOG_BUFFER_SIZE];
-	memset(Temp, 0, LOG_BUFFER_SIZE);
-
-	const char *LevelPrefix[] = {
-		"[FATAL]: ",
-		"[ERROR]: ",
-		"[WARN]:  ",
-		"[INFO]:  ",
-		"[DEBUG]: ",
-		"[TRACE]: ",
+	va_list Args;
+	va_start(Args, Message);
+	OutputV(LogChannel_General, Level, Message, Args);
+	va_end(Args);
+}
+
+KIWI_API void Logger::OutputChannel(LogChannel Channel, LogLevel Level, u32 Suppressed, const char *Message, ...)
+{
+	if (Suppressed)
+	{
+		OutputChannel(Channel, Level, 0, "Rate limiter: %u messages like the next one were suppressed", Suppressed);
+	}
+
+	va_list Args;
+	va_start(Args, Message);
+	OutputV(Channel, Level, Message, Args);
+	va_end(Args);
+}
+
+void Logger::OutputV(LogChannel Channel, LogLevel Level, const char *Message, va_list Args)
+{
+	// NOTE: The common case formats the message once, straight into the
+	// stack buffer right after the prefix. Only messages that don't fit
+	// are built again on the scratch arena, so nothing is ever truncated.
+	char Buffer[LOG_BUFFER_SIZE];
+	KStrView LevelPrefix = LogLevelPrefix[Level];
+	KStrView ChannelTag = LogChannelTag[Channel];
+	MemSystem::Copy(Buffer, (void *)LevelPrefix.Data, LevelPrefix.Length);
+	MemSystem::Copy(Buffer + LevelPrefix.Length, (void *)ChannelTag.Data, ChannelTag.Length);
+	KStrView Prefix = {LevelPrefix.Length + ChannelTag.Length, Buffer};
+
+	// NOTE: -1 leaves room for the \n
+	va_list ArgsCopy;
+	va_copy(ArgsCopy, Args);
+	i32 Written = vsnprintf(Buffer + Prefix.Length, LOG_BUFFER_SIZE - Prefix.Length - 1, Message, ArgsCopy);
+	va_end(ArgsCopy);
+
+	if (Written < 0)
+	{
+		return;
+	}
+
+	const char *OutMessage = Buffer;
+	u64 Length = Prefix.Length + Written;
+	MemArena *Scratch = MemSystem::GetArena(MemTag_Scratch);
+	u64 ScratchStart = Scratch->OccupiedMem;
+
+	// NOTE: The scratch arena belongs to the main thread, the
+	// others get their long messages truncated instead
+	b8 CanUseScratch = Scratch->BasePtr && (!IsAsync || Platform::GetThreadId() == MainThreadId);
+	if (Length + 2 > LOG_BUFFER_SIZE)
+	{
+		if (CanUseScratch)
+		{
+			KStrBuilder Builder;
+			Builder.Begin(Scratch);
+			Builder.Append(Prefix);
+			Builder.AppendV(Message, Args);
+			Builder.AppendChar('\n');
+			KStrView Built = Builder.End();
+			OutMessage = Built.Data;
+			Length = Built.Length;
+		}
+		else
+		{
+			Length = LOG_BUFFER_SIZE - 2;
+		}
+	}
+
+	if (OutMessage == Buffer)
+	{
+		Buffer[Length++] = '\n';
+		Buffer[Length] = '\0';
+	}
+
+	if (LogCrashRing::IsOpen())
+	{
+		LogCrashRing::WriteText(Level, OutMessage, Length);
+	}
+
+	b8 Pushed = IsAsync && Push(Level, LogRecord_Text, OutMessage, Length);
+	if (Pushed && Level == LogLevel_Fatal)
+	{
+		Flush();
+	}
+	else if (!Pushed && (!IsAsync || Level == LogLevel_Fatal))
+	{
+		// NOTE: Fatals are too important to be dropped, even when the ring is full
+		WriteToConsole(Level, OutMessage);
+	}
+
+	Scratch->PopAt(ScratchStart);
+}
+
+KIWI_API void Logger::OutputBinary(LogLevel Level, const u8 *Record, u64 Length)
+{
+	if (LogCrashRing::IsOpen())
+	{
+		LogCrashRing::WriteBinary(Level, Record, Length);
+	}
+
+	b8 Pushed = IsAsync && Push(Level, LogRecord_Binary, Record, Length);
+	if (Pushed && Level == LogLevel_Fatal)
+	{
+		Flush();
+	}
+	else if (!Pushed && (!IsAsync || Level == LogLevel_Fatal))
+	{
+		char Buffer[LOG_BUFFER_SIZE];
+		FormatBinary(Buffer, sizeof(Buffer), Level, Record, Length);
+		WriteToConsole(Level, Buffer);
+	}
+}
+
+void Logger::Flush()
+{
+	// NOTE: The writer can log too (e.g. file errors), it can't wait for itself
+	if (!IsAsync || Platform::GetThreadId() == WriterThreadId)
+	{
+		return;
+	}
+
+	u64 Target = AtomicLoadAcquire64(&Ring.EnqueuePos);
+	Platform::SemaphoreSignal(&WakeUp);
+	while (AtomicLoadAcquire64(&Ring.DequeuePos) < Target)
+	{
+		Platform::YieldThread();
+	}
+}
+
+u64 Logger::GetDroppedCount()
+{
+	return AtomicLoadAcquire64(&Ring.DroppedCount);
+}
+
+void Logger::SetConsoleOutput(b8 Enabled)
+{
+	// NOTE: Whatever is already in the ring goes out with the old setting
+	Flush();
+	ConsoleOutput = Enabled;
+}
+
+void Logger::SetChannelLevel(LogChannel Channel, LogLevel MaxLevel)
+{
+	SetChannelMask(Channel, (u8)((1 << (MaxLevel + 1)) - 1));
+}
+
+void Logger::SetChannelMask(LogChannel Channel, u8 Mask)
+{
+	if (Channel >= LogChannel_Count)
+	{
+		LogError("Invalid log channel %u", (u32)Channel);
+		return;
+	}
+
+	// NOTE: What is compiled out stays out
+	ChannelMasks[Channel] = (u8)((Mask | LOG_ALWAYS_ENABLED_MASK) & LOG_COMPILED_MASK);
+}
+
+b8 Logger::SetChannelLevels(const char *Spec)
+{
+	local_persist const KStrView LevelNames[] = {
+		KStrViewLiteral("fatal"),
+		KStrViewLiteral("error"),
+		KStrViewLiteral("warning"),
+		KStrViewLiteral("info"),
+		KStrViewLiteral("debug"),
+		KStrViewLiteral("trace"),
 	};
+	StaticAssertMsg(ArrayCount(LevelNames) == LogLevel_Count, "Missing log level names");
+
+	b8 Result = true;
+	KStrView Rest = {KStr::Length(Spec), Spec};
+	while (Rest.Length)
+	{
+		u64 PairEnd = KStr::FindChar(Rest, ',');
+		KStrView Pair = {PairEnd == KSTR_NOT_FOUND ? Rest.Length : PairEnd, Rest.Data};
+		Rest.Data += Min(Pair.Length + 1, Rest.Length);
+		Rest.Length -= Min(Pair.Length + 1, Rest.Length);
 
-	va_list ArgsPtr;
-	va_start(ArgsPtr, Message);
-	vsnprintf(Temp, LOG_BUFFER_SIZE, Message, ArgsPtr);
-	va_end(ArgsPtr);
+		u64 Separator = KStr::FindChar(Pair, '=');
+		if (Separator == KSTR_NOT_FOUND)
+		{
+			LogWarning("Log channel setting '%.*s' is not in the form channel=level", (i32)Pair.Length, Pair.Data);
+			Result = false;
+			continue;
+		}
+		KStrView ChannelName = {Separator, Pair.Data};
+		KStrView LevelName = {Pair.Length - Separator - 1, Pair.Data + Separator + 1};
 
-	snprintf(OutMessage, LOG_BUFFER_SIZE, "%s%s\n", LevelPrefix[Level], Temp);
+		i32 Level = -1;
+		for (i32 Idx = 0; Idx < LogLevel_Count; ++Idx)
+		{
+			if (KStr::EqualIgnoreCase(LevelName, LevelNames[Idx]))
+			{
+				Level = Idx;
+				break;
+			}
+		}
 
+		b8 IsAll = KStr::EqualIgnoreCase(ChannelName, KStrViewLiteral("all"));
+		i32 Channel = -1;
+		for (i32 Idx = 0; Idx < LogChannel_Count && !IsAll; ++Idx)
+		{
+			if (KStr::EqualIgnoreCase(ChannelName, LogChannelNames[Idx]))
+			{
+				Channel = Idx;
+				break;
+			}
+		}
+
+		if (Level < 0 || (Channel < 0 && !IsAll))
+		{
+			LogWarning("Unknown log channel or level in '%.*s'", (i32)Pair.Length, Pair.Data);
+			Result = false;
+			continue;
+		}
+
+		for (i32 Idx = 0; Idx < LogChannel_Count; ++Idx)
+		{
+			if (IsAll || Idx == Channel)
+			{
+				SetChannelLevel((LogChannel)Idx, (LogLevel)Level);
+			}
+		}
+	}
+
+	return Result;
+}
+
+b8 Logger::AllowRate(LogRateLimiter *Limiter, u32 &OutSuppressed)
+{
+	OutSuppressed = 0;
+
+	// NOTE: No clock before Platform::Startup, let everything through
+	f64 Now = Platform::GetAbsoluteTime();
+	if (Now <= 0)
+	{
+		return true;
+	}
+
+	if (Now - Limiter->WindowStart >= LOG_RATE_LIMIT_WINDOW)
+	{
+		OutSuppressed = Limiter->Suppressed;
+		Limiter->WindowStart = Now;
+		Limiter->Count = 0;
+		Limiter->Suppressed = 0;
+	}
+
+	if (Limiter->Count >= LOG_RATE_LIMIT_COUNT)
+	{
+		++Limiter->Suppressed;
+		return false;
+	}
+
+	++Limiter->Count;
+	return true;
+}
+
+b8 Logger::Push(LogLevel Level, LogRecordKind Kind, const void *Data, u64 Length)
+{
+	const u8 *Bytes = (const u8 *)Data;
+	if (Length > LOG_MAX_RECORD_LENGTH)
+	{
+		Length = LOG_MAX_RECORD_LENGTH;
+	}
+
+	u64 CellCount = 1;
+	if (Length > LOG_FIRST_CELL_DATA_SIZE)
+	{
+		CellCount += (Length - LOG_FIRST_CELL_DATA_SIZE + LOG_CELL_DATA_SIZE - 1) / LOG_CELL_DATA_SIZE;
+	}
+
+	// NOTE: Same scheme as the event system thread queue, except that a
+	// record claims CellCount cells at once. The writer frees the cells in
+	// order, so when the last one is free for this lap all of them are.
+	u64 Mask = LOG_RING_CELL_COUNT - 1;
+	u64 Pos = AtomicLoadAcquire64(&Ring.EnqueuePos);
+	for (;;)
+	{
+		u64 LastPos = Pos + CellCount - 1;
+		i64 Difference = (i64)AtomicLoadAcquire64(&Cells[LastPos & Mask].Sequence) - (i64)LastPos;
+		if (Difference == 0)
+		{
+			if (AtomicCompareExchange64(&Ring.EnqueuePos, Pos, Pos + CellCount))
+			{
+				break;
+			}
+		}
+		else if (Difference < 0)
+		{
+			AtomicAdd64(&Ring.DroppedCount, 1);
+			return false;
+		}
+		else
+		{
+			Pos = AtomicLoadAcquire64(&Ring.EnqueuePos);
+		}
+	}
+
+	LogRingCell *First = Cells + (Pos & Mask);
+	LogRecordHeader Header = {(u32)Length, (u16)CellCount, (u8)Level, (u8)Kind};
+	MemSystem::Copy(First->Data, &Header, sizeof(Header));
+
+	u64 Chunk = Min(Length, (u64)LOG_FIRST_CELL_DATA_SIZE);
+	MemSystem::Copy(First->Data + sizeof(Header), (void *)Bytes, Chunk);
+	u64 Copied = Chunk;
+	for (u64 CellIdx = 1; CellIdx < CellCount; ++CellIdx)
+	{
+		Chunk = Min(Length - Copied, (u64)LOG_CELL_DATA_SIZE);
+		MemSystem::Copy(Cells[(Pos + CellIdx) & Mask].Data, (void *)(Bytes + Copied), Chunk);
+		Copied += Chunk;
+	}
+
+	// NOTE: Publishing the first cell publishes the whole record
+	AtomicStoreRelease64(&First->Sequence, Pos + 1);
+
+	// NOTE: The writer wakes up on its own every few ms, errors and
+	// a ring filling up are the only reasons to wake it up earlier
+	if (Level <= LogLevel_Error || (Pos + CellCount - AtomicLoadAcquire64(&Ring.DequeuePos)) > LOG_RING_CELL_COUNT / 2)
+	{
+		Platform::SemaphoreSignal(&WakeUp);
+	}
+	return true;
+}
+
+void Logger::WriteToConsole(LogLevel Level, const char *Text)
+{
 	b8 IsError = Level < LogLevel_Warning;
 	if (IsError)
-		Platform::ConsoleWriteError(OutMessage, (u8)Level);
+		Platform::ConsoleWriteError(Text, (u8)Level);
+	else
+		Platform::ConsoleWrite(Text, (u8)Level);
+}
+
+THREAD_PROC(Logger::WriterThread)
+{
+	WriterThreadId = Platform::GetThreadId();
+	SampleProfiler::RegisterThread("Logger");
+
+	while (AtomicLoadAcquire64(&WriterRunning))
+	{
+		Platform::SemaphoreWait(&WakeUp, LOG_WRITER_INTERVAL_MS);
+		Drain();
+	}
+
+	// NOTE: Whatever was logged before Terminate
+	Drain();
+	return 0;
+}
+
+void Logger::Drain()
+{
+	u64 Mask = LOG_RING_CELL_COUNT - 1;
+	for (;;)
+	{
+		u64 Pos = Ring.DequeuePos;
+		LogRingCell *First = Cells + (Pos & Mask);
+		if (AtomicLoadAcquire64(&First->Sequence) != Pos + 1)
+		{
+			break;
+		}
+
+		LogRecordHeader Header;
+		MemSystem::Copy(&Header, First->Data, sizeof(Header));
+
+		u64 Chunk = Min((u64)Header.Length, (u64)LOG_FIRST_CELL_DATA_SIZE);
+		MemSystem::Copy(RecordBuffer, First->Data + sizeof(Header), Chunk);
+		u64 Copied = Chunk;
+		for (u64 CellIdx = 1; CellIdx < Header.CellCount; ++CellIdx)
+		{
+			Chunk = Min(Header.Length - Copied, (u64)LOG_CELL_DATA_SIZE);
+			MemSystem::Copy(RecordBuffer + Copied, Cells[(Pos + CellIdx) & Mask].Data, Chunk);
+			Copied += Chunk;
+		}
+		RecordBuffer[Header.Length] = '\0';
+
+		// NOTE: Hand the cells back to the producers, in order
+		for (u64 CellIdx = 0; CellIdx < Header.CellCount; ++CellIdx)
+		{
+			AtomicStoreRelease64(&Cells[(Pos + CellIdx) & Mask].Sequence, Pos + CellIdx + LOG_RING_CELL_COUNT);
+		}
+
+		const char *Text = RecordBuffer;
+		u64 TextLength = Header.Length;
+		if (Header.Kind == LogRecord_Binary)
+		{
+			TextLength = FormatBinary(FormatBuffer, LOG_BUFFER_SIZE, (LogLevel)Header.Level,
+									  (u8 *)RecordBuffer, Header.Length);
+			Text = FormatBuffer;
+		}
+
+		if (ConsoleOutput)
+		{
+			WriteToConsole((LogLevel)Header.Level, Text);
+		}
+		WriteToFile(Text, TextLength);
+		AtomicStoreRelease64(&Ring.DequeuePos, Pos + Header.CellCount);
+	}
+
+	u64 Dropped = AtomicLoadAcquire64(&Ring.DroppedCount);
+	if (Dropped != ReportedDropped)
+	{
+		char Message[128];
+		i32 Length = snprintf(Message, sizeof(Message), "[WARN]:  Log ring full, %llu records dropped\n",
+							  Dropped - ReportedDropped);
+		WriteToConsole(LogLevel_Warning, Message);
+		WriteToFile(Message, (u64)Length);
+		ReportedDropped = Dropped;
+	}
+
+	FlushFile();
+}
+
+struct LogArgReader
+{
+	const u8 *At;
+	const u8 *End;
+	const u8 *Types;
+
+	// NOTE: Returns LogArg_End when the arguments are over (or the record is broken)
+	u8 Next(u64 &OutBits, const char *&OutString)
+	{
+		u8 Type = *Types;
+		if (Type == LogArg_End)
+		{
+			return LogArg_End;
+		}
+
+		if (Type == LogArg_String)
+		{
+			u32 Length;
+			if (At + sizeof(Length) > End)
+			{
+				return LogArg_End;
+			}
+			MemSystem::Copy(&Length, (void *)At, sizeof(Length));
+			if (At + sizeof(Length) + Length + 1 > End)
+			{
+				return LogArg_End;
+			}
+			OutString = (const char *)At + sizeof(Length);
+			At += sizeof(Length) + Length + 1;
+		}
+		else
+		{
+			if (At + sizeof(OutBits) > End)
+			{
+				return LogArg_End;
+			}
+			MemSystem::Copy(&OutBits, (void *)At, sizeof(OutBits));
+			At += sizeof(OutBits);
+		}
+
+		++Types;
+		return Type;
+	}
+};
+
+template <typename T>
+internal_func i32 LogFormatSpec(char *Out, u64 OutSize, const char *Spec, i32 *Stars, u32 StarCount, T Value)
+{
+	switch (StarCount)
+	{
+	case 0:
+		return snprintf(Out, OutSize, Spec, Value);
+	case 1:
+		return snprintf(Out, OutSize, Spec, Stars[0], Value);
+	default:
+		return snprintf(Out, OutSize, Spec, Stars[0], Stars[1], Value);
+	}
+}
+
+u64 Logger::FormatBinary(char *Out, u64 OutSize, LogLevel Level, const u8 *Record, u64 Length)
+{
+	LogBinaryPrefix Prefix;
+	MemSystem::Copy(&Prefix, (void *)Record, sizeof(Prefix));
+
+	// NOTE: The record was stamped before now, the age is what the clock converts.
+	// Another core can be a few ticks ahead, that's an age of 0
+	f64 Time = -1.0;
+	if (Clock::GetFrequency())
+	{
+		f64 Seconds = Clock::GetSeconds();
+		u64 Now = Clock::Now();
+		Time = Seconds - Clock::TicksToSeconds(Now > Prefix.Timestamp ? Now - Prefix.Timestamp : 0);
+	}
+
+	return FormatBinaryArgs(Out, OutSize, Level, Time, Prefix.Format, Prefix.ArgTypes, Record + sizeof(Prefix),
+							Length - sizeof(Prefix));
+}
+
+// NOTE: printf on a single conversion at a time, each one gets the
+// argument stored with its own type, whatever length modifiers the
+// format string has. Mismatches print a marker instead of crashing.
+u64 Logger::FormatBinaryArgs(char *Out, u64 OutSize, LogLevel Level, f64 Time, const char *Format,
+							 const u8 *ArgTypes, const u8 *Args, u64 ArgsLength)
+{
+	LogArgReader Reader = {Args, Args + ArgsLength, ArgTypes};
+
+	// NOTE: -1 leaves room for the \n
+	u64 Capacity = OutSize - 1;
+	u64 Used = 0;
+	KStrView LevelPrefix = LogLevelPrefix[Level];
+	MemSystem::Copy(Out, (void *)LevelPrefix.Data, LevelPrefix.Length);
+	Used += LevelPrefix.Length;
+
+	if (Time >= 0.0)
+	{
+		i32 Written = snprintf(Out + Used, Capacity - Used, "[%.6f] ", Time);
+		Used += Min((u64)Max(Written, 0), Capacity - Used - 1);
+	}
+
+	const char *At = Format;
+	while (*At && Used + 1 < Capacity)
+	{
+		if (*At != '%')
+		{
+			Out[Used++] = *At++;
+			continue;
+		}
+		if (At[1] == '%')
+		{
+			Out[Used++] = '%';
+			At += 2;
+			continue;
+		}
+
+		// NOTE: Rebuild the conversion without the length modifiers
+		char Spec[32];
+		u32 SpecLength = 0;
+		i32 Stars[2] = {};
+		u32 StarCount = 0;
+		b8 Broken = false;
+		Spec[SpecLength++] = *At++;
+		while (*At && KStr::FindChar("-+ #0123456789.*", *At) != KSTR_NOT_FOUND)
+		{
+			if (*At == '*')
+			{
+				u64 Bits = 0;
+				const char *String = nullptr;
+				u8 Type = Reader.Next(Bits, String);
+				if ((Type != LogArg_I32 && Type != LogArg_U32) || StarCount == 2)
+				{
+					Broken = true;
+				}
+				else
+				{
+					Stars[StarCount++] = (i32)Bits;
+				}
+			}
+			if (SpecLength < sizeof(Spec) - 4)
+			{
+				Spec[SpecLength++] = *At;
+			}
+			++At;
+		}
+		while (*At && KStr::FindChar("hlLqjztI0123456789", *At) != KSTR_NOT_FOUND)
+		{
+			++At;
+		}
+
+		char Conversion = *At;
+		if (!Conversion)
+		{
+			break;
+		}
+		++At;
+
+		u64 Bits = 0;
+		const char *String = nullptr;
+		u8 Type = Broken ? (u8)LogArg_End : Reader.Next(Bits, String);
+		b8 IsInteger = KStr::FindChar("diuxXoc", Conversion) != KSTR_NOT_FOUND;
+		b8 IsFloat = KStr::FindChar("fFeEgGaA", Conversion) != KSTR_NOT_FOUND;
+
+		i32 Written = -1;
+		char *SpecOut = Out + Used;
+		u64 SpecOutSize = Capacity - Used;
+		if (IsInteger && (Type == LogArg_I32 || Type == LogArg_U32))
+		{
+			Spec[SpecLength] = Conversion;
+			Spec[SpecLength + 1] = '\0';
+			Written = Type == LogArg_I32 ? LogFormatSpec(SpecOut, SpecOutSize, Spec, Stars, StarCount, (i32)Bits)
+										 : LogFormatSpec(SpecOut, SpecOutSize, Spec, Stars, StarCount, (u32)Bits);
+		}
+		else if (IsInteger && (Type == LogArg_I64 || Type == LogArg_U64 || Type == LogArg_Pointer))
+		{
+			Spec[SpecLength] = 'l';
+			Spec[SpecLength + 1] = 'l';
+			Spec[SpecLength + 2] = Conversion;
+			Spec[SpecLength + 3] = '\0';
+			Written = Type == LogArg_I64 ? LogFormatSpec(SpecOut, SpecOutSize, Spec, Stars, StarCount, (i64)Bits)
+										 : LogFormatSpec(SpecOut, SpecOutSize, Spec, Stars, StarCount, Bits);
+		}
+		else if (IsFloat && Type == LogArg_F64)
+		{
+			f64 Value;
+			MemSystem::Copy(&Value, &Bits, sizeof(Value));
+			Spec[SpecLength] = Conversion;
+			Spec[SpecLength + 1] = '\0';
+			Written = LogFormatSpec(SpecOut, SpecOutSize, Spec, Stars, StarCount, Value);
+		}
+		else if (Conversion == 's' && Type == LogArg_String)
+		{
+			Spec[SpecLength] = 's';
+			Spec[SpecLength + 1] = '\0';
+			Written = LogFormatSpec(SpecOut, SpecOutSize, Spec, Stars, StarCount, String);
+		}
+		else if (Conversion == 'p' && Type == LogArg_Pointer)
+		{
+			Spec[SpecLength] = 'p';
+			Spec[SpecLength + 1] = '\0';
+			Written = LogFormatSpec(SpecOut, SpecOutSize, Spec, Stars, StarCount, (void *)Bits);
+		}
+		else
+		{
+			Written = snprintf(SpecOut, SpecOutSize, "%%!%c", Conversion);
+		}
+
+		if (Written > 0)
+		{
+			Used += Min((u64)Written, SpecOutSize - 1);
+		}
+	}
+
+	Out[Used++] = '\n';
+	Out[Used] = '\0';
+	return Used;
+}
+
+void Logger::WriteToFile(const char *Text, u64 Length)
+{
+	if (!File.Handle)
+	{
+		return;
+	}
+
+	if (FileBufferUsed + Length > LOG_FILE_BUFFER_SIZE)
+	{
+		FlushFile();
+	}
+
+	if (Length > LOG_FILE_BUFFER_SIZE)
+	{
+		Platform::FileWrite(&File, Text, Length);
+		FileBytes += Length;
+	}
 	else
-		Platform::ConsoleWrite(OutMessage, (u8)Level);
+	{
+		MemSystem::Copy(FileBuffer + FileBufferUsed, (void *)Text, Length);
+		FileBufferUsed += Length;
+	}
+}
+
+void Logger::FlushFile()
+{
+	if (File.Handle && FileBufferUsed)
+	{
+		Platform::FileWrite(&File, FileBuffer, FileBufferUsed);
+		FileBytes += FileBufferUsed;
+	}
+	FileBufferUsed = 0;
+
+	if (FileBytes > LOG_FILE_MAX_SIZE)
+	{
+		RotateFile();
+	}
+}
+
+void Logger::RotateFile()
+{
+	Platform::FileClose(&File);
+
+	// NOTE: kiwi.log -> kiwi.1.log -> kiwi.2.log ... the oldest one is overwritten
+	char From[256];
+	char To[256];
+	for (i32 Idx = LOG_FILE_MAX_COUNT - 1; Idx > 0; --Idx)
+	{
+		if (Idx == 1)
+		{
+			snprintf(From, sizeof(From), "%s", LOG_FILE_PATH);
+		}
+		else
+		{
+			snprintf(From, sizeof(From), "%.*s.%d.log", (i32)(sizeof(LOG_FILE_PATH) - 5), LOG_FILE_PATH, Idx - 1);
+		}
+		snprintf(To, sizeof(To), "%.*s.%d.log", (i32)(sizeof(LOG_FILE_PATH) - 5), LOG_FILE_PATH, Idx);
+		Platform::FileMove(From, To);
+	}
+
+	Platform::FileOpen(&File, LOG_FILE_PATH, FileMode_Write);
+	FileBytes = 0;
 }
 
 void LogAssertion(const char *Expression, const char *File, int Line, const char *Message)
@@ -1,17 +1,23 @@
 #pragma once
 
 #include "defines.h"
+#include "platform/platform.h"
+#include "core/kiwi_mem.h"
+#include "core/kiwi_string.h"
+#include "core/clock.h"
 
 // NOTE(valentino): We always want to output fatals and errors
 #define WARNING_LOG_ENABLED TRUE
 #define INFO_LOG_ENABLED TRUE
+
+#ifdef KIWI_SLOW
 #define DEBUG_LOG_ENABLED TRUE
 #define TRACE_LOG_ENABLED TRUE
-
-#ifndef KIWI_SLOW
+#else
 #define DEBUG_LOG_ENABLED FALSE
 #define TRACE_LOG_ENABLED FALSE
 #endif
+
 enum LogLevel
 {
 	LogLevel_Fatal,
@@ -19,7 +25,98 @@ enum LogLevel
 	LogLevel_Warning,
 	LogLevel_Info,
 	LogLevel_Debug,
-	LogLevel_Trace
+	LogLevel_Trace,
+
+	LogLevel_Count
+};
+
+// NOTE: On top of the compile-time switches above every channel has a
+// runtime mask of the levels it lets through (bit 1 << LogLevel).
+// Fatals and errors can't be masked out. The plain LogX macros go to
+// the General channel.
+enum LogChannel
+{
+	LogChannel_General,
+	LogChannel_Memory,
+	LogChannel_Event,
+	LogChannel_Renderer,
+	LogChannel_Vulkan,
+	LogChannel_Input,
+
+	LogChannel_Count
+};
+
+#define LOG_ALWAYS_ENABLED_MASK ((1 << LogLevel_Fatal) | (1 << LogLevel_Error))
+#define LOG_COMPILED_MASK (LOG_ALWAYS_ENABLED_MASK |                \
+						   (WARNING_LOG_ENABLED << LogLevel_Warning) | \
+						   (INFO_LOG_ENABLED << LogLevel_Info) |       \
+						   (DEBUG_LOG_ENABLED << LogLevel_Debug) |     \
+						   (TRACE_LOG_ENABLED << LogLevel_Trace))
+
+// NOTE: Every call site lets through at most LOG_RATE_LIMIT_COUNT messages
+// per LOG_RATE_LIMIT_WINDOW seconds, the next message that gets through
+// says how many were suppressed in between. The limiter state is not
+// synchronized, with many threads on the same call site it is approximate.
+#define LOG_RATE_LIMIT_COUNT 16
+#define LOG_RATE_LIMIT_WINDOW 1.0
+
+struct LogRateLimiter
+{
+	f64 WindowStart;
+	u32 Count;
+	u32 Suppressed;
+};
+
+// NOTE: Between Initialize and Terminate the logger is asynchronous:
+// Output formats the message and pushes it into a lock-free ring, a
+// writer thread pops the records and writes them to the console and to
+// LOG_FILE_PATH, which is rotated every LOG_FILE_MAX_SIZE bytes.
+// If the ring is full the record is dropped (the caller never waits),
+// the writer reports how many were lost. Fatals are the exception: they
+// are flushed before Output returns, since a crash usually follows.
+// Outside of Initialize/Terminate everything goes straight to the console.
+#define LOG_FILE_PATH "kiwi.log"
+#define LOG_FILE_MAX_SIZE MiB(8)
+// NOTE: The current file plus the rotated ones (kiwi.1.log, kiwi.2.log...)
+#define LOG_FILE_MAX_COUNT 3
+#define LOG_WRITER_INTERVAL_MS 5
+
+// NOTE: The ring is made of cache line sized cells, a record takes as many
+// consecutive cells as needed. Must be a power of 2.
+#define LOG_RING_CELL_COUNT 16384
+#define LOG_CELL_DATA_SIZE (CACHE_LINE_SIZE - sizeof(u64))
+// NOTE: Longer messages are truncated
+#define LOG_MAX_RECORD_CELLS (LOG_RING_CELL_COUNT / 8)
+
+struct LogRingCell
+{
+	volatile u64 Sequence;
+	u8 Data[LOG_CELL_DATA_SIZE];
+};
+
+enum LogRecordKind
+{
+	LogRecord_Text,
+	LogRecord_Binary
+};
+
+// NOTE: Sits at the start of the first cell of every record
+struct LogRecordHeader
+{
+	u32 Length;
+	u16 CellCount;
+	u8 Level;
+	u8 Kind;
+};
+
+// NOTE: Producers only touch EnqueuePos and DroppedCount, the writer
+// DequeuePos. They are padded apart so they don't share a cache line.
+struct LogRingPositions
+{
+	volatile u64 EnqueuePos;
+	volatile u64 DroppedCount;
+	u8 Padding[CACHE_LINE_SIZE - 2 * sizeof(u64)];
+	volatile u64 DequeuePos;
 };
 
 // NOTE: this is a singleton
@@ -30,37 +127,331 @@ public:
 	static void Terminate();
 
 	KIWI_API static void Output(LogLevel Level, const char *Message, ...);
+	// NOTE: Suppressed is reported before the message, see LogRateLimiter
+	KIWI_API static void OutputChannel(LogChannel Channel, LogLevel Level, u32 Suppressed, const char *Message, ...);
+	// NOTE: Used by LogFast, Record starts with a filled LogBinaryPrefix
+	KIWI_API static void OutputBinary(LogLevel Level, const u8 *Record, u64 Length);
+
+	// NOTE: Wait until the writer thread has written everything logged before this call
+	KIWI_API static void Flush();
+	KIWI_API static u64 GetDroppedCount();
+	// NOTE: Only the records drained by the writer thread, the file still gets
+	// all of them. Used by the benchmarks so they don't measure the terminal.
+	KIWI_API static void SetConsoleOutput(b8 Enabled);
+
+	// NOTE: Levels above MaxLevel are masked out
+	KIWI_API static void SetChannelLevel(LogChannel Channel, LogLevel MaxLevel);
+	KIWI_API static void SetChannelMask(LogChannel Channel, u8 Mask);
+	// NOTE: Comma separated Channel=level pairs, e.g. "vulkan=warning,event=trace".
+	// "all" sets every channel, the names are case insensitive.
+	KIWI_API static b8 SetChannelLevels(const char *Spec);
+
+	// NOTE: Only called when the level passed the channel mask
+	KIWI_API static b8 AllowRate(LogRateLimiter *Limiter, u32 &OutSuppressed);
+
+	// NOTE: Formats the pieces of a binary record, see LogFast. Time is in
+	// seconds since Clock::Initialize, negative when it isn't known.
+	// Out gets the level prefix and a trailing \n, returns the length.
+	static u64 FormatBinaryArgs(char *Out, u64 OutSize, LogLevel Level, f64 Time, const char *Format,
+								const u8 *ArgTypes, const u8 *Args, u64 ArgsLength);
+
+	// NOTE: Read inline by the macros, use the setters to change them
+	KIWI_API static u8 ChannelMasks[LogChannel_Count];
+
+private:
+	static void OutputV(LogChannel Channel, LogLevel Level, const char *Message, va_list Args);
+	static b8 Push(LogLevel Level, LogRecordKind Kind, const void *Data, u64 Length);
+	static void WriteToConsole(LogLevel Level, const char *Text);
+	static u64 FormatBinary(char *Out, u64 OutSize, LogLevel Level, const u8 *Record, u64 Length);
+	static void Drain();
+	static void WriteToFile(const char *Text, u64 Length);
+	static void FlushFile();
+	static void RotateFile();
+	static THREAD_PROC(WriterThread);
+
+	static b8 IsAsync;
+	static u32 MainThreadId;
+
+	static LogRingCell *Cells;
+	static LogRingPositions Ring;
+
+	// NOTE: Writer thread state
+	static PlatformThread Writer;
+	static u32 WriterThreadId;
+	static PlatformSemaphore WakeUp;
+	static volatile u64 WriterRunning;
+	static volatile b8 ConsoleOutput;
+	static char *RecordBuffer;
+	static char *FormatBuffer;
+	static u8 *FileBuffer;
+	static u64 FileBufferUsed;
+	static PlatformFile File;
+	static u64 FileBytes;
+	static u64 ReportedDropped;
 };
 
-// NOTE: Variadic macros are compiler specific,
-// that's why we check for MSVC
-#ifdef KIWI_MSVC
+/*
+NOTE: Deferred formatting. LogFast only captures the format string
+pointer, a cpu timer timestamp and the raw bytes of the arguments, the
+writer thread does the actual formatting later. The argument types are
+known at compile time, so every call site gets a static list of type
+tags and the capture is just a few stores into a stack buffer.
+Things to keep in mind:
+- The format string must be a literal, it is read after the call returns
+  (the macros enforce it).
+- Strings are copied, everything else is stored as 8 bytes.
+- At most LOG_BINARY_MAX_ARGS arguments, long strings get truncated to
+  keep the record under LOG_BINARY_MAX_SIZE bytes.
+- The format pointer is only meaningful inside this process, so the
+  records can't be decoded offline, the writer formats them in-process.
+- A call that passes the mask should stay under 50ns (logger.fast_info_enabled).
+  About 20ns of it is the cycle counter read of the timestamp on the VMs the
+  benchmarks run on, the rest is building the record and copying it into
+  the ring. Claiming the slot is only a few ns of that.
+*/
+#define LOG_BINARY_MAX_SIZE 1024
+#define LOG_BINARY_MAX_ARGS 16
+#define LOG_BINARY_SLOT_SIZE sizeof(u64)
+
+enum LogArgType
+{
+	LogArg_End,
+	LogArg_I32,
+	LogArg_U32,
+	LogArg_I64,
+	LogArg_U64,
+	LogArg_F64,
+	LogArg_Pointer,
+	LogArg_String
+};
 
-#define LogFatal(Message, ...) Logger::Output(LogLevel_Fatal, (Message), __VA_ARGS__)
-#define LogError(Message, ...) Logger::Output(LogLevel_Error, (Message), __VA_ARGS__)
+struct LogBinaryPrefix
+{
+	const char *Format;
+	const u8 *ArgTypes;
+	u64 Timestamp;
+};
+
+struct LogArgWriter
+{
+	u8 *At;
+	u8 *End;
+
+	// NOTE: Slots after a string are unaligned, which is fine on x64
+	KIWI_INLINE void WriteSlot(u64 Bits)
+	{
+		*(u64 *)At = Bits;
+		At += sizeof(Bits);
+	}
+
+	// NOTE: Reserved is what the following arguments need at most
+	void WriteString(const char *String, u64 Reserved)
+	{
+		if (!String)
+		{
+			String = "(null)";
+		}
+
+		u64 Available = (u64)(End - At) - Reserved - sizeof(u32) - 1;
+		u32 Length = (u32)Min(KStr::Length(String), Available);
+		MemSystem::Copy(At, &Length, sizeof(Length));
+		MemSystem::Copy(At + sizeof(Length), (void *)String, Length);
+		At[sizeof(Length) + Length] = '\0';
+		At += sizeof(Length) + Length + 1;
+	}
+};
+
+template <typename T, u8 TType>
+struct LogScalarArg
+{
+	static const u8 Type = TType;
+	KIWI_INLINE static void Write(LogArgWriter &Writer, T Value, u64)
+	{
+		StaticAssertMsg(sizeof(T) == LOG_BINARY_SLOT_SIZE, "LogFast scalars must fill a slot");
+		union
+		{
+			T Value;
+			u64 Bits;
+		} Slot;
+		Slot.Value = Value;
+		Writer.WriteSlot(Slot.Bits);
+	}
+};
+
+template <typename T, b8 IsSigned>
+struct LogIntegerArg
+{
+	static const u8 Type = sizeof(T) > sizeof(u32) ? (IsSigned ? LogArg_I64 : LogArg_U64)
+													: (IsSigned ? LogArg_I32 : LogArg_U32);
+	KIWI_INLINE static void Write(LogArgWriter &Writer, T Value, u64)
+	{
+		// NOTE: Sign extended, so the decoder can always read a full slot
+		Writer.WriteSlot(IsSigned ? (u64)(i64)Value : (u64)Value);
+	}
+};
+
+struct LogStringArg
+{
+	static const u8 Type = LogArg_String;
+	KIWI_INLINE static void Write(LogArgWriter &Writer, const char *Value, u64 Reserved)
+	{
+		Writer.WriteString(Value, Reserved);
+	}
+};
+
+// NOTE: Anything that is not listed below has to be an enum
+template <typename T>
+struct LogArgTraits : LogIntegerArg<T, true>
+{
+	StaticAssertMsg(__is_enum(T), "Unsupported argument type for LogFast");
+};
+template <> struct LogArgTraits<b8> : LogIntegerArg<b8, false> {};
+template <> struct LogArgTraits<bool> : LogIntegerArg<bool, false> {};
+template <> struct LogArgTraits<char> : LogIntegerArg<char, true> {};
+template <> struct LogArgTraits<signed char> : LogIntegerArg<signed char, true> {};
+template <> struct LogArgTraits<i16> : LogIntegerArg<i16, true> {};
+template <> struct LogArgTraits<u16> : LogIntegerArg<u16, false> {};
+template <> struct LogArgTraits<i32> : LogIntegerArg<i32, true> {};
+template <> struct LogArgTraits<u32> : LogIntegerArg<u32, false> {};
+template <> struct LogArgTraits<long> : LogIntegerArg<long, true> {};
+template <> struct LogArgTraits<unsigned long> : LogIntegerArg<unsigned long, false> {};
+template <> struct LogArgTraits<i64> : LogIntegerArg<i64, true> {};
+template <> struct LogArgTraits<u64> : LogIntegerArg<u64, false> {};
+// NOTE: Floats are promoted like they would be by printf
+template <> struct LogArgTraits<f32> : LogScalarArg<f64, LogArg_F64> {};
+template <> struct LogArgTraits<f64> : LogScalarArg<f64, LogArg_F64> {};
+template <> struct LogArgTraits<char *> : LogStringArg {};
+template <> struct LogArgTraits<const char *> : LogStringArg {};
+template <typename T> struct LogArgTraits<T *> : LogScalarArg<T *, LogArg_Pointer> {};
+
+// NOTE: One static list per argument type combination, terminated by LogArg_End
+template <typename... TArgs>
+struct LogArgTypes
+{
+	static const u8 Types[sizeof...(TArgs) + 1];
+};
+template <typename... TArgs>
+const u8 LogArgTypes<TArgs...>::Types[sizeof...(TArgs) + 1] = {LogArgTraits<TArgs>::Type..., LogArg_End};
+
+KIWI_INLINE void LogWriteArgs(LogArgWriter &)
+{
+}
+
+template <typename T, typename... TRest>
+KIWI_INLINE void LogWriteArgs(LogArgWriter &Writer, T First, TRest... Rest)
+{
+	LogArgTraits<T>::Write(Writer, First, sizeof...(TRest) * LOG_BINARY_SLOT_SIZE);
+	LogWriteArgs(Writer, Rest...);
+}
+
+template <typename... TArgs>
+KIWI_INLINE void LogFast(LogLevel Level, const char *Format, TArgs... Args)
+{
+	StaticAssertMsg(sizeof...(TArgs) <= LOG_BINARY_MAX_ARGS, "Too many arguments for LogFast");
+
+	u64 Record[LOG_BINARY_MAX_SIZE / sizeof(u64)];
+	LogBinaryPrefix *Prefix = (LogBinaryPrefix *)Record;
+	Prefix->Format = Format;
+	Prefix->ArgTypes = LogArgTypes<TArgs...>::Types;
+	Prefix->Timestamp = Clock::Now();
+
+	LogArgWriter Writer = {(u8 *)(Prefix + 1), (u8 *)Record + sizeof(Record)};
+	LogWriteArgs(Writer, Args...);
+	Logger::OutputBinary(Level, (u8 *)Record, (u64)(Writer.At - (u8 *)Record));
+}
+
+// NOTE: Variadic macros are compiler specific, that's why we check for
+// the compiler. These never get an empty __VA_ARGS__, so they work as is
+// on MSVC, gcc and clang
+#if defined(KIWI_MSVC) || defined(KIWI_GCC) || defined(KIWI_CLANG)
+
+// NOTE: A message that is masked out costs a load and a branch. The limiter
+// is per call site, it's a zero initialized static so there is no guard.
+// The do/while keeps them single statements, an unbraced if/else around them still works.
+#define LogChannelOutput(Channel, Level, ...)                                               \
+	do                                                                                      \
+	{                                                                                       \
+		if (Logger::ChannelMasks[LogChannel_##Channel] & (1 << (Level)))                    \
+		{                                                                                   \
+			local_persist LogRateLimiter RateLimiter_;                                      \
+			u32 Suppressed_;                                                                \
+			if (Logger::AllowRate(&RateLimiter_, Suppressed_))                              \
+			{                                                                               \
+				Logger::OutputChannel(LogChannel_##Channel, (Level), Suppressed_, __VA_ARGS__); \
+			}                                                                               \
+		}                                                                                   \
+	} while (0)
+
+#define LogFatal(...) Logger::Output(LogLevel_Fatal, __VA_ARGS__)
+#define LogChannelFatal(Channel, ...) Logger::OutputChannel(LogChannel_##Channel, LogLevel_Fatal, 0, __VA_ARGS__)
+#define LogChannelError(Channel, ...) LogChannelOutput(Channel, LogLevel_Error, __VA_ARGS__)
+#define LogError(...) LogChannelError(General, __VA_ARGS__)
 
 #if WARNING_LOG_ENABLED
-#define LogWarning(Message, ...) Logger::Output(LogLevel_Warning, (Message), __VA_ARGS__)
+#define LogChannelWarning(Channel, ...) LogChannelOutput(Channel, LogLevel_Warning, __VA_ARGS__)
 #else
-#define LogWarning(Message, ...)
+#define LogChannelWarning(Channel, ...)
 #endif
+#define LogWarning(...) LogChannelWarning(General, __VA_ARGS__)
 
 #if INFO_LOG_ENABLED
-#define LogInfo(Message, ...) Logger::Output(LogLevel_Info, (Message), __VA_ARGS__)
+#define LogChannelInfo(Channel, ...) LogChannelOutput(Channel, LogLevel_Info, __VA_ARGS__)
 #else
-#define LogInfo(Message, ...)
+#define LogChannelInfo(Channel, ...)
 #endif
+#define LogInfo(...) LogChannelInfo(General, __VA_ARGS__)
 
 #if DEBUG_LOG_ENABLED
-#define LogDebug(Message, ...) Logger::Output(LogLevel_Debug, (Message), __VA_ARGS__)
+#define LogChannelDebug(Channel, ...) LogChannelOutput(Channel, LogLevel_Debug, __VA_ARGS__)
 #else
-#define LogDebug(Message, ...)
+#define LogChannelDebug(Channel, ...)
 #endif
+#define LogDebug(...) LogChannelDebug(General, __VA_ARGS__)
 
 #if TRACE_LOG_ENABLED
-#define LogTrace(Message, ...) Logger::Output(LogLevel_Trace, (Message), __VA_ARGS__)
+#define LogChannelTrace(Channel, ...) LogChannelOutput(Channel, LogLevel_Trace, __VA_ARGS__)
+#else
+#define LogChannelTrace(Channel, ...)
+#endif
+#define LogTrace(...) LogChannelTrace(General, __VA_ARGS__)
+
+// NOTE: The empty literal makes sure the format is a literal too.
+// Fast logs are meant for volume, they go through the General mask but
+// they are not rate limited.
+#define LogFastOutput(Level, ...)                                       \
+	do                                                                  \
+	{                                                                   \
+		if (Logger::ChannelMasks[LogChannel_General] & (1 << (Level))) \
+		{                                                               \
+			LogFast((Level), "" __VA_ARGS__);                           \
+		}                                                               \
+	} while (0)
+
+#define LogFastFatal(...) LogFast(LogLevel_Fatal, "" __VA_ARGS__)
+#define LogFastError(...) LogFastOutput(LogLevel_Error, __VA_ARGS__)
+
+#if WARNING_LOG_ENABLED
+#define LogFastWarning(...) LogFastOutput(LogLevel_Warning, __VA_ARGS__)
 #else
-#define LogTrace(Message, ...)
+#define LogFastWarning(...)
 #endif
 
-#endif
\ No newline at end of file
+#if INFO_LOG_ENABLED
+#define LogFastInfo(...) LogFastOutput(LogLevel_Info, __VA_ARGS__)
+#else
+#define LogFastInfo(...)
+#endif
+
+#if DEBUG_LOG_ENABLED
+#define LogFastDebug(...) LogFastOutput(LogLevel_Debug, __VA_ARGS__)
+#else
+#define LogFastDebug(...)
+#endif
+
+#if TRACE_LOG_ENABLED
+#define LogFastTrace(...) LogFastOutput(LogLevel_Trace, __VA_ARGS__)
+#else
+#define LogFastTrace(...)
+#endif
+
+#endif
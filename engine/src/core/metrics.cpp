@@ -0,0 +1,424 @@
+#include "metrics.h"
+#include "core/logger.h"
+#include "core/kiwi_string.h"
+#include "core/histogram.h"
+#include "core/clock.h"
+#include "core/event.h"
+
+#define METRICS_HISTOGRAM_BUCKET_COUNT \
+	HISTOGRAM_BUCKET_COUNT(METRICS_HISTOGRAM_SUB_BUCKET_BITS, METRICS_HISTOGRAM_MAX_VALUE_BITS)
+// NOTE: Count, Sum and the buckets
+#define METRICS_HISTOGRAM_SLOT_COUNT (2 + METRICS_HISTOGRAM_BUCKET_COUNT)
+#define METRICS_HISTOGRAM_MAX_VALUE ((1ULL << METRICS_HISTOGRAM_MAX_VALUE_BITS) - 1)
+
+// NOTE: Must match BuiltinMetric, the counters come first
+MetricDesc Metrics::Descriptors[METRICS_MAX_COUNT] = {
+	{"frames", MetricType_Counter, 0},
+	{"renderer.frames", MetricType_Counter, 1},
+	{"renderer.resizes", MetricType_Counter, 2},
+	{"karray.resizes", MetricType_Counter, 3},
+	{"events.dispatched", MetricType_Counter, 4},
+	{"events.posted", MetricType_Counter, 5},
+	{"events.coalesced", MetricType_Counter, 6},
+	{"events.from_threads", MetricType_Counter, 7},
+	{"events.thread_queue_full", MetricType_Counter, 8},
+	{"frame.time_ns", MetricType_Histogram, 9},
+};
+u32 Metrics::MetricCount = Metric_BuiltinCount;
+u32 Metrics::SlotCount = 9 + METRICS_HISTOGRAM_SLOT_COUNT;
+volatile i64 Metrics::Gauges[METRICS_MAX_COUNT] = {};
+MetricsThread *Metrics::Threads = nullptr;
+PlatformRWLock Metrics::Lock = {};
+u64 Metrics::Totals[METRICS_MAX_SLOTS] = {};
+u64 Metrics::Exported[METRICS_MAX_SLOTS] = {};
+EventQueueStats Metrics::LastQueueTotals = {};
+MetricId Metrics::MemoryGauges[MemTag_Count] = {};
+#ifdef KIWI_SLOW
+MetricId Metrics::CommittedGauge = METRICS_INVALID_ID;
+#endif
+PlatformFile Metrics::File = {};
+const char *Metrics::Path = nullptr;
+b8 Metrics::IsExporting = false;
+b8 Metrics::IsCSV = false;
+u32 Metrics::ColumnCount = 0;
+u64 Metrics::SnapshotPeriod = 0;
+u64 Metrics::NextSnapshot = 0;
+
+local_var thread_local MetricsThread *CurrentMetricsThread = nullptr;
+
+// NOTE: Previous is the histogram at the last snapshot, nullptr for the whole run
+internal_func MetricsHistogramSummary SummarizeMetricHistogram(const u64 *Slots, const u64 *Previous)
+{
+	MetricsHistogramSummary Summary = {};
+	Summary.Count = Slots[0] - (Previous ? Previous[0] : 0);
+	if (!Summary.Count)
+	{
+		return Summary;
+	}
+	Summary.Mean = (f64)(Slots[1] - (Previous ? Previous[1] : 0)) / (f64)Summary.Count;
+
+	// NOTE: The ranks of the samples, 1 based, rounded up
+	u64 Rank50 = Max((u64)(0.5 * (f64)Summary.Count + 0.999999), (u64)1);
+	u64 Rank90 = Max((u64)(0.9 * (f64)Summary.Count + 0.999999), (u64)1);
+	u64 Rank99 = Max((u64)(0.99 * (f64)Summary.Count + 0.999999), (u64)1);
+	u64 Seen = 0;
+	for (u32 Bucket = 0; Bucket < METRICS_HISTOGRAM_BUCKET_COUNT && Seen < Summary.Count; ++Bucket)
+	{
+		u64 BucketCount = Slots[2 + Bucket] - (Previous ? Previous[2 + Bucket] : 0);
+		if (!BucketCount)
+		{
+			continue;
+		}
+
+		u64 Value = HistogramBucketValue(Bucket, METRICS_HISTOGRAM_SUB_BUCKET_BITS);
+		if (Seen < Rank50 && Seen + BucketCount >= Rank50)
+		{
+			Summary.P50 = Value;
+		}
+		if (Seen < Rank90 && Seen + BucketCount >= Rank90)
+		{
+			Summary.P90 = Value;
+		}
+		if (Seen < Rank99 && Seen + BucketCount >= Rank99)
+		{
+			Summary.P99 = Value;
+		}
+		Summary.Max = Value;
+		Seen += BucketCount;
+	}
+	return Summary;
+}
+
+b8 Metrics::Initialize(const char *InPath, f32 Interval)
+{
+	MemArena *Arena = MemSystem::GetArena(MemTag_Metrics);
+	for (u8 Tag = 1; Tag < MemTag_Count; ++Tag)
+	{
+		Platform::LockExclusive(&Lock);
+		KStrBuilder Builder;
+		Builder.Begin(Arena);
+		// NOTE: Only the name of the tag, without the MemTag_ prefix
+		Builder.Appendf("mem.%s", MemSystem::GetTagName(Tag) + sizeof("MemTag_") - 1);
+		const char *Name = Builder.End().Data;
+		Platform::UnlockExclusive(&Lock);
+		MemoryGauges[Tag] = RegisterGauge(Name);
+	}
+#ifdef KIWI_SLOW
+	CommittedGauge = RegisterGauge("mem.committed");
+#endif
+	LastQueueTotals = EventSystem::GetQueueTotals();
+
+	if (!InPath)
+	{
+		return true;
+	}
+
+	if (!Platform::FileOpen(&File, InPath, FileMode_Write))
+	{
+		LogError("Could not open %s to write the metrics", InPath);
+		return false;
+	}
+
+	u64 PathLength = KStr::Length(InPath);
+	Path = InPath;
+	IsCSV = PathLength >= 4 && KStr::EqualIgnoreCase(InPath + PathLength - 4, ".csv");
+	IsExporting = true;
+	ColumnCount = 0;
+	SnapshotPeriod = Clock::SecondsToTicks(Interval > 0.0f ? Interval : METRICS_DEFAULT_INTERVAL);
+	NextSnapshot = Clock::Now() + SnapshotPeriod;
+	LogInfo("Writing a metrics snapshot every %.1fs to %s", Clock::TicksToSeconds(SnapshotPeriod), Path);
+	return true;
+}
+
+void Metrics::Terminate()
+{
+	Aggregate();
+	if (IsExporting)
+	{
+		WriteSnapshot();
+		Platform::FileClose(&File);
+		IsExporting = false;
+	}
+
+	AutoFreeArena ScratchHandle = AutoFreeArena(MemTag_Scratch);
+	KStrBuilder Builder;
+	Builder.Begin(ScratchHandle.Arena);
+	Builder.Appendf("Metrics after %.1fs:", Clock::GetSeconds());
+	for (MetricId Id = 0; Id < MetricCount; ++Id)
+	{
+		MetricDesc *Desc = &Descriptors[Id];
+		if (Desc->Type == MetricType_Counter)
+		{
+			Builder.Appendf("\n  %-24s %llu", Desc->Name, Totals[Desc->Slot]);
+		}
+		else if (Desc->Type == MetricType_Gauge)
+		{
+			Builder.Appendf("\n  %-24s %lld", Desc->Name, Gauges[Id]);
+		}
+		else
+		{
+			MetricsHistogramSummary Summary = SummarizeMetricHistogram(&Totals[Desc->Slot], nullptr);
+			Builder.Appendf("\n  %-24s count %llu, mean %.1f, p50 %llu, p90 %llu, p99 %llu, max %llu", Desc->Name,
+							Summary.Count, Summary.Mean, Summary.P50, Summary.P90, Summary.P99, Summary.Max);
+		}
+	}
+	LogInfo("%s", Builder.End().Data);
+}
+
+void Metrics::EndFrame()
+{
+	// NOTE: The engine counts that are kept somewhere else
+	EventQueueStats QueueTotals = EventSystem::GetQueueTotals();
+	Add(Metric_EventsDispatched, (u32)(QueueTotals.Dispatched - LastQueueTotals.Dispatched));
+	Add(Metric_EventsPosted, (u32)(QueueTotals.Posted - LastQueueTotals.Posted));
+	Add(Metric_EventsCoalesced, (u32)(QueueTotals.Coalesced - LastQueueTotals.Coalesced));
+	Add(Metric_EventsFromThreads, (u32)(QueueTotals.FromThreads - LastQueueTotals.FromThreads));
+	Add(Metric_EventThreadQueueFull, (u32)(QueueTotals.ThreadQueueFull - LastQueueTotals.ThreadQueueFull));
+	LastQueueTotals = QueueTotals;
+	for (u8 Tag = 1; Tag < MemTag_Count; ++Tag)
+	{
+		Set(MemoryGauges[Tag], (i64)MemSystem::GetArena(Tag)->OccupiedMem);
+	}
+#ifdef KIWI_SLOW
+	Set(CommittedGauge, (i64)MemSystem::TotalCommitted);
+#endif
+
+	Aggregate();
+
+	if (IsExporting && Clock::Now() >= NextSnapshot)
+	{
+		WriteSnapshot();
+		// NOTE: A long frame doesn't make the snapshots catch up, the next one is a period away
+		NextSnapshot = Clock::Now() + SnapshotPeriod;
+	}
+}
+
+MetricId Metrics::RegisterCounter(const char *Name)
+{
+	return Register(Name, MetricType_Counter);
+}
+
+MetricId Metrics::RegisterGauge(const char *Name)
+{
+	return Register(Name, MetricType_Gauge);
+}
+
+MetricId Metrics::RegisterHistogram(const char *Name)
+{
+	return Register(Name, MetricType_Histogram);
+}
+
+void Metrics::Add(MetricId Id, u64 Value)
+{
+	if (Id >= MetricCount || Descriptors[Id].Type != MetricType_Counter)
+	{
+		return;
+	}
+
+	MetricsThread *Thread = CurrentMetricsThread ? CurrentMetricsThread : RegisterThread();
+	if (Thread)
+	{
+		u32 Slot = Descriptors[Id].Slot;
+		Thread->Slots[Slot] = Thread->Slots[Slot] + Value;
+	}
+}
+
+void Metrics::Set(MetricId Id, i64 Value)
+{
+	if (Id < MetricCount)
+	{
+		Gauges[Id] = Value;
+	}
+}
+
+void Metrics::Record(MetricId Id, u64 Value)
+{
+	if (Id >= MetricCount || Descriptors[Id].Type != MetricType_Histogram)
+	{
+		return;
+	}
+
+	MetricsThread *Thread = CurrentMetricsThread ? CurrentMetricsThread : RegisterThread();
+	if (Thread)
+	{
+		Value = Min(Value, METRICS_HISTOGRAM_MAX_VALUE);
+		volatile u64 *Slots = &Thread->Slots[Descriptors[Id].Slot];
+		u32 Bucket = HistogramBucket(Value, METRICS_HISTOGRAM_SUB_BUCKET_BITS);
+		Slots[0] = Slots[0] + 1;
+		Slots[1] = Slots[1] + Value;
+		Slots[2 + Bucket] = Slots[2 + Bucket] + 1;
+	}
+}
+
+u64 Metrics::GetCounter(MetricId Id)
+{
+	return Id < MetricCount && Descriptors[Id].Type == MetricType_Counter ? Totals[Descriptors[Id].Slot] : 0;
+}
+
+i64 Metrics::GetGauge(MetricId Id)
+{
+	return Id < MetricCount ? Gauges[Id] : 0;
+}
+
+MetricsHistogramSummary Metrics::GetHistogram(MetricId Id)
+{
+	if (Id >= MetricCount || Descriptors[Id].Type != MetricType_Histogram)
+	{
+		MetricsHistogramSummary Empty = {};
+		return Empty;
+	}
+	return SummarizeMetricHistogram(&Totals[Descriptors[Id].Slot], nullptr);
+}
+
+MetricId Metrics::Register(const char *Name, MetricType Type)
+{
+	u32 Slots = 0;
+	if (Type == MetricType_Counter)
+	{
+		Slots = 1;
+	}
+	else if (Type == MetricType_Histogram)
+	{
+		Slots = METRICS_HISTOGRAM_SLOT_COUNT;
+	}
+
+	MetricId Result = METRICS_INVALID_ID;
+	Platform::LockExclusive(&Lock);
+	for (MetricId Id = 0; Id < MetricCount; ++Id)
+	{
+		if (KStr::Equal(Descriptors[Id].Name, Name))
+		{
+			Result = Descriptors[Id].Type == Type ? Id : METRICS_INVALID_ID;
+			Platform::UnlockExclusive(&Lock);
+			if (Result == METRICS_INVALID_ID)
+			{
+				LogError("Metric %s is already registered with another type", Name);
+			}
+			return Result;
+		}
+	}
+
+	if (MetricCount < METRICS_MAX_COUNT && SlotCount + Slots <= METRICS_MAX_SLOTS)
+	{
+		MetricDesc *Desc = &Descriptors[MetricCount];
+		Desc->Name = Name;
+		Desc->Type = Type;
+		Desc->Slot = SlotCount;
+		SlotCount += Slots;
+		Result = MetricCount;
+		Gauges[Result] = 0;
+		// NOTE: Published last, the updates check the id against it
+		MetricCount = MetricCount + 1;
+	}
+	Platform::UnlockExclusive(&Lock);
+
+	if (Result == METRICS_INVALID_ID)
+	{
+		LogError("Too many metrics, %s is not registered", Name);
+	}
+	return Result;
+}
+
+MetricsThread *Metrics::RegisterThread()
+{
+	// NOTE: The metrics arena is only touched with the lock held
+	Platform::LockExclusive(&Lock);
+	MetricsThread *Thread = (MetricsThread *)MemSystem::GetArena(MemTag_Metrics)
+								->PushAligned(sizeof(MetricsThread), CACHE_LINE_SIZE);
+	if (Thread)
+	{
+		Thread->Next = Threads;
+		Threads = Thread;
+	}
+	Platform::UnlockExclusive(&Lock);
+
+	CurrentMetricsThread = Thread;
+	return Thread;
+}
+
+void Metrics::Aggregate()
+{
+	Platform::LockShared(&Lock);
+	MemSystem::Zero(Totals, SlotCount * sizeof(u64));
+	for (MetricsThread *Thread = Threads; Thread; Thread = Thread->Next)
+	{
+		for (u32 Slot = 0; Slot < SlotCount; ++Slot)
+		{
+			Totals[Slot] += Thread->Slots[Slot];
+		}
+	}
+	Platform::UnlockShared(&Lock);
+}
+
+void Metrics::WriteSnapshot()
+{
+	AutoFreeArena ScratchHandle = AutoFreeArena(MemTag_Scratch);
+	KStrBuilder Builder;
+	Builder.Begin(ScratchHandle.Arena);
+
+	// NOTE: The metrics registered after the first row don't get a column
+	u32 Count = MetricCount;
+	if (IsCSV && !ColumnCount)
+	{
+		ColumnCount = Count;
+		Builder.Append("seconds");
+		for (MetricId Id = 0; Id < ColumnCount; ++Id)
+		{
+			const char *Name = Descriptors[Id].Name;
+			if (Descriptors[Id].Type == MetricType_Histogram)
+			{
+				Builder.Appendf(",%s.count,%s.mean,%s.p50,%s.p90,%s.p99,%s.max", Name, Name, Name, Name, Name, Name);
+			}
+			else
+			{
+				Builder.Appendf(",%s", Name);
+			}
+		}
+		Builder.AppendChar('\n');
+	}
+	if (IsCSV)
+	{
+		Count = ColumnCount;
+	}
+
+	Builder.Appendf(IsCSV ? "%.3f" : "{\"seconds\":%.3f", Clock::GetSeconds());
+	for (MetricId Id = 0; Id < Count; ++Id)
+	{
+		MetricDesc *Desc = &Descriptors[Id];
+		if (!IsCSV)
+		{
+			Builder.Appendf(",\"%s\":", Desc->Name);
+		}
+		else
+		{
+			Builder.AppendChar(',');
+		}
+
+		if (Desc->Type == MetricType_Counter)
+		{
+			Builder.Appendf("%llu", Totals[Desc->Slot] - Exported[Desc->Slot]);
+		}
+		else if (Desc->Type == MetricType_Gauge)
+		{
+			Builder.Appendf("%lld", Gauges[Id]);
+		}
+		else
+		{
+			MetricsHistogramSummary Summary = SummarizeMetricHistogram(&Totals[Desc->Slot], &Exported[Desc->Slot]);
+			Builder.Appendf(IsCSV ? "%llu,%.1f,%llu,%llu,%llu,%llu"
+								  : "{\"count\":%llu,\"mean\":%.1f,\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"max\":%llu}",
+							Summary.Count, Summary.Mean, Summary.P50, Summary.P90, Summary.P99, Summary.Max);
+		}
+	}
+	Builder.Append(IsCSV ? "\n" : "}\n");
+
+	KStrView Row = Builder.End();
+	if (!Platform::FileWrite(&File, Row.Data, Row.Length))
+	{
+		LogError("Could not write the metrics to %s, no more snapshots", Path);
+		Platform::FileClose(&File);
+		IsExporting = false;
+		return;
+	}
+	MemSystem::Copy(Exported, Totals, SlotCount * sizeof(u64));
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+/*
+NOTE: Engine metrics: counters, gauges and histograms, registered by name
+and updated through their MetricId from any thread.
+Counters and histograms are per thread: every thread gets its own block of
+slots the first time it updates something and only ever adds to it, no
+locks and no atomics on the hot path. EndFrame sums the blocks of all the
+threads, once per frame, so the totals lag at most a frame behind.
+Gauges are a single value, the last Set wins.
+With ApplicationConfig::MetricsPath set (--metrics <path>) a snapshot is
+appended to the file every MetricsInterval seconds, counters and
+histograms with what happened since the previous snapshot: a row per
+snapshot when the path ends in .csv, a JSON object per line otherwise.
+The CSV columns are the metrics registered when the first row is written.
+*/
+
+#include "defines.h"
+#include "core/kiwi_mem.h"
+#include "platform/platform.h"
+
+typedef u32 MetricId;
+
+// NOTE: event.h includes this through karray.h
+struct EventQueueStats;
+
+#define METRICS_INVALID_ID ((MetricId)-1)
+#define METRICS_MAX_COUNT 256
+// NOTE: u64 per thread, a counter takes one, a histogram 2 + its buckets
+#define METRICS_MAX_SLOTS 4096
+#define METRICS_HISTOGRAM_SUB_BUCKET_BITS 3
+// NOTE: Up to 2^48 (~3 days of nanoseconds), bigger values are clamped
+#define METRICS_HISTOGRAM_MAX_VALUE_BITS 48
+#define METRICS_DEFAULT_INTERVAL 1.0f
+
+// NOTE: Always registered, in this order, so they can be updated before Initialize
+enum BuiltinMetric
+{
+	Metric_Frames,
+	Metric_RendererFrames,
+	Metric_FramebufferResizes,
+	Metric_KArrayResizes,
+	// NOTE: The queue counters of the EventSystem, see EventQueueStats.
+	// The events fired directly aren't counted, Fire is too hot for a counter.
+	Metric_EventsDispatched,
+	Metric_EventsPosted,
+	Metric_EventsCoalesced,
+	Metric_EventsFromThreads,
+	Metric_EventThreadQueueFull,
+	// NOTE: Histogram of nanoseconds
+	Metric_FrameTime,
+
+	Metric_BuiltinCount
+};
+
+enum MetricType
+{
+	MetricType_Counter,
+	MetricType_Gauge,
+	MetricType_Histogram,
+};
+
+struct MetricDesc
+{
+	const char *Name;
+	MetricType Type;
+	// NOTE: First slot of the per thread blocks, unused by gauges
+	u32 Slot;
+};
+
+struct MetricsThread
+{
+	volatile u64 Slots[METRICS_MAX_SLOTS];
+	MetricsThread *Next;
+};
+
+// NOTE: Approximated to the histogram bucket, ~6% at most
+struct MetricsHistogramSummary
+{
+	u64 Count;
+	f64 Mean;
+	u64 P50;
+	u64 P90;
+	u64 P99;
+	u64 Max;
+};
+
+// NOTE: this is a singleton
+class Metrics
+{
+public:
+	// NOTE: Path nullptr registers the engine metrics without exporting them
+	static b8 Initialize(const char *InPath, f32 Interval);
+	// NOTE: Writes the last snapshot and logs the totals
+	static void Terminate();
+	// NOTE: Main thread, once per frame
+	static void EndFrame();
+
+	// NOTE: Registering a name twice gives back the same id.
+	// The name must outlive the registry, string literals are fine
+	KIWI_API static MetricId RegisterCounter(const char *Name);
+	KIWI_API static MetricId RegisterGauge(const char *Name);
+	KIWI_API static MetricId RegisterHistogram(const char *Name);
+
+	KIWI_API static void Add(MetricId Id, u64 Value);
+	KIWI_API static void Set(MetricId Id, i64 Value);
+	KIWI_API static void Record(MetricId Id, u64 Value);
+
+	// NOTE: As of the last EndFrame
+	KIWI_API static u64 GetCounter(MetricId Id);
+	KIWI_API static i64 GetGauge(MetricId Id);
+	KIWI_API static MetricsHistogramSummary GetHistogram(MetricId Id);
+
+private:
+	static MetricId Register(const char *Name, MetricType Type);
+	static MetricsThread *RegisterThread();
+	static void Aggregate();
+	static void WriteSnapshot();
+
+	static MetricDesc Descriptors[METRICS_MAX_COUNT];
+	static u32 MetricCount;
+	static u32 SlotCount;
+	static volatile i64 Gauges[METRICS_MAX_COUNT];
+	static MetricsThread *Threads;
+	static PlatformRWLock Lock;
+	// NOTE: Totals of all the threads at the last EndFrame and at the last snapshot
+	static u64 Totals[METRICS_MAX_SLOTS];
+	static u64 Exported[METRICS_MAX_SLOTS];
+	static EventQueueStats LastQueueTotals;
+	// NOTE: Occupied memory of every arena, MemTag_Unknown has none
+	static MetricId MemoryGauges[MemTag_Count];
+#ifdef KIWI_SLOW
+	static MetricId CommittedGauge;
+#endif
+	static PlatformFile File;
+	static const char *Path;
+	static b8 IsExporting;
+	static b8 IsCSV;
+	static u32 ColumnCount;
+	static u64 SnapshotPeriod;
+	static u64 NextSnapshot;
+};
@@ -0,0 +1,484 @@
+#include "profiler.h"
+#include "core/logger.h"
+#include "core/kiwi_mem.h"
+#include "core/kiwi_string.h"
+#include "core/trace_writer.h"
+#include "core/clock.h"
+
+#define PROFILER_RING_MASK (PROFILER_RING_EVENT_COUNT - 1)
+#define PROFILER_NAME_COLUMN_WIDTH 48
+
+ProfileThread *Profiler::Threads = nullptr;
+PlatformRWLock Profiler::ThreadsLock = {};
+ProfileFrame Profiler::LastFrame = {};
+ProfileFrame Profiler::SlowestFrame = {};
+u64 Profiler::FrameIndex = 0;
+u64 Profiler::FrameBeginTime = 0;
+b8 Profiler::IsInitialized = false;
+b8 Profiler::UsePerfCounters = false;
+
+local_var KIWI_THREAD_LOCAL ProfileThread *CurrentProfileThread = nullptr;
+
+b8 Profiler::Initialize(b8 InUsePerfCounters)
+{
+#if PROFILER_ENABLED
+	if (IsInitialized)
+	{
+		LogError("Profiler already initialized");
+		return false;
+	}
+
+	MemArena *Arena = MemSystem::GetArena(MemTag_Profiler);
+	LastFrame.Nodes = (ProfileNode *)Arena->PushNoZero(PROFILER_MAX_NODES * sizeof(ProfileNode));
+	SlowestFrame.Nodes = (ProfileNode *)Arena->PushNoZero(PROFILER_MAX_NODES * sizeof(ProfileNode));
+	if (!LastFrame.Nodes || !SlowestFrame.Nodes)
+	{
+		LogError("Could not allocate the profiler frames");
+		return false;
+	}
+
+	FrameBeginTime = ReadCycleCounter();
+	UsePerfCounters = InUsePerfCounters;
+	IsInitialized = true;
+#endif
+	return true;
+}
+
+void Profiler::Terminate()
+{
+	if (!IsInitialized)
+	{
+		return;
+	}
+
+	if (SlowestFrame.NodeCount)
+	{
+		LogInfo("Slowest frame of the run:");
+		LogFrame(&SlowestFrame);
+	}
+	IsInitialized = false;
+}
+
+ProfileThread *Profiler::RegisterThread()
+{
+	if (!IsInitialized)
+	{
+		return nullptr;
+	}
+
+	// NOTE: Without counters the scopes still have their time
+	PlatformPerfCounters PerfCounters = {};
+	b8 HasPerfCounters = UsePerfCounters && Platform::PerfCountersOpen(&PerfCounters);
+	if (UsePerfCounters && !HasPerfCounters)
+	{
+		UsePerfCounters = false;
+		LogWarning("Hardware performance counters are not available, profiler scopes only have their time");
+	}
+
+	// NOTE: The profiler arena is only touched here and in Initialize
+	Platform::LockExclusive(&ThreadsLock);
+	MemArena *Arena = MemSystem::GetArena(MemTag_Profiler);
+	ProfileThread *Thread = (ProfileThread *)Arena->PushAligned(sizeof(ProfileThread), CACHE_LINE_SIZE);
+	ProfileEvent *Events = nullptr;
+	u64 *Counters = nullptr;
+	if (Thread)
+	{
+		Events = (ProfileEvent *)Arena->PushNoZeroAligned(PROFILER_RING_EVENT_COUNT * sizeof(ProfileEvent),
+														  CACHE_LINE_SIZE);
+	}
+	if (Events && HasPerfCounters)
+	{
+		Counters = (u64 *)Arena->PushNoZeroAligned(PROFILER_RING_EVENT_COUNT * PerfCounter_Count * sizeof(u64),
+												   CACHE_LINE_SIZE);
+	}
+	if (Events)
+	{
+		Thread->Events = Events;
+		Thread->Counters = Counters;
+		Thread->PerfCounters = PerfCounters;
+		Thread->ThreadId = Platform::GetThreadId();
+		Thread->Next = Threads;
+		Threads = Thread;
+	}
+	Platform::UnlockExclusive(&ThreadsLock);
+
+	if (HasPerfCounters && !Counters)
+	{
+		Platform::PerfCountersClose(&PerfCounters);
+	}
+	if (!Events)
+	{
+		LogError("Could not allocate the profiler ring of thread %u", Platform::GetThreadId());
+		return nullptr;
+	}
+
+	CurrentProfileThread = Thread;
+	return Thread;
+}
+
+ProfileThread *Profiler::BeginScope(const char *Name)
+{
+	ProfileThread *Thread = CurrentProfileThread;
+	if (!Thread)
+	{
+		Thread = RegisterThread();
+		if (!Thread)
+		{
+			return nullptr;
+		}
+	}
+
+	// NOTE: Always leave room for this scope's end and the ends of the
+	// scopes already open. The consumer's position is read again only
+	// when the ring looks full, so usually only our own lines are touched.
+	u64 Pos = Thread->WritePos;
+	u64 Needed = Pos + Thread->OpenDepth + 2;
+	if (Needed > Thread->CachedReadPos + PROFILER_RING_EVENT_COUNT)
+	{
+		Thread->CachedReadPos = AtomicLoadAcquire64(&Thread->ReadPos);
+	}
+
+	// NOTE: Once a scope is dropped so are the ones nested in it,
+	// that way the ends can't be mismatched
+	if (Thread->DroppedDepth || Needed > Thread->CachedReadPos + PROFILER_RING_EVENT_COUNT)
+	{
+		++Thread->DroppedDepth;
+		Thread->DroppedCount = Thread->DroppedCount + 1;
+		return Thread;
+	}
+
+	ProfileEvent *Event = &Thread->Events[Pos & PROFILER_RING_MASK];
+	Event->Name = Name;
+	Event->Time = ReadCycleCounter();
+	// NOTE: Last thing on the way in, first on the way out
+	if (Thread->Counters)
+	{
+		Platform::PerfCountersRead(&Thread->PerfCounters, Thread->Counters + (Pos & PROFILER_RING_MASK) * PerfCounter_Count);
+	}
+	AtomicStoreRelease64(&Thread->WritePos, Pos + 1);
+	++Thread->OpenDepth;
+	return Thread;
+}
+
+void Profiler::EndScope(ProfileThread *Thread)
+{
+	u64 Time = ReadCycleCounter();
+	if (!Thread)
+	{
+		return;
+	}
+
+	if (Thread->DroppedDepth)
+	{
+		--Thread->DroppedDepth;
+		return;
+	}
+
+	if (!Thread->OpenDepth)
+	{
+		return;
+	}
+
+	u64 Pos = Thread->WritePos;
+	if (Thread->Counters)
+	{
+		Platform::PerfCountersRead(&Thread->PerfCounters, Thread->Counters + (Pos & PROFILER_RING_MASK) * PerfCounter_Count);
+	}
+	ProfileEvent *Event = &Thread->Events[Pos & PROFILER_RING_MASK];
+	Event->Name = nullptr;
+	Event->Time = Time;
+	AtomicStoreRelease64(&Thread->WritePos, Pos + 1);
+	--Thread->OpenDepth;
+}
+
+internal_func u32 AddProfileNode(ProfileFrame *Frame, u32 Parent, u32 PrevSibling, const char *Name, u32 ThreadId)
+{
+	if (Frame->NodeCount == PROFILER_MAX_NODES)
+	{
+		return PROFILER_INVALID_NODE;
+	}
+
+	u32 NodeIdx = Frame->NodeCount++;
+	ProfileNode *Node = &Frame->Nodes[NodeIdx];
+	Node->Name = Name;
+	Node->TotalTicks = 0;
+	Node->ChildTicks = 0;
+	Node->CallCount = 0;
+	Node->Depth = Parent != PROFILER_INVALID_NODE ? Frame->Nodes[Parent].Depth + 1 : 0;
+	Node->ThreadId = ThreadId;
+	Node->Parent = Parent;
+	Node->FirstChild = PROFILER_INVALID_NODE;
+	Node->NextSibling = PROFILER_INVALID_NODE;
+	MemSystem::Zero(Node->Counters, sizeof(Node->Counters));
+
+	if (PrevSibling != PROFILER_INVALID_NODE)
+	{
+		Frame->Nodes[PrevSibling].NextSibling = NodeIdx;
+	}
+	else if (Parent != PROFILER_INVALID_NODE)
+	{
+		Frame->Nodes[Parent].FirstChild = NodeIdx;
+	}
+	return NodeIdx;
+}
+
+// NOTE: Children keep the order in which they first ran. The same literal
+// can have a different address in another module, hence the string compare.
+internal_func u32 FindOrAddProfileNode(ProfileFrame *Frame, u32 Parent, const char *Name)
+{
+	if (Parent == PROFILER_INVALID_NODE || Frame->Nodes[Parent].Depth + 1 >= PROFILER_MAX_DEPTH)
+	{
+		return PROFILER_INVALID_NODE;
+	}
+
+	ProfileNode *Nodes = Frame->Nodes;
+	u32 LastChild = PROFILER_INVALID_NODE;
+	for (u32 Child = Nodes[Parent].FirstChild; Child != PROFILER_INVALID_NODE; Child = Nodes[Child].NextSibling)
+	{
+		if (Nodes[Child].Name == Name || KStr::Equal(Nodes[Child].Name, Name))
+		{
+			return Child;
+		}
+		LastChild = Child;
+	}
+
+	return AddProfileNode(Frame, Parent, LastChild, Name, Nodes[Parent].ThreadId);
+}
+
+u32 Profiler::BuildThreadTree(ProfileFrame *Frame, ProfileThread *Thread)
+{
+	u64 ReadPos = Thread->ReadPos;
+	u64 WritePos = AtomicLoadAcquire64(&Thread->WritePos);
+	u64 DroppedCount = Thread->DroppedCount;
+	u32 DroppedScopes = (u32)(DroppedCount - Thread->SeenDroppedCount);
+	Thread->SeenDroppedCount = DroppedCount;
+
+	// NOTE: Find where the last complete top level scope ends. An end
+	// with nothing open belongs to a scope that was thrown away below.
+	u64 ConsumeEnd = ReadPos;
+	u32 Depth = 0;
+	u32 PendingScopes = 0;
+	for (u64 Pos = ReadPos; Pos < WritePos; ++Pos)
+	{
+		if (Thread->Events[Pos & PROFILER_RING_MASK].Name)
+		{
+			++Depth;
+			++PendingScopes;
+		}
+		else if (Depth)
+		{
+			--Depth;
+		}
+
+		if (!Depth)
+		{
+			ConsumeEnd = Pos + 1;
+			PendingScopes = 0;
+		}
+	}
+
+	if (ConsumeEnd == ReadPos)
+	{
+		// NOTE: A scope open for half the ring will never fit in a frame,
+		// throw its events away before the ring stalls
+		if (WritePos - ReadPos > PROFILER_RING_EVENT_COUNT / 2)
+		{
+			AtomicStoreRelease64(&Thread->ReadPos, WritePos);
+			DroppedScopes += PendingScopes;
+		}
+		return DroppedScopes;
+	}
+
+	u32 Root = AddProfileNode(Frame, PROFILER_INVALID_NODE, PROFILER_INVALID_NODE, nullptr, Thread->ThreadId);
+	if (Thread->Counters)
+	{
+		Frame->HasCounters = true;
+	}
+
+	u32 Stack[PROFILER_MAX_DEPTH];
+	u64 StackBegin[PROFILER_MAX_DEPTH];
+	u64 StackCounters[PROFILER_MAX_DEPTH][PerfCounter_Count];
+	u32 StackDepth = 0;
+	// NOTE: Scopes that didn't get a node, too deep or out of nodes
+	u32 SkippedDepth = 0;
+	for (u64 Pos = ReadPos; Pos < ConsumeEnd; ++Pos)
+	{
+		ProfileEvent Event = Thread->Events[Pos & PROFILER_RING_MASK];
+		if (Event.Name)
+		{
+			u32 Node = PROFILER_INVALID_NODE;
+			if (!SkippedDepth)
+			{
+				Node = FindOrAddProfileNode(Frame, StackDepth ? Stack[StackDepth - 1] : Root, Event.Name);
+			}
+			if (Node == PROFILER_INVALID_NODE)
+			{
+				++SkippedDepth;
+				++DroppedScopes;
+				continue;
+			}
+			if (Thread->Counters)
+			{
+				MemSystem::Copy(StackCounters[StackDepth], Thread->Counters + (Pos & PROFILER_RING_MASK) * PerfCounter_Count,
+								sizeof(StackCounters[StackDepth]));
+			}
+			Stack[StackDepth] = Node;
+			StackBegin[StackDepth++] = Event.Time;
+		}
+		else if (SkippedDepth)
+		{
+			--SkippedDepth;
+		}
+		else if (StackDepth)
+		{
+			ProfileNode *Node = &Frame->Nodes[Stack[--StackDepth]];
+			u64 Ticks = Event.Time - StackBegin[StackDepth];
+			Node->TotalTicks += Ticks;
+			++Node->CallCount;
+			Frame->Nodes[Node->Parent].ChildTicks += Ticks;
+			if (Thread->Counters)
+			{
+				const u64 *EndCounters = Thread->Counters + (Pos & PROFILER_RING_MASK) * PerfCounter_Count;
+				for (u32 Counter = 0; Counter < PerfCounter_Count; ++Counter)
+				{
+					u64 Delta = EndCounters[Counter] - StackCounters[StackDepth][Counter];
+					Node->Counters[Counter] += Delta;
+					// NOTE: The root gets what its top level scopes ran
+					if (Node->Parent == Root)
+					{
+						Frame->Nodes[Root].Counters[Counter] += Delta;
+					}
+				}
+			}
+			if (TraceWriter::IsActive())
+			{
+				TraceWriter::AddScope(Thread->ThreadId, Node->Name, StackBegin[StackDepth], Event.Time);
+			}
+		}
+	}
+
+	// NOTE: Only now the producer can reuse these events
+	AtomicStoreRelease64(&Thread->ReadPos, ConsumeEnd);
+
+	if (Root != PROFILER_INVALID_NODE)
+	{
+		ProfileNode *RootNode = &Frame->Nodes[Root];
+		RootNode->TotalTicks = Max(Frame->EndTime - Frame->BeginTime, RootNode->ChildTicks);
+		RootNode->CallCount = 1;
+	}
+	return DroppedScopes;
+}
+
+void Profiler::BeginFrames()
+{
+	if (!IsInitialized)
+	{
+		return;
+	}
+
+	FrameBeginTime = ReadCycleCounter();
+}
+
+void Profiler::EndFrame()
+{
+	if (!IsInitialized)
+	{
+		return;
+	}
+
+	u64 Now = ReadCycleCounter();
+
+	ProfileFrame *Frame = &LastFrame;
+	Frame->FrameIndex = FrameIndex++;
+	Frame->BeginTime = FrameBeginTime;
+	Frame->EndTime = Now;
+	Frame->NodeCount = 0;
+	Frame->DroppedScopes = 0;
+	Frame->HasCounters = false;
+	FrameBeginTime = Now;
+
+	Platform::LockShared(&ThreadsLock);
+	for (ProfileThread *Thread = Threads; Thread; Thread = Thread->Next)
+	{
+		Frame->DroppedScopes += BuildThreadTree(Frame, Thread);
+	}
+	Platform::UnlockShared(&ThreadsLock);
+
+	if (Frame->EndTime - Frame->BeginTime > SlowestFrame.EndTime - SlowestFrame.BeginTime)
+	{
+		ProfileNode *SlowestNodes = SlowestFrame.Nodes;
+		SlowestFrame = *Frame;
+		SlowestFrame.Nodes = SlowestNodes;
+		MemSystem::Copy(SlowestNodes, Frame->Nodes, Frame->NodeCount * sizeof(ProfileNode));
+	}
+}
+
+const ProfileFrame *Profiler::GetLastFrame()
+{
+	return IsInitialized && FrameIndex ? &LastFrame : nullptr;
+}
+
+const ProfileFrame *Profiler::GetSlowestFrame()
+{
+	return IsInitialized && FrameIndex ? &SlowestFrame : nullptr;
+}
+
+f64 Profiler::TicksToMS(u64 Ticks)
+{
+	return Clock::CyclesToMS(Ticks);
+}
+
+internal_func void AppendProfileNode(KStrBuilder *Builder, const ProfileFrame *Frame, u32 NodeIdx)
+{
+	const ProfileNode *Node = &Frame->Nodes[NodeIdx];
+	i32 Indent = (i32)Node->Depth * 2;
+	if (Node->Name)
+	{
+		Builder->Appendf("\n  %*s%-*s", Indent, "", Max(PROFILER_NAME_COLUMN_WIDTH - Indent, 1), Node->Name);
+	}
+	else
+	{
+		Builder->Appendf("\n  Thread %-*u", PROFILER_NAME_COLUMN_WIDTH - 7, Node->ThreadId);
+	}
+	Builder->Appendf(" %10.3f %10.3f %8u", Profiler::TicksToMS(Node->TotalTicks),
+					 Profiler::TicksToMS(Node->SelfTicks()), Node->CallCount);
+	if (Frame->HasCounters)
+	{
+		u64 Cycles = Node->Counters[PerfCounter_Cycles];
+		Builder->Appendf(" %6.2f %12llu %12llu", Cycles ? (f64)Node->Counters[PerfCounter_Instructions] / (f64)Cycles : 0.0,
+						 Node->Counters[PerfCounter_CacheMisses], Node->Counters[PerfCounter_BranchMisses]);
+	}
+
+	for (u32 Child = Node->FirstChild; Child != PROFILER_INVALID_NODE; Child = Frame->Nodes[Child].NextSibling)
+	{
+		AppendProfileNode(Builder, Frame, Child);
+	}
+}
+
+void Profiler::LogFrame(const ProfileFrame *Frame)
+{
+	if (!Frame)
+	{
+		return;
+	}
+
+	// NOTE: A single message, the tree doesn't get interleaved with other logs
+	AutoFreeArena ScratchHandle = AutoFreeArena(MemTag_Scratch);
+	KStrBuilder Builder;
+	Builder.Begin(ScratchHandle.Arena);
+	Builder.Appendf("Frame %llu: %.3fms, %u scopes dropped", Frame->FrameIndex,
+					TicksToMS(Frame->EndTime - Frame->BeginTime), Frame->DroppedScopes);
+	Builder.Appendf("\n  %-*s %10s %10s %8s", PROFILER_NAME_COLUMN_WIDTH, "Scope", "Total ms", "Self ms", "Calls");
+	if (Frame->HasCounters)
+	{
+		Builder.Appendf(" %6s %12s %12s", "IPC", "Cache miss", "Branch miss");
+	}
+	for (u32 NodeIdx = 0; NodeIdx < Frame->NodeCount; ++NodeIdx)
+	{
+		if (Frame->Nodes[NodeIdx].Parent == PROFILER_INVALID_NODE)
+		{
+			AppendProfileNode(&Builder, Frame, NodeIdx);
+		}
+	}
+	LogInfo("%s", Builder.End().Data);
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+/*
+NOTE: Instrumented cpu profiler.
+KIWI_PROFILE_SCOPE("Name") times the rest of the enclosing block. All it
+does is write a begin and an end event (name pointer + cpu timer) in a ring
+owned by the calling thread: no lock, no lookup, no shared cache line.
+The name is stored as a pointer, so it must outlive the profiler (string
+literals, __FUNCTION__, interned strings).
+
+Once per frame, Profiler::EndFrame drains the rings of every thread and
+builds the call tree of the frame: one root per thread, scopes with the
+same name under the same parent are merged and every node gets its total
+time, its self time (total minus its children) and how many times it ran.
+Only complete top level scopes are consumed: a scope still open when the
+frame ends, with everything after it, goes into the next frame's tree.
+That's why a thread must not wrap its whole loop in a single scope.
+
+When a ring is full new scopes are dropped (nested ones included) and
+counted, the tree stays consistent.
+
+Optionally (Initialize(true), --perf-counters 1) every thread also reads
+its hardware counters at both ends of a scope, and the nodes get the
+cycles, instructions, cache misses and branch misses that ran in them.
+Where the platform has no counters the scopes only have their time.
+With PROFILER_ENABLED set to FALSE the macros expand to nothing.
+*/
+
+#include "defines.h"
+#include "platform/platform.h"
+
+#ifndef PROFILER_ENABLED
+#ifdef KIWI_SLOW
+#define PROFILER_ENABLED TRUE
+#else
+#define PROFILER_ENABLED FALSE
+#endif
+#endif
+
+// NOTE: Events per thread, must be a power of 2. 16 bytes each
+#define PROFILER_RING_EVENT_COUNT 65536
+#define PROFILER_MAX_NODES 4096
+#define PROFILER_MAX_DEPTH 64
+#define PROFILER_INVALID_NODE ((u32)-1)
+
+struct ProfileEvent
+{
+	// NOTE: nullptr marks the end of the last open scope
+	const char *Name;
+	u64 Time;
+};
+
+// NOTE: Single producer (the owning thread), single consumer (EndFrame)
+struct ProfileThread
+{
+	ProfileEvent *Events;
+	// NOTE: PerfCounter_Count values per event, nullptr without counters
+	u64 *Counters;
+	PlatformPerfCounters PerfCounters;
+	ProfileThread *Next;
+	u32 ThreadId;
+	// NOTE: Producer only. Scopes begun and not ended yet, and how
+	// many of them were dropped: ends always match the last begin
+	u32 OpenDepth;
+	u32 DroppedDepth;
+	u32 Reserved;
+	u64 CachedReadPos;
+	u8 Padding0[CACHE_LINE_SIZE - 4 * sizeof(void *) - 4 * sizeof(u32) - sizeof(u64)];
+	volatile u64 WritePos;
+	volatile u64 DroppedCount;
+	u8 Padding1[CACHE_LINE_SIZE - 2 * sizeof(u64)];
+	// NOTE: Consumer only, except ReadPos that the producer reads when the ring looks full
+	volatile u64 ReadPos;
+	u64 SeenDroppedCount;
+	u8 Padding2[CACHE_LINE_SIZE - 2 * sizeof(u64)];
+};
+
+struct ProfileNode
+{
+	// NOTE: nullptr for the root of a thread
+	const char *Name;
+	u64 TotalTicks;
+	u64 ChildTicks;
+	u32 CallCount;
+	u32 Depth;
+	u32 ThreadId;
+	// NOTE: Indices in ProfileFrame::Nodes, PROFILER_INVALID_NODE if none
+	u32 Parent;
+	u32 FirstChild;
+	u32 NextSibling;
+	// NOTE: Total, children included. Zero without counters
+	u64 Counters[PerfCounter_Count];
+
+	KIWI_INLINE u64 SelfTicks() const { return TotalTicks - ChildTicks; }
+};
+
+// NOTE: One root node per thread that completed a scope in the frame, the
+// root's self time is the part of the frame that no scope of that thread covered
+struct ProfileFrame
+{
+	u64 FrameIndex;
+	u64 BeginTime;
+	u64 EndTime;
+	ProfileNode *Nodes;
+	u32 NodeCount;
+	// NOTE: Scopes lost because a ring was full or the tree was too big
+	u32 DroppedScopes;
+	b8 HasCounters;
+};
+
+// NOTE: this is a singleton
+class Profiler
+{
+public:
+	static b8 Initialize(b8 InUsePerfCounters = false);
+	// NOTE: Logs the slowest frame seen
+	static void Terminate();
+	// NOTE: Right before the main loop, so the first frame doesn't include the startup
+	static void BeginFrames();
+	// NOTE: Main thread only, outside of any scope
+	static void EndFrame();
+
+	// NOTE: Not inline on purpose: the thread local ring can't be reached from the game dll.
+	// BeginScope returns the ring of the calling thread (nullptr without a profiler)
+	// and EndScope takes it back, so only the begin looks the thread local up.
+	KIWI_API static ProfileThread *BeginScope(const char *Name);
+	KIWI_API static void EndScope(ProfileThread *Thread);
+
+	// NOTE: Valid until the next EndFrame, nullptr before the first one
+	KIWI_API static const ProfileFrame *GetLastFrame();
+	KIWI_API static const ProfileFrame *GetSlowestFrame();
+	// NOTE: Profile times are ReadCycleCounter values
+	KIWI_API static f64 TicksToMS(u64 Ticks);
+	KIWI_API static void LogFrame(const ProfileFrame *Frame);
+
+private:
+	static ProfileThread *RegisterThread();
+	static u32 BuildThreadTree(ProfileFrame *Frame, ProfileThread *Thread);
+
+	static ProfileThread *Threads;
+	static PlatformRWLock ThreadsLock;
+	static ProfileFrame LastFrame;
+	static ProfileFrame SlowestFrame;
+	static u64 FrameIndex;
+	static u64 FrameBeginTime;
+	static b8 IsInitialized;
+	static b8 UsePerfCounters;
+};
+
+class ProfileScope
+{
+public:
+	KIWI_INLINE ProfileScope(const char *Name) : Thread(Profiler::BeginScope(Name)) {}
+	KIWI_INLINE ~ProfileScope() { Profiler::EndScope(Thread); }
+
+private:
+	ProfileThread *Thread;
+};
+
+#define PROFILE_CONCAT_(A, B) A##B
+#define PROFILE_CONCAT(A, B) PROFILE_CONCAT_(A, B)
+
+#if PROFILER_ENABLED
+#define KIWI_PROFILE_SCOPE(Name) ProfileScope PROFILE_CONCAT(ProfileScope_, __LINE__)(Name)
+#define KIWI_PROFILE_FUNCTION() KIWI_PROFILE_SCOPE(__FUNCTION__)
+#else
+#define KIWI_PROFILE_SCOPE(Name)
+#define KIWI_PROFILE_FUNCTION()
+#endif
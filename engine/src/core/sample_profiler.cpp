@@ -0,0 +1,378 @@
+#include "sample_profiler.h"
+#include "core/logger.h"
+#include "core/kiwi_mem.h"
+#include "core/kiwi_string.h"
+#include "core/clock.h"
+
+#include <stdio.h>
+
+#define SAMPLE_RING_MASK (SAMPLE_RING_SLOT_COUNT - 1)
+#define SAMPLE_TABLE_MASK (SAMPLE_TABLE_SIZE - 1)
+// NOTE: Distinct addresses symbolized, power of 2. Once full the others are symbolized every time
+#define SAMPLE_SYMBOL_CACHE_SIZE (1 << 16)
+#define SAMPLE_MAX_SYMBOL_LENGTH 512
+#define SAMPLE_FILE_BUFFER_SIZE KiB(64)
+
+SampleThread SampleProfiler::Threads[SAMPLE_MAX_THREADS] = {};
+u32 SampleProfiler::ThreadCount = 0;
+PlatformRWLock SampleProfiler::ThreadsLock = {};
+PlatformThread SampleProfiler::Sampler = {};
+volatile u64 SampleProfiler::SamplerRunning = 0;
+u64 SampleProfiler::Period = 0;
+f32 SampleProfiler::SampleRate = 0.0f;
+const char *SampleProfiler::Path = nullptr;
+SampleStack *SampleProfiler::Stacks = nullptr;
+u64 SampleProfiler::StackCount = 0;
+u64 *SampleProfiler::Pool = nullptr;
+u64 SampleProfiler::PoolUsed = 0;
+u64 SampleProfiler::SampleCount = 0;
+u64 SampleProfiler::DroppedCount = 0;
+
+struct SampleSymbol
+{
+	u64 Address;
+	const char *Name;
+};
+
+struct SampleOutput
+{
+	PlatformFile File;
+	char *Buffer;
+	u64 Used;
+	b8 Failed;
+};
+
+// NOTE: Sampler side, the sample goes in whole or not at all
+internal_func void PushSample(SampleThread *Thread, const u64 *Frames, u32 Depth)
+{
+	u64 WritePos = Thread->WritePos;
+	if (WritePos + Depth + 1 - AtomicLoadAcquire64(&Thread->ReadPos) > SAMPLE_RING_SLOT_COUNT)
+	{
+		++Thread->DroppedCount;
+		return;
+	}
+
+	Thread->Ring[WritePos & SAMPLE_RING_MASK] = Depth;
+	for (u32 Idx = 0; Idx < Depth; ++Idx)
+	{
+		Thread->Ring[(WritePos + 1 + Idx) & SAMPLE_RING_MASK] = Frames[Idx];
+	}
+	AtomicStoreRelease64(&Thread->WritePos, WritePos + Depth + 1);
+}
+
+internal_func b8 SampleFramesEqual(const u64 *FramesA, const u64 *FramesB, u32 Depth)
+{
+	for (u32 Idx = 0; Idx < Depth; ++Idx)
+	{
+		if (FramesA[Idx] != FramesB[Idx])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+internal_func void WriteSampleOutput(SampleOutput *Out, const char *Str, u64 Length)
+{
+	if (Out->Used + Length > SAMPLE_FILE_BUFFER_SIZE)
+	{
+		if (!Out->Failed && Out->Used && !Platform::FileWrite(&Out->File, Out->Buffer, Out->Used))
+		{
+			Out->Failed = true;
+		}
+		Out->Used = 0;
+	}
+
+	Length = Min(Length, (u64)SAMPLE_FILE_BUFFER_SIZE);
+	MemSystem::Copy(Out->Buffer + Out->Used, (void *)Str, Length);
+	Out->Used += Length;
+}
+
+// NOTE: The caller's address, the return one can already be in the next function
+internal_func const char *FindSampleSymbol(SampleSymbol *Symbols, u64 &SymbolCount, u64 Address, MemArena *Arena)
+{
+	u64 Mask = SAMPLE_SYMBOL_CACHE_SIZE - 1;
+	u64 Slot = KStr::FastHash(&Address, sizeof(Address)) & Mask;
+	for (; Symbols[Slot].Name; Slot = (Slot + 1) & Mask)
+	{
+		if (Symbols[Slot].Address == Address)
+		{
+			return Symbols[Slot].Name;
+		}
+	}
+
+	char Name[SAMPLE_MAX_SYMBOL_LENGTH];
+	if (!Platform::SymbolizeAddress(Address, Name, sizeof(Name)))
+	{
+		snprintf(Name, sizeof(Name), "0x%llx", Address);
+	}
+
+	char *Result = KStr::Duplicate(Name, Arena);
+	if (SymbolCount < SAMPLE_SYMBOL_CACHE_SIZE / 4 * 3)
+	{
+		Symbols[Slot].Address = Address;
+		Symbols[Slot].Name = Result;
+		++SymbolCount;
+	}
+	return Result;
+}
+
+b8 SampleProfiler::Initialize(f32 Rate, const char *InPath)
+{
+	if (Rate <= 0.0f)
+	{
+		return true;
+	}
+	if (IsActive())
+	{
+		LogError("Sample profiler already initialized");
+		return false;
+	}
+
+	MemArena *Arena = MemSystem::GetArena(MemTag_Profiler);
+	SampleStack *NewStacks = (SampleStack *)Arena->Push(SAMPLE_TABLE_SIZE * sizeof(SampleStack));
+	Pool = (u64 *)Arena->PushNoZero(SAMPLE_POOL_SLOT_COUNT * sizeof(u64));
+	// NOTE: All the rings up front, registering a thread never allocates
+	u64 *Rings = (u64 *)Arena->PushNoZero(SAMPLE_MAX_THREADS * SAMPLE_RING_SLOT_COUNT * sizeof(u64));
+	if (!NewStacks || !Pool || !Rings)
+	{
+		LogError("Could not allocate the sample profiler");
+		return false;
+	}
+
+	Platform::LockExclusive(&ThreadsLock);
+	for (u32 Idx = 0; Idx < SAMPLE_MAX_THREADS; ++Idx)
+	{
+		Threads[Idx].Ring = Rings + Idx * SAMPLE_RING_SLOT_COUNT;
+	}
+	Stacks = NewStacks;
+	Platform::UnlockExclusive(&ThreadsLock);
+
+	SampleRate = Rate;
+	Period = Clock::SecondsToTicks(1.0 / Rate);
+	Path = InPath;
+	StackCount = 0;
+	PoolUsed = 0;
+	SampleCount = 0;
+	DroppedCount = 0;
+
+	AtomicStoreRelease64(&SamplerRunning, 1);
+	if (!Platform::ThreadCreate(&Sampler, SamplerThread, nullptr))
+	{
+		LogError("Could not start the sampler thread");
+		AtomicStoreRelease64(&SamplerRunning, 0);
+		Stacks = nullptr;
+		return false;
+	}
+	return true;
+}
+
+void SampleProfiler::Terminate()
+{
+	if (!IsActive())
+	{
+		return;
+	}
+
+	AtomicStoreRelease64(&SamplerRunning, 0);
+	Platform::ThreadJoin(&Sampler);
+	Drain();
+
+	Platform::LockExclusive(&ThreadsLock);
+	for (u32 Idx = 0; Idx < ThreadCount; ++Idx)
+	{
+		DroppedCount += Threads[Idx].DroppedCount;
+		Platform::SampledThreadClose(&Threads[Idx].Handle);
+	}
+	ThreadCount = 0;
+	Platform::UnlockExclusive(&ThreadsLock);
+
+	f64 WriteStart = Clock::GetSeconds();
+	if (WriteFolded())
+	{
+		LogInfo("Sampled at %.0fHz: %llu samples, %llu distinct stacks, %llu dropped. Written to %s in %.2fs",
+				SampleRate, SampleCount, StackCount, DroppedCount, Path, Clock::GetSeconds() - WriteStart);
+	}
+	Stacks = nullptr;
+}
+
+void SampleProfiler::EndFrame()
+{
+	if (IsActive())
+	{
+		Drain();
+	}
+}
+
+void SampleProfiler::RegisterThread(const char *Name)
+{
+	Platform::LockExclusive(&ThreadsLock);
+	b8 IsFull = ThreadCount == SAMPLE_MAX_THREADS;
+	if (!IsFull)
+	{
+		SampleThread *Thread = &Threads[ThreadCount];
+		if (Platform::SampledThreadOpen(&Thread->Handle))
+		{
+			Thread->Name = Name;
+			Thread->WritePos = 0;
+			Thread->DroppedCount = 0;
+			Thread->ReadPos = 0;
+			++ThreadCount;
+		}
+	}
+	Platform::UnlockExclusive(&ThreadsLock);
+
+	if (IsFull)
+	{
+		LogWarning("Too many threads to sample, %s won't be", Name);
+	}
+}
+
+THREAD_PROC(SampleProfiler::SamplerThread)
+{
+	u64 Frames[SAMPLE_MAX_DEPTH];
+	u64 NextSample = Clock::Now();
+	while (AtomicLoadAcquire64(&SamplerRunning))
+	{
+		Platform::LockShared(&ThreadsLock);
+		for (u32 Idx = 0; Idx < ThreadCount; ++Idx)
+		{
+			SampleThread *Thread = &Threads[Idx];
+			u32 Depth = Platform::CaptureThreadStack(&Thread->Handle, Frames, SAMPLE_MAX_DEPTH);
+			if (Depth)
+			{
+				PushSample(Thread, Frames, Depth);
+			}
+		}
+		Platform::UnlockShared(&ThreadsLock);
+
+		// NOTE: A late sampler skips the samples it missed, it doesn't burst
+		NextSample += Period;
+		u64 Now = Clock::Now();
+		if (Now < NextSample)
+		{
+			Platform::SleepPrecise(Clock::TicksToSeconds(NextSample - Now));
+		}
+		else
+		{
+			NextSample = Now;
+		}
+	}
+	return 0;
+}
+
+void SampleProfiler::Drain()
+{
+	Platform::LockShared(&ThreadsLock);
+	u32 Count = ThreadCount;
+	Platform::UnlockShared(&ThreadsLock);
+
+	u64 Frames[SAMPLE_MAX_DEPTH];
+	for (u32 ThreadIdx = 0; ThreadIdx < Count; ++ThreadIdx)
+	{
+		SampleThread *Thread = &Threads[ThreadIdx];
+		u64 ReadPos = Thread->ReadPos;
+		u64 WritePos = AtomicLoadAcquire64(&Thread->WritePos);
+		while (ReadPos < WritePos)
+		{
+			u32 Depth = (u32)Thread->Ring[ReadPos++ & SAMPLE_RING_MASK];
+			for (u32 Idx = 0; Idx < Depth; ++Idx)
+			{
+				Frames[Idx] = Thread->Ring[ReadPos++ & SAMPLE_RING_MASK];
+			}
+			AddStack(ThreadIdx, Frames, Depth);
+		}
+		AtomicStoreRelease64(&Thread->ReadPos, ReadPos);
+	}
+}
+
+void SampleProfiler::AddStack(u32 ThreadIdx, const u64 *Frames, u32 Depth)
+{
+	++SampleCount;
+	u64 Hash = KStr::FastHash(Frames, Depth * sizeof(u64), ThreadIdx);
+	for (u64 Slot = Hash & SAMPLE_TABLE_MASK;; Slot = (Slot + 1) & SAMPLE_TABLE_MASK)
+	{
+		SampleStack *Stack = &Stacks[Slot];
+		if (!Stack->Count)
+		{
+			if (StackCount >= SAMPLE_TABLE_SIZE / 4 * 3 || PoolUsed + Depth > SAMPLE_POOL_SLOT_COUNT)
+			{
+				++DroppedCount;
+				return;
+			}
+
+			Stack->Hash = Hash;
+			Stack->Count = 1;
+			Stack->PoolOffset = (u32)PoolUsed;
+			Stack->Depth = (u16)Depth;
+			Stack->ThreadIdx = (u16)ThreadIdx;
+			MemSystem::Copy(Pool + PoolUsed, (void *)Frames, Depth * sizeof(u64));
+			PoolUsed += Depth;
+			++StackCount;
+			return;
+		}
+
+		if (Stack->Hash == Hash && Stack->Depth == Depth && Stack->ThreadIdx == ThreadIdx &&
+			SampleFramesEqual(Pool + Stack->PoolOffset, Frames, Depth))
+		{
+			++Stack->Count;
+			return;
+		}
+	}
+}
+
+b8 SampleProfiler::WriteFolded()
+{
+	SampleOutput Out = {};
+	if (!Platform::FileOpen(&Out.File, Path, FileMode_Write))
+	{
+		LogError("Could not open %s to write the samples", Path);
+		return false;
+	}
+
+	AutoFreeArena ScratchHandle = AutoFreeArena(MemTag_Scratch);
+	MemArena *Scratch = ScratchHandle.Arena;
+	Out.Buffer = (char *)Scratch->PushNoZero(SAMPLE_FILE_BUFFER_SIZE);
+	SampleSymbol *Symbols = (SampleSymbol *)Scratch->Push(SAMPLE_SYMBOL_CACHE_SIZE * sizeof(SampleSymbol));
+	u64 SymbolCount = 0;
+
+	for (u32 Slot = 0; Slot < SAMPLE_TABLE_SIZE; ++Slot)
+	{
+		SampleStack *Stack = &Stacks[Slot];
+		if (!Stack->Count)
+		{
+			continue;
+		}
+
+		const char *ThreadName = Threads[Stack->ThreadIdx].Name;
+		WriteSampleOutput(&Out, ThreadName, KStr::Length(ThreadName));
+
+		// NOTE: Outermost first. Only the innermost frame is where the thread
+		// was, the others are return addresses
+		const u64 *Frames = Pool + Stack->PoolOffset;
+		for (u32 Idx = Stack->Depth; Idx > 0; --Idx)
+		{
+			u64 Address = Idx > 1 ? Frames[Idx - 1] - 1 : Frames[0];
+			const char *Name = FindSampleSymbol(Symbols, SymbolCount, Address, Scratch);
+			WriteSampleOutput(&Out, ";", 1);
+			WriteSampleOutput(&Out, Name, KStr::Length(Name));
+		}
+
+		char Count[32];
+		i32 Length = snprintf(Count, sizeof(Count), " %llu\n", Stack->Count);
+		WriteSampleOutput(&Out, Count, (u64)Length);
+	}
+
+	if (!Out.Failed && Out.Used && !Platform::FileWrite(&Out.File, Out.Buffer, Out.Used))
+	{
+		Out.Failed = true;
+	}
+	Platform::FileClose(&Out.File);
+
+	if (Out.Failed)
+	{
+		LogError("Could not write the samples to %s", Path);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+/*
+NOTE: Sampling profiler, off unless ApplicationConfig::SampleRate is set
+(--sample <hz>). A sampler thread wakes up SampleRate times per second and
+captures the call stack of every registered thread, so the main loop, the
+renderer and everything else show up without any KIWI_PROFILE_SCOPE.
+Every thread has a ring the sampler writes the stacks in and the main
+thread drains in EndFrame, one producer and one consumer, no locks.
+The drain folds identical stacks in a hash table: memory grows with the
+number of distinct stacks, not with the length of the run.
+At Terminate the addresses are symbolized and written to SamplePath as
+folded stacks, a "Thread;Outer;...;Inner Count" line per stack, the input
+of flamegraph.pl, inferno and speedscope.
+Samples that don't fit in their ring or in the table are dropped and counted.
+*/
+
+#include "defines.h"
+#include "platform/platform.h"
+
+#define SAMPLE_DEFAULT_PATH "kiwi_samples.folded"
+#define SAMPLE_MAX_THREADS 16
+#define SAMPLE_MAX_DEPTH 128
+// NOTE: u64 per thread ring, a sample takes its depth + 1
+#define SAMPLE_RING_SLOT_COUNT (1 << 16)
+// NOTE: Distinct stacks, power of 2. The table is full at 3/4
+#define SAMPLE_TABLE_SIZE (1 << 16)
+// NOTE: u64 for the frames of all the distinct stacks
+#define SAMPLE_POOL_SLOT_COUNT (1 << 21)
+
+// NOTE: WritePos and DroppedCount belong to the sampler, ReadPos to the drain
+struct SampleThread
+{
+	PlatformSampledThread Handle;
+	const char *Name;
+	u64 *Ring;
+	volatile u64 WritePos;
+	volatile u64 DroppedCount;
+	u8 Padding[CACHE_LINE_SIZE - 2 * sizeof(u64)];
+	volatile u64 ReadPos;
+};
+
+// NOTE: The frames are in the pool, innermost first. Count 0 is a free slot
+struct SampleStack
+{
+	u64 Hash;
+	u64 Count;
+	u32 PoolOffset;
+	u16 Depth;
+	u16 ThreadIdx;
+};
+
+// NOTE: this is a singleton
+class SampleProfiler
+{
+public:
+	// NOTE: Rate 0 leaves it off
+	static b8 Initialize(f32 Rate, const char *InPath);
+	// NOTE: Stops the sampler and writes the folded stacks
+	static void Terminate();
+	// NOTE: Main thread, once per frame
+	static void EndFrame();
+
+	KIWI_INLINE static b8 IsActive() { return Stacks != nullptr; }
+
+	// NOTE: Called by the thread to sample, at any time: the threads
+	// registered before Initialize are sampled once it starts
+	KIWI_API static void RegisterThread(const char *Name);
+
+private:
+	static THREAD_PROC(SamplerThread);
+	static void Drain();
+	static void AddStack(u32 ThreadIdx, const u64 *Frames, u32 Depth);
+	static b8 WriteFolded();
+
+	static SampleThread Threads[SAMPLE_MAX_THREADS];
+	static u32 ThreadCount;
+	static PlatformRWLock ThreadsLock;
+	static PlatformThread Sampler;
+	static volatile u64 SamplerRunning;
+	static u64 Period;
+	static f32 SampleRate;
+	static const char *Path;
+	static SampleStack *Stacks;
+	static u64 StackCount;
+	static u64 *Pool;
+	static u64 PoolUsed;
+	static u64 SampleCount;
+	static u64 DroppedCount;
+};
@@ -0,0 +1,218 @@
+#include "string_interner.h"
+#include "core/kiwi_mem.h"
+#include "core/logger.h"
+
+b8 StringInterner::IsInitialized = false;
+MemArena *StringInterner::Arena = nullptr;
+PlatformRWLock StringInterner::Lock = {};
+
+StringInterner::Slot *StringInterner::Slots = nullptr;
+u32 StringInterner::SlotCount = 0;
+u32 StringInterner::EntryCount = 0;
+StringInterner::Entry *StringInterner::Chunks[STRING_INTERNER_MAX_CHUNKS] = {};
+
+b8 StringInterner::Initialize()
+{
+	if (IsInitialized)
+	{
+		LogError("StringInterner already initialized");
+		return false;
+	}
+
+	// NOTE: The interner owns the whole string arena, nobody else should push there
+	Arena = MemSystem::GetArena(MemTag_String);
+
+	SlotCount = STRING_INTERNER_INIT_SLOTS;
+	Slots = (Slot *)Arena->Push(SlotCount * sizeof(Slot));
+	EntryCount = 0;
+
+	IsInitialized = true;
+	return true;
+}
+
+void StringInterner::Terminate()
+{
+	LogInfo("StringInterner: %u strings interned", EntryCount);
+
+	Arena->Clear();
+	Slots = nullptr;
+	SlotCount = 0;
+	EntryCount = 0;
+	MemSystem::Zero(Chunks, sizeof(Chunks));
+	IsInitialized = false;
+}
+
+KStrId StringInterner::Intern(const char *Str)
+{
+	u64 Length = KStr::Length(Str);
+	return Intern(Str, Length, KStr::Hash(Str, Length));
+}
+
+KStrId StringInterner::Intern(const char *Str, u64 Length, u32 Hash)
+{
+	if (!IsInitialized)
+	{
+		LogError("StringInterner not yet initialized. Cannot intern \"%s\"", Str);
+		return {Hash, KSTR_INVALID_INDEX};
+	}
+
+	// NOTE: Most of the time the string is already there, try with the shared lock first
+	u32 SlotIdx;
+	Platform::LockShared(&Lock);
+	u32 Index = Lookup(Str, Length, Hash, SlotIdx);
+	Platform::UnlockShared(&Lock);
+
+	if (Index != KSTR_INVALID_INDEX)
+	{
+		return {Hash, Index};
+	}
+
+	Platform::LockExclusive(&Lock);
+
+	// NOTE: Someone could have inserted the same string while we weren't holding the lock
+	Index = Lookup(Str, Length, Hash, SlotIdx);
+	if (Index == KSTR_INVALID_INDEX)
+	{
+		if (EntryCount == STRING_INTERNER_CHUNK_SIZE * STRING_INTERNER_MAX_CHUNKS)
+		{
+			Platform::UnlockExclusive(&Lock);
+			LogFatal("StringInterner is full, cannot intern \"%s\"", Str);
+			KDebugBreak();
+			return {Hash, KSTR_INVALID_INDEX};
+		}
+
+		// Copy the bytes (null terminated) into the string arena
+		char *Copy = (char *)Arena->PushNoZero(Length + 1);
+		MemSystem::Copy(Copy, (void *)Str, Length);
+		Copy[Length] = '\0';
+
+		Index = EntryCount;
+		u32 ChunkIdx = Index / STRING_INTERNER_CHUNK_SIZE;
+		if (!Chunks[ChunkIdx])
+		{
+			Chunks[ChunkIdx] = (Entry *)Arena->Push(STRING_INTERNER_CHUNK_SIZE * sizeof(Entry));
+		}
+
+		Entry *NewEntry = GetEntry(Index);
+		NewEntry->Str = Copy;
+		NewEntry->Length = (u32)Length;
+		NewEntry->Hash = Hash;
+
+		Slots[SlotIdx].Hash = Hash;
+		Slots[SlotIdx].Index = Index + 1;
+		++EntryCount;
+
+		// NOTE: Keep the load factor under 1/2 so probe sequences stay short
+		if (EntryCount * 2 > SlotCount)
+		{
+			Grow();
+		}
+	}
+
+	Platform::UnlockExclusive(&Lock);
+	return {Hash, Index};
+}
+
+KStrId StringInterner::Find(const char *Str)
+{
+	u64 Length = KStr::Length(Str);
+	return Find(Str, Length, KStr::Hash(Str, Length));
+}
+
+KStrId StringInterner::Find(const char *Str, u64 Length, u32 Hash)
+{
+	if (!IsInitialized)
+	{
+		return {Hash, KSTR_INVALID_INDEX};
+	}
+
+	u32 SlotIdx;
+	Platform::LockShared(&Lock);
+	u32 Index = Lookup(Str, Length, Hash, SlotIdx);
+	Platform::UnlockShared(&Lock);
+
+	return {Hash, Index};
+}
+
+const char *StringInterner::GetString(KStrId Id)
+{
+	if (!Id.IsValid())
+	{
+		return "";
+	}
+	return GetEntry(Id.Index)->Str;
+}
+
+u32 StringInterner::GetLength(KStrId Id)
+{
+	if (!Id.IsValid())
+	{
+		return 0;
+	}
+	return GetEntry(Id.Index)->Length;
+}
+
+u32 StringInterner::Count()
+{
+	Platform::LockShared(&Lock);
+	u32 Result = EntryCount;
+	Platform::UnlockShared(&Lock);
+	return Result;
+}
+
+// NOTE: Must be called holding the lock (either mode).
+// Returns the entry index or KSTR_INVALID_INDEX. In the latter case
+// OutSlot is the empty slot where the string should be inserted.
+u32 StringInterner::Lookup(const char *Str, u64 Length, u32 Hash, u32 &OutSlot)
+{
+	u32 Mask = SlotCount - 1;
+	for (u32 SlotIdx = Hash & Mask;; SlotIdx = (SlotIdx + 1) & Mask)
+	{
+		Slot *Current = &Slots[SlotIdx];
+		if (!Current->Index)
+		{
+			OutSlot = SlotIdx;
+			return KSTR_INVALID_INDEX;
+		}
+
+		if (Current->Hash == Hash)
+		{
+			Entry *Candidate = GetEntry(Current->Index - 1);
+			if (KStr::Equal(KStrView{Candidate->Length, Candidate->Str}, KStrView{Length, Str}))
+			{
+				OutSlot = SlotIdx;
+				return Current->Index - 1;
+			}
+		}
+	}
+}
+
+StringInterner::Entry *StringInterner::GetEntry(u32 Index)
+{
+	return &Chunks[Index / STRING_INTERNER_CHUNK_SIZE][Index % STRING_INTERNER_CHUNK_SIZE];
+}
+
+// NOTE: Must be called holding the exclusive lock.
+// Like KArray, the old slot array is not given back to the arena.
+void StringInterner::Grow()
+{
+	u32 NewSlotCount = SlotCount * 2;
+	Slot *NewSlots = (Slot *)Arena->Push(NewSlotCount * sizeof(Slot));
+
+	u32 Mask = NewSlotCount - 1;
+	for (u32 Idx = 0; Idx < SlotCount; ++Idx)
+	{
+		if (Slots[Idx].Index)
+		{
+			u32 SlotIdx = Slots[Idx].Hash & Mask;
+			while (NewSlots[SlotIdx].Index)
+			{
+				SlotIdx = (SlotIdx + 1) & Mask;
+			}
+			NewSlots[SlotIdx] = Slots[Idx];
+		}
+	}
+
+	Slots = NewSlots;
+	SlotCount = NewSlotCount;
+}
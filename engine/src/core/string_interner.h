@@ -0,0 +1,73 @@
+#pragma once
+
+#include "defines.h"
+#include "core/kiwi_string.h"
+#include "platform/platform.h"
+
+class MemArena;
+
+#define STRING_INTERNER_CHUNK_SIZE 256
+#define STRING_INTERNER_MAX_CHUNKS 256
+#define STRING_INTERNER_INIT_SLOTS 512
+
+/*
+NOTE: Global string table. Every distinct string is stored once in
+the MemTag_String arena and identified by a KStrId, so equality
+between interned strings is an integer compare instead of a strcmp.
+
+It's safe to use from any thread: lookups take the lock in shared mode
+and only inserting a new string takes it exclusively. The entries live
+in fixed chunks that never move, so GetString/GetLength don't lock at all.
+*/
+// NOTE: this is a singleton
+class StringInterner
+{
+public:
+	static b8 Initialize();
+	static void Terminate();
+
+	// NOTE: Returns the id of the string, adding it to the table if needed
+	KIWI_API static KStrId Intern(const char *Str);
+	KIWI_API static KStrId Intern(const char *Str, u64 Length, u32 Hash);
+
+	// NOTE: Like Intern but never inserts. If the string has never
+	// been interned the returned id is not valid
+	KIWI_API static KStrId Find(const char *Str);
+	KIWI_API static KStrId Find(const char *Str, u64 Length, u32 Hash);
+
+	KIWI_API static const char *GetString(KStrId Id);
+	KIWI_API static u32 GetLength(KStrId Id);
+	KIWI_API static u32 Count();
+
+private:
+	struct Entry
+	{
+		const char *Str;
+		u32 Length;
+		u32 Hash;
+	};
+
+	// NOTE: Open addressing slot. The hash is duplicated here so that
+	// probing only touches the slot array until there is a real candidate
+	struct Slot
+	{
+		u32 Hash;
+		u32 Index;
+	};
+
+	static u32 Lookup(const char *Str, u64 Length, u32 Hash, u32 &OutSlot);
+	static Entry *GetEntry(u32 Index);
+	static void Grow();
+
+	static b8 IsInitialized;
+	static MemArena *Arena;
+	static PlatformRWLock Lock;
+
+	static Slot *Slots;
+	static u32 SlotCount;
+	static u32 EntryCount;
+	static Entry *Chunks[STRING_INTERNER_MAX_CHUNKS];
+};
+
+// NOTE: Interns a string literal with its length and hash computed at compile time
+#define KSTR_ID(Literal) StringInterner::Intern((Literal), sizeof(Literal) - 1, KStrHashLiteral(Literal))
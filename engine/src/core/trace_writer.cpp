@@ -0,0 +1,317 @@
+#include "trace_writer.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "core/event.h"
+#include "platform/platform.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+
+TraceRecord *TraceWriter::Records = nullptr;
+u64 TraceWriter::WritePos = 0;
+const char *TraceWriter::BaseName = TRACE_DEFAULT_BASE_NAME;
+f32 TraceWriter::Seconds = TRACE_DEFAULT_SECONDS;
+f32 TraceWriter::SpikeMS = 0.0f;
+u64 TraceWriter::LastSpikeDumpTime = 0;
+u32 TraceWriter::LastDispatchedCount = 0;
+u64 TraceWriter::LastMemory[MemTag_Count] = {};
+u32 TraceWriter::MainThreadId = 0;
+b8 TraceWriter::DumpRequested = false;
+
+#define TRACE_RING_MASK (TRACE_RING_RECORD_COUNT - 1)
+#define TRACE_FILE_BUFFER_SIZE KiB(64)
+// NOTE: A line never takes more than this, escaped name included
+#define TRACE_MAX_LINE_LENGTH 512
+#define TRACE_MAX_NAME_LENGTH 256
+#define TRACE_PATH_SIZE 256
+// NOTE: The frames get a track of their own, no thread has id 0
+#define TRACE_FRAME_TRACK_ID 0
+
+// NOTE: Buffered output of a dump. After a failed write every call is a no-op
+struct TraceFile
+{
+	PlatformFile File;
+	char *Buffer;
+	u64 Used;
+	b8 Failed;
+};
+
+internal_func void FlushTraceFile(TraceFile *Out)
+{
+	if (!Out->Failed && Out->Used && !Platform::FileWrite(&Out->File, Out->Buffer, Out->Used))
+	{
+		Out->Failed = true;
+	}
+	Out->Used = 0;
+}
+
+internal_func void TraceFileWritef(TraceFile *Out, const char *Format, ...)
+{
+	if (Out->Used + TRACE_MAX_LINE_LENGTH > TRACE_FILE_BUFFER_SIZE)
+	{
+		FlushTraceFile(Out);
+	}
+
+	va_list Args;
+	va_start(Args, Format);
+	i32 Written = vsnprintf(Out->Buffer + Out->Used, TRACE_FILE_BUFFER_SIZE - Out->Used, Format, Args);
+	va_end(Args);
+	if (Written > 0)
+	{
+		Out->Used += Min((u64)Written, TRACE_FILE_BUFFER_SIZE - Out->Used - 1);
+	}
+}
+
+// NOTE: Scope names are usually literals or __FUNCTION__, but
+// anything could end up in there: keep the JSON valid no matter what
+internal_func void EscapeTraceName(char *Out, const char *Name)
+{
+	u32 Length = 0;
+	for (; *Name && Length + 2 < TRACE_MAX_NAME_LENGTH; ++Name)
+	{
+		char C = *Name;
+		if (C == '"' || C == '\\')
+		{
+			Out[Length++] = '\\';
+			Out[Length++] = C;
+		}
+		else
+		{
+			Out[Length++] = (u8)C < 0x20 ? ' ' : C;
+		}
+	}
+	Out[Length] = '\0';
+}
+
+b8 TraceWriter::Initialize(const char *InBaseName, f32 InSeconds, f32 InSpikeMS)
+{
+	if (Records)
+	{
+		LogError("Trace writer already initialized");
+		return false;
+	}
+
+	BaseName = InBaseName;
+	Seconds = InSeconds;
+	SpikeMS = InSpikeMS;
+
+#if PROFILER_ENABLED
+	Records = (TraceRecord *)MemSystem::GetArena(MemTag_Profiler)->PushNoZero(TRACE_RING_RECORD_COUNT * sizeof(TraceRecord));
+	if (!Records)
+	{
+		LogError("Could not allocate the trace ring");
+		return false;
+	}
+
+	WritePos = 0;
+	LastSpikeDumpTime = 0;
+	LastDispatchedCount = EventSystem::GetQueueTotals().Dispatched;
+	MainThreadId = Platform::GetThreadId();
+	DumpRequested = false;
+	// NOTE: So that the first frame has every counter
+	for (u32 Tag = 0; Tag < MemTag_Count; ++Tag)
+	{
+		LastMemory[Tag] = (u64)-1;
+	}
+
+	if (SpikeMS > 0.0f)
+	{
+		LogInfo("Tracing the last %.1fs, F9 or frames over %.1fms write them to %s_<frame>.json",
+				Seconds, SpikeMS, BaseName);
+	}
+	else
+	{
+		LogInfo("Tracing the last %.1fs, F9 writes them to %s_<frame>.json", Seconds, BaseName);
+	}
+	return true;
+#else
+	// NOTE: Without the profiler there is nothing to trace
+	return false;
+#endif
+}
+
+void TraceWriter::Terminate()
+{
+	Records = nullptr;
+}
+
+TraceRecord *TraceWriter::Push()
+{
+	// NOTE: The oldest records are simply overwritten
+	return &Records[WritePos++ & TRACE_RING_MASK];
+}
+
+void TraceWriter::AddScope(u32 ThreadId, const char *Name, u64 Begin, u64 End)
+{
+	TraceRecord *Record = Push();
+	Record->Begin = Begin;
+	Record->End = End;
+	Record->Name = Name;
+	Record->Id = ThreadId;
+	Record->Kind = TraceRecord_Scope;
+}
+
+void TraceWriter::AddCounter(const char *Name, u64 Time, u64 Value)
+{
+	TraceRecord *Record = Push();
+	Record->Begin = Time;
+	Record->End = Value;
+	Record->Name = Name;
+	Record->Id = 0;
+	Record->Kind = TraceRecord_Counter;
+}
+
+void TraceWriter::EndFrame()
+{
+	const ProfileFrame *Frame = Profiler::GetLastFrame();
+	if (!Records || !Frame)
+	{
+		return;
+	}
+
+	TraceRecord *Record = Push();
+	Record->Begin = Frame->BeginTime;
+	Record->End = Frame->EndTime;
+	Record->Name = nullptr;
+	Record->Id = (u32)Frame->FrameIndex;
+	Record->Kind = TraceRecord_Frame;
+
+	// NOTE: A counter keeps its value until the next sample,
+	// so the arenas are sampled only when they change
+	for (u8 Tag = 1; Tag < MemTag_Count; ++Tag)
+	{
+		u64 Occupied = MemSystem::GetArena(Tag)->OccupiedMem;
+		if (Occupied != LastMemory[Tag])
+		{
+			AddCounter(MemSystem::GetTagName(Tag), Frame->EndTime, Occupied);
+			LastMemory[Tag] = Occupied;
+		}
+	}
+
+	u32 DispatchedCount = EventSystem::GetQueueTotals().Dispatched;
+	AddCounter("Events dispatched", Frame->EndTime, (u32)(DispatchedCount - LastDispatchedCount));
+	LastDispatchedCount = DispatchedCount;
+
+	// NOTE: After a spike the window has to be filled again before another
+	// one can trigger a dump, a slow stretch would dump every frame otherwise.
+	// Frame 0 never counts: it pays for every first use (pipelines, pages,
+	// caches) and its window only holds the startup.
+	f64 FrameMS = Profiler::TicksToMS(Frame->EndTime - Frame->BeginTime);
+	b8 IsSpike = SpikeMS > 0.0f && Frame->FrameIndex > 0 && FrameMS > SpikeMS &&
+				 (!LastSpikeDumpTime || Profiler::TicksToMS(Frame->EndTime - LastSpikeDumpTime) > Seconds * 1000.0);
+	if (!DumpRequested && !IsSpike)
+	{
+		return;
+	}
+
+	if (IsSpike)
+	{
+		LogWarning("Frame %llu took %.3fms, dumping the trace", Frame->FrameIndex, FrameMS);
+	}
+
+	// NOTE: The time spent here ends up in the next frame, at least it's labeled
+	KIWI_PROFILE_SCOPE("TraceWriter::Dump");
+	char Path[TRACE_PATH_SIZE];
+	snprintf(Path, sizeof(Path), "%s_%llu.json", BaseName, Frame->FrameIndex);
+	Dump(Path);
+	DumpRequested = false;
+	if (IsSpike)
+	{
+		LastSpikeDumpTime = Frame->EndTime;
+	}
+}
+
+void TraceWriter::RequestDump()
+{
+	DumpRequested = true;
+}
+
+b8 TraceWriter::Dump(const char *Path)
+{
+	if (!Records)
+	{
+		LogError("Trace writer not initialized, nothing to dump");
+		return false;
+	}
+
+	// NOTE: Only what happened in the last Seconds, timestamps start from the oldest event
+	u64 Now = ReadCycleCounter();
+	f64 WindowMS = Seconds * 1000.0;
+	u64 FirstPos = WritePos > TRACE_RING_RECORD_COUNT ? WritePos - TRACE_RING_RECORD_COUNT : 0;
+	u64 Origin = Now;
+	for (u64 Pos = FirstPos; Pos < WritePos; ++Pos)
+	{
+		u64 Begin = Records[Pos & TRACE_RING_MASK].Begin;
+		if (Begin < Origin && Profiler::TicksToMS(Now - Begin) <= WindowMS)
+		{
+			Origin = Begin;
+		}
+	}
+
+	TraceFile Out = {};
+	if (!Platform::FileOpen(&Out.File, Path, FileMode_Write))
+	{
+		LogError("Could not open %s to write the trace", Path);
+		return false;
+	}
+
+	AutoFreeArena ScratchHandle = AutoFreeArena(MemTag_Scratch);
+	Out.Buffer = (char *)ScratchHandle.Arena->PushNoZero(TRACE_FILE_BUFFER_SIZE);
+
+	TraceFileWritef(&Out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	TraceFileWritef(&Out, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"args\":{\"name\":\"Kiwi\"}},\n");
+	TraceFileWritef(&Out, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Frames\"}},\n",
+					TRACE_FRAME_TRACK_ID);
+	TraceFileWritef(&Out, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Main thread\"}}",
+					MainThreadId);
+
+	u64 EventCount = 0;
+	char Name[TRACE_MAX_NAME_LENGTH];
+	for (u64 Pos = FirstPos; Pos < WritePos; ++Pos)
+	{
+		TraceRecord *Record = &Records[Pos & TRACE_RING_MASK];
+		if (Record->Begin < Origin)
+		{
+			continue;
+		}
+
+		f64 Timestamp = Profiler::TicksToMS(Record->Begin - Origin) * 1000.0;
+		switch (Record->Kind)
+		{
+		case TraceRecord_Scope:
+		{
+			EscapeTraceName(Name, Record->Name);
+			TraceFileWritef(&Out, ",\n{\"ph\":\"X\",\"name\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+							Name, Record->Id, Timestamp, Profiler::TicksToMS(Record->End - Record->Begin) * 1000.0);
+			break;
+		}
+		case TraceRecord_Frame:
+		{
+			TraceFileWritef(&Out, ",\n{\"ph\":\"X\",\"name\":\"Frame %u\",\"cat\":\"frame\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+							Record->Id, TRACE_FRAME_TRACK_ID, Timestamp, Profiler::TicksToMS(Record->End - Record->Begin) * 1000.0);
+			break;
+		}
+		case TraceRecord_Counter:
+		{
+			EscapeTraceName(Name, Record->Name);
+			TraceFileWritef(&Out, ",\n{\"ph\":\"C\",\"name\":\"%s\",\"pid\":1,\"ts\":%.3f,\"args\":{\"value\":%llu}}",
+							Name, Timestamp, Record->End);
+			break;
+		}
+		}
+		++EventCount;
+	}
+
+	TraceFileWritef(&Out, "\n]}\n");
+	FlushTraceFile(&Out);
+	Platform::FileClose(&Out.File);
+
+	if (Out.Failed)
+	{
+		LogError("Could not write the trace to %s", Path);
+		return false;
+	}
+
+	LogInfo("Trace of %llu events written to %s", EventCount, Path);
+	return true;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+/*
+NOTE: Frame timeline in the Trace Event JSON format, the one that
+chrome://tracing and ui.perfetto.dev open.
+While the profiler is enabled every frame goes into an in-memory ring:
+the scopes completed in the frame (fed by Profiler::EndFrame), a frame
+marker on its own track and a few counters (memory used by every MemTag,
+queued events dispatched). Nothing is written until a dump, which takes the last
+TraceSeconds of the ring and streams them to <BaseName>_<frame>.json.
+A dump happens on request (F9 or RequestDump) or on its own when a frame
+takes longer than the spike threshold, at most once per window so that a
+slow stretch doesn't dump every frame.
+
+The file is written one event per line through a small buffer, so its
+size is never bound by memory, and timestamps are relative to the first
+event to keep millions of them short and precise.
+Everything lives on the main thread.
+*/
+
+#include "defines.h"
+#include "core/kiwi_mem.h"
+
+#define TRACE_RING_RECORD_COUNT (1 << 19)
+#define TRACE_DEFAULT_BASE_NAME "kiwi_trace"
+#define TRACE_DEFAULT_SECONDS 10.0f
+
+enum TraceRecordKind
+{
+	TraceRecord_Scope,
+	TraceRecord_Frame,
+	TraceRecord_Counter,
+};
+
+struct TraceRecord
+{
+	// NOTE: Cpu timer. Counters use only Begin, and their value is in End
+	u64 Begin;
+	u64 End;
+	const char *Name;
+	// NOTE: Thread id for scopes, frame index for frames
+	u32 Id;
+	u32 Kind;
+};
+
+// NOTE: this is a singleton
+class TraceWriter
+{
+public:
+	// NOTE: SpikeMS 0 disables the dumps on slow frames
+	static b8 Initialize(const char *InBaseName, f32 InSeconds, f32 InSpikeMS);
+	static void Terminate();
+	// NOTE: After Profiler::EndFrame
+	static void EndFrame();
+
+	KIWI_INLINE static b8 IsActive() { return Records != nullptr; }
+
+	// NOTE: Called by the profiler for every completed scope
+	static void AddScope(u32 ThreadId, const char *Name, u64 Begin, u64 End);
+
+	// NOTE: The dump happens at the end of the current frame
+	KIWI_API static void RequestDump();
+	KIWI_API static b8 Dump(const char *Path);
+
+private:
+	static TraceRecord *Push();
+	static void AddCounter(const char *Name, u64 Time, u64 Value);
+
+	static TraceRecord *Records;
+	static u64 WritePos;
+	static const char *BaseName;
+	static f32 Seconds;
+	static f32 SpikeMS;
+	static u64 LastSpikeDumpTime;
+	static u32 LastDispatchedCount;
+	static u64 LastMemory[MemTag_Count];
+	static u32 MainThreadId;
+	static b8 DumpRequested;
+};
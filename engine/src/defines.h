@@ -11,14 +11,14 @@ macros and templates that can be usefull in every part of the code
 // NOTE: _MSC_VER GENERALLY means we're building with MSVC,
 // but it can be also defined by the intel compiler. Since we
 // don't plan on supporting it, the check against it is missing.
+// Clang defines __GNUC__ too, so it has to be checked first.
+// GCC and Clang are only used for the Linux builds (the benchmarks).
 #if defined(_MSC_VER)
 #define KIWI_MSVC
-#elif defined(__GNUC__)
-#define KIWI_GCC
-#error "Only MSVC compiler is supported for now! OMEGALUL"
 #elif defined(__clang__)
 #define KIWI_CLANG
-#error "Only MSVC compiler is supported for now! OMEGALUL"
+#elif defined(__GNUC__)
+#define KIWI_GCC
 #else
 #error "No compiler detected"
 #endif
@@ -32,8 +32,14 @@ macros and templates that can be usefull in every part of the code
 #else
 #error "64-bit compilation required!"
 #endif
+#elif defined(__linux__)
+#if defined(__x86_64__)
+#define KIWI_LINUX
+#else
+#error "64-bit x86 compilation required!"
+#endif
 #else
-#error "Only windows is supported for now! OMEGALUL"
+#error "Only windows and linux are supported for now! OMEGALUL"
 #endif
 
 /*
@@ -45,6 +51,8 @@ macros and templates that can be usefull in every part of the code
 #else
 #define KIWI_API __declspec(dllimport)
 #endif
+#else
+#define KIWI_API __attribute__((visibility("default")))
 #endif
 
 /*
@@ -55,16 +63,35 @@ macros and templates that can be usefull in every part of the code
 #define KIWI_NOINLINE __declspec(noinline)
 #else
 // TODO: This should work both on gcc and clang, but i haven't done too much
-// research about it. Also I don't know a way of preventing inlining on those compilers
+// research about it
 #define KIWI_INLINE inline __attribute__((always_inline))
-#define KIWI_NOINLINE
+// NOTE: noclone, or gcc still specializes the function for its callers
+#ifdef KIWI_GCC
+#define KIWI_NOINLINE __attribute__((noinline, noclone))
+#else
+#define KIWI_NOINLINE __attribute__((noinline))
+#endif
+#endif
+
+// NOTE: For the thread locals on hot paths. In the engine .so the default
+// model goes through __tls_get_addr on every access, initial-exec reads them
+// at a fixed offset from the thread pointer like the executable does. Fine as
+// long as the engine is loaded with the executable, not dlopen'ed later.
+#ifdef KIWI_MSVC
+#define KIWI_THREAD_LOCAL thread_local
+#else
+#define KIWI_THREAD_LOCAL thread_local __attribute__((tls_model("initial-exec")))
 #endif
 
 /*
         RUNTIME AND STATIC ASSERTION
 */
-#if defined(KIWI_MSVC) && defined(KIWI_SLOW)
+#ifdef KIWI_SLOW
+#ifdef KIWI_MSVC
 #define KDebugBreak() __debugbreak()
+#else
+#define KDebugBreak() __builtin_trap()
+#endif
 KIWI_API void LogAssertion(const char *Expression, const char *File, int Line, const char *Message = "");
 #define Assert(Expression)                                     \
         if (!(Expression))                                     \
@@ -85,6 +112,7 @@ KIWI_API void LogAssertion(const char *Expression, const char *File, int Line, c
 #else
 
 #define DebugBreak()
+#define KDebugBreak()
 #define Assert(Expression)
 #define AssertMsg(Expression, Message)
 #define StaticAssert(Expression)
@@ -147,16 +175,22 @@ StaticAssertMsg(sizeof(void *) == 8, "32-bit compilation not supported");
 #define SUPPRESS_WARNING(Code) __pragma(warning(suppress : Code))
 #define SUPPRESS_WARNING_JUSTIFIED(Code, Just) __pragma(warning(suppress : Code, justification : Just))
 
-#elif defined(KIWI_GCC) || define(KIWI_CLANG)
-// GCC example for future reference
+#elif defined(KIWI_GCC) || defined(KIWI_CLANG)
+// NOTE: The codes are MSVC ones and have no gcc/clang equivalent, so these
+// are no-ops. The Linux build scripts turn the unused-* warnings off explicitly
 #define DISABLE_WARNING_PUSH _Pragma("GCC diagnostic push")
 #define DISABLE_WARNING_POP _Pragma("GCC diagnostic pop")
+#define DISABLE_WARNING(Code)
+#define DISABLE_WARNING_JUSTIFIED(Code, Just)
+#define SUPPRESS_WARNING(Code)
+#define SUPPRESS_WARNING_JUSTIFIED(Code, Just)
 
+// GCC example for future reference
 #define DO_PRAGMA(X) _Pragma(#X)
-#define DISABLE_WARNING(WarningName) DO_PRAGMA(GCC diagnostic ignored #warningName)
+#define DISABLE_GCC_WARNING(WarningName) DO_PRAGMA(GCC diagnostic ignored #WarningName)
 // Then well define for all three compilers a macro like this
 // and use the push-disable-pop tecnique
-#define DISABLE_WARNING_UNREFERENCED_FORMAL_PARAMETER DISABLE_WARNING(-Wunused-parameter)
+#define DISABLE_WARNING_UNREFERENCED_FORMAL_PARAMETER DISABLE_GCC_WARNING(-Wunused-parameter)
 #endif
 
 /*
@@ -189,7 +223,120 @@ KIWI_INLINE T Clamp(T Value, T Low, T High) { return Max(Min(Value, High), Low);
 template <typename T>
 KIWI_INLINE void Swap(T *A, T *B)
 {
-        T *Temp = A;
-        A = B;
-        B = Temp;
-}
\ No newline at end of file
+        T Temp = *A;
+        *A = *B;
+        *B = Temp;
+}
+
+/*
+        INTRINSICS
+*/
+// NOTE: Thin wrappers around the bit manipulation intrinsics so that
+// containers don't have to care about which compiler is building them.
+// All of them assume a non-zero input where it matters (FindFirstSet64, FindLastSet64).
+#ifdef KIWI_MSVC
+#include <intrin.h>
+
+KIWI_INLINE u32 PopCount64(u64 Value) { return (u32)__popcnt64(Value); }
+KIWI_INLINE u32 FindFirstSet64(u64 Value)
+{
+        unsigned long Index;
+        _BitScanForward64(&Index, Value);
+        return (u32)Index;
+}
+KIWI_INLINE u32 FindLastSet64(u64 Value)
+{
+        unsigned long Index;
+        _BitScanReverse64(&Index, Value);
+        return (u32)Index;
+}
+// NOTE: Full 64x64 -> 128 bit multiplication, returns the low half
+KIWI_INLINE u64 Multiply128(u64 A, u64 B, u64 &OutHigh) { return _umul128(A, B, &OutHigh); }
+// NOTE: Time stamp counter, constant rate on every cpu we care about.
+// Only good for measuring intervals, it has to be calibrated against a real clock.
+KIWI_INLINE u64 ReadCycleCounter() { return __rdtsc(); }
+// NOTE: The time stamp counter ticks at a constant rate through frequency
+// and power state changes, and it's synchronized across cores
+KIWI_INLINE b8 HasInvariantCycleCounter()
+{
+        int Registers[4];
+        __cpuid(Registers, 0x80000000);
+        if ((u32)Registers[0] < 0x80000007)
+        {
+                return false;
+        }
+        __cpuid(Registers, 0x80000007);
+        return (Registers[3] & (1 << 8)) != 0;
+}
+#else
+#include <x86intrin.h>
+#include <cpuid.h>
+
+KIWI_INLINE u32 PopCount64(u64 Value) { return (u32)__builtin_popcountll(Value); }
+KIWI_INLINE u32 FindFirstSet64(u64 Value) { return (u32)__builtin_ctzll(Value); }
+KIWI_INLINE u32 FindLastSet64(u64 Value) { return 63 - (u32)__builtin_clzll(Value); }
+KIWI_INLINE u64 Multiply128(u64 A, u64 B, u64 &OutHigh)
+{
+        unsigned __int128 Result = (unsigned __int128)A * B;
+        OutHigh = (u64)(Result >> 64);
+        return (u64)Result;
+}
+KIWI_INLINE u64 ReadCycleCounter() { return __rdtsc(); }
+KIWI_INLINE b8 HasInvariantCycleCounter()
+{
+        u32 Eax = 0, Ebx = 0, Ecx = 0, Edx = 0;
+        if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007)
+        {
+                return false;
+        }
+        __get_cpuid(0x80000007, &Eax, &Ebx, &Ecx, &Edx);
+        return (Edx & (1 << 8)) != 0;
+}
+#endif
+
+/*
+        ATOMICS
+*/
+// NOTE: Just what the lock-free code in the engine needs. On x64 plain
+// loads and stores already have acquire/release semantics, so on MSVC
+// we only have to stop the compiler from reordering around them.
+// CompareExchange64 updates Expected with the current value on failure.
+#ifdef KIWI_MSVC
+KIWI_INLINE u64 AtomicLoadAcquire64(volatile u64 *Ptr)
+{
+        u64 Value = *Ptr;
+        _ReadWriteBarrier();
+        return Value;
+}
+KIWI_INLINE void AtomicStoreRelease64(volatile u64 *Ptr, u64 Value)
+{
+        _ReadWriteBarrier();
+        *Ptr = Value;
+}
+KIWI_INLINE b8 AtomicCompareExchange64(volatile u64 *Ptr, u64 &Expected, u64 Desired)
+{
+        u64 Previous = (u64)_InterlockedCompareExchange64((volatile long long *)Ptr, (long long)Desired, (long long)Expected);
+        b8 Exchanged = (Previous == Expected);
+        Expected = Previous;
+        return Exchanged;
+}
+// NOTE: Returns the value before the addition
+KIWI_INLINE u64 AtomicAdd64(volatile u64 *Ptr, u64 Value)
+{
+        return (u64)_InterlockedExchangeAdd64((volatile long long *)Ptr, (long long)Value);
+}
+KIWI_INLINE void CpuPause() { _mm_pause(); }
+#else
+KIWI_INLINE u64 AtomicLoadAcquire64(volatile u64 *Ptr) { return __atomic_load_n(Ptr, __ATOMIC_ACQUIRE); }
+KIWI_INLINE void AtomicStoreRelease64(volatile u64 *Ptr, u64 Value) { __atomic_store_n(Ptr, Value, __ATOMIC_RELEASE); }
+KIWI_INLINE b8 AtomicCompareExchange64(volatile u64 *Ptr, u64 &Expected, u64 Desired)
+{
+        return __atomic_compare_exchange_n(Ptr, &Expected, Desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+KIWI_INLINE u64 AtomicAdd64(volatile u64 *Ptr, u64 Value) { return __atomic_fetch_add(Ptr, Value, __ATOMIC_ACQ_REL); }
+KIWI_INLINE void CpuPause() { __builtin_ia32_pause(); }
+#endif
+
+// NOTE: Most x64 cpus have 64 byte cache lines. Used to pad data that
+// different threads write to, so they don't fight over the same line.
+#define CACHE_LINE_SIZE 64
@@ -5,10 +5,13 @@
 #include "core/logger.h"
 #include "game_types.h"
 #include "core/kiwi_mem.h"
+#include "core/kiwi_string.h"
+
+#include <stdlib.h>
 
 extern b8 CreateGame(Game *OutGame);
 
-int main(void)
+int main(int ArgCount, char **Args)
 {
 	// NOTE: Only very specific subsystems will be initialized here
 	MemSystem::Initialize();
@@ -27,6 +30,74 @@ int main(void)
 		return -2;
 	}
 
+	// NOTE: The command line has the last word over the game's config
+	for (i32 ArgIdx = 1; ArgIdx + 1 < ArgCount; ++ArgIdx)
+	{
+		if (KStr::Equal(Args[ArgIdx], "--record"))
+		{
+			GameInstance.AppConfig.RecordPath = Args[++ArgIdx];
+		}
+		else if (KStr::Equal(Args[ArgIdx], "--replay"))
+		{
+			GameInstance.AppConfig.ReplayPath = Args[++ArgIdx];
+		}
+		else if (KStr::Equal(Args[ArgIdx], "--crash-log"))
+		{
+			GameInstance.AppConfig.CrashLogPath = Args[++ArgIdx];
+		}
+		else if (KStr::Equal(Args[ArgIdx], "--trace"))
+		{
+			GameInstance.AppConfig.TraceBaseName = Args[++ArgIdx];
+		}
+		else if (KStr::Equal(Args[ArgIdx], "--trace-seconds"))
+		{
+			GameInstance.AppConfig.TraceSeconds = (f32)atof(Args[++ArgIdx]);
+		}
+		else if (KStr::Equal(Args[ArgIdx], "--trace-spike"))
+		{
+			GameInstance.AppConfig.TraceSpikeMS = (f32)atof(Args[++ArgIdx]);
+		}
+		else if (KStr::Equal(Args[ArgIdx], "--fps"))
+		{
+			GameInstance.AppConfig.TargetFrameRate = (f32)atof(Args[++ArgIdx]);
+		}
+		else if (KStr::Equal(Args[ArgIdx], "--update-rate"))
+		{
+			GameInstance.AppConfig.FixedUpdateRate = (f32)atof(Args[++ArgIdx]);
+		}
+		else if (KStr::Equal(Args[ArgIdx], "--sample"))
+		{
+			GameInstance.AppConfig.SampleRate = (f32)atof(Args[++ArgIdx]);
+		}
+		else if (KStr::Equal(Args[ArgIdx], "--sample-output"))
+		{
+			GameInstance.AppConfig.SamplePath = Args[++ArgIdx];
+		}
+		else if (KStr::Equal(Args[ArgIdx], "--perf-counters"))
+		{
+			GameInstance.AppConfig.PerfCounters = atoi(Args[++ArgIdx]) != 0;
+		}
+		else if (KStr::Equal(Args[ArgIdx], "--metrics"))
+		{
+			GameInstance.AppConfig.MetricsPath = Args[++ArgIdx];
+		}
+		else if (KStr::Equal(Args[ArgIdx], "--metrics-interval"))
+		{
+			GameInstance.AppConfig.MetricsInterval = (f32)atof(Args[++ArgIdx]);
+		}
+		else if (KStr::Equal(Args[ArgIdx], "--headless"))
+		{
+			// NOTE: e.g. --headless 10000, 0 runs until killed
+			GameInstance.AppConfig.Headless = true;
+			GameInstance.AppConfig.FrameCount = (u32)atoi(Args[++ArgIdx]);
+		}
+		else if (KStr::Equal(Args[ArgIdx], "--log"))
+		{
+			// NOTE: e.g. --log vulkan=warning,event=trace
+			Logger::SetChannelLevels(Args[++ArgIdx]);
+		}
+	}
+
 	// Initialization
 	if (!Application::Create(&GameInstance))
 	{
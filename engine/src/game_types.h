@@ -12,7 +12,10 @@ typedef INITIALIZE(initialize);
 #define UPDATE(name) b8 name(Game *GameInstance, f32 DeltaTime)
 typedef UPDATE(update);
 
-#define RENDER(name) b8 name(Game *GameInstance, f32 DeltaTime)
+// NOTE: Alpha is how far the frame is between the last two updates, in [0, 1]:
+// render Previous + (Current - Previous) * Alpha. It's always 1 when the
+// updates are not at a fixed rate (see ApplicationConfig::FixedUpdateRate)
+#define RENDER(name) b8 name(Game *GameInstance, f32 DeltaTime, f32 Alpha)
 typedef RENDER(render);
 
 #define ON_RESIZE(name) void name(Game *GameInstance, u32 Width, u32 Height)
@@ -30,9 +30,8 @@
 KIWI_INLINE b8 IsPowerOfTwo(u64 Value) { return (Value != 0) && ((Value & (Value - 1)) == 0); }
 
 // Misc Function
-// TODO: FIX
-KIWI_INLINE f32 KSqrt(f32 Value) { return Value; }
-KIWI_INLINE f32 KAbs(f32 Value) { return Value; }
+KIWI_INLINE f32 KSqrt(f32 Value) { return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(Value))); }
+KIWI_INLINE f32 KAbs(f32 Value) { return _mm_cvtss_f32(_mm_andnot_ps(_mm_set_ss(-0.0f), _mm_set_ss(Value))); }
 
 // Trig Function
 KIWI_INLINE f32 KSin(f32 Angle);
@@ -23,7 +23,7 @@ struct Vec2
 
 	Vec2() {}
 
-	Vec2(Vec2 &V)
+	Vec2(const Vec2 &V)
 	{
 		x = V.x;
 		y = V.y;
@@ -75,6 +75,9 @@ struct Vec3
 		{
 			f32 r, g, b;
 		};
+#ifdef KIWI_MSVC
+		// NOTE: gcc and clang don't allow members with constructors in
+		// anonymous structs, the swizzles are an MSVC extension
 		struct
 		{
 			Vec2 xy;
@@ -85,11 +88,12 @@ struct Vec3
 			f32 _x;
 			Vec2 yz;
 		};
+#endif
 	};
 
 	Vec3() {}
 
-	Vec3(Vec3 &V)
+	Vec3(const Vec3 &V)
 	{
 		x = V.x;
 		y = V.y;
@@ -151,6 +155,7 @@ struct Vec4
 		{
 			f32 r, g, b, a;
 		};
+#ifdef KIWI_MSVC
 		struct
 		{
 			Vec2 xy;
@@ -172,11 +177,12 @@ struct Vec4
 			f32 _x1;
 			Vec3 yzw;
 		};
+#endif
 	};
 
 	Vec4() {}
 
-	Vec4(Vec4 &V)
+	Vec4(const Vec4 &V)
 	{
 		x = V.x;
 		y = V.y;
@@ -7,9 +7,79 @@ struct PlatformState
 	void *InternalState;
 };
 
+// NOTE: Slim reader/writer lock. Zero initialized means unlocked
+struct PlatformRWLock
+{
+	void *Internal;
+};
+
+struct PlatformFile
+{
+	void *Handle;
+};
+
+// NOTE: A file mapped in memory, the pages are shared with the OS file
+// cache so what is written survives a crash of the process
+struct PlatformFileMapping
+{
+	void *File;
+	void *Mapping;
+	void *Memory;
+	u64 Size;
+};
+
+struct PlatformThread
+{
+	void *Handle;
+};
+
+struct PlatformSemaphore
+{
+	void *Handle;
+};
+
+// NOTE: A thread another one can capture the call stack of
+struct PlatformSampledThread
+{
+	void *Handle;
+};
+
+enum PerfCounter
+{
+	PerfCounter_Cycles,
+	PerfCounter_Instructions,
+	PerfCounter_CacheMisses,
+	PerfCounter_BranchMisses,
+
+	PerfCounter_Count
+};
+
+// NOTE: Hardware performance counters of a thread, one OS handle per counter
+// (a file descriptor on Linux). Zero initialized means not opened
+struct PlatformPerfCounters
+{
+	i32 Handles[PerfCounter_Count];
+	b8 Opened;
+};
+
+#define THREAD_PROC(name) u32 name(void *Param)
+typedef THREAD_PROC(thread_proc);
+
+enum FileMode
+{
+	// Open an existing file for reading
+	FileMode_Read,
+	// Create the file, or truncate it if it exists
+	FileMode_Write,
+	// Create the file if needed and write at its end
+	FileMode_Append,
+};
+
 namespace Platform
 {
 	b8 Startup(PlatformState *PlatState, const char *ApplicationName, i32 X, i32 Y, i32 Width, i32 Height);
+	// NOTE: Everything but the window, there are no messages for ProcessMessageQueue
+	b8 StartupHeadless(PlatformState *PlatState);
 	void Terminate(PlatformState *PlatState);
 
 	b8 ProcessMessageQueue(PlatformState *PlatState);
@@ -27,7 +97,69 @@ namespace Platform
 	void ConsoleWrite(const char *Message, u8 Level);
 	void ConsoleWriteError(const char *Message, u8 Level);
 
+	// NOTE: The OS monotonic clock, in ticks of GetTickFrequency() per second.
+	// The engine reads the time through Clock, which may use the cycle counter instead
+	u64 GetTicks();
+	u64 GetTickFrequency();
+	// NOTE: Seconds since Clock::Initialize, 0 before. Only a wrapper of
+	// Clock for whoever wants f64 seconds, prefer the ticks
 	f64 GetAbsoluteTime();
 
 	void SleepMS(u64 ms);
+	// NOTE: High resolution wait, it can still oversleep by the scheduler
+	// latency: whoever needs to wake up on time spins the last bit
+	void SleepPrecise(f64 Seconds);
+	// NOTE: Give the rest of the time slice to another ready thread, if any
+	void YieldThread();
+
+	// Files
+	// NOTE: Blocking, unbuffered calls. Whoever writes often is expected to batch.
+	b8 FileOpen(PlatformFile *OutFile, const char *Path, FileMode Mode);
+	void FileClose(PlatformFile *File);
+	b8 FileWrite(PlatformFile *File, const void *Data, u64 Size);
+	// NOTE: Return the number of bytes actually read, 0 at the end of the file
+	u64 FileRead(PlatformFile *File, void *Dest, u64 Size);
+	u64 FileSize(PlatformFile *File);
+	// NOTE: Replaces the destination if it exists
+	b8 FileMove(const char *From, const char *To);
+	b8 FileDelete(const char *Path);
+	// NOTE: Creates the file if needed and resizes it to Size, read-write
+	b8 FileMapOpen(PlatformFileMapping *OutMapping, const char *Path, u64 Size);
+	void FileMapClose(PlatformFileMapping *Mapping);
+
+	// Threads
+	b8 ThreadCreate(PlatformThread *OutThread, thread_proc *Proc, void *Param);
+	// NOTE: Waits for the thread to finish and releases it
+	void ThreadJoin(PlatformThread *Thread);
+	u32 GetThreadId();
+
+	b8 SemaphoreCreate(PlatformSemaphore *OutSemaphore, u32 InitialCount);
+	void SemaphoreDestroy(PlatformSemaphore *Semaphore);
+	void SemaphoreSignal(PlatformSemaphore *Semaphore);
+	// NOTE: Returns false if the timeout expired first
+	b8 SemaphoreWait(PlatformSemaphore *Semaphore, u32 TimeoutMS);
+
+	// Sampling
+	// NOTE: Called by the thread that is going to be sampled
+	b8 SampledThreadOpen(PlatformSampledThread *OutThread);
+	void SampledThreadClose(PlatformSampledThread *Thread);
+	// NOTE: Stops the thread for the time of the capture and writes its return
+	// addresses in OutFrames, the innermost first. Returns how many, 0 on failure
+	u32 CaptureThreadStack(PlatformSampledThread *Thread, u64 *OutFrames, u32 MaxFrames);
+	// NOTE: The symbols are loaded at the first call, it's slow: meant for shutdown
+	b8 SymbolizeAddress(u64 Address, char *OutName, u32 NameSize);
+
+	// Performance counters
+	// NOTE: Opens the counters of the calling thread. Fails, quietly, where
+	// the OS gives no access to them: the caller is expected to go without
+	b8 PerfCountersOpen(PlatformPerfCounters *OutCounters);
+	void PerfCountersClose(PlatformPerfCounters *Counters);
+	// NOTE: Only from the thread that opened them, PerfCounter_Count values
+	void PerfCountersRead(PlatformPerfCounters *Counters, u64 *OutValues);
+
+	// Synchronization
+	void LockShared(PlatformRWLock *Lock);
+	void UnlockShared(PlatformRWLock *Lock);
+	void LockExclusive(PlatformRWLock *Lock);
+	void UnlockExclusive(PlatformRWLock *Lock);
 }
\ No newline at end of file
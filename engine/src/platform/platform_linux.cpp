@@ -0,0 +1,847 @@
+#include "platform.h"
+
+#ifdef KIWI_LINUX
+
+#include "core/logger.h"
+#include "core/kiwi_mem.h"
+#include "core/clock.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <linux/futex.h>
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <sched.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+
+// NOTE: Frames the signal handler can capture, the handler's own included
+#define LINUX_MAX_CAPTURE_FRAMES 256
+// NOTE: How long the sampler waits for the signal handler of the sampled thread
+#define LINUX_CAPTURE_TIMEOUT_MS 50.0
+
+/*
+NOTE: Linux has no window yet, the platform layer is everything but that:
+enough for the tools and the benchmarks to run on the build machines.
+*/
+
+struct InternalState
+{
+	b8 HasWindow;
+};
+
+struct LinuxThreadStart
+{
+	thread_proc *Proc;
+	void *Param;
+};
+
+// NOTE: One capture at a time, the sampler thread is the only caller.
+// The handler checks the thread id, so a late signal of a capture that
+// timed out can't fill the next one with the wrong stack.
+local_var volatile u64 CaptureRequest = 0;
+local_var volatile u64 CaptureDone = 0;
+local_var volatile pid_t CaptureThread = 0;
+local_var volatile u32 CaptureCount = 0;
+local_var u64 CaptureFrames[LINUX_MAX_CAPTURE_FRAMES];
+local_var b8 CaptureHandlerInstalled = false;
+
+// NOTE: The files are kept as fd + 1, so that a null handle is a closed file
+KIWI_INLINE int LinuxFd(void *Handle)
+{
+	return (int)(u64)Handle - 1;
+}
+
+KIWI_INLINE void *LinuxFileHandle(int Fd)
+{
+	return (void *)(u64)(Fd + 1);
+}
+
+b8 Platform::Startup(PlatformState *PlatState, const char *ApplicationName,
+					 i32 ClientX, i32 ClientY, i32 ClientWidth, i32 ClientHeight)
+{
+	// TODO: Replace malloc
+	PlatState->InternalState = malloc(sizeof(InternalState));
+	InternalState *State = (InternalState *)PlatState->InternalState;
+	State->HasWindow = false;
+
+	LogFatal("Could not create the window of %s (%d, %d, %dx%d): windows are not supported on Linux yet, "
+			 "only headless runs",
+			 ApplicationName, ClientX, ClientY, ClientWidth, ClientHeight);
+	return false;
+}
+
+b8 Platform::StartupHeadless(PlatformState *PlatState)
+{
+	// TODO: Replace malloc
+	PlatState->InternalState = malloc(sizeof(InternalState));
+	InternalState *State = (InternalState *)PlatState->InternalState;
+	State->HasWindow = false;
+	return true;
+}
+
+void Platform::Terminate(PlatformState *PlatState)
+{
+	if (PlatState->InternalState)
+	{
+		free(PlatState->InternalState);
+		PlatState->InternalState = nullptr;
+	}
+}
+
+SUPPRESS_WARNING(4100)
+b8 Platform::ProcessMessageQueue(PlatformState *PlatState)
+{
+	return true;
+}
+
+char *Platform::GetLastErrorMessage()
+{
+	return strerror(errno);
+}
+
+void Platform::GetMemoryInfo(u32 &OutPageSize, u32 &OutAllocationGranularity)
+{
+	// NOTE: mmap works at page granularity
+	OutPageSize = (u32)sysconf(_SC_PAGESIZE);
+	OutAllocationGranularity = OutPageSize;
+}
+
+char *Platform::GetMemoryAllocationInfo(void *Address)
+{
+	char Buffer[1000] = {};
+
+	// NOTE: The mappings of the process, one per line: "start-end perms ..."
+	FILE *Maps = fopen("/proc/self/maps", "r");
+	if (Maps)
+	{
+		char Line[512];
+		while (fgets(Line, sizeof(Line), Maps))
+		{
+			u64 Start;
+			u64 End;
+			char Permissions[8];
+			if (sscanf(Line, "%llx-%llx %7s", &Start, &End, Permissions) == 3 &&
+				(u64)Address >= Start && (u64)Address < End)
+			{
+				snprintf(Buffer, sizeof(Buffer),
+						 "Allocation info for Address 0x%llx\nBaseAddress=0x%llx, RegionSize=%llu, Protect=%s",
+						 (u64)Address, Start, End - Start, Permissions);
+				break;
+			}
+		}
+		fclose(Maps);
+	}
+
+	// TODO: This function is currently LEAKING MEMORY
+	return strdup(Buffer);
+}
+
+// NOTE: The allocation type keeps the engine flags that mean something to
+// mmap (commit and reserve), the protection becomes the PROT_ flags.
+// Reset, physical, top down, write watch, caching and guard pages have no
+// equivalent and are ignored.
+void Platform::TranslateAllocSpecifiers(u32 MemAllocFlags, u32 &OutAllocType, u32 &OutProtectionType)
+{
+	OutAllocType |= MemAllocFlags & (MemAlloc_Commit | MemAlloc_Reserve | MemAlloc_LargePages);
+
+	if (CheckFlags(MemAllocFlags, MemAlloc_Execute))
+	{
+		OutProtectionType |= PROT_EXEC;
+	}
+	if (CheckFlags(MemAllocFlags, MemAlloc_ExecuteRead))
+	{
+		OutProtectionType |= PROT_EXEC | PROT_READ;
+	}
+	if (CheckFlags(MemAllocFlags, MemAlloc_ExecuteReadWrite | MemAlloc_ExecuteWriteCopy))
+	{
+		OutProtectionType |= PROT_EXEC | PROT_READ | PROT_WRITE;
+	}
+	if (CheckFlags(MemAllocFlags, MemAlloc_ReadOnly))
+	{
+		OutProtectionType |= PROT_READ;
+	}
+	if (CheckFlags(MemAllocFlags, MemAlloc_ReadWrite | MemAlloc_WriteCopy))
+	{
+		OutProtectionType |= PROT_READ | PROT_WRITE;
+	}
+}
+
+// NOTE: Reserving maps fresh pages, committing changes the protection of
+// pages already reserved. Linux backs them with memory on the first touch
+// either way, commit or not: MAP_NORESERVE keeps the reservations out of
+// the overcommit accounting.
+void *Platform::Allocate(void *Address, u64 Size, u32 MemAllocFlags)
+{
+	u32 AllocationType = 0;
+	u32 ProtectionType = 0;
+	TranslateAllocSpecifiers(MemAllocFlags, AllocationType, ProtectionType);
+
+	if (CheckFlags(AllocationType, MemAlloc_Reserve))
+	{
+		int Flags = MAP_PRIVATE | MAP_ANONYMOUS;
+		if (!CheckFlags(AllocationType, MemAlloc_Commit))
+		{
+			Flags |= MAP_NORESERVE;
+			ProtectionType = PROT_NONE;
+		}
+		if (CheckFlags(AllocationType, MemAlloc_LargePages))
+		{
+			Flags |= MAP_HUGETLB;
+		}
+
+		void *Result = mmap(Address, Size, (int)ProtectionType, Flags, -1, 0);
+		return Result == MAP_FAILED ? nullptr : Result;
+	}
+
+	return mprotect(Address, Size, (int)ProtectionType) == 0 ? Address : nullptr;
+}
+
+void Platform::Free(void *Address, u64 Size, u8 MemDeallocFlag)
+{
+	if (CheckFlags(MemDeallocFlag, MemDealloc_Release))
+	{
+		munmap(Address, Size);
+	}
+	else
+	{
+		// NOTE: Gives the pages back, they read as zeros if committed again
+		madvise(Address, Size, MADV_DONTNEED);
+		mprotect(Address, Size, PROT_NONE);
+	}
+}
+
+void Platform::SetMem(void *Address, u64 Size, u32 Value)
+{
+	memset(Address, (int)Value, Size);
+}
+
+void Platform::ZeroMem(void *Address, u64 Size)
+{
+	memset(Address, 0, Size);
+}
+
+void Platform::CopyMem(void *Dest, void *Source, u64 Size)
+{
+	memcpy(Dest, Source, Size);
+}
+
+// NOTE: Same colors as the Win32 console, as ANSI escape sequences
+local_var const char *ConsoleColors[] = {
+	"\x1b[41;1m", // Fatal
+	"\x1b[31;1m", // Error
+	"\x1b[33;1m", // Warning
+	"\x1b[32;1m", // Info
+	"\x1b[34;1m", // Debug
+	"\x1b[90m",	  // Trace
+};
+
+internal_func void LinuxConsoleWrite(int Fd, const char *Message, u8 Level)
+{
+	const char *Color = ConsoleColors[Level < ArrayCount(ConsoleColors) ? Level : ArrayCount(ConsoleColors) - 1];
+	const char *Reset = "\x1b[0m";
+
+	// NOTE: A single write, so the lines of different threads don't mix
+	char Buffer[4096];
+	int Length = snprintf(Buffer, sizeof(Buffer), "%s%s%s", Color, Message, Reset);
+	if (Length > 0 && Length < (int)sizeof(Buffer))
+	{
+		ssize_t Written = write(Fd, Buffer, (size_t)Length);
+		(void)Written;
+	}
+	else
+	{
+		// NOTE: Too long for the buffer, it goes out in pieces
+		ssize_t Written = write(Fd, Color, strlen(Color));
+		Written = write(Fd, Message, strlen(Message));
+		Written = write(Fd, Reset, strlen(Reset));
+		(void)Written;
+	}
+}
+
+void Platform::ConsoleWrite(const char *Message, u8 Level)
+{
+	LinuxConsoleWrite(STDOUT_FILENO, Message, Level);
+}
+
+void Platform::ConsoleWriteError(const char *Message, u8 Level)
+{
+	LinuxConsoleWrite(STDERR_FILENO, Message, Level);
+}
+
+u64 Platform::GetTicks()
+{
+	// NOTE: Answered by the vDSO, no trip in the kernel
+	timespec Now;
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	return (u64)Now.tv_sec * 1000000000ULL + (u64)Now.tv_nsec;
+}
+
+u64 Platform::GetTickFrequency()
+{
+	return 1000000000ULL;
+}
+
+f64 Platform::GetAbsoluteTime()
+{
+	return Clock::GetSeconds();
+}
+
+void Platform::SleepMS(u64 ms)
+{
+	SleepPrecise((f64)ms / 1000.0);
+}
+
+// NOTE: An absolute deadline, so the signals of the sampler (that interrupt
+// the sleep) don't make it longer
+void Platform::SleepPrecise(f64 Seconds)
+{
+	if (Seconds <= 0.0)
+	{
+		return;
+	}
+
+	u64 Nanoseconds = (u64)(Seconds * 1000000000.0);
+	timespec Deadline;
+	clock_gettime(CLOCK_MONOTONIC, &Deadline);
+	Deadline.tv_sec += (time_t)(Nanoseconds / 1000000000ULL);
+	Deadline.tv_nsec += (long)(Nanoseconds % 1000000000ULL);
+	if (Deadline.tv_nsec >= 1000000000L)
+	{
+		++Deadline.tv_sec;
+		Deadline.tv_nsec -= 1000000000L;
+	}
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Deadline, nullptr) == EINTR)
+	{
+	}
+}
+
+void Platform::YieldThread()
+{
+	sched_yield();
+}
+
+b8 Platform::FileOpen(PlatformFile *OutFile, const char *Path, FileMode Mode)
+{
+	int Flags = O_RDONLY;
+	if (Mode == FileMode_Write)
+	{
+		Flags = O_WRONLY | O_CREAT | O_TRUNC;
+	}
+	else if (Mode == FileMode_Append)
+	{
+		Flags = O_WRONLY | O_CREAT | O_APPEND;
+	}
+
+	int Fd = open(Path, Flags | O_CLOEXEC, 0644);
+	if (Fd < 0)
+	{
+		LogError("Could not open file %s: %s", Path, GetLastErrorMessage());
+		OutFile->Handle = nullptr;
+		return false;
+	}
+
+	OutFile->Handle = LinuxFileHandle(Fd);
+	return true;
+}
+
+void Platform::FileClose(PlatformFile *File)
+{
+	if (File->Handle)
+	{
+		close(LinuxFd(File->Handle));
+		File->Handle = nullptr;
+	}
+}
+
+b8 Platform::FileWrite(PlatformFile *File, const void *Data, u64 Size)
+{
+	// NOTE: write can stop early, the rest goes in the next round
+	const u8 *Source = (const u8 *)Data;
+	while (Size)
+	{
+		ssize_t Written = write(LinuxFd(File->Handle), Source, (size_t)Min(Size, (u64)0x40000000));
+		if (Written < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (Written <= 0)
+		{
+			return false;
+		}
+		Source += Written;
+		Size -= (u64)Written;
+	}
+	return true;
+}
+
+u64 Platform::FileRead(PlatformFile *File, void *Dest, u64 Size)
+{
+	u8 *Target = (u8 *)Dest;
+	u64 TotalRead = 0;
+	while (TotalRead < Size)
+	{
+		ssize_t Read = read(LinuxFd(File->Handle), Target + TotalRead, (size_t)Min(Size - TotalRead, (u64)0x40000000));
+		if (Read < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (Read <= 0)
+		{
+			break;
+		}
+		TotalRead += (u64)Read;
+	}
+	return TotalRead;
+}
+
+u64 Platform::FileSize(PlatformFile *File)
+{
+	struct stat Stat;
+	if (fstat(LinuxFd(File->Handle), &Stat) != 0)
+	{
+		return 0;
+	}
+	return (u64)Stat.st_size;
+}
+
+b8 Platform::FileMove(const char *From, const char *To)
+{
+	return rename(From, To) == 0;
+}
+
+b8 Platform::FileDelete(const char *Path)
+{
+	return unlink(Path) == 0;
+}
+
+b8 Platform::FileMapOpen(PlatformFileMapping *OutMapping, const char *Path, u64 Size)
+{
+	*OutMapping = {};
+
+	int Fd = open(Path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (Fd < 0)
+	{
+		LogError("Could not open file %s: %s", Path, GetLastErrorMessage());
+		return false;
+	}
+
+	// NOTE: Unlike Windows the mapping doesn't size the file
+	if (ftruncate(Fd, (off_t)Size) != 0)
+	{
+		LogError("Could not resize %s: %s", Path, GetLastErrorMessage());
+		close(Fd);
+		return false;
+	}
+
+	void *Memory = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+	if (Memory == MAP_FAILED)
+	{
+		LogError("Could not map %s: %s", Path, GetLastErrorMessage());
+		close(Fd);
+		return false;
+	}
+
+	OutMapping->File = LinuxFileHandle(Fd);
+	OutMapping->Memory = Memory;
+	OutMapping->Size = Size;
+	return true;
+}
+
+void Platform::FileMapClose(PlatformFileMapping *Mapping)
+{
+	if (!Mapping->Memory)
+	{
+		return;
+	}
+
+	munmap(Mapping->Memory, Mapping->Size);
+	close(LinuxFd(Mapping->File));
+	*Mapping = {};
+}
+
+internal_func void *LinuxThreadMain(void *Param)
+{
+	LinuxThreadStart Start = *(LinuxThreadStart *)Param;
+	free(Param);
+	Start.Proc(Start.Param);
+	return nullptr;
+}
+
+StaticAssertMsg(sizeof(pthread_t) <= sizeof(void *), "pthread_t doesn't fit in PlatformThread");
+
+b8 Platform::ThreadCreate(PlatformThread *OutThread, thread_proc *Proc, void *Param)
+{
+	// NOTE: thread_proc doesn't match what pthread wants, it's called from LinuxThreadMain
+	// TODO: Replace malloc
+	LinuxThreadStart *Start = (LinuxThreadStart *)malloc(sizeof(LinuxThreadStart));
+	Start->Proc = Proc;
+	Start->Param = Param;
+
+	pthread_t Thread;
+	int Error = pthread_create(&Thread, nullptr, LinuxThreadMain, Start);
+	if (Error)
+	{
+		LogError("Could not create a thread: %s", strerror(Error));
+		free(Start);
+		OutThread->Handle = nullptr;
+		return false;
+	}
+
+	OutThread->Handle = (void *)Thread;
+	return true;
+}
+
+void Platform::ThreadJoin(PlatformThread *Thread)
+{
+	if (Thread->Handle)
+	{
+		pthread_join((pthread_t)Thread->Handle, nullptr);
+		Thread->Handle = nullptr;
+	}
+}
+
+u32 Platform::GetThreadId()
+{
+	return (u32)syscall(SYS_gettid);
+}
+
+b8 Platform::SemaphoreCreate(PlatformSemaphore *OutSemaphore, u32 InitialCount)
+{
+	// TODO: Replace malloc
+	sem_t *Semaphore = (sem_t *)malloc(sizeof(sem_t));
+	if (!Semaphore || sem_init(Semaphore, 0, InitialCount) != 0)
+	{
+		free(Semaphore);
+		OutSemaphore->Handle = nullptr;
+		return false;
+	}
+
+	OutSemaphore->Handle = Semaphore;
+	return true;
+}
+
+void Platform::SemaphoreDestroy(PlatformSemaphore *Semaphore)
+{
+	if (Semaphore->Handle)
+	{
+		sem_destroy((sem_t *)Semaphore->Handle);
+		free(Semaphore->Handle);
+		Semaphore->Handle = nullptr;
+	}
+}
+
+void Platform::SemaphoreSignal(PlatformSemaphore *Semaphore)
+{
+	sem_post((sem_t *)Semaphore->Handle);
+}
+
+// NOTE: sem_timedwait wants a CLOCK_REALTIME deadline, a change of the
+// wall clock during the wait makes it shorter or longer
+b8 Platform::SemaphoreWait(PlatformSemaphore *Semaphore, u32 TimeoutMS)
+{
+	timespec Deadline;
+	clock_gettime(CLOCK_REALTIME, &Deadline);
+	Deadline.tv_sec += (time_t)(TimeoutMS / 1000);
+	Deadline.tv_nsec += (long)(TimeoutMS % 1000) * 1000000L;
+	if (Deadline.tv_nsec >= 1000000000L)
+	{
+		++Deadline.tv_sec;
+		Deadline.tv_nsec -= 1000000000L;
+	}
+
+	while (sem_timedwait((sem_t *)Semaphore->Handle, &Deadline) != 0)
+	{
+		if (errno != EINTR)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// NOTE: Runs on the sampled thread, interrupted wherever it was. backtrace
+// walks from here through the signal frame into the interrupted code, the
+// first two frames are this handler and the signal trampoline.
+internal_func void LinuxCaptureHandler(int Signal)
+{
+	(void)Signal;
+	u64 Request = CaptureRequest;
+	if (Request == CaptureDone || (pid_t)syscall(SYS_gettid) != CaptureThread)
+	{
+		return;
+	}
+
+	void *Frames[LINUX_MAX_CAPTURE_FRAMES];
+	int FrameCount = backtrace(Frames, LINUX_MAX_CAPTURE_FRAMES);
+	u32 Count = 0;
+	for (int Idx = 2; Idx < FrameCount; ++Idx)
+	{
+		CaptureFrames[Count++] = (u64)Frames[Idx];
+	}
+	CaptureCount = Count;
+	AtomicStoreRelease64(&CaptureDone, Request);
+}
+
+b8 Platform::SampledThreadOpen(PlatformSampledThread *OutThread)
+{
+	// NOTE: The first backtrace loads libgcc, which allocates: it can't happen
+	// in the handler, so it's done here. The handler is shared by all threads.
+	if (!CaptureHandlerInstalled)
+	{
+		void *Frames[4];
+		backtrace(Frames, ArrayCount(Frames));
+
+		struct sigaction Action = {};
+		Action.sa_handler = LinuxCaptureHandler;
+		Action.sa_flags = SA_RESTART;
+		sigemptyset(&Action.sa_mask);
+		if (sigaction(SIGPROF, &Action, nullptr) != 0)
+		{
+			LogError("Could not install the SIGPROF handler: %s", GetLastErrorMessage());
+			return false;
+		}
+		CaptureHandlerInstalled = true;
+	}
+
+	OutThread->Handle = (void *)(u64)syscall(SYS_gettid);
+	return true;
+}
+
+void Platform::SampledThreadClose(PlatformSampledThread *Thread)
+{
+	Thread->Handle = nullptr;
+}
+
+// NOTE: The thread captures its own stack in the SIGPROF handler, no need to
+// stop it from here. Sleeping or blocked threads run the handler too, their
+// call is restarted (SA_RESTART) or returns EINTR, which the platform
+// layer retries.
+u32 Platform::CaptureThreadStack(PlatformSampledThread *Thread, u64 *OutFrames, u32 MaxFrames)
+{
+	u64 Request = CaptureRequest + 1;
+	CaptureThread = (pid_t)(u64)Thread->Handle;
+	AtomicStoreRelease64(&CaptureRequest, Request);
+	if (syscall(SYS_tgkill, getpid(), CaptureThread, SIGPROF) != 0)
+	{
+		return 0;
+	}
+
+	u64 Start = Clock::Now();
+	while (AtomicLoadAcquire64(&CaptureDone) != Request)
+	{
+		if (Clock::TicksToMS(Clock::Now() - Start) > LINUX_CAPTURE_TIMEOUT_MS)
+		{
+			return 0;
+		}
+		CpuPause();
+	}
+
+	u32 FrameCount = Min((u32)CaptureCount, MaxFrames);
+	for (u32 Idx = 0; Idx < FrameCount; ++Idx)
+	{
+		OutFrames[Idx] = CaptureFrames[Idx];
+	}
+	return FrameCount;
+}
+
+// NOTE: dladdr only knows the symbols in the dynamic table, executables
+// have to be linked with -rdynamic for their functions to show up.
+// Whatever has no name is reported as module+offset.
+b8 Platform::SymbolizeAddress(u64 Address, char *OutName, u32 NameSize)
+{
+	Dl_info Info;
+	if (!dladdr((void *)Address, &Info))
+	{
+		return false;
+	}
+
+	if (!Info.dli_sname)
+	{
+		if (!Info.dli_fname)
+		{
+			return false;
+		}
+		const char *Module = strrchr(Info.dli_fname, '/');
+		snprintf(OutName, NameSize, "%s+0x%llx", Module ? Module + 1 : Info.dli_fname,
+				 Address - (u64)Info.dli_fbase);
+		return true;
+	}
+
+	int Status;
+	char *Demangled = abi::__cxa_demangle(Info.dli_sname, nullptr, nullptr, &Status);
+	snprintf(OutName, NameSize, "%s", Demangled ? Demangled : Info.dli_sname);
+	free(Demangled);
+	return true;
+}
+
+local_var const u64 PerfCounterConfigs[PerfCounter_Count] = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_MISSES,
+	PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+// NOTE: All the counters of a thread are a group, read at once and always
+// scheduled on the PMU together, so the ratios between them are consistent.
+// Fails without a PMU (most VMs) or with perf_event_paranoid too high.
+b8 Platform::PerfCountersOpen(PlatformPerfCounters *OutCounters)
+{
+	OutCounters->Opened = false;
+
+	for (u32 Idx = 0; Idx < PerfCounter_Count; ++Idx)
+	{
+		perf_event_attr Attributes = {};
+		Attributes.size = sizeof(Attributes);
+		Attributes.type = PERF_TYPE_HARDWARE;
+		Attributes.config = PerfCounterConfigs[Idx];
+		Attributes.disabled = Idx == 0;
+		Attributes.exclude_kernel = 1;
+		Attributes.exclude_hv = 1;
+		Attributes.read_format = PERF_FORMAT_GROUP;
+
+		int Leader = Idx ? OutCounters->Handles[0] : -1;
+		OutCounters->Handles[Idx] = (int)syscall(SYS_perf_event_open, &Attributes, 0, -1, Leader, PERF_FLAG_FD_CLOEXEC);
+		if (OutCounters->Handles[Idx] < 0)
+		{
+			for (u32 Opened = 0; Opened < Idx; ++Opened)
+			{
+				close(OutCounters->Handles[Opened]);
+			}
+			return false;
+		}
+	}
+	ioctl(OutCounters->Handles[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+	OutCounters->Opened = true;
+	return true;
+}
+
+void Platform::PerfCountersClose(PlatformPerfCounters *Counters)
+{
+	if (Counters->Opened)
+	{
+		for (u32 Idx = 0; Idx < PerfCounter_Count; ++Idx)
+		{
+			close(Counters->Handles[Idx]);
+		}
+		Counters->Opened = false;
+	}
+}
+
+void Platform::PerfCountersRead(PlatformPerfCounters *Counters, u64 *OutValues)
+{
+	// NOTE: PERF_FORMAT_GROUP gives the number of counters, then their values
+	u64 Values[1 + PerfCounter_Count] = {};
+	if (!Counters->Opened || read(Counters->Handles[0], Values, sizeof(Values)) != (ssize_t)sizeof(Values))
+	{
+		MemSystem::Zero(Values, sizeof(Values));
+	}
+
+	for (u32 Idx = 0; Idx < PerfCounter_Count; ++Idx)
+	{
+		OutValues[Idx] = Values[1 + Idx];
+	}
+}
+
+/*
+NOTE: PlatformRWLock is a single pointer, zero initialized, so pthread's
+lock doesn't fit: this is a futex based one in its low 32 bits.
+The readers are counted in the low bits, a writer holds the top one.
+Whoever has to wait sets the waiters bit and sleeps on the value it saw,
+the last one out clears it and wakes everybody up, they race again.
+The engine locks are short and rarely contended, that's good enough.
+*/
+#define RW_LOCK_WRITER (1u << 31)
+#define RW_LOCK_WAITERS (1u << 30)
+#define RW_LOCK_READERS (RW_LOCK_WAITERS - 1)
+
+StaticAssertMsg(sizeof(PlatformRWLock) >= sizeof(u32), "PlatformRWLock can't hold the futex");
+
+internal_func void RWLockWait(volatile u32 *State, u32 Expected)
+{
+	// NOTE: Only sleeps if the state is still the one we saw
+	if (__atomic_compare_exchange_n(State, &Expected, Expected | RW_LOCK_WAITERS, false, __ATOMIC_ACQUIRE,
+									__ATOMIC_ACQUIRE) ||
+		Expected == (Expected | RW_LOCK_WAITERS))
+	{
+		syscall(SYS_futex, State, FUTEX_WAIT_PRIVATE, Expected | RW_LOCK_WAITERS, nullptr, nullptr, 0);
+	}
+}
+
+internal_func void RWLockWakeAll(volatile u32 *State)
+{
+	syscall(SYS_futex, State, FUTEX_WAKE_PRIVATE, 0x7FFFFFFF, nullptr, nullptr, 0);
+}
+
+void Platform::LockShared(PlatformRWLock *Lock)
+{
+	volatile u32 *State = (volatile u32 *)Lock;
+	for (;;)
+	{
+		u32 Current = __atomic_load_n(State, __ATOMIC_RELAXED);
+		if (!(Current & RW_LOCK_WRITER))
+		{
+			if (__atomic_compare_exchange_n(State, &Current, Current + 1, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			{
+				return;
+			}
+			continue;
+		}
+		RWLockWait(State, Current);
+	}
+}
+
+void Platform::UnlockShared(PlatformRWLock *Lock)
+{
+	volatile u32 *State = (volatile u32 *)Lock;
+	u32 Current = __atomic_sub_fetch(State, 1, __ATOMIC_RELEASE);
+	if (Current == RW_LOCK_WAITERS &&
+		__atomic_compare_exchange_n(State, &Current, 0, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+	{
+		RWLockWakeAll(State);
+	}
+}
+
+void Platform::LockExclusive(PlatformRWLock *Lock)
+{
+	volatile u32 *State = (volatile u32 *)Lock;
+	for (;;)
+	{
+		u32 Current = __atomic_load_n(State, __ATOMIC_RELAXED);
+		if (!(Current & (RW_LOCK_WRITER | RW_LOCK_READERS)))
+		{
+			if (__atomic_compare_exchange_n(State, &Current, Current | RW_LOCK_WRITER, true, __ATOMIC_ACQUIRE,
+											__ATOMIC_RELAXED))
+			{
+				return;
+			}
+			continue;
+		}
+		RWLockWait(State, Current);
+	}
+}
+
+void Platform::UnlockExclusive(PlatformRWLock *Lock)
+{
+	volatile u32 *State = (volatile u32 *)Lock;
+	if (__atomic_exchange_n(State, 0, __ATOMIC_RELEASE) & RW_LOCK_WAITERS)
+	{
+		RWLockWakeAll(State);
+	}
+}
+
+#endif // KIWI_LINUX
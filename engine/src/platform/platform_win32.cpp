@@ -6,13 +6,21 @@
 #include "core/input.h"
 #include "core/event.h"
 #include "core/kiwi_mem.h"
+#include "core/clock.h"
 
 #include <windows.h>
 #include <windowsx.h>
+#include <dbghelp.h>
 #include <stdlib.h>
 #include <stdio.h>
 
 #define SCHEDULER_GRANULARITY 1
+#define MAX_SYMBOL_NAME_LENGTH 512
+
+// NOTE: Windows 10 1803 and later, missing from older SDKs
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
 
 struct InternalState
 {
@@ -20,8 +28,10 @@ struct InternalState
 	HWND WindowHandle;
 };
 
-local_var f64 ClockFrequency;
-local_var LARGE_INTEGER StartTime;
+// NOTE: One per thread, the waits on a waitable timer can't be shared
+local_var thread_local HANDLE PreciseSleepTimer = nullptr;
+local_var b8 SymbolsLoaded = false;
+local_var b8 SymbolsFailed = false;
 
 LRESULT CALLBACK
 Win32ProcessMessage(HWND WindowHandle, u32 Message, WPARAM WParam, LPARAM LParam);
@@ -76,11 +86,6 @@ b8 Platform::Startup(PlatformState *PlatState, const char *ApplicationName,
 		return false;
 	}
 
-	LARGE_INTEGER Frequency;
-	QueryPerformanceFrequency(&Frequency);
-	ClockFrequency = 1.0 / (f64)Frequency.QuadPart;
-	QueryPerformanceCounter(&StartTime);
-
 	// NOTE: Set the Windows scheduler granularity to 1 ms
 	// so that Sleep() can be more granular.
 	// Returns TIMERR_NOCANDO if it fails
@@ -93,11 +98,36 @@ b8 Platform::Startup(PlatformState *PlatState, const char *ApplicationName,
 	return true;
 }
 
+b8 Platform::StartupHeadless(PlatformState *PlatState)
+{
+	// TODO: Replace malloc
+	PlatState->InternalState = malloc(sizeof(InternalState));
+	InternalState *State = (InternalState *)PlatState->InternalState;
+
+	State->InstanceHandle = GetModuleHandleA(0);
+	State->WindowHandle = 0;
+
+	// NOTE: Same Sleep() granularity as the windowed runs
+	if (timeBeginPeriod(SCHEDULER_GRANULARITY) != TIMERR_NOERROR)
+	{
+		LogFatal("Could not set the scheduler granularity");
+		return false;
+	}
+
+	return true;
+}
+
 void Platform::Terminate(PlatformState *PlatState)
 {
 	// NOTE: Reset the scheduler granlarity
 	timeEndPeriod(SCHEDULER_GRANULARITY);
 
+	if (SymbolsLoaded)
+	{
+		SymCleanup(GetCurrentProcess());
+		SymbolsLoaded = false;
+	}
+
 	InternalState *State = (InternalState *)PlatState->InternalState;
 
 	if (State->WindowHandle)
@@ -285,7 +315,7 @@ void Platform::ZeroMem(void *Address, u64 Size)
 	memset(Address, 0, Size);
 }
 
-void Platform::CopyMem(void *Source, void *Dest, u64 Size)
+void Platform::CopyMem(void *Dest, void *Source, u64 Size)
 {
 	// TODO: Use platform specific function
 	memcpy(Dest, Source, Size);
@@ -331,12 +361,24 @@ void Platform::ConsoleWriteError(const char *Message, u8 Level)
 	WriteConsoleA(ConsoleHandle, Message, (DWORD)Length, WrittenLen, 0);
 }
 
-f64 Platform::GetAbsoluteTime()
+u64 Platform::GetTicks()
 {
-	// TODO: rework all the time stuff to be able to work with f32 safely
 	LARGE_INTEGER Now;
 	QueryPerformanceCounter(&Now);
-	return (f64)Now.QuadPart * ClockFrequency;
+	return (u64)Now.QuadPart;
+}
+
+u64 Platform::GetTickFrequency()
+{
+	// NOTE: Fixed at boot, it can be read at any time
+	LARGE_INTEGER Frequency;
+	QueryPerformanceFrequency(&Frequency);
+	return (u64)Frequency.QuadPart;
+}
+
+f64 Platform::GetAbsoluteTime()
+{
+	return Clock::GetSeconds();
 }
 
 void Platform::SleepMS(u64 ms)
@@ -344,6 +386,389 @@ void Platform::SleepMS(u64 ms)
 	Sleep((DWORD)ms);
 }
 
+void Platform::SleepPrecise(f64 Seconds)
+{
+	if (Seconds <= 0.0)
+	{
+		return;
+	}
+
+	if (!PreciseSleepTimer)
+	{
+		PreciseSleepTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		if (!PreciseSleepTimer)
+		{
+			// NOTE: Older Windows, this one is as precise as the scheduler granularity
+			PreciseSleepTimer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+		}
+	}
+
+	// NOTE: Negative means relative, in 100ns units
+	LARGE_INTEGER DueTime;
+	DueTime.QuadPart = -(LONGLONG)(Seconds * 10000000.0);
+	if (PreciseSleepTimer && SetWaitableTimer(PreciseSleepTimer, &DueTime, 0, nullptr, nullptr, FALSE))
+	{
+		WaitForSingleObject(PreciseSleepTimer, INFINITE);
+	}
+	else
+	{
+		Sleep((DWORD)(Seconds * 1000.0));
+	}
+}
+
+void Platform::YieldThread()
+{
+	SwitchToThread();
+}
+
+b8 Platform::FileOpen(PlatformFile *OutFile, const char *Path, FileMode Mode)
+{
+	DWORD Access = GENERIC_READ;
+	DWORD Creation = OPEN_EXISTING;
+	if (Mode == FileMode_Write)
+	{
+		Access = GENERIC_WRITE;
+		Creation = CREATE_ALWAYS;
+	}
+	else if (Mode == FileMode_Append)
+	{
+		Access = FILE_APPEND_DATA;
+		Creation = OPEN_ALWAYS;
+	}
+
+	HANDLE Handle = CreateFileA(Path, Access, FILE_SHARE_READ, 0, Creation, FILE_ATTRIBUTE_NORMAL, 0);
+	if (Handle == INVALID_HANDLE_VALUE)
+	{
+		LogError("Could not open file %s: %s", Path, GetLastErrorMessage());
+		OutFile->Handle = nullptr;
+		return false;
+	}
+
+	OutFile->Handle = Handle;
+	return true;
+}
+
+void Platform::FileClose(PlatformFile *File)
+{
+	if (File->Handle)
+	{
+		CloseHandle((HANDLE)File->Handle);
+		File->Handle = nullptr;
+	}
+}
+
+b8 Platform::FileWrite(PlatformFile *File, const void *Data, u64 Size)
+{
+	// NOTE: WriteFile takes a DWORD, big buffers are written in pieces
+	const u8 *Source = (const u8 *)Data;
+	while (Size)
+	{
+		DWORD ToWrite = (DWORD)Min(Size, (u64)0x40000000);
+		DWORD Written = 0;
+		if (!WriteFile((HANDLE)File->Handle, Source, ToWrite, &Written, 0) || Written != ToWrite)
+		{
+			return false;
+		}
+		Source += Written;
+		Size -= Written;
+	}
+	return true;
+}
+
+u64 Platform::FileRead(PlatformFile *File, void *Dest, u64 Size)
+{
+	u8 *Target = (u8 *)Dest;
+	u64 TotalRead = 0;
+	while (TotalRead < Size)
+	{
+		DWORD ToRead = (DWORD)Min(Size - TotalRead, (u64)0x40000000);
+		DWORD Read = 0;
+		if (!ReadFile((HANDLE)File->Handle, Target + TotalRead, ToRead, &Read, 0) || Read == 0)
+		{
+			break;
+		}
+		TotalRead += Read;
+	}
+	return TotalRead;
+}
+
+u64 Platform::FileSize(PlatformFile *File)
+{
+	LARGE_INTEGER Size;
+	if (!GetFileSizeEx((HANDLE)File->Handle, &Size))
+	{
+		return 0;
+	}
+	return (u64)Size.QuadPart;
+}
+
+b8 Platform::FileMove(const char *From, const char *To)
+{
+	return MoveFileExA(From, To, MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+b8 Platform::FileDelete(const char *Path)
+{
+	return DeleteFileA(Path) != 0;
+}
+
+b8 Platform::FileMapOpen(PlatformFileMapping *OutMapping, const char *Path, u64 Size)
+{
+	*OutMapping = {};
+
+	HANDLE File = CreateFileA(Path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, 0, OPEN_ALWAYS,
+							  FILE_ATTRIBUTE_NORMAL, 0);
+	if (File == INVALID_HANDLE_VALUE)
+	{
+		LogError("Could not open file %s: %s", Path, GetLastErrorMessage());
+		return false;
+	}
+
+	// NOTE: The mapping sets the size of the file
+	HANDLE Mapping = CreateFileMappingA(File, 0, PAGE_READWRITE, (DWORD)(Size >> 32), (DWORD)Size, 0);
+	if (!Mapping)
+	{
+		LogError("Could not create a mapping of %s: %s", Path, GetLastErrorMessage());
+		CloseHandle(File);
+		return false;
+	}
+
+	void *Memory = MapViewOfFile(Mapping, FILE_MAP_ALL_ACCESS, 0, 0, Size);
+	if (!Memory)
+	{
+		LogError("Could not map %s: %s", Path, GetLastErrorMessage());
+		CloseHandle(Mapping);
+		CloseHandle(File);
+		return false;
+	}
+
+	OutMapping->File = File;
+	OutMapping->Mapping = Mapping;
+	OutMapping->Memory = Memory;
+	OutMapping->Size = Size;
+	return true;
+}
+
+void Platform::FileMapClose(PlatformFileMapping *Mapping)
+{
+	if (!Mapping->Memory)
+	{
+		return;
+	}
+
+	UnmapViewOfFile(Mapping->Memory);
+	CloseHandle((HANDLE)Mapping->Mapping);
+	CloseHandle((HANDLE)Mapping->File);
+	*Mapping = {};
+}
+
+b8 Platform::ThreadCreate(PlatformThread *OutThread, thread_proc *Proc, void *Param)
+{
+	// NOTE: thread_proc has the same signature as a ThreadProc, x64 has a single calling convention
+	HANDLE Handle = CreateThread(0, 0, (LPTHREAD_START_ROUTINE)Proc, Param, 0, 0);
+	if (!Handle)
+	{
+		LogError("Could not create a thread: %s", GetLastErrorMessage());
+		OutThread->Handle = nullptr;
+		return false;
+	}
+
+	OutThread->Handle = Handle;
+	return true;
+}
+
+void Platform::ThreadJoin(PlatformThread *Thread)
+{
+	if (Thread->Handle)
+	{
+		WaitForSingleObject((HANDLE)Thread->Handle, INFINITE);
+		CloseHandle((HANDLE)Thread->Handle);
+		Thread->Handle = nullptr;
+	}
+}
+
+u32 Platform::GetThreadId()
+{
+	return (u32)GetCurrentThreadId();
+}
+
+b8 Platform::SemaphoreCreate(PlatformSemaphore *OutSemaphore, u32 InitialCount)
+{
+	OutSemaphore->Handle = CreateSemaphoreA(0, (LONG)InitialCount, 0x7FFFFFFF, 0);
+	return OutSemaphore->Handle != nullptr;
+}
+
+void Platform::SemaphoreDestroy(PlatformSemaphore *Semaphore)
+{
+	if (Semaphore->Handle)
+	{
+		CloseHandle((HANDLE)Semaphore->Handle);
+		Semaphore->Handle = nullptr;
+	}
+}
+
+void Platform::SemaphoreSignal(PlatformSemaphore *Semaphore)
+{
+	ReleaseSemaphore((HANDLE)Semaphore->Handle, 1, 0);
+}
+
+b8 Platform::SemaphoreWait(PlatformSemaphore *Semaphore, u32 TimeoutMS)
+{
+	return WaitForSingleObject((HANDLE)Semaphore->Handle, TimeoutMS) == WAIT_OBJECT_0;
+}
+
+b8 Platform::SampledThreadOpen(PlatformSampledThread *OutThread)
+{
+	OutThread->Handle = OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION,
+								   FALSE, GetCurrentThreadId());
+	if (!OutThread->Handle)
+	{
+		LogError("Could not open the thread to sample: %s", GetLastErrorMessage());
+		return false;
+	}
+	return true;
+}
+
+void Platform::SampledThreadClose(PlatformSampledThread *Thread)
+{
+	if (Thread->Handle)
+	{
+		CloseHandle((HANDLE)Thread->Handle);
+		Thread->Handle = nullptr;
+	}
+}
+
+// NOTE: The thread is stopped anywhere, possibly holding the heap or the
+// logger lock: nothing between the suspend and the resume can allocate or
+// log. The unwind reads the stack through the unwind info of the modules,
+// a frame without it (a leaf function) has the return address on top.
+// Garbage on the stack can send the walk outside of it, hence the __try.
+u32 Platform::CaptureThreadStack(PlatformSampledThread *Thread, u64 *OutFrames, u32 MaxFrames)
+{
+	HANDLE Handle = (HANDLE)Thread->Handle;
+	if (SuspendThread(Handle) == (DWORD)-1)
+	{
+		return 0;
+	}
+
+	// NOTE: GetThreadContext also waits for the suspension to actually happen
+	u32 FrameCount = 0;
+	CONTEXT Context;
+	Context.ContextFlags = CONTEXT_CONTROL | CONTEXT_INTEGER;
+	if (GetThreadContext(Handle, &Context))
+	{
+		__try
+		{
+			while (FrameCount < MaxFrames && Context.Rip)
+			{
+				OutFrames[FrameCount++] = Context.Rip;
+
+				DWORD64 ImageBase;
+				PRUNTIME_FUNCTION Function = RtlLookupFunctionEntry(Context.Rip, &ImageBase, nullptr);
+				if (Function)
+				{
+					void *HandlerData;
+					DWORD64 EstablisherFrame;
+					RtlVirtualUnwind(UNW_FLAG_NHANDLER, ImageBase, Context.Rip, Function, &Context,
+									 &HandlerData, &EstablisherFrame, nullptr);
+				}
+				else
+				{
+					Context.Rip = *(DWORD64 *)Context.Rsp;
+					Context.Rsp += sizeof(DWORD64);
+				}
+			}
+		}
+		__except (EXCEPTION_EXECUTE_HANDLER)
+		{
+		}
+	}
+
+	ResumeThread(Handle);
+	return FrameCount;
+}
+
+b8 Platform::SymbolizeAddress(u64 Address, char *OutName, u32 NameSize)
+{
+	HANDLE Process = GetCurrentProcess();
+	if (!SymbolsLoaded)
+	{
+		if (SymbolsFailed)
+		{
+			return false;
+		}
+
+		SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS);
+		if (!SymInitialize(Process, nullptr, TRUE))
+		{
+			LogError("Could not load the symbols: %s", GetLastErrorMessage());
+			SymbolsFailed = true;
+			return false;
+		}
+		SymbolsLoaded = true;
+	}
+
+	u64 Buffer[(sizeof(SYMBOL_INFO) + MAX_SYMBOL_NAME_LENGTH + sizeof(u64) - 1) / sizeof(u64)];
+	SYMBOL_INFO *Symbol = (SYMBOL_INFO *)Buffer;
+	Symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+	Symbol->MaxNameLen = MAX_SYMBOL_NAME_LENGTH;
+	DWORD64 Displacement;
+	if (!SymFromAddr(Process, Address, &Displacement, Symbol))
+	{
+		return false;
+	}
+
+	snprintf(OutName, NameSize, "%s", Symbol->Name);
+	return true;
+}
+
+// NOTE: User mode has no access to the PMU on Windows, it takes a kernel
+// driver (or ETW with admin rights, and only for sampling). Nothing to open.
+SUPPRESS_WARNING(4100)
+b8 Platform::PerfCountersOpen(PlatformPerfCounters *OutCounters)
+{
+	OutCounters->Opened = false;
+	return false;
+}
+
+SUPPRESS_WARNING(4100)
+void Platform::PerfCountersClose(PlatformPerfCounters *Counters)
+{
+}
+
+SUPPRESS_WARNING(4100)
+void Platform::PerfCountersRead(PlatformPerfCounters *Counters, u64 *OutValues)
+{
+	for (u32 Idx = 0; Idx < PerfCounter_Count; ++Idx)
+	{
+		OutValues[Idx] = 0;
+	}
+}
+
+// NOTE: PlatformRWLock is laid out exactly like an SRWLOCK (a single pointer)
+// and SRWLOCK_INIT is all zeros, so no initialization call is needed
+StaticAssertMsg(sizeof(PlatformRWLock) == sizeof(SRWLOCK), "PlatformRWLock doesn't match SRWLOCK");
+
+void Platform::LockShared(PlatformRWLock *Lock)
+{
+	AcquireSRWLockShared((PSRWLOCK)Lock);
+}
+
+void Platform::UnlockShared(PlatformRWLock *Lock)
+{
+	ReleaseSRWLockShared((PSRWLOCK)Lock);
+}
+
+void Platform::LockExclusive(PlatformRWLock *Lock)
+{
+	AcquireSRWLockExclusive((PSRWLOCK)Lock);
+}
+
+void Platform::UnlockExclusive(PlatformRWLock *Lock)
+{
+	ReleaseSRWLockExclusive((PSRWLOCK)Lock);
+}
+
 LRESULT CALLBACK
 Win32ProcessMessage(HWND WindowHandle, u32 Message, WPARAM WParam, LPARAM LParam)
 {
@@ -359,7 +784,7 @@ Win32ProcessMessage(HWND WindowHandle, u32 Message, WPARAM WParam, LPARAM LParam
 	}
 	case WM_CLOSE:
 	{
-		EventSystem::Fire(SEC_ApplicationQuit, nullptr, {});
+		EventSystem::Post(SEC_ApplicationQuit, nullptr, {});
 		break;
 	}
 	case WM_DESTROY:
@@ -378,7 +803,8 @@ Win32ProcessMessage(HWND WindowHandle, u32 Message, WPARAM WParam, LPARAM LParam
 		EventContext Context = {};
 		Context.u16[0] = (u16)Width;
 		Context.u16[1] = (u16)Height;
-		EventSystem::Fire(SEC_Resized, nullptr, Context);
+		// NOTE: Posted, a resize drag sends a lot of these and only the last one matters
+		EventSystem::Post(SEC_Resized, nullptr, Context);
 		break;
 	}
 	case WM_KEYDOWN:
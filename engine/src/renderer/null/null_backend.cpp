@@ -0,0 +1,32 @@
+#include "null_backend.h"
+#include "core/logger.h"
+#include "core/metrics.h"
+
+SUPPRESS_WARNING(4100)
+b8 NullRenderer::Initialize(const char *ApplicationName, u32 Width, u32 Height)
+{
+	LogChannelInfo(Renderer, "Null renderer backend initialized, nothing will be drawn");
+	return true;
+}
+
+void NullRenderer::Terminate()
+{
+}
+
+SUPPRESS_WARNING(4100)
+void NullRenderer::Resized(u16 Width, u16 Height)
+{
+	Metrics::Add(Metric_FramebufferResizes, 1);
+}
+
+SUPPRESS_WARNING(4100)
+b8 NullRenderer::BeginFrame(f32 DeltaTime)
+{
+	return true;
+}
+
+SUPPRESS_WARNING(4100)
+b8 NullRenderer::EndFrame(f32 DeltaTime)
+{
+	return true;
+}
\ No newline at end of file
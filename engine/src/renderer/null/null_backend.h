@@ -0,0 +1,19 @@
+#pragma once
+
+#include "renderer/renderer_backend.h"
+
+// NOTE: Draws nothing, for the headless runs (see ApplicationConfig::Headless).
+// It needs no window and no GPU, the frames only go through the frontend
+class NullRenderer : public RendererBackend
+{
+public:
+	b8 Initialize(const char *ApplicationName, u32 Width, u32 Height) override;
+
+	void Terminate() override;
+
+	void Resized(u16 Width, u16 Height) override;
+
+	b8 BeginFrame(f32 DeltaTime) override;
+
+	b8 EndFrame(f32 DeltaTime) override;
+};
\ No newline at end of file
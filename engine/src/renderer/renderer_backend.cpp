@@ -1,11 +1,18 @@
 #include "renderer_backend.h"
-#include "renderer/vulkan/vulkan_backend.h"
+#include "renderer/null/null_backend.h"
+#include "core/logger.h"
 #include "core/kiwi_mem.h"
 #include <new>
 
+// NOTE: The Vulkan backend only knows how to make a Win32 surface so far
+#ifdef KIWI_WIN
+#include "renderer/vulkan/vulkan_backend.h"
+#endif
+
 b8 RendererBackend::Create(RendererBackendType Type, PlatformState *PlatState, const char *ApplicationName,
 						   u32 Width, u32 Height, RendererBackend **OutRendererBackend)
 {
+#ifdef KIWI_WIN
 	if (Type == RendererBackendType_Vulkan)
 	{
 		// NOTE: placement new required to populate the __vfptr
@@ -13,10 +20,19 @@ b8 RendererBackend::Create(RendererBackendType Type, PlatformState *PlatState, c
 		*OutRendererBackend = new (Memory) VulkanRenderer(); // TODO: This is done in order for the VTABLE to be populated
 	}
 	else
+#endif
+	if (Type == RendererBackendType_Null)
+	{
+		void *Memory = MemSystem::GetArena(MemTag_Renderer)->Push(sizeof(NullRenderer));
+		*OutRendererBackend = new (Memory) NullRenderer();
+	}
+	else
 	{
 		// TODO: Direct3D one day? Who knows...
-		LogFatal("Renderer backend type not supported");
+		LogChannelFatal(Renderer, "Renderer backend type not supported");
 		KDebugBreak();
+		*OutRendererBackend = nullptr;
+		return false;
 	}
 
 	RendererBackend *NewBackend = *OutRendererBackend;
@@ -35,7 +51,7 @@ b8 RendererBackend::Create(RendererBackendType Type, PlatformState *PlatState, c
 
 void RendererBackend::Destroy(RendererBackend *RendererBackend)
 {
-	if (RendererBackend->Type == RendererBackendType_Vulkan)
+	if (RendererBackend)
 	{
 		RendererBackend->Terminate();
 		RendererBackend->Arena->Clear();
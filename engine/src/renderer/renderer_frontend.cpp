@@ -2,18 +2,19 @@
 
 #include "renderer_frontend.h"
 #include "core/logger.h"
+#include "core/metrics.h"
 
 RendererBackend *Renderer::Backend = nullptr;
 
-b8 Renderer::Initialize(const char *ApplicationName, u32 Width, u32 Height, PlatformState *PlatState)
+b8 Renderer::Initialize(RendererBackendType Type, const char *ApplicationName, u32 Width, u32 Height,
+						PlatformState *PlatState)
 {
-	// TODO: Vulkan type is hardcoded
-	if (RendererBackend::Create(RendererBackendType_Vulkan, PlatState, ApplicationName, Width, Height, &Backend))
+	if (RendererBackend::Create(Type, PlatState, ApplicationName, Width, Height, &Backend))
 	{
 		return true;
 	}
 
-	LogFatal("Could not create the renderer backend");
+	LogChannelFatal(Renderer, "Could not create the renderer backend");
 	return false;
 }
 
@@ -30,7 +31,7 @@ void Renderer::OnResized(u16 Width, u16 Height)
 	}
 	else
 	{
-		LogWarning("Renderer backend does not exist and cannot be resized");
+		LogChannelWarning(Renderer, "Renderer backend does not exist and cannot be resized");
 	}
 }
 
@@ -40,13 +41,14 @@ b8 Renderer::DrawFrame(RenderPacket *Packet)
 	if (Backend->BeginFrame(Packet->DeltaTime))
 	{
 		Backend->FrameCount++;
+		Metrics::Add(Metric_RendererFrames, 1);
 
 		// TODO: mid-frame operations
 
 		// NOTE: we cannot recover from EndFrame failure
 		if (!Backend->EndFrame(Packet->DeltaTime))
 		{
-			LogFatal("Renderer backend EndFrame() failed. Shutting down.");
+			LogChannelFatal(Renderer, "Renderer backend EndFrame() failed. Shutting down.");
 			return false;
 		}
 	}
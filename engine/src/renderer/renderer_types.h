@@ -9,7 +9,9 @@ enum RendererBackendType
 {
 	RendererBackendType_Vulkan,
 	RendererBackendType_DirectX,
-	RendererBackendType_OpenGL
+	RendererBackendType_OpenGL,
+	// NOTE: No output at all, for the headless runs
+	RendererBackendType_Null
 };
 
 struct RenderPacket
@@ -2,8 +2,10 @@
 #include "vulkan_platform.h"
 #include "vulkan_device.h"
 #include "core/logger.h"
-#include "core/kiwi_string.h"
+#include "core/metrics.h"
+#include "core/string_interner.h"
 #include "containers/karray.h"
+#include "containers/kbitset.h"
 
 VulkanContext VulkanRenderer::Context = {};
 
@@ -33,19 +35,19 @@ b8 VulkanRenderer::Initialize(const char *ApplicationName, u32 Width, u32 Height
 #ifdef KIWI_SLOW
 	Extensions.Push(VK_EXT_DEBUG_UTILS_EXTENSION_NAME); // debug utils
 
-	LogDebug("--- Vulkan Required Extensions:");
+	LogChannelDebug(Vulkan, "--- Vulkan Required Extensions:");
 	for (u32 i = 0; i < Extensions.Length; ++i)
 	{
-		LogDebug(Extensions[i]);
+		LogChannelDebug(Vulkan, Extensions[i]);
 	}
-	LogDebug("");
+	LogChannelDebug(Vulkan, "");
 #endif
 
 	// Obtain the list of required validation layers
 	KArray<const char *> RequiredLayers;
 	RequiredLayers.Create(ScratchArenaHandle.Arena);
 #ifdef KIWI_SLOW
-	LogDebug("--- Vulkan validation layers enabled. Enumerating...");
+	LogChannelDebug(Vulkan, "--- Vulkan validation layers enabled. Enumerating...");
 
 	RequiredLayers.Push("VK_LAYER_KHRONOS_validation");
 
@@ -55,28 +57,46 @@ b8 VulkanRenderer::Initialize(const char *ApplicationName, u32 Width, u32 Height
 	AvailableLayers.Create(ScratchArenaHandle.Arena, AvailableLayersCount, AvailableLayersCount);
 	VK_CHECK(vkEnumerateInstanceLayerProperties(&AvailableLayersCount, AvailableLayers.Elements));
 
+	// NOTE: The required names are interned once, then every available layer
+	// is hashed and looked up a single time. Matching is an id compare, not a strcmp
+	KArray<KStrId> RequiredLayerIds;
+	RequiredLayerIds.Create(ScratchArenaHandle.Arena, RequiredLayers.Length, RequiredLayers.Length);
 	for (u32 RequiredIndex = 0; RequiredIndex < RequiredLayers.Length; ++RequiredIndex)
 	{
-		b8 Found = false;
-		for (u32 AvailableIndex = 0; AvailableIndex < AvailableLayers.Length; ++AvailableIndex)
+		RequiredLayerIds[RequiredIndex] = StringInterner::Intern(RequiredLayers[RequiredIndex]);
+	}
+
+	KBitArray Found;
+	Found.Create(ScratchArenaHandle.Arena, RequiredLayerIds.Length);
+	for (u32 AvailableIndex = 0; AvailableIndex < AvailableLayers.Length; ++AvailableIndex)
+	{
+		KStrId AvailableId = StringInterner::Find(AvailableLayers[AvailableIndex].layerName);
+		if (!AvailableId.IsValid())
 		{
-			if (KStr::Equal(RequiredLayers[RequiredIndex], AvailableLayers[AvailableIndex].layerName))
+			continue;
+		}
+
+		for (u32 RequiredIndex = 0; RequiredIndex < RequiredLayerIds.Length; ++RequiredIndex)
+		{
+			if (AvailableId == RequiredLayerIds[RequiredIndex])
 			{
-				Found = true;
-				LogDebug("%s found", RequiredLayers[RequiredIndex]);
-				break;
+				Found.Set(RequiredIndex);
+				LogChannelDebug(Vulkan, "%s found", RequiredLayers[RequiredIndex]);
 			}
 		}
+	}
 
-		if (!Found)
+	for (u32 RequiredIndex = 0; RequiredIndex < RequiredLayers.Length; ++RequiredIndex)
+	{
+		if (!Found.Test(RequiredIndex))
 		{
-			LogFatal("Required validation layer is missing: %s", RequiredLayers[RequiredIndex]);
+			LogChannelFatal(Vulkan, "Required validation layer is missing: %s", RequiredLayers[RequiredIndex]);
 			return false;
 		}
 	}
 
-	LogDebug("Found all validation layers required");
-	LogDebug("");
+	LogChannelDebug(Vulkan, "Found all validation layers required");
+	LogChannelDebug(Vulkan, "");
 #endif
 
 	VkInstanceCreateInfo InstanceCreateInfo = {};
@@ -88,15 +108,15 @@ b8 VulkanRenderer::Initialize(const char *ApplicationName, u32 Width, u32 Height
 	InstanceCreateInfo.ppEnabledExtensionNames = Extensions.Elements;
 
 	VK_CHECK(vkCreateInstance(&InstanceCreateInfo, Context.Allocator, &Context.Instance));
-	LogInfo("Vulkan Instance created");
+	LogChannelInfo(Vulkan, "Vulkan Instance created");
 
 	u32 InstanceVersion;
 	VK_CHECK(vkEnumerateInstanceVersion(&InstanceVersion));
-	LogInfo("Instance Version: %d.%d.%d", VK_API_VERSION_MAJOR(InstanceVersion),
+	LogChannelInfo(Vulkan, "Instance Version: %d.%d.%d", VK_API_VERSION_MAJOR(InstanceVersion),
 			VK_API_VERSION_MINOR(InstanceVersion), VK_API_VERSION_PATCH(InstanceVersion));
 
 #ifdef KIWI_SLOW
-	LogDebug("--- Creating Vulkan Debugger");
+	LogChannelDebug(Vulkan, "--- Creating Vulkan Debugger");
 
 	VkDebugUtilsMessengerCreateInfoEXT DebugMessengerInfo = {};
 	DebugMessengerInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
@@ -119,19 +139,19 @@ b8 VulkanRenderer::Initialize(const char *ApplicationName, u32 Width, u32 Height
 	VK_CHECK(CreateDebuggerFunc(Context.Instance, &DebugMessengerInfo,
 								Context.Allocator, &Context.DebugMessenger));
 
-	LogDebug("Vulkan Debugger successfully created");
+	LogChannelDebug(Vulkan, "Vulkan Debugger successfully created");
 
 #endif
 
 	if (!VulkanPlatform::CreateSurface(PlatState, &Context))
 	{
-		LogFatal("Could not create Vulkan surface");
+		LogChannelFatal(Vulkan, "Could not create Vulkan surface");
 		return false;
 	}
 
 	if (!VulkanDeviceCreate(&Context))
 	{
-		LogFatal("Could not create Vulkan device");
+		LogChannelFatal(Vulkan, "Could not create Vulkan device");
 		return false;
 	}
 
@@ -170,7 +190,7 @@ b8 VulkanRenderer::Initialize(const char *ApplicationName, u32 Width, u32 Height
 	// TODO: Are we allocating on the right arena?
 	Context.ImagesInFlight.Create(Arena, Context.Swapchain.ImageCount, Context.Swapchain.ImageCount);
 
-	LogInfo("Vulkan renderer initialized successfully");
+	LogChannelInfo(Vulkan, "Vulkan renderer initialized successfully");
 	return true;
 }
 
@@ -207,10 +227,10 @@ void VulkanRenderer::Terminate()
 
 	Context.Swapchain.Destroy();
 
-	LogDebug("Destroying Vulkan device");
+	LogChannelDebug(Vulkan, "Destroying Vulkan device");
 	VulkanDeviceDestroy(&Context);
 
-	LogDebug("Destroying Vulkan surface");
+	LogChannelDebug(Vulkan, "Destroying Vulkan surface");
 	if (Context.Surface)
 	{
 		vkDestroySurfaceKHR(Context.Instance, Context.Surface, Context.Allocator);
@@ -218,7 +238,7 @@ void VulkanRenderer::Terminate()
 	}
 
 #ifdef KIWI_SLOW
-	LogDebug("Destroying Vulkan Debugger");
+	LogChannelDebug(Vulkan, "Destroying Vulkan Debugger");
 	if (Context.DebugMessenger)
 	{
 		PFN_vkDestroyDebugUtilsMessengerEXT DestroyDebuggerFunc =
@@ -228,7 +248,7 @@ void VulkanRenderer::Terminate()
 	}
 #endif
 
-	LogDebug("Destroyng the Vulkan Instance");
+	LogChannelDebug(Vulkan, "Destroyng the Vulkan Instance");
 	vkDestroyInstance(Context.Instance, Context.Allocator);
 
 	Arena->Clear();
@@ -239,8 +259,9 @@ void VulkanRenderer::Resized(u16 Width, u16 Height)
 	CachedFramebufferWidth = Width;
 	CachedFramebufferHeight = Height;
 	Context.FramebufferSizeGeneration++;
+	Metrics::Add(Metric_FramebufferResizes, 1);
 
-	LogInfo("Vulkan renderer backend resized. W: %i, H: %i, Gen: %llu",
+	LogChannelInfo(Vulkan, "Vulkan renderer backend resized. W: %i, H: %i, Gen: %llu",
 			Width, Height, Context.FramebufferSizeGeneration);
 }
 
@@ -256,10 +277,10 @@ b8 VulkanRenderer::BeginFrame(f32 DeltaTime)
 		VkResult Result = vkDeviceWaitIdle(Device->LogicalDevice);
 		if (!VulkanResultIsSuccess(Result))
 		{
-			LogError("Vulkan Renderer Begin Frame Wait[1] failed: %s", VulkanResultString(Result, true));
+			LogChannelError(Vulkan, "Vulkan Renderer Begin Frame Wait[1] failed: %s", VulkanResultString(Result, true));
 			return false;
 		}
-		LogInfo("Recreating Swapchain, booting");
+		LogChannelInfo(Vulkan, "Recreating Swapchain, booting");
 		return false;
 	}
 
@@ -269,7 +290,7 @@ b8 VulkanRenderer::BeginFrame(f32 DeltaTime)
 		VkResult Result = vkDeviceWaitIdle(Device->LogicalDevice);
 		if (!VulkanResultIsSuccess(Result))
 		{
-			LogError("Vulkan Renderer Begin Frame Wait[2] failed: %s", VulkanResultString(Result, true));
+			LogChannelError(Vulkan, "Vulkan Renderer Begin Frame Wait[2] failed: %s", VulkanResultString(Result, true));
 			return false;
 		}
 
@@ -278,20 +299,20 @@ b8 VulkanRenderer::BeginFrame(f32 DeltaTime)
 			return false;
 		}
 
-		LogInfo("Resized, booting");
+		LogChannelInfo(Vulkan, "Resized, booting");
 		return false;
 	}
 
 	if (!Context.InFlightFences[Context.CurrentFrame].Wait(UINT64_MAX))
 	{
-		LogWarning("In flight fence wait failed");
+		LogChannelWarning(Vulkan, "In flight fence wait failed");
 		return false;
 	}
 
 	if (!Context.Swapchain.AcquireNextImageIndex(UINT64_MAX, Context.ImageAvailableSemaphores[Context.CurrentFrame],
 												 0, &Context.ImageIndex))
 	{
-		LogWarning("Failed acquiring the next image index from the swapchain");
+		LogChannelWarning(Vulkan, "Failed acquiring the next image index from the swapchain");
 		return false;
 	}
 
@@ -365,7 +386,7 @@ b8 VulkanRenderer::EndFrame(f32 DeltaTime)
 									Context.ImagesInFlight[Context.CurrentFrame]->Handle);
 	if (Result != VK_SUCCESS)
 	{
-		LogError("Queue Submit failed: %s", VulkanResultString(Result, true));
+		LogChannelError(Vulkan, "Queue Submit failed: %s", VulkanResultString(Result, true));
 		return false;
 	}
 
@@ -389,22 +410,22 @@ VKAPI_ATTR VkBool32 VKAPI_CALL VulkanDebugCallback(VkDebugUtilsMessageSeverityFl
 	{
 	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
 	{
-		LogError(CallbackData->pMessage);
+		LogChannelError(Vulkan, CallbackData->pMessage);
 		break;
 	}
 	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
 	{
-		LogWarning(CallbackData->pMessage);
+		LogChannelWarning(Vulkan, CallbackData->pMessage);
 		break;
 	}
 	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:
 	{
-		LogInfo(CallbackData->pMessage);
+		LogChannelInfo(Vulkan, CallbackData->pMessage);
 		break;
 	}
 	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT:
 	{
-		LogTrace(CallbackData->pMessage);
+		LogChannelTrace(Vulkan, CallbackData->pMessage);
 		break;
 	}
 	}
@@ -433,7 +454,7 @@ void VulkanRenderer::CreateCommandBuffers()
 		Context.GraphicsCommandBuffers[Idx].Allocate(Context.Device.GraphicsCommandPool, true);
 	}
 
-	LogInfo("Graphics command buffer created");
+	LogChannelInfo(Vulkan, "Graphics command buffer created");
 }
 
 void VulkanRenderer::DestroyCommandBuffers()
@@ -464,13 +485,13 @@ b8 VulkanRenderer::RecreateSwapchain()
 {
 	if (Context.RecreatingSwapchain)
 	{
-		LogDebug("Already recreating the swapchain");
+		LogChannelDebug(Vulkan, "Already recreating the swapchain");
 		return false;
 	}
 
 	if (Context.FramebufferWidth == 0 || Context.FramebufferHeight == 0)
 	{
-		LogDebug("Trying to recreate the swapchain with a dimension that is <1");
+		LogChannelDebug(Vulkan, "Trying to recreate the swapchain with a dimension that is <1");
 		return false;
 	}
 
@@ -1,7 +1,8 @@
 #include "vulkan_device.h"
 #include "core/logger.h"
 #include "containers/karray.h"
-#include "core/kiwi_string.h"
+#include "containers/kbitset.h"
+#include "core/string_interner.h"
 #include "core/kiwi_mem.h"
 
 struct PhysicalDeviceRequirements
@@ -14,7 +15,8 @@ struct PhysicalDeviceRequirements
 
 	b8 SamplerAnisotropy;
 	b8 DiscreteGPU;
-	KArray<const char *> ExtensionNames;
+	// NOTE: Interned so that matching against the available ones is an id compare
+	KArray<KStrId> Extensions;
 };
 
 struct PhysicalDeviceQueueFamilyInfo
@@ -35,7 +37,7 @@ b8 VulkanDeviceCreate(VulkanContext *Context)
 		return false;
 	}
 
-	LogInfo("Creating logical device");
+	LogChannelInfo(Vulkan, "Creating logical device");
 	// NOTE: Don't create additional queues for shared indices
 	VulkanDevice &Device = Context->Device;
 	KArray<u32> Indices;
@@ -99,7 +101,7 @@ b8 VulkanDeviceCreate(VulkanContext *Context)
 	VK_CHECK(vkCreateDevice(Device.PhysicalDevice, &DeviceCreateInfo,
 							Context->Allocator, &Device.LogicalDevice));
 
-	LogInfo("Logical device created");
+	LogChannelInfo(Vulkan, "Logical device created");
 
 	// Get queues
 	vkGetDeviceQueue(Device.LogicalDevice, Device.GraphicsIndex, 0, &Device.GraphicsQueue);
@@ -107,7 +109,7 @@ b8 VulkanDeviceCreate(VulkanContext *Context)
 	vkGetDeviceQueue(Device.LogicalDevice, Device.TransferIndex, 0, &Device.TransferQueue);
 	vkGetDeviceQueue(Device.LogicalDevice, Device.ComputeIndex, 0, &Device.ComputeQueue);
 
-	LogInfo("Queues obtained");
+	LogChannelInfo(Vulkan, "Queues obtained");
 
 	// Create graphics command pool
 	VkCommandPoolCreateInfo PoolCreateInfo = {};
@@ -118,7 +120,7 @@ b8 VulkanDeviceCreate(VulkanContext *Context)
 	VK_CHECK(vkCreateCommandPool(Device.LogicalDevice, &PoolCreateInfo, Context->Allocator,
 								 &Device.GraphicsCommandPool));
 
-	LogInfo("Craphics command pool Created");
+	LogChannelInfo(Vulkan, "Craphics command pool Created");
 
 	return true;
 }
@@ -127,13 +129,13 @@ b8 SelectPhysicalDevice(VulkanContext *Context, PhysicalDeviceQueueCounts &OutQu
 {
 	AutoFreeArena ScratchArenaHandle = AutoFreeArena(MemTag_Scratch);
 
-	LogInfo("Selecting physical device");
+	LogChannelInfo(Vulkan, "Selecting physical device");
 	// Querying for the appropriate physical device
 	u32 PhysicalDeviceCount = 0;
 	VK_CHECK(vkEnumeratePhysicalDevices(Context->Instance, &PhysicalDeviceCount, nullptr));
 	if (PhysicalDeviceCount == 0)
 	{
-		LogFatal("No device which support Vulkan found");
+		LogChannelFatal(Vulkan, "No device which support Vulkan found");
 		return false;
 	}
 
@@ -150,8 +152,8 @@ b8 SelectPhysicalDevice(VulkanContext *Context, PhysicalDeviceQueueCounts &OutQu
 	Requirements.Compute = true;
 	Requirements.SamplerAnisotropy = true;
 	Requirements.DiscreteGPU = true;
-	Requirements.ExtensionNames.Create(ScratchArenaHandle.Arena);
-	Requirements.ExtensionNames.Push(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+	Requirements.Extensions.Create(ScratchArenaHandle.Arena);
+	Requirements.Extensions.Push(KSTR_ID(VK_KHR_SWAPCHAIN_EXTENSION_NAME));
 
 	for (u32 Index = 0; Index < PhysicalDevices.Length; ++Index)
 	{
@@ -188,7 +190,7 @@ b8 SelectPhysicalDevice(VulkanContext *Context, PhysicalDeviceQueueCounts &OutQu
 			{
 				if (Prop.deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
 				{
-					LogInfo("Device %d is not a discrete GPU", i);
+					LogChannelInfo(Vulkan, "Device %d is not a discrete GPU", i);
 					continue;
 				}
 			}
@@ -244,13 +246,13 @@ b8 SelectPhysicalDevice(VulkanContext *Context, PhysicalDeviceQueueCounts &OutQu
 			}
 		}
 
-		LogInfo("Graphics | Present | Transfer | Compute | Name");
-		LogInfo("       %d |       %d |        %d |       %d | %s",
+		LogChannelInfo(Vulkan, "Graphics | Present | Transfer | Compute | Name");
+		LogChannelInfo(Vulkan, "       %d |       %d |        %d |       %d | %s",
 				QueueInfo.GraphicsIndex, QueueInfo.PresentIndex,
 				QueueInfo.TransferIndex, QueueInfo.ComputeIndex, Properties.deviceName);
 
 		// Device extensions
-		if (Requirements.ExtensionNames.Length)
+		if (Requirements.Extensions.Length)
 		{
 			u32 AvailableExtensionsCount = 0;
 			KArray<VkExtensionProperties> ExtensionProperties;
@@ -261,24 +263,35 @@ b8 SelectPhysicalDevice(VulkanContext *Context, PhysicalDeviceQueueCounts &OutQu
 				VK_CHECK(vkEnumerateDeviceExtensionProperties(Device, 0, &AvailableExtensionsCount,
 															  ExtensionProperties.Elements));
 
-				b8 Found = true;
-				for (u32 ReqIdx = 0; ReqIdx < Requirements.ExtensionNames.Length && Found; ++ReqIdx)
+				// NOTE: Every available extension is looked up once. Names that were
+				// never interned can't be required, so they are discarded by the lookup
+				KBitArray FoundExtensions;
+				FoundExtensions.Create(ScratchArenaHandle.Arena, Requirements.Extensions.Length);
+				for (u32 AvIdx = 0; AvIdx < ExtensionProperties.Length; ++AvIdx)
 				{
-					Found = false;
-					for (u32 AvIdx = 0; AvIdx < ExtensionProperties.Length; ++AvIdx)
+					KStrId AvailableId = StringInterner::Find(ExtensionProperties[AvIdx].extensionName);
+					if (!AvailableId.IsValid())
+					{
+						continue;
+					}
+
+					for (u32 ReqIdx = 0; ReqIdx < Requirements.Extensions.Length; ++ReqIdx)
 					{
-						if (KStr::Equal(Requirements.ExtensionNames[ReqIdx],
-										ExtensionProperties[AvIdx].extensionName))
+						if (AvailableId == Requirements.Extensions[ReqIdx])
 						{
-							Found = true;
-							break;
+							FoundExtensions.Set(ReqIdx);
 						}
 					}
+				}
 
-					if (!Found)
+				b8 Found = true;
+				for (u32 ReqIdx = 0; ReqIdx < Requirements.Extensions.Length; ++ReqIdx)
+				{
+					if (!FoundExtensions.Test(ReqIdx))
 					{
-						LogInfo("Could not find extension %s. Skipping.",
-								Requirements.ExtensionNames[ReqIdx]);
+						LogChannelInfo(Vulkan, "Could not find extension %s. Skipping.",
+								StringInterner::GetString(Requirements.Extensions[ReqIdx]));
+						Found = false;
 						break;
 					}
 				}
@@ -292,7 +305,7 @@ b8 SelectPhysicalDevice(VulkanContext *Context, PhysicalDeviceQueueCounts &OutQu
 
 		if (Requirements.SamplerAnisotropy && !Features.samplerAnisotropy)
 		{
-			LogInfo("Device %d does not support sampler anisotropy. Skipping.");
+			LogChannelInfo(Vulkan, "Device %d does not support sampler anisotropy. Skipping.");
 			continue;
 		}
 
@@ -314,42 +327,42 @@ b8 SelectPhysicalDevice(VulkanContext *Context, PhysicalDeviceQueueCounts &OutQu
 		Context->Device.MemoryProperties = MemoryProperties;
 
 		// Log some informations
-		LogInfo("Selected device: %s", Properties.deviceName);
+		LogChannelInfo(Vulkan, "Selected device: %s", Properties.deviceName);
 		switch (Properties.deviceType)
 		{
 		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
 		{
-			LogInfo("GPU type is Integrated");
+			LogChannelInfo(Vulkan, "GPU type is Integrated");
 		}
 		break;
 		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
 		{
-			LogInfo("GPU type is Discrete");
+			LogChannelInfo(Vulkan, "GPU type is Discrete");
 		}
 		break;
 		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
 		{
-			LogInfo("GPU type is Virtual");
+			LogChannelInfo(Vulkan, "GPU type is Virtual");
 		}
 		break;
 		case VK_PHYSICAL_DEVICE_TYPE_CPU:
 		{
-			LogInfo("GPU type is CPU");
+			LogChannelInfo(Vulkan, "GPU type is CPU");
 		}
 		break;
 		case VK_PHYSICAL_DEVICE_TYPE_OTHER:
 		default:
 		{
-			LogInfo("GPU type is Unknown");
+			LogChannelInfo(Vulkan, "GPU type is Unknown");
 		}
 		}
 
-		LogInfo("GPU Driver version: %d.%d.%d",
+		LogChannelInfo(Vulkan, "GPU Driver version: %d.%d.%d",
 				VK_VERSION_MAJOR(Properties.driverVersion),
 				VK_VERSION_MINOR(Properties.driverVersion),
 				VK_VERSION_PATCH(Properties.driverVersion));
 
-		LogInfo("Vulkan API version: %d.%d.%d",
+		LogChannelInfo(Vulkan, "Vulkan API version: %d.%d.%d",
 				VK_VERSION_MAJOR(Properties.apiVersion),
 				VK_VERSION_MINOR(Properties.apiVersion),
 				VK_VERSION_PATCH(Properties.apiVersion));
@@ -359,29 +372,29 @@ b8 SelectPhysicalDevice(VulkanContext *Context, PhysicalDeviceQueueCounts &OutQu
 			f32 MemorySizeGib = (f32)(ToGiB(MemoryProperties.memoryHeaps[HeapIdx].size));
 			if (MemoryProperties.memoryHeaps[HeapIdx].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
 			{
-				LogInfo("Local GPU memory: %.2f GiB", MemorySizeGib);
+				LogChannelInfo(Vulkan, "Local GPU memory: %.2f GiB", MemorySizeGib);
 			}
 			else
 			{
-				LogInfo("Shared System memory: %.2f GiB", MemorySizeGib);
+				LogChannelInfo(Vulkan, "Shared System memory: %.2f GiB", MemorySizeGib);
 			}
 		}
 
-		LogInfo("Physical Device Selected");
+		LogChannelInfo(Vulkan, "Physical Device Selected");
 		return true;
 	}
 
-	LogError("No physical device that meets the requirement found");
+	LogChannelError(Vulkan, "No physical device that meets the requirement found");
 	return false;
 }
 
 void VulkanDeviceDestroy(VulkanContext *Context)
 {
-	LogInfo("Destroying command pools");
+	LogChannelInfo(Vulkan, "Destroying command pools");
 	vkDestroyCommandPool(Context->Device.LogicalDevice, Context->Device.GraphicsCommandPool,
 						 Context->Allocator);
 
-	LogInfo("Destroying logical device");
+	LogChannelInfo(Vulkan, "Destroying logical device");
 	if (Context->Device.LogicalDevice)
 	{
 		vkDestroyDevice(Context->Device.LogicalDevice, Context->Allocator);
@@ -396,7 +409,7 @@ void VulkanDeviceDestroy(VulkanContext *Context)
 
 	// NOTE: there is not such a thing like destroying a physical device
 	// but we can release all the resources that we obtained during creation
-	LogInfo("Releasing physical device resources");
+	LogChannelInfo(Vulkan, "Releasing physical device resources");
 	Context->Device.PhysicalDevice = 0;
 
 	Context->Device.GraphicsIndex = (u32)(-1);
@@ -49,27 +49,27 @@ b8 VulkanFence::Wait(u64 TimeoutNS)
 		}
 		case VK_TIMEOUT:
 		{
-			LogWarning("Vulkan Fence Wait: Timed out");
+			LogChannelWarning(Vulkan, "Vulkan Fence Wait: Timed out");
 			break;
 		}
 		case VK_ERROR_DEVICE_LOST:
 		{
-			LogError("Vulkan Fence Wait: VK_ERROR_DEVICE_LOST");
+			LogChannelError(Vulkan, "Vulkan Fence Wait: VK_ERROR_DEVICE_LOST");
 			break;
 		}
 		case VK_ERROR_OUT_OF_HOST_MEMORY:
 		{
-			LogError("Vulkan Fence Wait: VK_ERROR_OUT_OF_HOST_MEMORY");
+			LogChannelError(Vulkan, "Vulkan Fence Wait: VK_ERROR_OUT_OF_HOST_MEMORY");
 			break;
 		}
 		case VK_ERROR_OUT_OF_DEVICE_MEMORY:
 		{
-			LogError("Vulkan Fence Wait: VK_ERROR_OUT_OF_DEVICE_MEMORY");
+			LogChannelError(Vulkan, "Vulkan Fence Wait: VK_ERROR_OUT_OF_DEVICE_MEMORY");
 			break;
 		}
 		default:
 		{
-			LogError("Vulkan Fence Wait: An unknown error has occurred");
+			LogChannelError(Vulkan, "Vulkan Fence Wait: An unknown error has occurred");
 			break;
 		}
 		}
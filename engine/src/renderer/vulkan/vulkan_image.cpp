@@ -38,7 +38,7 @@ void VulkanImage::Create(VkImageType Type, u32 InWidth, u32 InHeight, VkFormat F
 	i32 MemTypeIdx = FindMemoryTypeIndex(MemoryRequirements.memoryTypeBits, MemoryFlags);
 	if (MemTypeIdx == MEMORY_TYPE_INDEX_INVALID)
 	{
-		LogError("Could not get the required memory type. Image not valid.");
+		LogChannelError(Vulkan, "Could not get the required memory type. Image not valid.");
 	}
 
 	// Allocate memory
@@ -117,6 +117,6 @@ u32 VulkanImage::FindMemoryTypeIndex(u32 TypeFilter, u32 PropertyFlags)
 		}
 	}
 
-	LogWarning("Unable to find a suitable memory type");
+	LogChannelWarning(Vulkan, "Unable to find a suitable memory type");
 	return (u32)MEMORY_TYPE_INDEX_INVALID;
 }
\ No newline at end of file
@@ -12,7 +12,7 @@ void VulkanSwapchain::Create(u32 Width, u32 Height, MemArena *RendererArena)
 	if (!QuerySupport(Context->Device.PhysicalDevice, Context->Surface,
 					  ScratchArenaHandle.Arena, SwapchainSupport))
 	{
-		LogWarning("Could not query swapchain support during Swapchain creation");
+		LogChannelWarning(Vulkan, "Could not query swapchain support during Swapchain creation");
 		KDebugBreak();
 	}
 
@@ -144,14 +144,14 @@ void VulkanSwapchain::Create(u32 Width, u32 Height, MemArena *RendererArena)
 	if (!VulkanDeviceDetectDepthFormat(&Context->Device))
 	{
 		Context->Device.DepthFormat = VK_FORMAT_UNDEFINED;
-		LogFatal("Failed to find a supported depth format");
+		LogChannelFatal(Vulkan, "Failed to find a supported depth format");
 	}
 	DepthAttachment.Create(VK_IMAGE_TYPE_2D, SwapchainExtent.width, SwapchainExtent.height,
 						   Context->Device.DepthFormat, VK_IMAGE_TILING_OPTIMAL,
 						   VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 						   true, VK_IMAGE_ASPECT_DEPTH_BIT);
 
-	LogInfo("Swapchain created successfully");
+	LogChannelInfo(Vulkan, "Swapchain created successfully");
 }
 
 void VulkanSwapchain::Destroy()
@@ -195,7 +195,7 @@ b8 VulkanSwapchain::AcquireNextImageIndex(u64 TimeoutNs, VkSemaphore ImageAvaila
 	}
 	else if (Result != VK_SUCCESS && Result != VK_SUBOPTIMAL_KHR)
 	{
-		LogFatal("Failed to acquire swapchain image!");
+		LogChannelFatal(Vulkan, "Failed to acquire swapchain image!");
 		return false;
 	}
 
@@ -223,7 +223,7 @@ void VulkanSwapchain::Present(VkSemaphore RenderCompleteSemaphore, u32 PresentIm
 	}
 	else if (Result != VK_SUCCESS)
 	{
-		LogFatal("Failed to present swap chain image");
+		LogChannelFatal(Vulkan, "Failed to present swap chain image");
 	}
 
 	Context->CurrentFrame = (Context->CurrentFrame + 1) % ImageCount;
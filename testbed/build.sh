@@ -0,0 +1,21 @@
+#!/bin/bash
+# NOTE: Linux build of the testbed, see engine/build.sh. Run it with --headless <frames>
+set -e
+
+mkdir -p ../bin
+UnityBuild=../bin/testbed_unity_build.cpp
+: > $UnityBuild
+
+for File in $(find src -name "*.cpp" | sort); do
+	echo "#include \"$(realpath $File)\"" >> $UnityBuild
+done
+
+Assembly=Testbed
+IncludeFolders="-Isrc -I../engine/src"
+Defines="-DKIWI_SLOW"
+WarningsOptions="-Wall -Werror -Wno-unused-function -Wno-unused-parameter -Wno-unused-variable -Wno-missing-braces"
+# NOTE: -rdynamic so the sampling profiler can name the functions, the engine is looked up next to the executable
+CompilerFlags="-std=c++14 -g -O0 -fno-rtti -pthread -rdynamic $IncludeFolders $Defines $WarningsOptions"
+LinkerFlags="-L../bin -lengine -Wl,-rpath,\$ORIGIN"
+
+g++ $CompilerFlags $UnityBuild -o ../bin/$Assembly $LinkerFlags
@@ -0,0 +1,25 @@
+@echo off
+
+SETLOCAL ENABLEDELAYEDEXPANSION
+
+break>..\..\bin\logdump_unity_build.cpp
+
+for /R %%f in (*.cpp) do (
+	set "IncludeFile=#include "%%f""
+	echo !IncludeFile! >> ..\..\bin\logdump_unity_build.cpp
+)
+
+pushd ..\..\bin
+
+set Assembly=LogDump
+set IncludeFolders=/I../tools/logdump/src /I../engine/src/
+set Defines=/DKIWI_SLOW
+set WarningsOptions=/W4 /WX
+
+set CompilerFlags=/nologo /MTd /fp:fast /GR- /Od /Oi /FC /Zi /permissive- %IncludeFolders% %Defines% %WarningsOptions%
+set LinkerFlags=/nologo /incremental:no /opt:ref engine.lib
+
+
+cl %CompilerFlags% logdump_unity_build.cpp /Fe%Assembly% /link %LinkerFlags%
+
+popd
\ No newline at end of file
@@ -0,0 +1,25 @@
+#include "defines.h"
+#include "core/kiwi_mem.h"
+#include "core/log_crash_ring.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// NOTE: Prints the last records of a crash ring written with --crash-log
+int main(int ArgCount, char **Args)
+{
+	if (ArgCount < 2)
+	{
+		printf("Usage: logdump <crash ring file> [record count, default %d]\n", LOG_CRASH_RING_DUMP_DEFAULT_COUNT);
+		return 1;
+	}
+
+	u32 RecordCount = LOG_CRASH_RING_DUMP_DEFAULT_COUNT;
+	if (ArgCount > 2)
+	{
+		RecordCount = (u32)strtoul(Args[2], nullptr, 10);
+	}
+
+	MemSystem::Initialize();
+	return LogCrashRing::Dump(Args[1], RecordCount) ? 0 : 2;
+}